@@ -0,0 +1,469 @@
+/* ED_CBORFile.c - CBOR functions
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#define strdup _strdup
+#endif
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_trace.h"
+#include "ED_bindoc.h"
+#include "ModelicaUtilities.h"
+#include "../Include/ED_trim.h"
+#include "../Include/ED_CBORFile.h"
+
+/* Reader of CBOR (RFC 8949) documents. The file is mapped and the values
+ * are found by walking the maps of the dotted element name in place,
+ * without building a tree (see ED_bindoc.h). The mapping is released when
+ * the handle is trimmed.
+ */
+
+/* Tags of RFC 8746 */
+#define CBOR_TAG_MULTI_DIM_ROW_MAJOR (40UL)
+#define CBOR_TAG_MULTI_DIM_COLUMN_MAJOR (1040UL)
+#define CBOR_TAG_TYPED_ARRAY_FIRST (64UL)
+#define CBOR_TAG_TYPED_ARRAY_LAST (87UL)
+
+typedef struct {
+	char* fileName;
+	ED_VFILE* fp; /* Open while the content is mapped */
+	const unsigned char* map; /* Content, NULL if trimmed */
+	char* buf; /* Content if the file cannot be mapped */
+	size_t len;
+	ED_TrimEntry* trim;
+} CBORFile;
+
+/* Apply the tag to the item, only the tags of (multi-dimensional) numeric
+ * arrays are considered
+ */
+static int applyTag(unsigned long tag, ED_BinItem* item)
+{
+	if (item->kind == ED_BINDOC_BYTES && tag >= CBOR_TAG_TYPED_ARRAY_FIRST &&
+		tag <= CBOR_TAG_TYPED_ARRAY_LAST) {
+		/* Bits of the tag: 010fsell, float, signed, little endian and
+		 * the length
+		 */
+		unsigned long t = tag - CBOR_TAG_TYPED_ARRAY_FIRST;
+		int isFloat = (t & 16) != 0;
+		size_t size = isFloat ? (size_t)2 << (t & 3) : (size_t)1 << (t & 3);
+		if (size > 8) {
+			/* 128-bit floating-point numbers are not supported */
+			item->kind = ED_BINDOC_OTHER;
+			return 0;
+		}
+		if (item->count % size != 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		item->kind = ED_BINDOC_TYPED_ARRAY;
+		item->elemType = isFloat ? ED_BINDOC_FLOAT : (t & 8) ? ED_BINDOC_SINT : ED_BINDOC_UINT;
+		item->elemSize = size;
+		item->bigEndian = (t & 4) == 0;
+		item->count /= size;
+	}
+	else if (item->kind == ED_BINDOC_ARRAY) {
+		if (tag == CBOR_TAG_MULTI_DIM_ROW_MAJOR) {
+			item->order = ED_BINDOC_ROW_MAJOR;
+		}
+		else if (tag == CBOR_TAG_MULTI_DIM_COLUMN_MAJOR) {
+			item->order = ED_BINDOC_COLUMN_MAJOR;
+		}
+	}
+	return 0;
+}
+
+static int readCBOR(const unsigned char* p, size_t len, size_t pos, ED_BinItem* item)
+{
+	unsigned long tag = 0;
+	int tagged = 0;
+
+	memset(item, 0, sizeof(ED_BinItem));
+	for (;;) {
+		unsigned int major;
+		unsigned int info;
+		size_t n = 0; /* Bytes of the argument */
+		unsigned long lo = 0;
+		unsigned long hi = 0;
+		size_t arg;
+
+		if (pos >= len) {
+			errno = EINVAL;
+			return -1;
+		}
+		major = p[pos] >> 5;
+		info = p[pos] & 31;
+		pos++;
+		if (info < 24) {
+			lo = info;
+		}
+		else if (info <= 27) {
+			size_t k;
+			n = (size_t)1 << (info - 24);
+			if (n > len - pos) {
+				errno = EINVAL;
+				return -1;
+			}
+			for (k = 0; k < n; k++) {
+				if (n - k > 4) {
+					hi = (hi << 8) | p[pos + k];
+				}
+				else {
+					lo = (lo << 8) | p[pos + k];
+				}
+			}
+			pos += n;
+		}
+		else {
+			/* Indefinite lengths are not supported */
+			errno = EINVAL;
+			return -1;
+		}
+		/* Lengths beyond size_t are saturated, failing the bounds checks */
+		arg = (size_t)lo;
+		if (hi != 0) {
+			arg = sizeof(size_t) <= 4 ? (size_t)-1 : arg | ((size_t)hi << 16 << 16);
+		}
+
+		switch (major) {
+			case 0: /* Unsigned and negative integers */
+			case 1:
+				item->kind = ED_BINDOC_NUMBER;
+				item->isInt = 1;
+				item->value = (double)hi*4294967296.0 + (double)lo;
+				if (major == 1) {
+					item->value = -1.0 - item->value;
+				}
+				break;
+
+			case 2: /* Byte and text strings */
+			case 3:
+				if (arg > len - pos) {
+					errno = EINVAL;
+					return -1;
+				}
+				item->kind = major == 2 ? ED_BINDOC_BYTES : ED_BINDOC_STRING;
+				item->count = arg;
+				item->data = p + pos;
+				pos += arg;
+				break;
+
+			case 4: /* Arrays and maps */
+			case 5:
+				item->kind = major == 4 ? ED_BINDOC_ARRAY : ED_BINDOC_MAP;
+				item->count = arg;
+				break;
+
+			case 6:
+				/* The tag applies to the following item */
+				tag = hi != 0 ? 0 : lo;
+				tagged = 1;
+				continue;
+
+			default:
+				if (info == 20 || info == 21) {
+					item->kind = ED_BINDOC_BOOL;
+					item->isInt = 1;
+					item->value = info == 21 ? 1.0 : 0.0;
+				}
+				else if (info == 22 || info == 23) {
+					/* Null and undefined */
+					item->kind = ED_BINDOC_NIL;
+				}
+				else if (info >= 25) {
+					item->kind = ED_BINDOC_NUMBER;
+					item->value = ED_bindocReadFloat(p + pos - n, n, 1);
+				}
+				else {
+					item->kind = ED_BINDOC_OTHER;
+				}
+				break;
+		}
+		break;
+	}
+	item->next = pos;
+	return tagged ? applyTag(tag, item) : 0;
+}
+
+static void closeFile(CBORFile* cbor)
+{
+	if (cbor->fp != NULL) {
+		ED_vfclose(cbor->fp);
+		cbor->fp = NULL;
+	}
+	free(cbor->buf);
+	cbor->buf = NULL;
+	cbor->map = NULL;
+}
+
+/* Map the file, or read it if it cannot be mapped */
+static int openFile(CBORFile* cbor)
+{
+	const char* map;
+	cbor->fp = ED_vfopen(cbor->fileName);
+	if (cbor->fp == NULL) {
+		return -1;
+	}
+	map = ED_vfmap(cbor->fp, &cbor->len);
+	if (map == NULL) {
+		cbor->buf = ED_vfreadall(cbor->fp, &cbor->len);
+		ED_vfclose(cbor->fp);
+		cbor->fp = NULL;
+		if (cbor->buf == NULL) {
+			return -1;
+		}
+		map = cbor->buf;
+	}
+	cbor->map = (const unsigned char*)map;
+	return 0;
+}
+
+/* Release the mapping, it is opened again on the next access */
+static void trimCBOR(void* _cbor)
+{
+	closeFile((CBORFile*)_cbor);
+}
+
+void* ED_createCBOR(const char* fileName, int verbose)
+{
+	ED_BinItem root;
+	CBORFile* cbor;
+	ED_TRACE_CREATE_BEGIN("CBOR", fileName);
+	cbor = (CBORFile*)calloc(1, sizeof(CBORFile));
+	if (cbor == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	cbor->fileName = strdup(fileName);
+	if (cbor->fileName == NULL) {
+		free(cbor);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	if (0 != openFile(cbor)) {
+		int rc = errno;
+		free(cbor->fileName);
+		free(cbor);
+		ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(rc));
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("readCBOR", fileName);
+	if (0 != readCBOR(cbor->map, cbor->len, 0, &root)) {
+		closeFile(cbor);
+		free(cbor->fileName);
+		free(cbor);
+		ModelicaFormatError("Cannot parse file \"%s\": Invalid CBOR document\n", fileName);
+		return NULL;
+	}
+
+	ED_TRACE_PARSE_END("readCBOR", fileName, cbor->len);
+
+	cbor->trim = ED_trimRegister(cbor, trimCBOR);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("CBOR", fileName, cbor);
+	return cbor;
+}
+
+void ED_destroyCBOR(void* _cbor)
+{
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_TRACE_DESTROY("CBOR", cbor->fileName);
+		ED_trimUnregister(cbor->trim);
+		closeFile(cbor);
+		free(cbor->fileName);
+		free(cbor);
+		ED_parallelRelease();
+	}
+}
+
+/* Raise the error of errno for the element varName, value is the kind of
+ * the expected value
+ */
+static void raiseError(const CBORFile* cbor, const char* varName, const char* value)
+{
+	if (errno == ENOENT) {
+		ModelicaFormatError("Cannot read element \"%s\" from file \"%s\"\n",
+			varName, cbor->fileName);
+	}
+	else if (errno == EDOM) {
+		ModelicaFormatError("Cannot read %s value of element \"%s\" from file \"%s\"\n",
+			value, varName, cbor->fileName);
+	}
+	else {
+		ModelicaFormatError("Cannot parse file \"%s\": Invalid CBOR document\n",
+			cbor->fileName);
+	}
+}
+
+/* Document of the handle and offset of the value of varName, raises an
+ * error on failure
+ */
+static size_t findValue(CBORFile* cbor, const char* varName, ED_BinDoc* doc)
+{
+	size_t pos = 0;
+	if (cbor->map == NULL && 0 != openFile(cbor)) {
+		ModelicaFormatError("Cannot read \"%s\": %s\n", cbor->fileName, strerror(errno));
+		return 0;
+	}
+	doc->p = cbor->map;
+	doc->len = cbor->len;
+	doc->read = readCBOR;
+	if (0 != ED_bindocFind(doc, varName, &pos)) {
+		raiseError(cbor, varName, "");
+	}
+	return pos;
+}
+
+double ED_getDoubleFromCBOR(void* _cbor, const char* varName)
+{
+	double ret = 0.;
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(cbor->fileName, varName);
+		ED_trimEnter(cbor->trim);
+		pos = findValue(cbor, varName, &doc);
+		if (0 != ED_bindocGetDouble(&doc, pos, &ret)) {
+			raiseError(cbor, varName, "double");
+		}
+		ED_TRACE_GET_END(cbor->fileName, varName, 1);
+		ED_trimLeave(cbor->trim);
+	}
+	return ret;
+}
+
+const char* ED_getStringFromCBOR(void* _cbor, const char* varName)
+{
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_BinDoc doc;
+		ED_BinItem item;
+		size_t pos;
+		char* ret;
+		ED_TRACE_GET_BEGIN(cbor->fileName, varName);
+		ED_trimEnter(cbor->trim);
+		pos = findValue(cbor, varName, &doc);
+		if (0 != doc.read(doc.p, doc.len, pos, &item)) {
+			raiseError(cbor, varName, "string");
+		}
+		if (item.kind != ED_BINDOC_STRING) {
+			errno = EDOM;
+			raiseError(cbor, varName, "string");
+		}
+		ret = ModelicaAllocateString(item.count);
+		memcpy(ret, item.data, item.count);
+		ret[item.count] = '\0';
+		ED_TRACE_GET_END(cbor->fileName, varName, 1);
+		ED_trimLeave(cbor->trim);
+		return (const char*)ret;
+	}
+	return "";
+}
+
+int ED_getIntFromCBOR(void* _cbor, const char* varName)
+{
+	int ret = 0;
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_BinDoc doc;
+		ED_BinItem item;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(cbor->fileName, varName);
+		ED_trimEnter(cbor->trim);
+		pos = findValue(cbor, varName, &doc);
+		if (0 != doc.read(doc.p, doc.len, pos, &item)) {
+			raiseError(cbor, varName, "int");
+		}
+		if ((item.kind != ED_BINDOC_NUMBER && item.kind != ED_BINDOC_BOOL) ||
+			!item.isInt || item.value < -2147483648.0 || item.value > 2147483647.0) {
+			errno = EDOM;
+			raiseError(cbor, varName, "int");
+		}
+		ret = (int)item.value;
+		ED_TRACE_GET_END(cbor->fileName, varName, 1);
+		ED_trimLeave(cbor->trim);
+	}
+	return ret;
+}
+
+void ED_getArray2DSizeFromCBOR(void* _cbor, const char* varName, int* dim)
+{
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		size_t m = 0;
+		size_t n = 0;
+		ED_TRACE_GET_BEGIN(cbor->fileName, varName);
+		ED_trimEnter(cbor->trim);
+		pos = findValue(cbor, varName, &doc);
+		if (0 != ED_bindocGetSize(&doc, pos, &m, &n)) {
+			raiseError(cbor, varName, "numeric");
+		}
+		dim[0] = (int)m;
+		dim[1] = (int)n;
+		ED_TRACE_GET_END(cbor->fileName, varName, 0);
+		ED_trimLeave(cbor->trim);
+	}
+}
+
+void ED_getDoubleArray1DFromCBOR(void* _cbor, const char* varName, double* a, size_t n)
+{
+	CBORFile* cbor = (CBORFile*)_cbor;
+	if (cbor != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(cbor->fileName, varName);
+		ED_trimEnter(cbor->trim);
+		pos = findValue(cbor, varName, &doc);
+		if (0 != ED_bindocReadArray(&doc, pos, a, n)) {
+			if (errno == ERANGE) {
+				ModelicaFormatError("Cannot read %lu double values of element \"%s\" "
+					"from file \"%s\"\n", (unsigned long)n, varName, cbor->fileName);
+			}
+			raiseError(cbor, varName, "double");
+		}
+		ED_TRACE_GET_END(cbor->fileName, varName, n);
+		ED_trimLeave(cbor->trim);
+	}
+}
+
+void ED_getDoubleArray2DFromCBOR(void* _cbor, const char* varName, double* a, size_t m, size_t n)
+{
+	ED_getDoubleArray1DFromCBOR(_cbor, varName, a, m*n);
+}
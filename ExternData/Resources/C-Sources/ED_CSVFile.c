@@ -34,11 +34,16 @@
 #define strdup _strdup
 #endif
 #include "ED_locale.h"
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_table.h"
+#include "ED_trace.h"
+#include "ED_scan.h"
 #include "array.h"
 #include "utstring.h"
-#include "zstring_strtok_dquotes.h"
 #include "zstring_rtrim.h"
 #include "ModelicaUtilities.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_CSVFile.h"
 
 #if !defined(LINE_BUFFER_LENGTH)
@@ -51,15 +56,18 @@ typedef struct {
 	char* fileName;
 	char* sep;
 	char quote;
+	int quoted; /* 1 if any line contains the quotation */
 	ED_LOCALE_TYPE loc;
-	cpo_array_t* lines;
+	cpo_array_t* lines; /* Released when the table is built or trimmed */
+	ED_Table* table;
+	ED_TrimEntry* trim;
 } CSVFile;
 
-static int readLine(char** buf, int* bufLen, FILE* fp) {
+static int readLine(char** buf, int* bufLen, ED_VFILE* fp) {
 	char* offset;
 	int oldBufLen;
 
-	if (fgets(*buf, *bufLen, fp) == NULL) {
+	if (ED_vfgets(*buf, *bufLen, fp) == NULL) {
 		return EOF;
 	}
 
@@ -76,7 +84,7 @@ static int readLine(char** buf, int* bufLen, FILE* fp) {
 		*bufLen *= 2;
 		tmp = (char*)realloc(*buf, (size_t)*bufLen);
 		if (tmp == NULL) {
-			fclose(fp);
+			ED_vfclose(fp);
 			free(*buf);
 			ModelicaError("Memory allocation error\n");
 			return 1;
@@ -84,19 +92,187 @@ static int readLine(char** buf, int* bufLen, FILE* fp) {
 		*buf = tmp;
 		offset = &((*buf)[oldBufLen - 1]);
 
-	} while (fgets(offset, oldBufLen + 1, fp));
+	} while (ED_vfgets(offset, oldBufLen + 1, fp));
 
 	return 0;
 }
 
-void* ED_createCSV(const char* fileName, const char* sep, const char* quote, int verbose)
+static void freeLines(CSVFile* csv)
+{
+	if (csv->lines != NULL) {
+		size_t i;
+		for (i = 0; i < csv->lines->num; i++) {
+			Line* line = (Line*)cpo_array_get_at(csv->lines, i);
+			utstring_done(line);
+		}
+		cpo_array_destroy(csv->lines);
+		csv->lines = NULL;
+	}
+}
+
+/* Read the lines of the file, 1 if it cannot be opened */
+static int readLines(CSVFile* csv)
 {
 	char* buf;
 	int bufLen = LINE_BUFFER_LENGTH;
 	int readError;
-	FILE* fp;
+	ED_VFILE* fp;
+
+	csv->lines = cpo_array_create(1 , sizeof(Line));
+	if (csv->lines == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return 0;
+	}
+
+	fp = ED_vfopen(csv->fileName);
+	if (fp == NULL) {
+		cpo_array_destroy(csv->lines);
+		csv->lines = NULL;
+		return 1;
+	}
+
+	buf = (char*)malloc(LINE_BUFFER_LENGTH*sizeof(char));
+	if (buf == NULL) {
+		ED_vfclose(fp);
+		cpo_array_destroy(csv->lines);
+		csv->lines = NULL;
+		ModelicaError("Memory allocation error\n");
+		return 0;
+	}
+
+	/* Loop over lines of file */
+	ED_TRACE_PARSE_BEGIN("readLines", csv->fileName);
+	while ((readError = readLine(&buf, &bufLen, fp)) == 0) {
+		Line* line = (Line*)cpo_array_push(csv->lines);
+		utstring_init(line);
+		zstring_rtrim(buf);
+		utstring_bincpy(line, buf, strlen(buf));
+	}
+	ED_TRACE_PARSE_END("readLines", csv->fileName, ED_vftell(fp));
+
+	if (1 != readError) {
+		free(buf);
+		ED_vfclose(fp);
+	}
+	return 0;
+}
+
+/* Parse all fields of the lines into the table: empty fields are 0,
+ * quoted fields are unquoted, and fields that are not numeric are kept
+ * as text. A quotation toggles between quoted and unquoted text, column
+ * delimiters in quoted text do not split a field.
+ *
+ * The kernel is generated for the column delimiter sep and the quotation
+ * quote, which is '\0' if the file contains no quotation. A decimal number
+ * is scanned in the same pass that finds the end of its field, unless the
+ * number can contain the column delimiter or the quotation. Any other
+ * field is split by memchr if unquoted, or else by the quotation aware
+ * loop. Returns 0 on success or -1 and sets errno on failure.
+ */
+#define ED_CSV_KERNEL(name, sep, quote) \
+static int name(CSVFile* csv, ED_Table* table) \
+{ \
+	const int fused = NULL == strchr("+-.0123456789Ee", (sep)) && (quote) != (sep) && \
+		((quote) == '\0' || NULL == strchr("+-.0123456789Ee", (quote))); \
+	size_t i; \
+	for (i = 0; i < csv->lines->num; i++) { \
+		Line* line = (Line*)cpo_array_get_at(csv->lines, i); \
+		char* p = utstring_body(line); \
+		char* const end = p + utstring_len(line); \
+		size_t j = 0; \
+		for (;;) { \
+			double val; \
+			int rc; \
+			char* q = fused ? (char*)ED_scanDecimalPrefix(p, end, &val) : NULL; \
+			if (q != NULL && (q == end || *q == (sep))) { \
+				rc = ED_tableSetDouble(table, i, j, val); \
+			} \
+			else { \
+				if ((quote) == '\0') { \
+					q = (char*)memchr(p, (sep), (size_t)(end - p)); \
+					if (q == NULL) { \
+						q = end; \
+					} \
+				} \
+				else { \
+					int inQuotes = 0; \
+					for (q = p; q < end; q++) { \
+						if (*q == (quote)) { \
+							inQuotes = !inQuotes; \
+						} \
+						else if (*q == (sep) && !inQuotes) { \
+							break; \
+						} \
+					} \
+				} \
+				if (q == p || *p == (sep)) { \
+					rc = ED_tableSetDouble(table, i, j, 0.); \
+				} \
+				else { \
+					char* first = p; \
+					char* last = q; \
+					int numeric = 0; \
+					if ((quote) != '\0' && last - first > 1 && *first == (quote) && last[-1] == (quote)) { \
+						first++; \
+						last--; \
+						numeric = ED_scanDecimal(first, last, &val); \
+					} \
+					if (!numeric) { \
+						const char c = *last; \
+						*last = '\0'; \
+						numeric = !ED_strtod(first, csv->loc, &val); \
+						rc = numeric ? 0 : ED_tableSetString(table, i, j, first); \
+						*last = c; \
+					} \
+					if (numeric) { \
+						rc = ED_tableSetDouble(table, i, j, val); \
+					} \
+				} \
+			} \
+			if (rc != 0) { \
+				return -1; \
+			} \
+			if (q == end) { \
+				break; \
+			} \
+			p = q + 1; \
+			j++; \
+		} \
+	} \
+	return 0; \
+}
+
+/* The kernels are specialized by the presence of the quotation only. The
+ * delimiter stays a runtime value: kernels for the constant delimiters ','
+ * ';' and '\t' built no faster than these, see Test/bench_csv.c.
+ */
+ED_CSV_KERNEL(buildTableUnquoted, csv->sep[0], '\0')
+ED_CSV_KERNEL(buildTableQuoted, csv->sep[0], csv->quote)
+
+/* 1 if any line contains the quotation */
+static int hasQuote(const CSVFile* csv)
+{
+	size_t i;
+	for (i = 0; i < csv->lines->num; i++) {
+		Line* line = (Line*)cpo_array_get_at(csv->lines, i);
+		if (NULL != memchr(utstring_body(line), csv->quote, utstring_len(line))) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Release the lines, they are reloaded if the table is not yet built */
+static void trimCSV(void* _csv)
+{
+	freeLines((CSVFile*)_csv);
+}
+
+void* ED_createCSV(const char* fileName, const char* sep, const char* quote, int verbose)
+{
 	CSVFile* csv;
 
+	ED_TRACE_CREATE_BEGIN("CSV", fileName);
 	if (strlen(sep) != 1) {
 		ModelicaError("Invalid column delimiter, must be a single character.\n");
 		return NULL;
@@ -124,23 +300,13 @@ void* ED_createCSV(const char* fileName, const char* sep, const char* quote, int
 		return NULL;
 	}
 	csv->quote = quote[0];
-	csv->lines = cpo_array_create(1 , sizeof(Line));
-	if (csv->lines == NULL) {
-		free(csv->sep);
-		free(csv->fileName);
-		free(csv);
-		ModelicaError("Memory allocation error\n");
-		return NULL;
-	}
 
 	if (verbose == 1) {
 		/* Print info message, that file is loading */
 		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
 	}
 
-	fp = fopen(fileName, "r");
-	if (fp == NULL) {
-		cpo_array_destroy(csv->lines);
+	if (0 != readLines(csv)) {
 		free(csv->sep);
 		free(csv->fileName);
 		free(csv);
@@ -149,30 +315,12 @@ void* ED_createCSV(const char* fileName, const char* sep, const char* quote, int
 		return NULL;
 	}
 
-	buf = (char*)malloc(LINE_BUFFER_LENGTH*sizeof(char));
-	if (buf == NULL) {
-		fclose(fp);
-		cpo_array_destroy(csv->lines);
-		free(csv->sep);
-		free(csv->fileName);
-		free(csv);
-		ModelicaError("Memory allocation error\n");
-		return NULL;
-	}
-
-	/* Loop over lines of file */
-	while ((readError = readLine(&buf, &bufLen, fp)) == 0) {
-		Line* line = (Line*)cpo_array_push(csv->lines);
-		utstring_init(line);
-		utstring_bincpy(line, zstring_rtrim(buf), strlen(buf));
-	}
-
-	if (1 != readError) {
-		free(buf);
-		fclose(fp);
-	}
-
+	csv->quoted = hasQuote(csv);
 	csv->loc = ED_INIT_LOCALE;
+	csv->table = NULL;
+	csv->trim = ED_trimRegister(csv, trimCSV);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("CSV", fileName, csv);
 	return csv;
 }
 
@@ -180,6 +328,7 @@ void ED_destroyCSV(void* _csv)
 {
 	CSVFile* csv = (CSVFile*)_csv;
 	if (csv != NULL) {
+		ED_TRACE_DESTROY("CSV", csv->fileName);
 		if (csv->fileName != NULL) {
 			free(csv->fileName);
 		}
@@ -187,15 +336,11 @@ void ED_destroyCSV(void* _csv)
 			free(csv->sep);
 		}
 		ED_FREE_LOCALE(csv->loc);
-		if (csv->lines != NULL) {
-			size_t i;
-			for (i = 0; i < csv->lines->num; i++) {
-				Line* line = (Line*)cpo_array_get_at(csv->lines, i);
-				utstring_done(line);
-			}
-			cpo_array_destroy(csv->lines);
-		}
+		ED_trimUnregister(csv->trim);
+		freeLines(csv);
+		ED_tableFree(csv->table);
 		free(csv);
+		ED_parallelRelease();
 	}
 }
 
@@ -209,48 +354,57 @@ void ED_getDoubleArray2DFromCSV(void* _csv, int* field, double* a, size_t m, siz
 		ModelicaError("Invalid column mumber, must be greater than or equal to one.\n");
 	}
 	if (csv != NULL) {
-		size_t i;
-		for (i = 0; i < m; i++) {
-			size_t j = field[0] + i - 1;
-			Line* line;
-			char* token;
-			char* nextToken = NULL;
-			int k;
-			if (j >= csv->lines->num) {
-				ModelicaFormatError("Error in line %i: Cannot read line from file \"%s\"\n",
-					field[0] + (int)i, csv->fileName);
+		size_t row = (size_t)field[0] - 1;
+		size_t col = (size_t)field[1] - 1;
+		ED_TRACE_GET_BEGIN(csv->fileName, "");
+		ED_trimEnter(csv->trim);
+		if (csv->table == NULL) {
+			if (csv->lines == NULL && 0 != readLines(csv)) {
+				ModelicaFormatError("Not possible to open file \"%s\": "
+					"No such file or directory\n", csv->fileName);
 				return;
 			}
-			line = (Line*)cpo_array_get_at(csv->lines, j);
-			token = zstring_strtok_dquotes(utstring_body(line), csv->sep, csv->quote, &nextToken);
-			for (k = 0; k < field[1] - 1; k++) {
-				// Ignore leading tokens
-				token = zstring_strtok_dquotes(NULL, csv->sep, csv->quote, &nextToken);
+			ED_TRACE_PARSE_BEGIN("buildTable", csv->fileName);
+			csv->table = ED_tableCreate();
+			if (csv->table == NULL || 0 != (csv->quoted ?
+				buildTableQuoted(csv, csv->table) : buildTableUnquoted(csv, csv->table))) {
+				ED_tableFree(csv->table);
+				csv->table = NULL;
+				ModelicaError("Memory allocation error\n");
+				return;
 			}
-			for (j = 0; j < n; j++) {
-				if (token != NULL) {
-					size_t len;
-					if (token[0] == csv->sep[0]) {
-						a[i*n + j] = 0.;
-						continue;
-					}
-					len = strlen(token);
-					if (token[0] == csv->quote && token[len - 1] == csv->quote) {
-						token[0] = ' ';
-						token[len - 1] = '\0';
-					}
-					if (ED_strtod(token, csv->loc, &a[i*n + j])) {
+			if (ED_tableCompressionEnabled()) {
+				(void)ED_tableCompress(csv->table);
+			}
+			ED_TRACE_PARSE_END("buildTable", csv->fileName, 0);
+			freeLines(csv);
+		}
+		if (m > 0 && row + m > ED_tableRows(csv->table)) {
+			size_t i = ED_tableRows(csv->table) > row ? ED_tableRows(csv->table) - row : 0;
+			ModelicaFormatError("Error in line %i: Cannot read line from file \"%s\"\n",
+				field[0] + (int)i, csv->fileName);
+			return;
+		}
+		if (0 != ED_tableGetDoubleArray2D(csv->table, row, col, m, n, a)) {
+			size_t i, j;
+			/* Report the first field that is not numeric */
+			for (i = 0; i < m; i++) {
+				for (j = 0; j < n; j++) {
+					const char* token = ED_tableGetString(csv->table, row + i, col + j);
+					if (token != NULL) {
 						ModelicaFormatError("Error in line %i: Cannot read double value \"%s\" at column %i from file \"%s\"\n",
 							field[0] + (int)i, token, field[1] + (int)j, csv->fileName);
 						return;
 					}
-					token = zstring_strtok_dquotes(NULL, csv->sep, csv->quote, &nextToken);
-				}
-				else {
-					ModelicaFormatError("Error in line %i: Cannot read double value at column %i from file \"%s\"\n",
-						field[0] + (int)i, field[1] + (int)j, csv->fileName);
+					if (ED_tableCellType(csv->table, row + i, col + j) == ED_TABLE_EMPTY) {
+						ModelicaFormatError("Error in line %i: Cannot read double value at column %i from file \"%s\"\n",
+							field[0] + (int)i, field[1] + (int)j, csv->fileName);
+						return;
+					}
 				}
 			}
 		}
+		ED_TRACE_GET_END(csv->fileName, "", m*n);
+		ED_trimLeave(csv->trim);
 	}
 }
@@ -29,30 +29,57 @@
 #endif
 
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
 #if defined(_MSC_VER)
 #define strdup _strdup
 #endif
 #include "ED_locale.h"
+#include "ED_parallel.h"
+#include "ED_share.h"
+#include "ED_trace.h"
+#include "ED_scan.h"
+#include "ED_vfile.h"
 #include "array.h"
 #define INI_BUFFERSIZE 1024
 #include "minIni.h"
 #include "ModelicaUtilities.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_INIFile.h"
 
 typedef struct {
 	char* key;
 	char* value;
+	double* values; /* Numeric array of the value, NULL until it is read */
+	size_t rows;
+	size_t cols;
+	char* delimiter; /* Column delimiters the array is read with */
+	char* rowDelimiter; /* Row delimiters the array is read with */
 } INIPair;
 
+/* Byte range of the lines of a section after its header */
+typedef struct {
+	size_t start;
+	size_t end;
+} INIRange;
+
 typedef struct {
 	char* name;
-	cpo_array_t* pairs;
+	cpo_array_t* pairs; /* NULL until the section is read */
+	size_t range; /* First range of the section in the section index */
+	size_t nRanges; /* 0 for overlays, whose pairs are read at once */
 } INISection;
 
-typedef struct {
+typedef struct INIFile {
 	char* fileName;
 	ED_LOCALE_TYPE loc;
-	cpo_array_t* sections;
+	cpo_array_t* sections; /* Sorted section index of a file */
+	INIRange* ranges; /* Ranges of the sections in the order of the index */
+	char* text; /* Text of a compressed file or archive member, NULL for plain files */
+	size_t textLen; /* Length of text */
+	struct INIFile* base; /* Base of an overlay, NULL otherwise */
+	int refCount; /* Number of owners, i.e. the callers and overlays */
+	ED_TrimEntry* trim; /* NULL for overlays */
 } INIFile;
 
 static int compareSection(const void *a, const void *b)
@@ -67,16 +94,40 @@ static int compareKey(const void *a, const void *b)
 
 static INISection* findSection(INIFile* ini, const char* name)
 {
-	INISection tmpSection = {(char*)name, NULL};
-	INISection* ret = (INISection*)cpo_array_bsearch(ini->sections, &tmpSection, compareSection);
-	return ret;
+	INISection tmpSection = {(char*)name, NULL, 0, 0};
+	if (ini->base == NULL) {
+		/* The section index of a file is sorted when it is built */
+		return (INISection*)bsearch(&tmpSection, ini->sections->v, ini->sections->num,
+			sizeof(INISection), compareSection);
+	}
+	return (INISection*)cpo_array_bsearch(ini->sections, &tmpSection, compareSection);
 }
 
 static INIPair* findKey(INISection* section, const char* key)
 {
-	INIPair tmpPair = {(char*)key, NULL};
-	INIPair* ret = (INIPair*)cpo_array_bsearch(section->pairs, &tmpPair, compareKey);
-	return ret;
+	INIPair tmpPair = {(char*)key, NULL, NULL, 0, 0, NULL, NULL};
+	if (section->nRanges > 0) {
+		/* The pairs of an indexed section are sorted when they are read */
+		return (INIPair*)bsearch(&tmpPair, section->pairs->v, section->pairs->num,
+			sizeof(INIPair), compareKey);
+	}
+	return (INIPair*)cpo_array_bsearch(section->pairs, &tmpPair, compareKey);
+}
+
+static int pushPair(INISection* section, const char *key, const char *value)
+{
+	INIPair* pair = (INIPair*)cpo_array_push(section->pairs);
+	if (pair == NULL) {
+		return 0;
+	}
+	pair->key = (key != NULL) ? strdup(key) : NULL;
+	pair->value = (value != NULL) ? strdup(value) : NULL;
+	pair->values = NULL;
+	pair->rows = 0;
+	pair->cols = 0;
+	pair->delimiter = NULL;
+	pair->rowDelimiter = NULL;
+	return (key == NULL || pair->key != NULL) && (value == NULL || pair->value != NULL);
 }
 
 /* Callback function for ini_browse */
@@ -84,21 +135,279 @@ static int fillValues(const char *section, const char *key, const char *value, c
 {
 	INIFile* ini = (INIFile*)userdata;
 	if (ini != NULL) {
-		INIPair* pair;
 		INISection* _section = findSection(ini, section);
 		if (_section == NULL) {
 			_section = (INISection*)cpo_array_push(ini->sections);
+			if (_section == NULL) {
+				return 0;
+			}
 			_section->name = (section != NULL) ? strdup(section) : NULL;
 			_section->pairs = cpo_array_create(4 , sizeof(INIPair));
+			_section->range = 0;
+			_section->nRanges = 0;
+			if (_section->pairs == NULL) {
+				return 0;
+			}
 		}
-		pair = (INIPair*)cpo_array_push(_section->pairs);
-		pair->key = (key != NULL) ? strdup(key) : NULL;
-		pair->value = (value != NULL) ? strdup(value) : NULL;
-		return 1;
+		return pushPair(_section, key, value);
 	}
 	return 0;
 }
 
+/* Callback function to fill the pairs of a single section */
+static int fillSection(const char *section, const char *key, const char *value, const void *userdata)
+{
+	(void)section;
+	return pushPair((INISection*)userdata, key, value);
+}
+
+static void freeArray(INIPair* pair)
+{
+	free(pair->values);
+	free(pair->delimiter);
+	free(pair->rowDelimiter);
+	pair->values = NULL;
+	pair->delimiter = NULL;
+	pair->rowDelimiter = NULL;
+}
+
+static void freePairs(INISection* section)
+{
+	if (section->pairs != NULL) {
+		size_t j;
+		for (j = 0; j < section->pairs->num; j++) {
+			INIPair* pair = (INIPair*)cpo_array_get_at(section->pairs, j);
+			free(pair->key);
+			free(pair->value);
+			freeArray(pair);
+		}
+		cpo_array_destroy(section->pairs);
+		section->pairs = NULL;
+	}
+}
+
+static void freeSections(INIFile* ini)
+{
+	if (ini->sections != NULL) {
+		size_t i;
+		for (i = 0; i < ini->sections->num; i++) {
+			INISection* section = (INISection*)cpo_array_get_at(ini->sections, i);
+			free(section->name);
+			freePairs(section);
+		}
+		cpo_array_destroy(ini->sections);
+		ini->sections = NULL;
+	}
+	free(ini->ranges);
+	ini->ranges = NULL;
+	free(ini->text);
+	ini->text = NULL;
+	ini->textLen = 0;
+}
+
+/* Release the section index, the pairs and the decoded text, they are
+ * read again on the next access
+ */
+static void trimINI(void* _ini)
+{
+	freeSections((INIFile*)_ini);
+}
+
+typedef struct {
+	char* name;
+	INIRange range;
+} INIIndexEntry;
+
+static int compareIndexEntry(const void *a, const void *b)
+{
+	const INIIndexEntry* entryA = (const INIIndexEntry*)a;
+	const INIIndexEntry* entryB = (const INIIndexEntry*)b;
+	int ret = strcmp(entryA->name, entryB->name);
+	if (ret != 0) {
+		return ret;
+	}
+	return entryA->range.start < entryB->range.start ? -1 :
+		entryA->range.start > entryB->range.start;
+}
+
+/* Append the section name of length len starting at its byte range */
+static int pushIndexEntry(cpo_array_t* entries, const char* name, size_t len, size_t start)
+{
+	INIIndexEntry* entry = (INIIndexEntry*)cpo_array_push(entries);
+	if (entry == NULL) {
+		return 0;
+	}
+	entry->name = (char*)malloc(len + 1);
+	if (entry->name == NULL) {
+		entries->num--;
+		return 0;
+	}
+	memcpy(entry->name, name, len);
+	entry->name[len] = '\0';
+	entry->range.start = start;
+	return 1;
+}
+
+/* Check if the lines of the INI text [text, end) have a key */
+static int hasKeys(const char* text, const char* end)
+{
+	const char* line = text;
+	while (line < end) {
+		const char* lineEnd = (const char*)memchr(line, '\n', (size_t)(end - line));
+		const char* sp = line;
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+		while (sp < lineEnd && '\0' < *sp && *sp <= ' ') {
+			sp++;
+		}
+		if (sp < lineEnd && *sp != ';' && *sp != '#' &&
+			(memchr(sp, '=', (size_t)(lineEnd - sp)) != NULL ||
+			memchr(sp, ':', (size_t)(lineEnd - sp)) != NULL)) {
+			return 1;
+		}
+		line = lineEnd + 1;
+	}
+	return 0;
+}
+
+/* Build the sorted section index of the INI text of length len by the
+ * rules of ini_browse, without reading the keys. Section headers are
+ * found by a sweep for '[' at the start of a line. The lines before the
+ * first header form the empty section if there is any key line.
+ */
+static int buildIndex(INIFile* ini, const char* text, size_t len)
+{
+	cpo_array_t* entries = cpo_array_create(16, sizeof(INIIndexEntry));
+	const char* end = text + len;
+	const char* p = text;
+	size_t i, j;
+	int ok = entries != NULL;
+
+	while (ok) {
+		const char* lineStart;
+		const char* lineEnd;
+		const char* q;
+		p = (const char*)memchr(p, '[', (size_t)(end - p));
+		if (p == NULL) {
+			break;
+		}
+		/* Only blanks may precede the bracket on its line */
+		for (q = p; q > text && '\0' < q[-1] && q[-1] <= ' ' && q[-1] != '\n'; q--) {
+		}
+		lineStart = q;
+		lineEnd = (const char*)memchr(p, '\n', (size_t)(end - p));
+		if (lineEnd == NULL) {
+			lineEnd = end;
+		}
+		if (lineStart == text || lineStart[-1] == '\n') {
+			const char* bracket = (const char*)memchr(p, ']', (size_t)(lineEnd - p));
+			if (bracket != NULL) {
+				if (entries->num == 0) {
+					/* Lines before the first header */
+					if (hasKeys(text, lineStart)) {
+						ok = pushIndexEntry(entries, "", 0, 0);
+						if (ok) {
+							((INIIndexEntry*)cpo_array_get_at(entries, 0))->range.end = (size_t)(lineStart - text);
+						}
+					}
+				}
+				else {
+					((INIIndexEntry*)cpo_array_get_at(entries, entries->num - 1))->range.end = (size_t)(lineStart - text);
+				}
+				if (ok) {
+					ok = pushIndexEntry(entries, p + 1, (size_t)(bracket - p - 1),
+						(size_t)(lineEnd - text) + (lineEnd < end ? 1 : 0));
+				}
+			}
+		}
+		p = lineEnd;
+	}
+	if (ok && entries->num > 0) {
+		((INIIndexEntry*)cpo_array_get_at(entries, entries->num - 1))->range.end = len;
+	}
+	else if (ok && hasKeys(text, end)) {
+		/* File without section header */
+		ok = pushIndexEntry(entries, "", 0, 0);
+		if (ok) {
+			((INIIndexEntry*)cpo_array_get_at(entries, 0))->range.end = len;
+		}
+	}
+
+	/* Merge the ranges of repeated sections */
+	if (ok) {
+		cpo_array_qsort(entries, compareIndexEntry);
+		ini->sections = cpo_array_create(entries->num > 0 ? entries->num : 1, sizeof(INISection));
+		ini->ranges = (INIRange*)malloc((entries->num > 0 ? entries->num : 1)*sizeof(INIRange));
+		ok = ini->sections != NULL && ini->ranges != NULL;
+	}
+	for (i = 0; ok && i < entries->num; i = j) {
+		INIIndexEntry* entry = (INIIndexEntry*)cpo_array_get_at(entries, i);
+		INISection* section = (INISection*)cpo_array_push(ini->sections);
+		section->name = entry->name;
+		section->pairs = NULL;
+		section->range = i;
+		entry->name = NULL;
+		for (j = i; j < entries->num; j++) {
+			INIIndexEntry* next = (INIIndexEntry*)cpo_array_get_at(entries, j);
+			if (next->name != NULL && strcmp(next->name, section->name) != 0) {
+				break;
+			}
+			ini->ranges[j] = next->range;
+			free(next->name);
+			next->name = NULL;
+		}
+		section->nRanges = j - i;
+	}
+	if (entries != NULL) {
+		for (i = 0; i < entries->num; i++) {
+			free(((INIIndexEntry*)cpo_array_get_at(entries, i))->name);
+		}
+		cpo_array_destroy(entries);
+	}
+	if (!ok) {
+		freeSections(ini);
+		errno = ENOMEM;
+	}
+	return ok ? 0 : -1;
+}
+
+/* Read the section index of the INI file, returns -1 and sets errno on
+ * failure
+ */
+static int readIndex(INIFile* ini)
+{
+	ED_VFILE* vf = ED_vfopen(ini->fileName);
+	const char* text;
+	char* buf = NULL;
+	size_t len = 0;
+	int plain;
+	int ret;
+	if (vf == NULL) {
+		return -1;
+	}
+	ED_TRACE_PARSE_BEGIN("readIndex", ini->fileName);
+	plain = ED_vfplain(vf);
+	text = plain ? ED_vfmap(vf, &len) : NULL;
+	if (text == NULL) {
+		text = buf = ED_vfreadall(vf, &len);
+	}
+	ret = text != NULL ? buildIndex(ini, text, len) : -1;
+	if (ret == 0 && !plain) {
+		/* Keep the text for the sections, as reopening would decode the
+		 * whole file (or reopen the archive) on the first access of each
+		 */
+		ini->text = buf;
+		ini->textLen = len;
+	}
+	else {
+		free(buf);
+	}
+	ED_vfclose(vf);
+	ED_TRACE_PARSE_END("readIndex", ini->fileName, len);
+	return ret;
+}
+
 void* ED_createINI(const char* fileName, int verbose)
 {
 	INIFile* ini = (INIFile*)malloc(sizeof(INIFile));
@@ -113,82 +422,401 @@ void* ED_createINI(const char* fileName, int verbose)
 		return NULL;
 	}
 
-	ini->sections = cpo_array_create(1 , sizeof(INISection));
+	ED_TRACE_CREATE_BEGIN("INI", fileName);
+	ini->sections = NULL;
+	ini->ranges = NULL;
+	ini->text = NULL;
+	ini->textLen = 0;
+	ini->base = NULL;
 
 	if (verbose == 1) {
 		/* Print info message, that file is loading */
 		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
 	}
 
-	if (1 != ini_browse(fillValues, ini, fileName)) {
-		cpo_array_destroy(ini->sections);
+	/* Only the section index is read, the keys of a section on its first
+	 * access
+	 */
+	if (0 != readIndex(ini)) {
+		int err = errno;
 		free(ini->fileName);
 		free(ini);
-		ModelicaFormatError("Cannot read \"%s\"\n", fileName);
+		if (err == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
+		else {
+			ModelicaFormatError("Cannot read \"%s\"\n", fileName);
+		}
 		return NULL;
 	}
 	ini->loc = ED_INIT_LOCALE;
+	ini->refCount = 1;
+	ini->trim = ED_trimRegister(ini, trimINI);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("INI", fileName, ini);
 	return ini;
 }
 
 void ED_destroyINI(void* _ini)
 {
 	INIFile* ini = (INIFile*)_ini;
-	if (ini != NULL) {
+	if (ini != NULL && ED_shareRelease(ini, &ini->refCount)) {
+		ED_TRACE_DESTROY("INI", ini->fileName);
 		if (ini->fileName != NULL) {
 			free(ini->fileName);
 		}
 		ED_FREE_LOCALE(ini->loc);
-		if (ini->sections != NULL) {
-			size_t i;
-			for (i = 0; i < ini->sections->num; i++) {
-				INISection* section = (INISection*)cpo_array_get_at(ini->sections, i);
-				free(section->name);
-				if (section->pairs != NULL) {
-					size_t j;
-					for (j = 0; j < section->pairs->num; j++) {
-						INIPair* pair = (INIPair*)cpo_array_get_at(section->pairs, j);
-						free(pair->key);
-						free(pair->value);
-					}
-					cpo_array_destroy(section->pairs);
+		ED_trimUnregister(ini->trim);
+		freeSections(ini);
+		if (ini->base != NULL) {
+			ED_destroyINI(ini->base);
+		}
+		free(ini);
+		ED_parallelRelease();
+	}
+}
+
+static char* stripTrailing(char* str)
+{
+	char* p = str + strlen(str);
+	while (p > str && '\0' < p[-1] && p[-1] <= ' ') {
+		p--;
+	}
+	*p = '\0';
+	return str;
+}
+
+/* Call func for the values of the INI text buf, which is modified, by the
+ * rules of ini_browse, starting in section
+ */
+static int browseText(char* buf, const char* section, INI_CALLBACK func, const void* userdata)
+{
+	char* line = buf;
+	while (line != NULL) {
+		char* sp = line;
+		char* ep;
+		char* value;
+		int isString = 0;
+		line = strpbrk(line, "\r\n");
+		if (line != NULL) {
+			*line++ = '\0';
+		}
+		while ('\0' < *sp && *sp <= ' ') {
+			sp++;
+		}
+		/* Ignore empty lines and comments */
+		if (*sp == '\0' || *sp == ';' || *sp == '#') {
+			continue;
+		}
+		ep = strchr(sp, ']');
+		if (*sp == '[' && ep != NULL) {
+			*ep = '\0';
+			section = sp + 1;
+			continue;
+		}
+		ep = strchr(sp, '=');
+		if (ep == NULL) {
+			ep = strchr(sp, ':');
+		}
+		if (ep == NULL) {
+			continue;
+		}
+		*ep++ = '\0';
+		stripTrailing(sp);
+		while ('\0' < *ep && *ep <= ' ') {
+			ep++;
+		}
+		/* Remove a trailing comment and surrounding double quotes */
+		value = ep;
+		for (; *ep != '\0' && ((*ep != ';' && *ep != '#') || isString); ep++) {
+			if (*ep == '"') {
+				if (ep[1] == '"') {
+					ep++;
+				}
+				else {
+					isString = !isString;
 				}
 			}
-			cpo_array_destroy(ini->sections);
+			else if (*ep == '\\' && ep[1] == '"') {
+				ep++;
+			}
 		}
+		*ep = '\0';
+		stripTrailing(value);
+		ep = value + strlen(value);
+		if (*value == '"' && ep > value + 1 && ep[-1] == '"') {
+			char* p = ++value;
+			char* q = value;
+			*--ep = '\0';
+			while (*p != '\0') {
+				if ((*p == '"' || *p == '\\') && p[1] == '"') {
+					p++;
+				}
+				*q++ = *p++;
+			}
+			*q = '\0';
+		}
+		if (!func(section, sp, value, userdata)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Fill the values of the INI text str by the rules of ini_browse */
+static int parseValues(INIFile* ini, const char* str)
+{
+	char* buf = strdup(str);
+	int ret;
+	if (buf == NULL) {
+		return 0;
+	}
+	ret = browseText(buf, "", fillValues, ini);
+	free(buf);
+	return ret;
+}
+
+/* Read the pairs of an indexed section from its byte ranges of the INI
+ * file, returns -1 and sets errno on failure
+ */
+static int readSection(INIFile* ini, INISection* section)
+{
+	ED_VFILE* vf = NULL;
+	const char* text;
+	size_t len = 0;
+	size_t parsed = 0;
+	size_t i;
+	int ret = 0;
+
+	section->pairs = cpo_array_create(4, sizeof(INIPair));
+	if (section->pairs == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	if (ini->text != NULL) {
+		text = ini->text;
+		len = ini->textLen;
+	}
+	else {
+		/* Plain files are mapped again */
+		vf = ED_vfopen(ini->fileName);
+		if (vf == NULL) {
+			freePairs(section);
+			return -1;
+		}
+		text = ED_vfmap(vf, &len);
+	}
+	ED_TRACE_PARSE_BEGIN("readSection", ini->fileName);
+	for (i = 0; i < section->nRanges && ret == 0; i++) {
+		INIRange range = ini->ranges[section->range + i];
+		size_t n = range.end - range.start;
+		char* buf = (char*)malloc(n + 1);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			ret = -1;
+		}
+		else if (text != NULL && range.end <= len) {
+			memcpy(buf, text + range.start, n);
+		}
+		else if (vf == NULL || range.start > LONG_MAX || ED_vfseek(vf, (long)range.start) != 0 ||
+			ED_vfread(buf, n, vf) != n) {
+			errno = EIO;
+			ret = -1;
+		}
+		if (ret == 0) {
+			buf[n] = '\0';
+			parsed += n;
+			if (!browseText(buf, section->name, fillSection, section)) {
+				errno = ENOMEM;
+				ret = -1;
+			}
+		}
+		free(buf);
+	}
+	ED_vfclose(vf);
+	ED_TRACE_PARSE_END("readSection", ini->fileName, parsed);
+	if (ret == 0) {
+		cpo_array_qsort(section->pairs, compareKey);
+	}
+	else {
+		freePairs(section);
+	}
+	return ret;
+}
+
+/* Overlay of base with the values of the INI file fileName or, if NULL,
+ * of the INI text str
+ */
+static INIFile* createOverlay(INIFile* base, const char* fileName, const char* str, int verbose)
+{
+	INIFile* ini = (INIFile*)malloc(sizeof(INIFile));
+	if (ini == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	ini->fileName = strdup(fileName != NULL ? fileName : base->fileName);
+	if (ini->fileName == NULL) {
 		free(ini);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	ini->sections = cpo_array_create(1 , sizeof(INISection));
+	ini->ranges = NULL;
+	ini->text = NULL;
+	ini->textLen = 0;
+	ini->base = base;
+
+	if (fileName != NULL) {
+		if (verbose == 1) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+		}
+		ED_TRACE_PARSE_BEGIN("ini_browse", fileName);
+		if (1 != ini_browse(fillValues, ini, fileName)) {
+			freeSections(ini);
+			free(ini->fileName);
+			free(ini);
+			ModelicaFormatError("Cannot read \"%s\"\n", fileName);
+			return NULL;
+		}
+		ED_TRACE_PARSE_END("ini_browse", fileName, 0);
+	}
+	ini->loc = ED_INIT_LOCALE;
+	ini->refCount = 1;
+	ini->trim = NULL;
+	ED_parallelAcquire();
+	if (fileName == NULL && !parseValues(ini, str)) {
+		/* No reference of base is taken yet */
+		ini->base = NULL;
+		ED_destroyINI(ini);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
 	}
+	ED_shareRetain(&base->refCount);
+	return ini;
 }
 
-double ED_getDoubleFromINI(void* _ini, const char* varName, const char* section)
+void* ED_createINIOverlay(void* _base, const char* fileName, const char* overrides, int verbose)
 {
-	double ret = 0.;
-	INIFile* ini = (INIFile*)_ini;
-	if (ini != NULL) {
-		INISection* _section = findSection(ini, section);
+	INIFile* base = (INIFile*)_base;
+	INIFile* ini = base;
+	if (base == NULL) {
+		return NULL;
+	}
+	ED_TRACE_CREATE_BEGIN("INIOverlay", fileName != NULL ? fileName : "");
+	if (fileName != NULL && strlen(fileName) > 0) {
+		ini = createOverlay(base, fileName, NULL, verbose);
+	}
+	if (ini != NULL && overrides != NULL && strlen(overrides) > 0) {
+		INIFile* overlay = createOverlay(ini, NULL, overrides, verbose);
+		if (ini != base) {
+			/* The overrides hold the reference of the file overlay */
+			ED_destroyINI(ini);
+		}
+		ini = overlay;
+	}
+	if (ini == base) {
+		ED_shareRetain(&base->refCount);
+	}
+	ED_TRACE_CREATE_END("INIOverlay", fileName != NULL ? fileName : "", ini);
+	return ini;
+}
+
+void* ED_createINIWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose)
+{
+	/* The base is shared by all variants of the file */
+	INIFile* base = (INIFile*)ED_shareFind("INI", fileName);
+	void* ini;
+	if (base == NULL) {
+		INIFile* created = (INIFile*)ED_createINI(fileName, verbose);
+		base = (INIFile*)ED_shareAdd(created, &created->refCount, "INI", fileName);
+		if (base != created) {
+			ED_destroyINI(created);
+		}
+	}
+	ini = ED_createINIOverlay(base, overlayFileName, overrides, verbose);
+	ED_destroyINI(base);
+	return ini;
+}
+
+/* Pair of key varName in section of the overrides of the overlays or else
+ * of the base, ini is set to the handle providing it
+ */
+static INIPair* findPair(INIFile** ini, const char* varName, const char* section)
+{
+	INISection* _section;
+	while ((*ini)->base != NULL) {
+		_section = findSection(*ini, section);
 		if (_section != NULL) {
 			INIPair* pair = findKey(_section, varName);
 			if (pair != NULL) {
-				if (ED_strtod(pair->value, ini->loc, &ret)) {
-					ModelicaFormatError("Cannot read double value \"%s\" from file \"%s\"\n",
-						pair->value, ini->fileName);
-				}
-			}
-			else {
-				ModelicaFormatError("Cannot read key \"%s\" from file \"%s\"\n",
-					varName, ini->fileName);
+				return pair;
 			}
 		}
+		*ini = (*ini)->base;
+	}
+	ED_trimEnter((*ini)->trim);
+	if ((*ini)->sections == NULL && 0 != readIndex(*ini)) {
+		if (errno == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
 		else {
-			if (strlen(section) > 0) {
-				ModelicaFormatError("Cannot read section \"%s\" from file \"%s\"\n",
-					section, ini->fileName);
-			}
-			else {
-				ModelicaFormatError("Cannot read empty section from file \"%s\"\n",
-					ini->fileName);
+			ModelicaFormatError("Cannot read \"%s\"\n", (*ini)->fileName);
+		}
+		return NULL;
+	}
+	_section = findSection(*ini, section);
+	if (_section != NULL && _section->pairs == NULL && 0 != readSection(*ini, _section)) {
+		if (errno == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
+		else {
+			ModelicaFormatError("Cannot read \"%s\"\n", (*ini)->fileName);
+		}
+		return NULL;
+	}
+	if (_section != NULL && _section->pairs->num == 0) {
+		/* As for ini_browse, a section without keys does not exist */
+		_section = NULL;
+	}
+	if (_section != NULL) {
+		INIPair* pair = findKey(_section, varName);
+		if (pair != NULL) {
+			return pair;
+		}
+		ModelicaFormatError("Cannot read key \"%s\" from file \"%s\"\n",
+			varName, (*ini)->fileName);
+	}
+	else {
+		if (strlen(section) > 0) {
+			ModelicaFormatError("Cannot read section \"%s\" from file \"%s\"\n",
+				section, (*ini)->fileName);
+		}
+		else {
+			ModelicaFormatError("Cannot read empty section from file \"%s\"\n",
+				(*ini)->fileName);
+		}
+	}
+	return NULL;
+}
+
+double ED_getDoubleFromINI(void* _ini, const char* varName, const char* section)
+{
+	double ret = 0.;
+	INIFile* ini = (INIFile*)_ini;
+	if (ini != NULL) {
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findPair(&ini, varName, section);
+		if (pair != NULL) {
+			if (ED_strtod(pair->value, ini->loc, &ret)) {
+				ModelicaFormatError("Cannot read double value \"%s\" from file \"%s\"\n",
+					pair->value, ini->fileName);
 			}
 		}
+		ED_TRACE_GET_END(ini->fileName, varName, 1);
+		ED_trimLeave(ini->trim);
 	}
 	return ret;
 }
@@ -197,62 +825,463 @@ const char* ED_getStringFromINI(void* _ini, const char* varName, const char* sec
 {
 	INIFile* ini = (INIFile*)_ini;
 	if (ini != NULL) {
-		INISection* _section = findSection(ini, section);
-		if (_section != NULL) {
-			INIPair* pair = findKey(_section, varName);
-			if (pair != NULL) {
-				char* ret = ModelicaAllocateString(strlen(pair->value));
-				strcpy(ret, pair->value);
-				return (const char*)ret;
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findPair(&ini, varName, section);
+		if (pair != NULL) {
+			char* ret = ModelicaAllocateString(strlen(pair->value));
+			strcpy(ret, pair->value);
+			ED_TRACE_GET_END(ini->fileName, varName, 1);
+			ED_trimLeave(ini->trim);
+			return (const char*)ret;
+		}
+	}
+	return "";
+}
+
+int ED_getIntFromINI(void* _ini, const char* varName, const char* section)
+{
+	long ret = 0;
+	INIFile* ini = (INIFile*)_ini;
+	if (ini != NULL) {
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findPair(&ini, varName, section);
+		if (pair != NULL) {
+			if (ED_strtol(pair->value, ini->loc, &ret)) {
+				ModelicaFormatError("Cannot read int value \"%s\" from file \"%s\"\n",
+					pair->value, ini->fileName);
 			}
-			else {
-				ModelicaFormatError("Cannot read key \"%s\" from file \"%s\"\n",
-					varName, ini->fileName);
+		}
+		ED_TRACE_GET_END(ini->fileName, varName, 1);
+		ED_trimLeave(ini->trim);
+	}
+	return (int)ret;
+}
+
+/* Convert the token [p, end), which is temporarily terminated for the
+ * forms the decimal scan does not cover, e.g., inf, nan or hexadecimal
+ */
+static int scanDouble(char* p, char* end, ED_LOCALE_TYPE loc, double* val)
+{
+	char c;
+	int ret;
+	if (ED_scanDecimal(p, end, val)) {
+		return ED_OK;
+	}
+	c = *end;
+	*end = '\0';
+	ret = ED_strtod(p, loc, val);
+	*end = c;
+	return ret;
+}
+
+enum {
+	CHAR_VALUE = 0,
+	CHAR_BLANK,
+	CHAR_COLUMN,
+	CHAR_ROW,
+	CHAR_END
+};
+
+/* Read the value of pair into its packed numeric array. The columns are
+ * separated by any character of delimiter, the rows by any character of
+ * rowDelimiter. Blanks around the numbers are skipped, and separate the
+ * columns if delimiter has a blank. A value without row delimiter is a
+ * column vector. Returns -1 and sets errno on failure, the token that is
+ * not numeric is returned in bad and badLen.
+ */
+static int readArray(INIPair* pair, const char* delimiter, const char* rowDelimiter,
+	ED_LOCALE_TYPE loc, const char** bad, size_t* badLen)
+{
+	unsigned char type[256];
+	char* p = pair->value;
+	size_t nMax = strlen(p)/2 + 1; /* At most every other character starts a number */
+	size_t n = 0;
+	size_t rows = 0;
+	size_t cols = 0;
+	size_t rowStart = 0;
+	size_t i;
+	int hasRows = 0;
+	int blankSep = strchr(delimiter, ' ') != NULL || strchr(delimiter, '\t') != NULL;
+	double* values;
+
+	memset(type, CHAR_VALUE, sizeof(type));
+	for (; *rowDelimiter != '\0'; rowDelimiter++) {
+		type[(unsigned char)*rowDelimiter] = CHAR_ROW;
+	}
+	for (; *delimiter != '\0'; delimiter++) {
+		type[(unsigned char)*delimiter] = CHAR_COLUMN;
+	}
+	for (i = 1; i <= ' '; i++) {
+		type[i] = CHAR_BLANK;
+	}
+	type[0] = CHAR_END;
+
+	values = (double*)malloc(nMax*sizeof(double));
+	if (values == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	while (type[(unsigned char)*p] == CHAR_BLANK) {
+		p++;
+	}
+	while (*p != '\0') {
+		char* q = p;
+		int t;
+		int ret;
+		while (type[(unsigned char)*q] == CHAR_VALUE) {
+			q++;
+		}
+		ret = q > p ? scanDouble(p, q, loc, &values[n]) : ED_ERROR;
+		if (ret != ED_OK) {
+			free(values);
+			*bad = p;
+			*badLen = (size_t)(q - p);
+			errno = ret == ED_OOM ? ENOMEM : EDOM;
+			return -1;
+		}
+		n++;
+		p = q;
+		while (type[(unsigned char)*p] == CHAR_BLANK) {
+			p++;
+		}
+		t = type[(unsigned char)*p];
+		if (t == CHAR_VALUE && !(blankSep && p > q)) {
+			for (q = p; type[(unsigned char)*q] == CHAR_VALUE; q++) {
 			}
+			free(values);
+			*bad = p;
+			*badLen = (size_t)(q - p);
+			errno = EDOM;
+			return -1;
 		}
-		else {
-			if (strlen(section) > 0) {
-				ModelicaFormatError("Cannot read section \"%s\" from file \"%s\"\n",
-					section, ini->fileName);
+		if (t == CHAR_ROW || t == CHAR_END) {
+			if (rows > 0 && n - rowStart != cols) {
+				free(values);
+				errno = ERANGE;
+				return -1;
+			}
+			cols = n - rowStart;
+			rowStart = n;
+			rows++;
+			hasRows |= t == CHAR_ROW;
+		}
+		if (t == CHAR_ROW || t == CHAR_COLUMN) {
+			/* A separator is followed by a number */
+			for (p++; type[(unsigned char)*p] == CHAR_BLANK; p++) {
+			}
+			if (*p == '\0') {
+				free(values);
+				*bad = p;
+				*badLen = 0;
+				errno = EDOM;
+				return -1;
+			}
+		}
+	}
+	if (!hasRows && rows == 1) {
+		rows = cols;
+		cols = 1;
+	}
+	if (n < nMax) {
+		double* tmp = (double*)realloc(values, (n > 0 ? n : 1)*sizeof(double));
+		if (tmp != NULL) {
+			values = tmp;
+		}
+	}
+	pair->values = values;
+	pair->rows = rows;
+	pair->cols = cols;
+	return 0;
+}
+
+/* Pair of key varName in section with its numeric array, which is read on
+ * the first access and again only for other delimiters
+ */
+static INIPair* findArray(INIFile** ini, const char* varName, const char* section,
+	const char* delimiter, const char* rowDelimiter)
+{
+	INIPair* pair = findPair(ini, varName, section);
+	if (pair != NULL && pair->values != NULL &&
+		(strcmp(pair->delimiter, delimiter) != 0 || strcmp(pair->rowDelimiter, rowDelimiter) != 0)) {
+		freeArray(pair);
+	}
+	if (pair != NULL && pair->values == NULL) {
+		const char* bad = NULL;
+		size_t badLen = 0;
+		pair->delimiter = strdup(delimiter);
+		pair->rowDelimiter = strdup(rowDelimiter);
+		if (pair->delimiter == NULL || pair->rowDelimiter == NULL) {
+			freeArray(pair);
+			ModelicaError("Memory allocation error\n");
+			return NULL;
+		}
+		if (0 != readArray(pair, delimiter, rowDelimiter, (*ini)->loc, &bad, &badLen)) {
+			int err = errno;
+			freeArray(pair);
+			if (err == ENOMEM) {
+				ModelicaError("Memory allocation error\n");
+			}
+			else if (err == ERANGE) {
+				ModelicaFormatError("Cannot read array of key \"%s\" from file \"%s\": "
+					"Rows of different length\n", varName, (*ini)->fileName);
 			}
 			else {
-				ModelicaFormatError("Cannot read empty section from file \"%s\"\n",
-					ini->fileName);
+				ModelicaFormatError("Cannot read double value \"%.*s\" of key \"%s\" from file \"%s\"\n",
+					(int)badLen, bad, varName, (*ini)->fileName);
 			}
+			return NULL;
 		}
 	}
-	return "";
+	return pair;
 }
 
-int ED_getIntFromINI(void* _ini, const char* varName, const char* section)
+void ED_getArray2DSizeFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, int* dim)
 {
-	long ret = 0;
 	INIFile* ini = (INIFile*)_ini;
+	dim[0] = 0;
+	dim[1] = 0;
 	if (ini != NULL) {
-		INISection* _section = findSection(ini, section);
-		if (_section != NULL) {
-			INIPair* pair = findKey(_section, varName);
-			if (pair != NULL) {
-				if (ED_strtol(pair->value, ini->loc, &ret)) {
-					ModelicaFormatError("Cannot read int value \"%s\" from file \"%s\"\n",
-						pair->value, ini->fileName);
-				}
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findArray(&ini, varName, section, delimiter, rowDelimiter);
+		if (pair != NULL) {
+			dim[0] = (int)pair->rows;
+			dim[1] = (int)pair->cols;
+		}
+		ED_TRACE_GET_END(ini->fileName, varName, 0);
+		ED_trimLeave(ini->trim);
+	}
+}
+
+void ED_getDoubleArray1DFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, double* a, size_t m)
+{
+	INIFile* ini = (INIFile*)_ini;
+	if (ini != NULL) {
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findArray(&ini, varName, section, delimiter, rowDelimiter);
+		if (pair != NULL) {
+			if (m > pair->rows*pair->cols) {
+				ModelicaFormatError("Cannot read %lu double values of key \"%s\" from file \"%s\"\n",
+					(unsigned long)m, varName, ini->fileName);
+				return;
 			}
-			else {
-				ModelicaFormatError("Cannot read key \"%s\" from file \"%s\"\n",
-					varName, ini->fileName);
+			if (m > 0) {
+				memcpy(a, pair->values, m*sizeof(double));
 			}
 		}
-		else {
-			if (strlen(section) > 0) {
-				ModelicaFormatError("Cannot read section \"%s\" from file \"%s\"\n",
-					section, ini->fileName);
+		ED_TRACE_GET_END(ini->fileName, varName, m);
+		ED_trimLeave(ini->trim);
+	}
+}
+
+void ED_getDoubleArray2DFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, double* a, size_t m, size_t n)
+{
+	INIFile* ini = (INIFile*)_ini;
+	if (ini != NULL) {
+		INIPair* pair;
+		ED_TRACE_GET_BEGIN(ini->fileName, varName);
+		pair = findArray(&ini, varName, section, delimiter, rowDelimiter);
+		if (pair != NULL) {
+			if (m == 1 && pair->cols == 1 && n <= pair->rows) {
+				/* Column vector read as row */
+				memcpy(a, pair->values, n*sizeof(double));
+			}
+			else if (m > pair->rows || n > pair->cols) {
+				ModelicaFormatError("Cannot read %lu x %lu double values of key \"%s\" from file \"%s\"\n",
+					(unsigned long)m, (unsigned long)n, varName, ini->fileName);
+				return;
+			}
+			else if (n == pair->cols) {
+				memcpy(a, pair->values, m*n*sizeof(double));
 			}
 			else {
-				ModelicaFormatError("Cannot read empty section from file \"%s\"\n",
-					ini->fileName);
+				size_t i;
+				for (i = 0; i < m; i++) {
+					memcpy(a + i*n, pair->values + i*pair->cols, n*sizeof(double));
+				}
 			}
 		}
+		ED_TRACE_GET_END(ini->fileName, varName, m*n);
+		ED_trimLeave(ini->trim);
 	}
-	return (int)ret;
+}
+
+enum {
+	BULK_OK = 0,
+	BULK_READ_ERROR,
+	BULK_KEY_ERROR,
+	BULK_VALUE_ERROR,
+	BULK_MEMORY_ERROR
+};
+
+typedef struct {
+	const char* section;
+	const char* key;
+	size_t j; /* Index of the key */
+} INIBulkKey;
+
+typedef struct {
+	size_t i; /* Index of the file */
+	size_t j; /* Index of the key */
+	int type; /* BULK_OK or the kind of error */
+} INIBulkError;
+
+typedef struct {
+	const char** fileNames;
+	size_t n;
+	size_t k;
+	size_t nChunks;
+	INIBulkKey* keys; /* Sorted by section and key */
+	double* a;
+	ED_LOCALE_TYPE loc;
+	INIBulkError* errors; /* First error per chunk */
+} INIBulk;
+
+typedef struct {
+	INIBulk* bulk;
+	size_t i; /* Index of the file */
+	char* found; /* Flags of the keys found in the file */
+	INIBulkError* err;
+} INIBulkFile;
+
+/* Number of chunks of files per thread */
+#define ED_INI_BULK_CHUNKS_PER_THREAD (4)
+
+static int compareBulkKey(const void *a, const void *b)
+{
+	const INIBulkKey* keyA = (const INIBulkKey*)a;
+	const INIBulkKey* keyB = (const INIBulkKey*)b;
+	int ret = strcmp(keyA->section, keyB->section);
+	return ret != 0 ? ret : strcmp(keyA->key, keyB->key);
+}
+
+/* Callback function for ini_browse, only the first value of a key is read */
+static int readBulkValue(const char *section, const char *key, const char *value, const void *userdata)
+{
+	INIBulkFile* file = (INIBulkFile*)userdata;
+	INIBulk* bulk = file->bulk;
+	INIBulkKey tmpKey;
+	INIBulkKey* iter;
+	tmpKey.section = section;
+	tmpKey.key = key;
+	iter = (INIBulkKey*)bsearch(&tmpKey, bulk->keys, bulk->k, sizeof(INIBulkKey), compareBulkKey);
+	if (iter == NULL || file->found[iter->j] != 0) {
+		return 1;
+	}
+	/* Fill all requests of the same key */
+	while (iter > bulk->keys && compareBulkKey(iter - 1, &tmpKey) == 0) {
+		iter--;
+	}
+	for (; iter < bulk->keys + bulk->k && compareBulkKey(iter, &tmpKey) == 0; iter++) {
+		file->found[iter->j] = 1;
+		if (ED_strtod((char*)value, bulk->loc, &bulk->a[file->i*bulk->k + iter->j])) {
+			file->err->type = BULK_VALUE_ERROR;
+			file->err->j = iter->j;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Read the consecutive files of chunk c and stop at the first error */
+static void readBulkChunk(void* data, size_t c)
+{
+	INIBulk* bulk = (INIBulk*)data;
+	INIBulkFile file;
+	size_t iEnd = (c + 1)*bulk->n/bulk->nChunks;
+	file.bulk = bulk;
+	file.i = c*bulk->n/bulk->nChunks;
+	file.found = (char*)malloc(bulk->k);
+	file.err = &bulk->errors[c];
+	file.err->type = file.found != NULL ? BULK_OK : BULK_MEMORY_ERROR;
+	file.err->i = file.i;
+	for (; file.i < iEnd && file.err->type == BULK_OK; file.i++) {
+		size_t j;
+		file.err->i = file.i;
+		memset(file.found, 0, bulk->k);
+		ED_TRACE_PARSE_BEGIN("ini_browse", bulk->fileNames[file.i]);
+		if (1 != ini_browse(readBulkValue, &file, bulk->fileNames[file.i])) {
+			file.err->type = BULK_READ_ERROR;
+			break;
+		}
+		ED_TRACE_PARSE_END("ini_browse", bulk->fileNames[file.i], 0);
+		for (j = 0; j < bulk->k && file.err->type == BULK_OK; j++) {
+			if (file.found[j] == 0) {
+				file.err->type = BULK_KEY_ERROR;
+				file.err->j = j;
+			}
+		}
+	}
+	free(file.found);
+}
+
+void ED_getDoubleArray2DFromINIFiles(const char** fileNames, size_t n, const char** varNames, const char** sections, size_t k, double* a, int verbose)
+{
+	INIBulk bulk;
+	size_t c;
+	if (n == 0 || k == 0) {
+		return;
+	}
+	if (verbose == 1) {
+		for (c = 0; c < n; c++) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileNames[c]);
+		}
+	}
+	bulk.fileNames = fileNames;
+	bulk.n = n;
+	bulk.k = k;
+	bulk.a = a;
+	bulk.nChunks = ED_INI_BULK_CHUNKS_PER_THREAD*ED_parallelThreads();
+	if (bulk.nChunks > n) {
+		bulk.nChunks = n;
+	}
+	bulk.keys = (INIBulkKey*)malloc(k*sizeof(INIBulkKey));
+	bulk.errors = (INIBulkError*)malloc(bulk.nChunks*sizeof(INIBulkError));
+	if (bulk.keys == NULL || bulk.errors == NULL) {
+		free(bulk.keys);
+		free(bulk.errors);
+		ModelicaError("Memory allocation error\n");
+		return;
+	}
+	for (c = 0; c < k; c++) {
+		bulk.keys[c].section = sections[c];
+		bulk.keys[c].key = varNames[c];
+		bulk.keys[c].j = c;
+	}
+	qsort(bulk.keys, k, sizeof(INIBulkKey), compareBulkKey);
+	bulk.loc = ED_INIT_LOCALE;
+	ED_parallelFor(bulk.nChunks, readBulkChunk, &bulk);
+	ED_FREE_LOCALE(bulk.loc);
+	free(bulk.keys);
+
+	/* Report the error of the first file that failed */
+	for (c = 0; c < bulk.nChunks; c++) {
+		INIBulkError err = bulk.errors[c];
+		if (err.type != BULK_OK) {
+			const char* fileName = fileNames[err.i];
+			free(bulk.errors);
+			switch (err.type) {
+				case BULK_READ_ERROR:
+					ModelicaFormatError("Cannot read \"%s\"\n", fileName);
+					break;
+				case BULK_KEY_ERROR:
+					ModelicaFormatError("Cannot read key \"%s\" of section \"%s\" from file \"%s\"\n",
+						varNames[err.j], sections[err.j], fileName);
+					break;
+				case BULK_VALUE_ERROR:
+					ModelicaFormatError("Cannot read double value of key \"%s\" of section \"%s\" from file \"%s\"\n",
+						varNames[err.j], sections[err.j], fileName);
+					break;
+				default:
+					ModelicaError("Memory allocation error\n");
+					break;
+			}
+			return;
+		}
+	}
+	free(bulk.errors);
 }
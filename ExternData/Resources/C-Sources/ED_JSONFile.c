@@ -28,13 +28,22 @@
 #define _GNU_SOURCE 1
 #endif
 
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
 #if defined(_MSC_VER)
 #define strdup _strdup
 #endif
 #include "ED_locale.h"
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_share.h"
+#include "ED_trace.h"
 #include "bsjson.h"
 #include "ModelicaUtilities.h"
+#define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
+#include "uthash.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_JSONFile.h"
 
 /* The standard way to detect posix is to check _POSIX_VERSION,
@@ -56,59 +65,341 @@
 #endif
 
 typedef struct {
+	char* key; /* Normalized variable name */
+	char* value; /* Pair value in the root of the overlay */
+	UT_hash_handle hh; /* Hashable structure */
+} JSONOverride;
+
+typedef struct JSONFile {
 	char* fileName;
 	JsonNodeRef root;
 	ED_LOCALE_TYPE loc;
+	struct JSONFile* base; /* Base of an overlay, NULL otherwise */
+	JSONOverride* overrides; /* Values of an overlay by variable name */
+	int refCount; /* Number of owners, i.e. the callers and overlays */
+	ED_TrimEntry* trim; /* NULL for overlays */
 } JSONFile;
 
-void* ED_createJSON(const char* fileName, int verbose)
+/* Parse the file, errors are raised */
+static JsonNodeRef readJSON(const char* fileName)
 {
 	JsonParser jsonParser;
-	JSONFile* json = (JSONFile*)malloc(sizeof(JSONFile));
+	JsonNodeRef root;
+	ED_VFILE* vf;
+	char* buffer;
+	size_t len;
+	int err;
+
+	vf = ED_vfopen(fileName);
+	if (vf == NULL) {
+		ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(errno));
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("JsonParser_parse", fileName);
+	buffer = ED_vfreadall(vf, &len);
+	err = errno;
+	ED_vfclose(vf);
+	if (buffer == NULL) {
+		ED_TRACE_PARSE_END("JsonParser_parse", fileName, 0);
+		ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(err));
+		return NULL;
+	}
+	root = JsonParser_parseBuffer(&jsonParser, buffer, (long)len);
+	free(buffer);
+	ED_TRACE_PARSE_END("JsonParser_parse", fileName, len);
+	if (root == NULL) {
+		if (JsonParser_getErrorLineSet(&jsonParser) != 0) {
+			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse file \"%s\"\n",
+				JsonParser_getErrorString(&jsonParser), JsonParser_getErrorLine(&jsonParser), fileName);
+		}
+		else {
+			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, JsonParser_getErrorString(&jsonParser));
+		}
+	}
+	return root;
+}
+
+/* Release the tree, it is parsed again on the next access */
+static void trimJSON(void* _json)
+{
+	JSONFile* json = (JSONFile*)_json;
+	JsonNode_deleteTree(json->root);
+	json->root = NULL;
+}
+
+void* ED_createJSON(const char* fileName, int verbose)
+{
+	JsonNodeRef root;
+	JSONFile* json;
+
+	ED_TRACE_CREATE_BEGIN("JSON", fileName);
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	root = readJSON(fileName);
+	json = (JSONFile*)malloc(sizeof(JSONFile));
 	if (json == NULL) {
+		JsonNode_deleteTree(root);
 		ModelicaError("Memory allocation error\n");
 		return NULL;
 	}
 	json->fileName = strdup(fileName);
 	if (json->fileName == NULL) {
+		JsonNode_deleteTree(root);
 		free(json);
 		ModelicaError("Memory allocation error\n");
 		return NULL;
 	}
+	json->root = root;
+	json->loc = ED_INIT_LOCALE;
+	json->base = NULL;
+	json->overrides = NULL;
+	json->refCount = 1;
+	json->trim = ED_trimRegister(json, trimJSON);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("JSON", fileName, json);
+	return json;
+}
 
-	if (verbose == 1) {
-		/* Print info message, that file is loading */
-		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+void ED_destroyJSON(void* _json)
+{
+	JSONFile* json = (JSONFile*)_json;
+	if (json != NULL && ED_shareRelease(json, &json->refCount)) {
+		JSONOverride* iter;
+		JSONOverride* tmp;
+		ED_TRACE_DESTROY("JSON", json->fileName);
+		if (json->fileName != NULL) {
+			free(json->fileName);
+		}
+		ED_trimUnregister(json->trim);
+		JsonNode_deleteTree(json->root);
+		ED_FREE_LOCALE(json->loc);
+		HASH_ITER(hh, json->overrides, iter, tmp) {
+			HASH_DEL(json->overrides, iter);
+			free(iter->key);
+			free(iter);
+		}
+		if (json->base != NULL) {
+			ED_destroyJSON(json->base);
+		}
+		free(json);
+		ED_parallelRelease();
+	}
+}
+
+/* Variable name without empty tokens, as they are skipped by findValue */
+static char* normalizeName(const char* varName)
+{
+	char* key = (char*)malloc(strlen(varName) + 1);
+	if (key != NULL) {
+		const char* p = varName;
+		char* q = key;
+		while (*p != '\0') {
+			if (*p != '.' || (q > key && q[-1] != '.')) {
+				*q++ = *p;
+			}
+			p++;
+		}
+		if (q > key && q[-1] == '.') {
+			q--;
+		}
+		*q = '\0';
+	}
+	return key;
+}
+
+/* Add the pairs of node and its named descendants by their path */
+static int addOverrides(JSONFile* json, JsonNodeRef node, const char* path)
+{
+	size_t len = strlen(path);
+	size_t i;
+	for (i = 0; i < JsonNode_getPairCount(node); i++) {
+		JsonPair* pair = JsonNode_getPair(node, i);
+		if (pair->key != NULL && pair->value != NULL) {
+			JSONOverride* iter;
+			char* key = (char*)malloc(len + strlen(pair->key) + 2);
+			if (key == NULL) {
+				return 0;
+			}
+			sprintf(key, len > 0 ? "%s.%s" : "%s%s", path, pair->key);
+			HASH_FIND_STR(json->overrides, key, iter);
+			if (iter != NULL) {
+				/* First one wins */
+				free(key);
+				continue;
+			}
+			iter = (JSONOverride*)malloc(sizeof(JSONOverride));
+			if (iter == NULL) {
+				free(key);
+				return 0;
+			}
+			iter->key = key;
+			iter->value = pair->value;
+			HASH_ADD_KEYPTR(hh, json->overrides, iter->key, strlen(iter->key), iter);
+		}
+	}
+	for (i = 0; i < JsonNode_getChildCount(node); i++) {
+		JsonNodeRef child = JsonNode_getChild(node, i);
+		if (child->m_name != NULL) {
+			int ok;
+			char* childPath = (char*)malloc(len + strlen(child->m_name) + 2);
+			if (childPath == NULL) {
+				return 0;
+			}
+			sprintf(childPath, len > 0 ? "%s.%s" : "%s%s", path, child->m_name);
+			ok = addOverrides(json, child, childPath);
+			free(childPath);
+			if (!ok) {
+				return 0;
+			}
+		}
 	}
+	return 1;
+}
 
-	json->root = JsonParser_parseFile(&jsonParser, fileName);
+/* Overlay of base with the values of the JSON file fileName or, if NULL,
+ * of the JSON text str
+ */
+static JSONFile* createOverlay(JSONFile* base, const char* fileName, const char* str, int verbose)
+{
+	JsonParser jsonParser;
+	const char* name = fileName != NULL ? fileName : base->fileName;
+	JSONFile* json = (JSONFile*)malloc(sizeof(JSONFile));
+	if (json == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	json->fileName = strdup(name);
+	if (json->fileName == NULL) {
+		free(json);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	if (fileName != NULL) {
+		ED_VFILE* vf;
+		char* buffer;
+		size_t len;
+		int err;
+		if (verbose == 1) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+		}
+		vf = ED_vfopen(fileName);
+		if (vf == NULL) {
+			free(json->fileName);
+			free(json);
+			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(errno));
+			return NULL;
+		}
+		ED_TRACE_PARSE_BEGIN("JsonParser_parse", fileName);
+		buffer = ED_vfreadall(vf, &len);
+		err = errno;
+		ED_vfclose(vf);
+		if (buffer == NULL) {
+			free(json->fileName);
+			free(json);
+			ED_TRACE_PARSE_END("JsonParser_parse", fileName, 0);
+			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(err));
+			return NULL;
+		}
+		json->root = JsonParser_parseBuffer(&jsonParser, buffer, (long)len);
+		free(buffer);
+		ED_TRACE_PARSE_END("JsonParser_parse", fileName, len);
+	}
+	else {
+		json->root = JsonParser_parse(&jsonParser, str);
+	}
 	if (json->root == NULL) {
 		free(json->fileName);
 		free(json);
 		if (JsonParser_getErrorLineSet(&jsonParser) != 0) {
-			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse file \"%s\"\n",
-				JsonParser_getErrorString(&jsonParser), JsonParser_getErrorLine(&jsonParser), fileName);
+			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse overrides of file \"%s\"\n",
+				JsonParser_getErrorString(&jsonParser), JsonParser_getErrorLine(&jsonParser), name);
 		}
 		else {
-			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, JsonParser_getErrorString(&jsonParser));
+			ModelicaFormatError("Cannot read overrides of file \"%s\": %s\n", name, JsonParser_getErrorString(&jsonParser));
 		}
 		return NULL;
 	}
+	json->overrides = NULL;
+	json->base = base;
+	json->refCount = 1;
+	json->trim = NULL;
 	json->loc = ED_INIT_LOCALE;
+	ED_parallelAcquire();
+	if (!addOverrides(json, json->root, "")) {
+		/* No reference of base is taken yet */
+		json->base = NULL;
+		ED_destroyJSON(json);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	ED_shareRetain(&base->refCount);
 	return json;
 }
 
-void ED_destroyJSON(void* _json)
+void* ED_createJSONOverlay(void* _base, const char* fileName, const char* overrides, int verbose)
 {
-	JSONFile* json = (JSONFile*)_json;
-	if (json != NULL) {
-		if (json->fileName != NULL) {
-			free(json->fileName);
+	JSONFile* base = (JSONFile*)_base;
+	JSONFile* json = base;
+	if (base == NULL) {
+		return NULL;
+	}
+	ED_TRACE_CREATE_BEGIN("JSONOverlay", fileName != NULL ? fileName : "");
+	if (fileName != NULL && strlen(fileName) > 0) {
+		json = createOverlay(base, fileName, NULL, verbose);
+	}
+	if (json != NULL && overrides != NULL && strlen(overrides) > 0) {
+		JSONFile* overlay = createOverlay(json, NULL, overrides, verbose);
+		if (json != base) {
+			/* The overrides hold the reference of the file overlay */
+			ED_destroyJSON(json);
+		}
+		json = overlay;
+	}
+	if (json == base) {
+		ED_shareRetain(&base->refCount);
+	}
+	ED_TRACE_CREATE_END("JSONOverlay", fileName != NULL ? fileName : "", json);
+	return json;
+}
+
+void* ED_createJSONWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose)
+{
+	/* The base is shared by all variants of the file */
+	JSONFile* base = (JSONFile*)ED_shareFind("JSON", fileName);
+	void* json;
+	if (base == NULL) {
+		JSONFile* created = (JSONFile*)ED_createJSON(fileName, verbose);
+		base = (JSONFile*)ED_shareAdd(created, &created->refCount, "JSON", fileName);
+		if (base != created) {
+			ED_destroyJSON(created);
 		}
-		JsonNode_deleteTree(json->root);
-		ED_FREE_LOCALE(json->loc);
-		free(json);
 	}
+	json = ED_createJSONOverlay(base, overlayFileName, overrides, verbose);
+	ED_destroyJSON(base);
+	return json;
+}
+
+/* Value of the dotted element name buf (which is modified) below root,
+ * NULL if not found
+ */
+static char* findElement(JsonNodeRef root, char* buf)
+{
+	char* nextToken = NULL;
+	char* token = strtok_r(buf, ".", &nextToken);
+	while (token != NULL && JsonNode_getChildCount(root) > 0) {
+		JsonNodeRef child = JsonNode_findChild(root, token, JSON_OBJ);
+		if (child == NULL) {
+			break;
+		}
+		root = child;
+		token = strtok_r(NULL, ".", &nextToken);
+	}
+	return token != NULL ? JsonNode_getPairValue(root, token) : NULL;
 }
 
 static char* findValue(JsonNodeRef* root, const char* varName, const char* fileName)
@@ -116,41 +407,12 @@ static char* findValue(JsonNodeRef* root, const char* varName, const char* fileN
 	char* token = NULL;
 	char* buf = strdup(varName);
 	if (buf != NULL) {
-		int elementError = 0;
-		char* nextToken = NULL;
-		token = strtok_r(buf, ".", &nextToken);
-		if (token == NULL) {
-			elementError = 1;
-		}
-		while (token != NULL && elementError == 0) {
-			size_t i;
-			int foundToken = 0;
-			for (i = 0; i < JsonNode_getChildCount(*root); i++) {
-				JsonNodeRef child = JsonNode_findChild(*root, token, JSON_OBJ);
-				if (child != NULL) {
-					*root = child;
-					token = strtok_r(NULL, ".", &nextToken);
-					foundToken = 1;
-					break;
-				}
-			}
-			if (foundToken == 0) {
-				elementError = 1;
-			}
-		}
+		token = findElement(*root, buf);
+		free(buf);
 		if (token == NULL) {
-			free(buf);
 			ModelicaFormatError("Cannot read element \"%s\" from file \"%s\"\n",
 				varName, fileName);
 		}
-		else {
-			token = JsonNode_getPairValue(*root, token);
-			free(buf);
-			if (token == NULL) {
-				ModelicaFormatError("Cannot read element \"%s\" from file \"%s\"\n",
-					varName, fileName);
-			}
-		}
 	}
 	else {
 		ModelicaError("Memory allocation error\n");
@@ -158,13 +420,45 @@ static char* findValue(JsonNodeRef* root, const char* varName, const char* fileN
 	return token;
 }
 
+/* Value of varName in the overrides of the overlays or else in the base,
+ * json is set to the handle providing it
+ */
+static char* lookupValue(JSONFile** json, const char* varName)
+{
+	JsonNodeRef root;
+	if ((*json)->base != NULL) {
+		char* key = normalizeName(varName);
+		if (key == NULL) {
+			ModelicaError("Memory allocation error\n");
+			return NULL;
+		}
+		do {
+			JSONOverride* iter;
+			HASH_FIND_STR((*json)->overrides, key, iter);
+			if (iter != NULL) {
+				free(key);
+				return iter->value;
+			}
+			*json = (*json)->base;
+		} while ((*json)->base != NULL);
+		free(key);
+	}
+	ED_trimEnter((*json)->trim);
+	if ((*json)->root == NULL) {
+		(*json)->root = readJSON((*json)->fileName);
+	}
+	root = (*json)->root;
+	return findValue(&root, varName, (*json)->fileName);
+}
+
 double ED_getDoubleFromJSON(void* _json, const char* varName)
 {
 	double ret = 0.;
 	JSONFile* json = (JSONFile*)_json;
 	if (json != NULL) {
-		JsonNodeRef root = json->root;
-		char* token = findValue(&root, varName, json->fileName);
+		char* token;
+		ED_TRACE_GET_BEGIN(json->fileName, varName);
+		token = lookupValue(&json, varName);
 		if (token != NULL) {
 			if (ED_strtod(token, json->loc, &ret)) {
 				ModelicaFormatError("Cannot read double value \"%s\" from file \"%s\"\n",
@@ -175,6 +469,8 @@ double ED_getDoubleFromJSON(void* _json, const char* varName)
 			ModelicaFormatError("Cannot read double value from file \"%s\"\n",
 				json->fileName);
 		}
+		ED_TRACE_GET_END(json->fileName, varName, 1);
+		ED_trimLeave(json->trim);
 	}
 	return ret;
 }
@@ -183,11 +479,14 @@ const char* ED_getStringFromJSON(void* _json, const char* varName)
 {
 	JSONFile* json = (JSONFile*)_json;
 	if (json != NULL) {
-		JsonNodeRef root = json->root;
-		char* token = findValue(&root, varName, json->fileName);
+		char* token;
+		ED_TRACE_GET_BEGIN(json->fileName, varName);
+		token = lookupValue(&json, varName);
 		if (token != NULL) {
 			char* ret = ModelicaAllocateString(strlen(token));
 			strcpy(ret, token);
+			ED_TRACE_GET_END(json->fileName, varName, 1);
+			ED_trimLeave(json->trim);
 			return (const char*)ret;
 		}
 		else {
@@ -203,8 +502,9 @@ int ED_getIntFromJSON(void* _json, const char* varName)
 	long ret = 0;
 	JSONFile* json = (JSONFile*)_json;
 	if (json != NULL) {
-		JsonNodeRef root = json->root;
-		char* token = findValue(&root, varName, json->fileName);
+		char* token;
+		ED_TRACE_GET_BEGIN(json->fileName, varName);
+		token = lookupValue(&json, varName);
 		if (token != NULL) {
 			if (ED_strtol(token, json->loc, &ret)) {
 				ModelicaFormatError("Cannot read int value \"%s\" from file \"%s\"\n",
@@ -215,6 +515,197 @@ int ED_getIntFromJSON(void* _json, const char* varName)
 			ModelicaFormatError("Cannot read int value from file \"%s\"\n",
 				json->fileName);
 		}
+		ED_TRACE_GET_END(json->fileName, varName, 1);
+		ED_trimLeave(json->trim);
 	}
 	return (int)ret;
 }
+
+enum {
+	BULK_OK = 0,
+	BULK_READ_ERROR,
+	BULK_PARSE_ERROR,
+	BULK_ELEMENT_ERROR,
+	BULK_VALUE_ERROR,
+	BULK_MEMORY_ERROR
+};
+
+typedef struct {
+	size_t i; /* Index of the file */
+	size_t j; /* Index of the element */
+	int type; /* BULK_OK or the kind of error */
+	int errnum; /* BULK_READ_ERROR: errno */
+	const char* errorString; /* BULK_PARSE_ERROR: Parser message and line */
+	int errorLine;
+	int errorLineSet;
+} JSONBulkError;
+
+typedef struct {
+	const char** fileNames;
+	const char** varNames;
+	size_t n;
+	size_t k;
+	size_t nChunks;
+	size_t maxNameLen;
+	double* a;
+	ED_LOCALE_TYPE loc;
+	JSONBulkError* errors; /* First error per chunk */
+} JSONBulk;
+
+/* Number of chunks of files per thread */
+#define ED_JSON_BULK_CHUNKS_PER_THREAD (4)
+
+/* Read the consecutive files of chunk c, reusing the file buffer and the
+ * element name buffer, and stop at the first error
+ */
+static void readBulkChunk(void* data, size_t c)
+{
+	JSONBulk* bulk = (JSONBulk*)data;
+	JSONBulkError* err = &bulk->errors[c];
+	size_t i = c*bulk->n/bulk->nChunks;
+	size_t iEnd = (c + 1)*bulk->n/bulk->nChunks;
+	char* name = (char*)malloc(bulk->maxNameLen + 1);
+	char* buffer = NULL;
+	size_t bufferLen = 0;
+	err->type = name != NULL ? BULK_OK : BULK_MEMORY_ERROR;
+	err->i = i;
+	for (; i < iEnd && err->type == BULK_OK; i++) {
+		JsonParser jsonParser;
+		JsonNodeRef root;
+		size_t len = 0;
+		size_t j;
+		ED_VFILE* vf = ED_vfopen(bulk->fileNames[i]);
+		err->i = i;
+		if (vf == NULL) {
+			err->type = BULK_READ_ERROR;
+			err->errnum = errno;
+			break;
+		}
+		for (;;) {
+			size_t nRead;
+			if (bufferLen - len < 2) {
+				size_t newLen = bufferLen > 0 ? 2*bufferLen : 4096;
+				char* newBuffer = (char*)realloc(buffer, newLen);
+				if (newBuffer == NULL) {
+					err->type = BULK_MEMORY_ERROR;
+					break;
+				}
+				buffer = newBuffer;
+				bufferLen = newLen;
+			}
+			nRead = ED_vfread(buffer + len, bufferLen - len - 1, vf);
+			if (nRead == 0) {
+				break;
+			}
+			len += nRead;
+		}
+		ED_vfclose(vf);
+		if (err->type != BULK_OK) {
+			break;
+		}
+		buffer[len] = '\0';
+		ED_TRACE_PARSE_BEGIN("JsonParser_parse", bulk->fileNames[i]);
+		root = JsonParser_parseBuffer(&jsonParser, buffer, (long)len);
+		ED_TRACE_PARSE_END("JsonParser_parse", bulk->fileNames[i], len);
+		if (root == NULL) {
+			err->type = BULK_PARSE_ERROR;
+			err->errorString = JsonParser_getErrorString(&jsonParser);
+			err->errorLine = JsonParser_getErrorLine(&jsonParser);
+			err->errorLineSet = JsonParser_getErrorLineSet(&jsonParser);
+			break;
+		}
+		for (j = 0; j < bulk->k; j++) {
+			char* token;
+			strcpy(name, bulk->varNames[j]);
+			token = findElement(root, name);
+			if (token == NULL) {
+				err->type = BULK_ELEMENT_ERROR;
+			}
+			else if (ED_strtod(token, bulk->loc, &bulk->a[i*bulk->k + j])) {
+				err->type = BULK_VALUE_ERROR;
+			}
+			if (err->type != BULK_OK) {
+				err->j = j;
+				break;
+			}
+		}
+		JsonNode_deleteTree(root);
+	}
+	free(buffer);
+	free(name);
+}
+
+void ED_getDoubleArray2DFromJSONFiles(const char** fileNames, size_t n, const char** varNames, size_t k, double* a, int verbose)
+{
+	JSONBulk bulk;
+	size_t c;
+	if (n == 0 || k == 0) {
+		return;
+	}
+	if (verbose == 1) {
+		for (c = 0; c < n; c++) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileNames[c]);
+		}
+	}
+	bulk.fileNames = fileNames;
+	bulk.varNames = varNames;
+	bulk.n = n;
+	bulk.k = k;
+	bulk.a = a;
+	bulk.maxNameLen = 0;
+	for (c = 0; c < k; c++) {
+		size_t len = strlen(varNames[c]);
+		if (len > bulk.maxNameLen) {
+			bulk.maxNameLen = len;
+		}
+	}
+	bulk.nChunks = ED_JSON_BULK_CHUNKS_PER_THREAD*ED_parallelThreads();
+	if (bulk.nChunks > n) {
+		bulk.nChunks = n;
+	}
+	bulk.errors = (JSONBulkError*)malloc(bulk.nChunks*sizeof(JSONBulkError));
+	if (bulk.errors == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return;
+	}
+	bulk.loc = ED_INIT_LOCALE;
+	ED_parallelFor(bulk.nChunks, readBulkChunk, &bulk);
+	ED_FREE_LOCALE(bulk.loc);
+
+	/* Report the error of the first file that failed */
+	for (c = 0; c < bulk.nChunks; c++) {
+		JSONBulkError err = bulk.errors[c];
+		if (err.type != BULK_OK) {
+			const char* fileName = fileNames[err.i];
+			free(bulk.errors);
+			switch (err.type) {
+				case BULK_READ_ERROR:
+					ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(err.errnum));
+					break;
+				case BULK_PARSE_ERROR:
+					if (err.errorLineSet != 0) {
+						ModelicaFormatError("Error \"%s\" in line %i: Cannot parse file \"%s\"\n",
+							err.errorString, err.errorLine, fileName);
+					}
+					else {
+						ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, err.errorString);
+					}
+					break;
+				case BULK_ELEMENT_ERROR:
+					ModelicaFormatError("Cannot read element \"%s\" from file \"%s\"\n",
+						varNames[err.j], fileName);
+					break;
+				case BULK_VALUE_ERROR:
+					ModelicaFormatError("Cannot read double value of element \"%s\" from file \"%s\"\n",
+						varNames[err.j], fileName);
+					break;
+				default:
+					ModelicaError("Memory allocation error\n");
+					break;
+			}
+			return;
+		}
+	}
+	free(bulk.errors);
+}
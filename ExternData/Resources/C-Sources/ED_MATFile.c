@@ -26,11 +26,16 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
 #if defined(_MSC_VER)
 #define strdup _strdup
 #endif
 #include "ModelicaUtilities.h"
 #include "ModelicaIO.c"
+#include "ED_NDTable.h"
+#include "ED_align.h"
+#include "ED_table.h"
+#include "ED_trace.h"
 #include "../Include/ED_MATFile.h"
 
 typedef struct {
@@ -38,9 +43,38 @@ typedef struct {
 	int verbose;
 } MATFile;
 
+typedef struct {
+	ED_NDTable* table;
+	char* varName;
+	char* fileName;
+} NDTable;
+
+/* Time series of a MAT-file with the time stamps in the first column */
+typedef struct {
+	mat_t* matfp;
+	matvar_t* matvar;
+	matvar_t* matvarRoot;
+	double* buf; /* Window or all rows, column-major */
+	size_t nRows;
+	size_t nCols; /* Columns read */
+	size_t row; /* Next row to read */
+	int whole; /* 1 if buf holds all rows */
+} MATSeries;
+
+enum {
+	ND_ERR_NONE = 0,
+	ND_ERR_MEMORY,
+	ND_ERR_NOT_FOUND,
+	ND_ERR_NOT_NUMERIC,
+	ND_ERR_RANK,
+	ND_ERR_READ
+};
+
 void* ED_createMAT(const char* fileName, int verbose)
 {
-	MATFile* mat = (MATFile*)malloc(sizeof(MATFile));
+	MATFile* mat;
+	ED_TRACE_CREATE_BEGIN("MAT", fileName);
+	mat = (MATFile*)malloc(sizeof(MATFile));
 	if (mat == NULL) {
 		ModelicaError("Memory allocation error\n");
 		return NULL;
@@ -53,6 +87,7 @@ void* ED_createMAT(const char* fileName, int verbose)
 	}
 	mat->verbose = verbose;
 
+	ED_TRACE_CREATE_END("MAT", fileName, mat);
 	return mat;
 }
 
@@ -60,6 +95,7 @@ void ED_destroyMAT(void* _mat)
 {
 	MATFile* mat = (MATFile*)_mat;
 	if (mat != NULL) {
+		ED_TRACE_DESTROY("MAT", mat->fileName);
 		if (mat->fileName != NULL) {
 			free(mat->fileName);
 		}
@@ -71,7 +107,75 @@ void ED_getDoubleArray2DFromMAT(void* _mat, const char* varName, double* a, size
 {
 	MATFile* mat = (MATFile*)_mat;
 	if (mat != NULL) {
-		ModelicaIO_readRealMatrix(mat->fileName, varName, a, m, n, mat->verbose);
+		MatIO matio = {NULL, NULL, NULL};
+		double* data = NULL;
+		int readError = 0;
+		ED_Table* table;
+
+		if (mat->verbose == 1) {
+			/* Print info message, that matrix / file is loading */
+			ModelicaFormatMessage("... loading \"%s\" from \"%s\"\n", varName, mat->fileName);
+		}
+
+		ED_TRACE_GET_BEGIN(mat->fileName, varName);
+		ED_TRACE_PARSE_BEGIN("readMatIO", mat->fileName);
+		readRealMatIO(mat->fileName, varName, &matio);
+		ED_TRACE_PARSE_END("readMatIO", mat->fileName, 0);
+		if (NULL != matio.matvar) {
+			matvar_t* matvar = matio.matvar;
+
+			/* Check if number of rows and columns match */
+			if (m != matvar->dims[0] || n != matvar->dims[1]) {
+				Mat_VarFree(matio.matvarRoot);
+				(void)Mat_Close(matio.mat);
+				ModelicaFormatError(
+					"Cannot read %lu %s of array \"%s(%lu,%lu)\" "
+					"from file \"%s\"\n", (unsigned long)(m != matvar->dims[0] ? m : n),
+					m != matvar->dims[0] ? "rows" : "columns", varName,
+					(unsigned long)matvar->dims[0], (unsigned long)matvar->dims[1],
+					mat->fileName);
+				return;
+			}
+
+			if (m > 0 && n > 0) {
+				/* Read the column-major data as columns of a table */
+				int start[2] = {0, 0};
+				int stride[2] = {1, 1};
+				int edge[2];
+				edge[0] = (int)m;
+				edge[1] = (int)n;
+				data = (double*)malloc(m*n*sizeof(double));
+				if (data == NULL) {
+					Mat_VarFree(matio.matvarRoot);
+					(void)Mat_Close(matio.mat);
+					ModelicaError("Memory allocation error\n");
+					return;
+				}
+				readError = Mat_VarReadData(matio.mat, matvar, data, start, stride, edge);
+			}
+		}
+
+		Mat_VarFree(matio.matvarRoot);
+		(void)Mat_Close(matio.mat);
+
+		if (readError != 0) {
+			free(data);
+			ModelicaFormatError(
+				"Error when reading numeric data of matrix \"%s(%lu,%lu)\" "
+				"from file \"%s\"\n", varName, (unsigned long)m,
+				(unsigned long)n, mat->fileName);
+			return;
+		}
+		if (data != NULL) {
+			table = ED_tableCreateColumnMajor(data, m, n);
+			if (table == NULL) {
+				ModelicaError("Memory allocation error\n");
+				return;
+			}
+			(void)ED_tableGetDoubleArray2D(table, 0, 0, m, n, a);
+			ED_tableFree(table);
+		}
+		ED_TRACE_GET_END(mat->fileName, varName, m*n);
 	}
 }
 
@@ -86,7 +190,10 @@ void ED_getStringArray1DFromMAT(void* _mat, const char* varName, const char* str
 			ModelicaFormatMessage("... loading \"%s\" from \"%s\"\n", varName, mat->fileName);
 		}
 
+		ED_TRACE_GET_BEGIN(mat->fileName, varName);
+		ED_TRACE_PARSE_BEGIN("readMatIO", mat->fileName);
 		readMatIO(mat->fileName, varName, &matio);
+		ED_TRACE_PARSE_END("readMatIO", mat->fileName, 0);
 		if (NULL != matio.matvar) {
 			matvar_t* matvar = matio.matvar;
 			size_t nRow, nCol, i;
@@ -138,5 +245,795 @@ void ED_getStringArray1DFromMAT(void* _mat, const char* varName, const char* str
 			Mat_VarFree(matio.matvarRoot);
 			(void)Mat_Close(matio.mat);
 		}
+		ED_TRACE_GET_END(mat->fileName, varName, m);
+	}
+}
+
+/* Read the real sparse matrix varName with its stored row indices, column
+ * pointers and values and validate the compressed structure
+ */
+static void readSparseMatIO(MATFile* mat, const char* varName, MatIO* matio)
+{
+	if (mat->verbose == 1) {
+		/* Print info message, that matrix / file is loading */
+		ModelicaFormatMessage("... loading \"%s\" from \"%s\"\n", varName, mat->fileName);
+	}
+
+	ED_TRACE_PARSE_BEGIN("readMatIO", mat->fileName);
+	readMatIO(mat->fileName, varName, matio);
+	ED_TRACE_PARSE_END("readMatIO", mat->fileName, 0);
+	if (NULL != matio->matvar) {
+		matvar_t* matvar = matio->matvar;
+		mat_sparse_t* sparse;
+		size_t nRow, nCol, nnz, j;
+
+		if (matvar->class_type != MAT_C_SPARSE) {
+			Mat_VarFree(matio->matvarRoot);
+			(void)Mat_Close(matio->mat);
+			ModelicaFormatError("Matrix \"%s\" is not a sparse array.\n", varName);
+			return;
+		}
+		if (matvar->isComplex) {
+			Mat_VarFree(matio->matvarRoot);
+			(void)Mat_Close(matio->mat);
+			ModelicaFormatError("Matrix \"%s\" must not be complex.\n", varName);
+			return;
+		}
+
+		(void)Mat_VarReadDataAll(matio->mat, matvar);
+		sparse = (mat_sparse_t*)matvar->data;
+		nRow = matvar->dims[0];
+		nCol = matvar->dims[1];
+		nnz = 0;
+		j = 0;
+		if (NULL != sparse && NULL != sparse->jc && sparse->njc >= 1 &&
+			(size_t)sparse->njc == nCol + 1 && sparse->jc[0] == 0) {
+			for (j = 1; j <= nCol; j++) {
+				if (sparse->jc[j] < sparse->jc[j - 1]) {
+					break;
+				}
+			}
+			nnz = (size_t)sparse->jc[nCol];
+		}
+		if (NULL == sparse || NULL == sparse->jc || j <= nCol ||
+			(nnz > 0 && (NULL == sparse->ir || NULL == sparse->data ||
+			nnz > (size_t)sparse->nir || nnz > (size_t)sparse->ndata))) {
+			Mat_VarFree(matio->matvarRoot);
+			(void)Mat_Close(matio->mat);
+			ModelicaFormatError("Error when reading sparse matrix \"%s\" "
+				"from file \"%s\"\n", varName, mat->fileName);
+			return;
+		}
+		for (j = 0; j < nnz; j++) {
+			if (sparse->ir[j] < 0 || (size_t)sparse->ir[j] >= nRow) {
+				Mat_VarFree(matio->matvarRoot);
+				(void)Mat_Close(matio->mat);
+				ModelicaFormatError("Row index %ld of sparse matrix \"%s\" "
+					"exceeds its %lu rows\n", (long)sparse->ir[j] + 1, varName,
+					(unsigned long)nRow);
+				return;
+			}
+		}
+	}
+}
+
+static double getSparseValue(const void* data, enum matio_types type, size_t k)
+{
+	switch (type) {
+		case MAT_T_DOUBLE:
+			return ((const double*)data)[k];
+		case MAT_T_SINGLE:
+			return (double)((const float*)data)[k];
+		case MAT_T_INT8:
+			return (double)((const mat_int8_t*)data)[k];
+		case MAT_T_UINT8:
+			return (double)((const mat_uint8_t*)data)[k];
+		case MAT_T_INT16:
+			return (double)((const mat_int16_t*)data)[k];
+		case MAT_T_UINT16:
+			return (double)((const mat_uint16_t*)data)[k];
+		case MAT_T_INT32:
+			return (double)((const mat_int32_t*)data)[k];
+		case MAT_T_UINT32:
+			return (double)((const mat_uint32_t*)data)[k];
+		case MAT_T_INT64:
+			return (double)((const mat_int64_t*)data)[k];
+		case MAT_T_UINT64:
+			return (double)((const mat_uint64_t*)data)[k];
+		default:
+			return 0.;
+	}
+}
+
+void ED_getSparseArray2DSizeFromMAT(void* _mat, const char* varName, int* dim)
+{
+	MATFile* mat = (MATFile*)_mat;
+	if (mat != NULL) {
+		MatIO matio = {NULL, NULL, NULL};
+
+		readSparseMatIO(mat, varName, &matio);
+		if (NULL != matio.matvar) {
+			matvar_t* matvar = matio.matvar;
+			mat_sparse_t* sparse = (mat_sparse_t*)matvar->data;
+
+			dim[0] = (int)matvar->dims[0];
+			dim[1] = (int)matvar->dims[1];
+			dim[2] = sparse->jc[matvar->dims[1]];
+
+			Mat_VarFree(matio.matvarRoot);
+			(void)Mat_Close(matio.mat);
+		}
+	}
+}
+
+void ED_getSparseArray2DFromMAT(void* _mat, const char* varName, int rowMajor, int* ptr, size_t nPtr, int* idx, double* val, size_t nnz)
+{
+	MATFile* mat = (MATFile*)_mat;
+	if (mat != NULL) {
+		MatIO matio = {NULL, NULL, NULL};
+
+		ED_TRACE_GET_BEGIN(mat->fileName, varName);
+		readSparseMatIO(mat, varName, &matio);
+		if (NULL != matio.matvar) {
+			matvar_t* matvar = matio.matvar;
+			mat_sparse_t* sparse = (mat_sparse_t*)matvar->data;
+			size_t nRow = matvar->dims[0];
+			size_t nCol = matvar->dims[1];
+			size_t nnzVar = (size_t)sparse->jc[nCol];
+			size_t i, j;
+			size_t k;
+
+			/* Check size of compressed arrays */
+			if (nPtr != (rowMajor ? nRow : nCol) + 1 || nnz != nnzVar) {
+				Mat_VarFree(matio.matvarRoot);
+				(void)Mat_Close(matio.mat);
+				ModelicaFormatError(
+					"Cannot read %lu pointers and %lu nonzeros of sparse matrix "
+					"\"%s(%lu,%lu)\" with %lu nonzeros from file \"%s\"\n",
+					(unsigned long)nPtr, (unsigned long)nnz, varName,
+					(unsigned long)nRow, (unsigned long)nCol,
+					(unsigned long)nnzVar, mat->fileName);
+				return;
+			}
+
+			if (!rowMajor) {
+				for (j = 0; j <= nCol; j++) {
+					ptr[j] = sparse->jc[j] + 1;
+				}
+				for (k = 0; k < nnz; k++) {
+					idx[k] = sparse->ir[k] + 1;
+					val[k] = getSparseValue(sparse->data, matvar->data_type, k);
+				}
+			}
+			else {
+				/* Transpose by counting the nonzeros per row, ptr[i + 1]
+				 * is the insertion position of row i while the columns
+				 * are scattered in increasing order
+				 */
+				for (i = 0; i <= nRow; i++) {
+					ptr[i] = 0;
+				}
+				for (k = 0; k < nnz; k++) {
+					ptr[sparse->ir[k] + 1]++;
+				}
+				for (i = 1; i <= nRow; i++) {
+					ptr[i] += ptr[i - 1];
+				}
+				for (i = nRow; i > 0; i--) {
+					ptr[i] = ptr[i - 1];
+				}
+				for (j = 0; j < nCol; j++) {
+					for (k = (size_t)sparse->jc[j]; k < (size_t)sparse->jc[j + 1]; k++) {
+						const int pos = ptr[sparse->ir[k] + 1]++;
+						idx[pos] = (int)j + 1;
+						val[pos] = getSparseValue(sparse->data, matvar->data_type, k);
+					}
+				}
+				for (i = 0; i <= nRow; i++) {
+					ptr[i]++;
+				}
+			}
+
+			Mat_VarFree(matio.matvarRoot);
+			(void)Mat_Close(matio.mat);
+		}
+		ED_TRACE_GET_END(mat->fileName, varName, nnz);
+	}
+}
+
+/* Look up the numeric variable varName (struct fields separated by '.') of
+ * an open MAT-file and set it up to be read as double values
+ */
+static matvar_t* findRealVar(mat_t* matfp, const char* varName, matvar_t** matvarRoot,
+	int* err)
+{
+	matvar_t* matvar;
+	char* varNameCopy;
+	char* token;
+	char* nextToken = NULL;
+
+	*matvarRoot = NULL;
+	varNameCopy = strdup(varName);
+	if (varNameCopy == NULL) {
+		*err = ND_ERR_MEMORY;
+		return NULL;
+	}
+	token = strtok_r(varNameCopy, ".", &nextToken);
+	*matvarRoot = Mat_VarReadInfo(matfp, NULL == token ? varName : token);
+	matvar = *matvarRoot;
+	token = strtok_r(NULL, ".", &nextToken);
+	while (NULL != token && NULL != matvar) {
+		if (matvar->class_type == MAT_C_STRUCT && matvar->rank == 2 &&
+			matvar->dims[0] == 1 && matvar->dims[1] == 1) {
+			matvar = Mat_VarGetStructField(matvar, (void*)token, MAT_BY_NAME, 0);
+			token = strtok_r(NULL, ".", &nextToken);
+		}
+		else {
+			matvar = NULL;
+		}
+	}
+	free(varNameCopy);
+	if (NULL == matvar) {
+		Mat_VarFree(*matvarRoot);
+		*matvarRoot = NULL;
+		*err = ND_ERR_NOT_FOUND;
+		return NULL;
+	}
+
+	if ((matvar->class_type != MAT_C_DOUBLE && matvar->class_type != MAT_C_SINGLE &&
+		matvar->class_type != MAT_C_INT8 && matvar->class_type != MAT_C_UINT8 &&
+		matvar->class_type != MAT_C_INT16 && matvar->class_type != MAT_C_UINT16 &&
+		matvar->class_type != MAT_C_INT32 && matvar->class_type != MAT_C_UINT32 &&
+		matvar->class_type != MAT_C_INT64 && matvar->class_type != MAT_C_UINT64) ||
+		matvar->isComplex) {
+		Mat_VarFree(*matvarRoot);
+		*matvarRoot = NULL;
+		*err = ND_ERR_NOT_NUMERIC;
+		return NULL;
+	}
+	matvar->class_type = MAT_C_DOUBLE;
+	*err = ND_ERR_NONE;
+	return matvar;
+}
+
+/* Read the numeric variable varName (struct fields separated by '.') of an
+ * open MAT-file in column-major order without transposing
+ */
+static double* readRealArrayND(mat_t* matfp, const char* varName, size_t* rank,
+	size_t* dims, int* err)
+{
+	matvar_t* matvarRoot;
+	matvar_t* matvar;
+	double* data;
+	size_t numel = 1;
+	size_t i;
+
+	matvar = findRealVar(matfp, varName, &matvarRoot, err);
+	if (NULL == matvar) {
+		return NULL;
+	}
+	if (matvar->rank < 1 || matvar->rank > ED_NDTABLE_MAX_DIMS) {
+		Mat_VarFree(matvarRoot);
+		*err = ND_ERR_RANK;
+		return NULL;
+	}
+	*rank = (size_t)matvar->rank;
+	for (i = 0; i < *rank; i++) {
+		dims[i] = matvar->dims[i];
+		numel *= dims[i];
+	}
+
+	data = (double*)malloc((numel > 0 ? numel : 1)*sizeof(double));
+	if (data == NULL) {
+		Mat_VarFree(matvarRoot);
+		*err = ND_ERR_MEMORY;
+		return NULL;
+	}
+	if (numel > 0 && 0 != Mat_VarReadDataLinear(matfp, matvar, data, 0, 1, (int)numel)) {
+		free(data);
+		Mat_VarFree(matvarRoot);
+		*err = ND_ERR_READ;
+		return NULL;
+	}
+	Mat_VarFree(matvarRoot);
+	*err = ND_ERR_NONE;
+	return data;
+}
+
+void* ED_createNDTableFromMAT(void* _mat, const char* varName, const char** axisNames,
+	size_t nAxes, int extrapolation)
+{
+	MATFile* mat = (MATFile*)_mat;
+	NDTable* nd;
+	mat_t* matfp;
+	double* axes[ED_NDTABLE_MAX_DIMS];
+	double* data;
+	size_t n[ED_NDTABLE_MAX_DIMS];
+	size_t dims[ED_NDTABLE_MAX_DIMS];
+	size_t rank;
+	size_t d;
+	const char* errName = varName;
+	int err;
+
+	if (mat == NULL) {
+		return NULL;
+	}
+	if (nAxes < 1 || nAxes > ED_NDTABLE_MAX_DIMS) {
+		ModelicaFormatError("Number of axes of table \"%s\" must be between 1 and %d\n",
+			varName, ED_NDTABLE_MAX_DIMS);
+		return NULL;
+	}
+	if (mat->verbose == 1) {
+		/* Print info message, that table / file is loading */
+		ModelicaFormatMessage("... loading \"%s\" from \"%s\"\n", varName, mat->fileName);
+	}
+
+	ED_TRACE_CREATE_BEGIN("NDTable", mat->fileName);
+	matfp = Mat_Open(mat->fileName, (int)MAT_ACC_RDONLY);
+	if (NULL == matfp) {
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", mat->fileName);
+		return NULL;
+	}
+
+	/* Read grid data and axis vectors into the buffers owned by the table */
+	ED_TRACE_PARSE_BEGIN("readMatIO", mat->fileName);
+	data = readRealArrayND(matfp, varName, &rank, dims, &err);
+	for (d = 0; d < nAxes; d++) {
+		axes[d] = NULL;
+	}
+	for (d = 0; d < nAxes && err == ND_ERR_NONE; d++) {
+		size_t axisRank;
+		size_t axisDims[ED_NDTABLE_MAX_DIMS];
+		errName = axisNames[d];
+		axes[d] = readRealArrayND(matfp, axisNames[d], &axisRank, axisDims, &err);
+		if (err == ND_ERR_NONE) {
+			if (axisRank != 2 || (axisDims[0] != 1 && axisDims[1] != 1)) {
+				err = ND_ERR_RANK;
+			}
+			else {
+				n[d] = axisDims[0]*axisDims[1];
+			}
+		}
+	}
+	(void)Mat_Close(matfp);
+	ED_TRACE_PARSE_END("readMatIO", mat->fileName, 0);
+
+	if (err != ND_ERR_NONE) {
+		free(data);
+		for (d = 0; d < nAxes; d++) {
+			free(axes[d]);
+		}
+		switch (err) {
+			case ND_ERR_MEMORY:
+				ModelicaError("Memory allocation error\n");
+				break;
+			case ND_ERR_NOT_FOUND:
+				ModelicaFormatError("Variable \"%s\" not found on file \"%s\".\n",
+					errName, mat->fileName);
+				break;
+			case ND_ERR_NOT_NUMERIC:
+				ModelicaFormatError("Variable \"%s\" is not a real-valued numeric array.\n",
+					errName);
+				break;
+			case ND_ERR_RANK:
+				if (errName == varName) {
+					ModelicaFormatError("Variable \"%s\" has more than %d dimensions.\n",
+						varName, ED_NDTABLE_MAX_DIMS);
+				}
+				else {
+					ModelicaFormatError("Axis \"%s\" of table \"%s\" is not a vector.\n",
+						errName, varName);
+				}
+				break;
+			default:
+				ModelicaFormatError("Error when reading numeric data of variable \"%s\" "
+					"from file \"%s\"\n", errName, mat->fileName);
+				break;
+		}
+		return NULL;
+	}
+
+	/* A 1D table can also be stored as row vector */
+	if (nAxes == 1 && rank == 2 && dims[0] == 1) {
+		dims[0] = dims[1];
+		rank = 1;
+	}
+	/* Trailing singleton dimensions are not stored */
+	for (d = 0; d < nAxes || d < rank; d++) {
+		size_t dataDim = d < rank ? dims[d] : 1;
+		size_t axisDim = d < nAxes ? n[d] : 1;
+		if (dataDim != axisDim) {
+			free(data);
+			for (d = 0; d < nAxes; d++) {
+				free(axes[d]);
+			}
+			ModelicaFormatError("Dimensions of table \"%s\" do not match the "
+				"lengths of its axes.\n", varName);
+			return NULL;
+		}
+	}
+	for (d = 0; d < nAxes; d++) {
+		size_t i;
+		for (i = 1; i < n[d]; i++) {
+			if (!(axes[d][i] > axes[d][i - 1])) {
+				break;
+			}
+		}
+		if (n[d] == 0 || i < n[d]) {
+			errName = axisNames[d];
+			free(data);
+			for (d = 0; d < nAxes; d++) {
+				free(axes[d]);
+			}
+			ModelicaFormatError("Axis \"%s\" of table \"%s\" must not be empty "
+				"and strictly increasing.\n", errName, varName);
+			return NULL;
+		}
+	}
+
+	nd = (NDTable*)calloc(1, sizeof(NDTable));
+	if (nd == NULL) {
+		free(data);
+		for (d = 0; d < nAxes; d++) {
+			free(axes[d]);
+		}
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	nd->table = ED_ndtableCreate(nAxes, n, axes, data, extrapolation);
+	nd->varName = strdup(varName);
+	nd->fileName = strdup(mat->fileName);
+	if (nd->table == NULL || nd->varName == NULL || nd->fileName == NULL) {
+		ED_destroyNDTable(nd);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	ED_TRACE_CREATE_END("NDTable", mat->fileName, nd);
+	return nd;
+}
+
+void ED_destroyNDTable(void* _nd)
+{
+	NDTable* nd = (NDTable*)_nd;
+	if (nd != NULL) {
+		ED_TRACE_DESTROY("NDTable", nd->fileName != NULL ? nd->fileName : "");
+		ED_ndtableFree(nd->table);
+		free(nd->varName);
+		free(nd->fileName);
+		free(nd);
+	}
+}
+
+double ED_getDoubleFromNDTable(void* _nd, const double* u, size_t nDims)
+{
+	double y = 0.;
+	ED_getDoubleArray1DFromNDTable(_nd, u, 1, nDims, &y);
+	return y;
+}
+
+void ED_getDoubleArray1DFromNDTable(void* _nd, const double* u, size_t m, size_t nDims, double* y)
+{
+	NDTable* nd = (NDTable*)_nd;
+	if (nd != NULL) {
+		size_t i;
+		if (nDims != ED_ndtableDims(nd->table)) {
+			ModelicaFormatError("Table \"%s\" from file \"%s\" has %lu dimensions, "
+				"but query points have %lu coordinates\n", nd->varName, nd->fileName,
+				(unsigned long)ED_ndtableDims(nd->table), (unsigned long)nDims);
+			return;
+		}
+		i = ED_ndtableEval(nd->table, u, m, y);
+		if (i < m) {
+			ModelicaFormatError("Query point %lu is outside the grid of table \"%s\" "
+				"from file \"%s\"\n", (unsigned long)(i + 1), nd->varName, nd->fileName);
+		}
+	}
+}
+
+static int readMATSeries(void* src, double* t, double* y, size_t maxRows, size_t* nRows)
+{
+	MATSeries* series = (MATSeries*)src;
+	size_t nSignals = series->nCols - 1;
+	size_t k = series->nRows - series->row;
+	size_t ld, off, i, j;
+
+	if (k > maxRows) {
+		k = maxRows;
+	}
+	*nRows = k;
+	if (k == 0) {
+		return 0;
+	}
+	if (series->whole) {
+		ld = series->nRows;
+		off = series->row;
+	}
+	else {
+		int start[2];
+		int stride[2] = {1, 1};
+		int edge[2];
+		start[0] = (int)series->row;
+		start[1] = 0;
+		edge[0] = (int)k;
+		edge[1] = (int)series->nCols;
+		if (0 != Mat_VarReadData(series->matfp, series->matvar, series->buf, start, stride, edge)) {
+			return -1;
+		}
+		ld = k;
+		off = 0;
+	}
+	for (i = 0; i < k; i++) {
+		t[i] = series->buf[off + i];
+	}
+	for (j = 0; j < nSignals; j++) {
+		const double* col = series->buf + (j + 1)*ld + off;
+		for (i = 0; i < k; i++) {
+			y[i*nSignals + j] = col[i];
+		}
+	}
+	series->row += k;
+	return 0;
+}
+
+static void closeAlignment(ED_Align* align, mat_t* matfp, MATSeries* series, size_t nVars)
+{
+	size_t i;
+	ED_alignFree(align);
+	if (series != NULL) {
+		for (i = 0; i < nVars; i++) {
+			Mat_VarFree(series[i].matvarRoot);
+			free(series[i].buf);
+		}
+		free(series);
+	}
+	if (matfp != NULL) {
+		(void)Mat_Close(matfp);
+	}
+}
+
+/* Open the time series varNames of a MAT-file as sources of an alignment,
+ * of their time stamps only if timeOnly. The time series are read in
+ * windows, except for compressed variables of v7 MAT-files, which can
+ * only be read from their start and are therefore read completely.
+ */
+static ED_Align* openAlignment(MATFile* mat, const char** varNames, size_t nVars,
+	const int* smoothness, const double* grid, size_t nGrid, int timeOnly,
+	mat_t** matfp, MATSeries** series)
+{
+	ED_AlignSource* sources;
+	ED_Align* align;
+	const char* errName = NULL;
+	size_t i;
+	int err = ND_ERR_NONE;
+
+	*matfp = NULL;
+	*series = NULL;
+	for (i = 0; smoothness != NULL && i < nVars; i++) {
+		if (smoothness[i] != ED_ALIGN_LINEAR_SEGMENTS &&
+			smoothness[i] != ED_ALIGN_CONSTANT_SEGMENTS) {
+			ModelicaFormatError("Smoothness of time series \"%s\" must be "
+				"LinearSegments or ConstantSegments.\n", varNames[i]);
+			return NULL;
+		}
+	}
+	for (i = 1; grid != NULL && i < nGrid; i++) {
+		if (!(grid[i] >= grid[i - 1])) {
+			ModelicaFormatError("Time point %lu of the target grid is smaller "
+				"than its predecessor.\n", (unsigned long)(i + 1));
+			return NULL;
+		}
+	}
+	if (mat->verbose == 1) {
+		for (i = 0; i < nVars; i++) {
+			/* Print info message, that time series / file is loading */
+			ModelicaFormatMessage("... loading \"%s\" from \"%s\"\n", varNames[i], mat->fileName);
+		}
+	}
+
+	*matfp = Mat_Open(mat->fileName, (int)MAT_ACC_RDONLY);
+	if (NULL == *matfp) {
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", mat->fileName);
+		return NULL;
+	}
+	*series = (MATSeries*)calloc(nVars > 0 ? nVars : 1, sizeof(MATSeries));
+	sources = (ED_AlignSource*)malloc((nVars > 0 ? nVars : 1)*sizeof(ED_AlignSource));
+	if (*series == NULL || sources == NULL) {
+		free(sources);
+		closeAlignment(NULL, *matfp, *series, 0);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	for (i = 0; i < nVars && err == ND_ERR_NONE; i++) {
+		MATSeries* s = &(*series)[i];
+		matvar_t* matvar;
+		size_t nBuf;
+
+		errName = varNames[i];
+		matvar = findRealVar(*matfp, varNames[i], &s->matvarRoot, &err);
+		if (NULL == matvar) {
+			break;
+		}
+		if (matvar->rank != 2 || matvar->dims[1] < 1) {
+			err = ND_ERR_RANK;
+			break;
+		}
+		s->matfp = *matfp;
+		s->matvar = matvar;
+		s->nRows = matvar->dims[0];
+		s->nCols = timeOnly ? 1 : matvar->dims[1];
+		s->whole = matvar->compression != MAT_COMPRESSION_NONE;
+		nBuf = s->whole || s->nRows < ED_ALIGN_WINDOW ? s->nRows : ED_ALIGN_WINDOW;
+		s->buf = (double*)malloc((nBuf > 0 ? nBuf : 1)*s->nCols*sizeof(double));
+		if (s->buf == NULL) {
+			err = ND_ERR_MEMORY;
+			break;
+		}
+		if (s->whole && s->nRows > 0) {
+			int start[2] = {0, 0};
+			int stride[2] = {1, 1};
+			int edge[2];
+			edge[0] = (int)s->nRows;
+			edge[1] = (int)s->nCols;
+			if (0 != Mat_VarReadData(*matfp, matvar, s->buf, start, stride, edge)) {
+				err = ND_ERR_READ;
+				break;
+			}
+		}
+		sources[i].read = readMATSeries;
+		sources[i].src = s;
+		sources[i].nSignals = s->nCols - 1;
+		sources[i].smoothness = smoothness != NULL ? smoothness[i] : ED_ALIGN_LINEAR_SEGMENTS;
+	}
+
+	if (err != ND_ERR_NONE) {
+		free(sources);
+		closeAlignment(NULL, *matfp, *series, nVars);
+		switch (err) {
+			case ND_ERR_MEMORY:
+				ModelicaError("Memory allocation error\n");
+				break;
+			case ND_ERR_NOT_FOUND:
+				ModelicaFormatError("Variable \"%s\" not found on file \"%s\".\n",
+					errName, mat->fileName);
+				break;
+			case ND_ERR_NOT_NUMERIC:
+				ModelicaFormatError("Variable \"%s\" is not a real-valued numeric array.\n",
+					errName);
+				break;
+			case ND_ERR_RANK:
+				ModelicaFormatError("Time series \"%s\" is not a matrix with the "
+					"time stamps in its first column.\n", errName);
+				break;
+			default:
+				ModelicaFormatError("Error when reading numeric data of variable \"%s\" "
+					"from file \"%s\"\n", errName, mat->fileName);
+				break;
+		}
+		return NULL;
+	}
+
+	align = ED_alignCreate(sources, nVars, nGrid > 0 ? grid : NULL, nGrid);
+	free(sources);
+	if (align == NULL) {
+		closeAlignment(NULL, *matfp, *series, nVars);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	return align;
+}
+
+/* Close the alignment and raise the error of its failed source */
+static void raiseAlignError(MATFile* mat, const char** varNames, size_t nVars,
+	ED_Align* align, mat_t* matfp, MATSeries* series)
+{
+	int err = errno;
+	const char* errName = varNames[ED_alignFailedSource(align)];
+	closeAlignment(align, matfp, series, nVars);
+	if (err == EINVAL) {
+		ModelicaFormatError("Time stamps of time series \"%s\" from file "
+			"\"%s\" must not be empty or decreasing.\n", errName, mat->fileName);
+	}
+	else {
+		ModelicaFormatError("Error when reading numeric data of variable \"%s\" "
+			"from file \"%s\"\n", errName, mat->fileName);
+	}
+}
+
+void ED_getAlignedArray2DSizeFromMAT(void* _mat, const char** varNames, size_t nVars, int* dim)
+{
+	MATFile* mat = (MATFile*)_mat;
+	if (mat != NULL) {
+		mat_t* matfp;
+		MATSeries* series;
+		ED_Align* align;
+		double t[256];
+		size_t m = 0;
+		size_t n = 1;
+		size_t nRows;
+		size_t i;
+
+		align = openAlignment(mat, varNames, nVars, NULL, NULL, 0, 1, &matfp, &series);
+		if (align == NULL) {
+			return;
+		}
+		for (i = 0; i < nVars; i++) {
+			n += series[i].matvar->dims[1] - 1;
+		}
+		do {
+			if (ED_alignNext(align, t, sizeof(t)/sizeof(t[0]), &nRows) != 0) {
+				raiseAlignError(mat, varNames, nVars, align, matfp, series);
+				return;
+			}
+			m += nRows;
+		} while (nRows > 0);
+		closeAlignment(align, matfp, series, nVars);
+
+		dim[0] = (int)m;
+		dim[1] = (int)n;
+	}
+}
+
+void ED_getAlignedArray2DFromMAT(void* _mat, const char** varNames, size_t nVars,
+	const int* smoothness, const double* grid, size_t nGrid, double* a, size_t m, size_t n)
+{
+	MATFile* mat = (MATFile*)_mat;
+	if (mat != NULL) {
+		mat_t* matfp;
+		MATSeries* series;
+		ED_Align* align;
+		double* extra;
+		size_t nRows;
+
+		align = openAlignment(mat, varNames, nVars, smoothness, grid, nGrid, 0, &matfp, &series);
+		if (align == NULL) {
+			return;
+		}
+		if (n != ED_alignCols(align)) {
+			size_t nCols = ED_alignCols(align);
+			closeAlignment(align, matfp, series, nVars);
+			ModelicaFormatError("Cannot read %lu columns of the aligned time series "
+				"with %lu columns from file \"%s\"\n", (unsigned long)n,
+				(unsigned long)nCols, mat->fileName);
+			return;
+		}
+		if (nGrid > 0 && m != nGrid) {
+			closeAlignment(align, matfp, series, nVars);
+			ModelicaFormatError("Cannot read %lu rows of the time series aligned "
+				"on a grid of %lu time points\n", (unsigned long)m, (unsigned long)nGrid);
+			return;
+		}
+
+		/* The rows are computed directly into the output */
+		if (ED_alignNext(align, a, m, &nRows) != 0) {
+			raiseAlignError(mat, varNames, nVars, align, matfp, series);
+			return;
+		}
+		if (nRows == m && nGrid == 0) {
+			/* Check that the union grid has no more time points */
+			size_t nMore = 0;
+			int err;
+			extra = (double*)malloc(n*sizeof(double));
+			if (extra == NULL) {
+				closeAlignment(align, matfp, series, nVars);
+				ModelicaError("Memory allocation error\n");
+				return;
+			}
+			err = ED_alignNext(align, extra, 1, &nMore);
+			free(extra);
+			if (err != 0) {
+				raiseAlignError(mat, varNames, nVars, align, matfp, series);
+				return;
+			}
+			nRows += nMore;
+		}
+		closeAlignment(align, matfp, series, nVars);
+		if (nRows != m) {
+			ModelicaFormatError("Cannot read %lu rows of the time series aligned "
+				"on the union of their time stamps from file \"%s\"\n",
+				(unsigned long)m, mat->fileName);
+		}
 	}
 }
@@ -0,0 +1,1165 @@
+/* ED_MDFFile.c - MDF functions
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include "zlib.h"
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_trace.h"
+#include "ModelicaUtilities.h"
+#define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
+#include "uthash.h"
+#include "../Include/ED_trim.h"
+#include "../Include/ED_MDFFile.h"
+
+/* Reader of ASAM MDF 4 measurement files. The block graph HD -> DG -> CG
+ * -> CN is parsed into an index of the channels by name when the file is
+ * opened. The record data of a data group (a single DT block or the DT
+ * and DZ fragments of a DL/HL list) is assembled on the first read of one
+ * of its channels, with the DZ fragments inflated in parallel, and kept
+ * until the handle is trimmed. Channels are extracted from the records by
+ * their byte and bit offsets. Plain files are mapped and a single DT block
+ * is read in place.
+ */
+
+/* Length of the identification block at the start of the file */
+#define MDF_ID_LENGTH (64)
+/* Length of the common block header: id, reserved, length and link count */
+#define MDF_BLOCK_HEADER_LENGTH (24)
+/* Length of the DZ block data preceding the compressed data */
+#define MDF_DZ_HEADER_LENGTH (24)
+/* No channel or channel group */
+#define MDF_NONE ((size_t)-1)
+
+/* Channel types (cn_type) */
+#define MDF_CN_VLSD (1)
+#define MDF_CN_MASTER (2)
+#define MDF_CN_VIRTUAL_MASTER (3)
+#define MDF_CN_VIRTUAL_DATA (6)
+
+/* Data types (cn_data_type) */
+#define MDF_UINT_LE (0)
+#define MDF_UINT_BE (1)
+#define MDF_INT_LE (2)
+#define MDF_INT_BE (3)
+#define MDF_FLOAT_LE (4)
+#define MDF_FLOAT_BE (5)
+
+/* Conversion types (cc_type) */
+#define MDF_CC_IDENTITY (0)
+#define MDF_CC_LINEAR (1)
+#define MDF_CC_RATIONAL (2)
+#define MDF_CC_TAB_INTERP (4)
+#define MDF_CC_TAB (5)
+#define MDF_CC_RANGE (6)
+
+typedef struct {
+	const unsigned char* id; /* Two characters after "##" */
+	const unsigned char* links;
+	size_t nLinks;
+	const unsigned char* data;
+	size_t dataLen;
+} MDFBlock;
+
+typedef struct {
+	char* name;
+	size_t cg; /* Index of the channel group */
+	int type;
+	int dataType;
+	int bitOffset;
+	size_t byteOffset;
+	size_t bitCount;
+	unsigned long flags;
+	size_t invalBitPos;
+	size_t cc; /* Offset of the conversion block, 0 for identity */
+	UT_hash_handle hh; /* Hashable structure */
+} MDFChannel;
+
+typedef struct {
+	size_t dg; /* Index of the data group */
+	size_t recordId;
+	size_t cycleCount;
+	size_t dataBytes;
+	size_t invalBytes;
+	int vlsd; /* Records of variable length signal data */
+	size_t master; /* Index of the master channel, MDF_NONE if none */
+	size_t* offsets; /* Record offsets in an unsorted data group */
+	size_t nRecords; /* Number of records once the data group is loaded */
+} MDFChannelGroup;
+
+typedef struct {
+	size_t data; /* Offset of the data block, 0 if none */
+	size_t recIdSize;
+	size_t firstCG;
+	size_t nCGs;
+	const unsigned char* records; /* Record data, NULL until loaded */
+	unsigned char* buf; /* Assembled record data, NULL if read in place */
+	size_t len;
+} MDFDataGroup;
+
+typedef struct {
+	char* fileName;
+	ED_VFILE* fp; /* Open while the content is mapped */
+	const unsigned char* map; /* Content, NULL if trimmed */
+	char* buf; /* Content if the file cannot be mapped */
+	size_t len;
+	MDFDataGroup* dgs;
+	size_t nDGs;
+	MDFChannelGroup* cgs;
+	size_t nCGs;
+	MDFChannel* channels;
+	size_t nChannels;
+	MDFChannel* index; /* Channels by name, the first one of equal names */
+	ED_TrimEntry* trim;
+} MDFFile;
+
+typedef struct {
+	const unsigned char* src;
+	size_t srcLen;
+	int zipped;
+	size_t columns; /* Columns of the transposition, 0 if not transposed */
+	size_t offset; /* Offset in the record data */
+	size_t len;
+	int rc;
+} MDFFragment;
+
+typedef struct {
+	MDFFragment* frags;
+	size_t nFrags;
+	size_t capacity;
+	size_t len;
+	unsigned char* buf;
+} MDFFragments;
+
+typedef struct {
+	int kind; /* 0: unsigned, 1: signed, 2: float, 3: record index */
+	int bigEndian;
+	size_t byteOffset;
+	size_t nBytes;
+	int bitOffset;
+	size_t bitCount;
+	int allInvalid;
+	size_t invalByte; /* Byte of the invalidation bit in the record */
+	unsigned char invalMask; /* 0 if no invalidation bit */
+	int ccType;
+	const unsigned char* val; /* Conversion parameters, in place */
+	size_t nVal;
+} MDFDecoder;
+
+static size_t readLE16(const unsigned char* p)
+{
+	return (size_t)p[0] | ((size_t)p[1] << 8);
+}
+
+static unsigned long readLE32(const unsigned char* p)
+{
+	return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+		((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+/* Offsets and counts beyond size_t are saturated, failing the bounds checks */
+static size_t readLE64(const unsigned char* p)
+{
+	size_t v = (size_t)readLE32(p);
+	unsigned long high = readLE32(p + 4);
+	if (high != 0) {
+		if (sizeof(size_t) <= 4) {
+			return MDF_NONE;
+		}
+		v |= (size_t)high << 16 << 16;
+	}
+	return v;
+}
+
+static int isBigEndianHost(void)
+{
+	const unsigned short one = 1;
+	return *(const unsigned char*)&one == 0;
+}
+
+/* Floating-point number of n (4 or 8) bytes in the given byte order */
+static double readFloat(const unsigned char* p, size_t n, int bigEndian)
+{
+	unsigned char b[8];
+	size_t k;
+	if (bigEndian != isBigEndianHost()) {
+		for (k = 0; k < n; k++) {
+			b[k] = p[n - 1 - k];
+		}
+	}
+	else {
+		memcpy(b, p, n);
+	}
+	if (n == 4) {
+		float f;
+		memcpy(&f, b, 4);
+		return (double)f;
+	}
+	else {
+		double d;
+		memcpy(&d, b, 8);
+		return d;
+	}
+}
+
+/* Parse the header of the block at pos, id is the expected block type or
+ * NULL for any type
+ */
+static int readBlock(const MDFFile* mdf, size_t pos, const char* id, MDFBlock* blk)
+{
+	const unsigned char* p;
+	size_t len;
+	size_t nLinks;
+
+	if (pos == 0 || pos >= mdf->len || mdf->len - pos < MDF_BLOCK_HEADER_LENGTH) {
+		errno = EINVAL;
+		return -1;
+	}
+	p = mdf->map + pos;
+	if (p[0] != '#' || p[1] != '#' || (id != NULL && 0 != memcmp(p + 2, id, 2))) {
+		errno = EINVAL;
+		return -1;
+	}
+	len = readLE64(p + 8);
+	nLinks = readLE64(p + 16);
+	if (len < MDF_BLOCK_HEADER_LENGTH || len > mdf->len - pos ||
+		nLinks > (len - MDF_BLOCK_HEADER_LENGTH)/8) {
+		errno = EINVAL;
+		return -1;
+	}
+	blk->id = p + 2;
+	blk->links = p + MDF_BLOCK_HEADER_LENGTH;
+	blk->nLinks = nLinks;
+	blk->data = blk->links + 8*nLinks;
+	blk->dataLen = len - MDF_BLOCK_HEADER_LENGTH - 8*nLinks;
+	return 0;
+}
+
+static size_t getLink(const MDFBlock* blk, size_t i)
+{
+	return i < blk->nLinks ? readLE64(blk->links + 8*i) : 0;
+}
+
+/* Grow the array *p of *capacity elements to hold at least n + 1 elements */
+static int reserve(void** p, size_t* capacity, size_t n, size_t size)
+{
+	if (n >= *capacity) {
+		size_t newCapacity = *capacity > 0 ? 2*(*capacity) : 16;
+		void* tmp = realloc(*p, newCapacity*size);
+		if (tmp == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		*p = tmp;
+		*capacity = newCapacity;
+	}
+	return 0;
+}
+
+/* Copy the text of a TX block, the empty string for pos 0 */
+static char* readText(const MDFFile* mdf, size_t pos)
+{
+	MDFBlock blk;
+	size_t n = 0;
+	char* str;
+	if (pos != 0) {
+		if (0 != readBlock(mdf, pos, "TX", &blk)) {
+			return NULL;
+		}
+		while (n < blk.dataLen && blk.data[n] != '\0') {
+			n++;
+		}
+	}
+	str = (char*)malloc(n + 1);
+	if (str == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	if (n > 0) {
+		memcpy(str, blk.data, n);
+	}
+	str[n] = '\0';
+	return str;
+}
+
+static void freeRecords(MDFFile* mdf)
+{
+	size_t i;
+	for (i = 0; i < mdf->nDGs; i++) {
+		free(mdf->dgs[i].buf);
+		mdf->dgs[i].buf = NULL;
+		mdf->dgs[i].records = NULL;
+		mdf->dgs[i].len = 0;
+	}
+	for (i = 0; i < mdf->nCGs; i++) {
+		free(mdf->cgs[i].offsets);
+		mdf->cgs[i].offsets = NULL;
+		mdf->cgs[i].nRecords = 0;
+	}
+}
+
+static void closeFile(MDFFile* mdf)
+{
+	freeRecords(mdf);
+	if (mdf->fp != NULL) {
+		ED_vfclose(mdf->fp);
+		mdf->fp = NULL;
+	}
+	free(mdf->buf);
+	mdf->buf = NULL;
+	mdf->map = NULL;
+}
+
+static void freeIndex(MDFFile* mdf)
+{
+	size_t i;
+	HASH_CLEAR(hh, mdf->index);
+	for (i = 0; i < mdf->nChannels; i++) {
+		free(mdf->channels[i].name);
+	}
+	free(mdf->channels);
+	mdf->channels = NULL;
+	mdf->nChannels = 0;
+	free(mdf->cgs);
+	mdf->cgs = NULL;
+	mdf->nCGs = 0;
+	free(mdf->dgs);
+	mdf->dgs = NULL;
+	mdf->nDGs = 0;
+}
+
+/* Map the file, or read it if it cannot be mapped. len is the length of
+ * the indexed content, 0 if not yet indexed.
+ */
+static int openFile(MDFFile* mdf, size_t len)
+{
+	const char* map;
+	mdf->fp = ED_vfopen(mdf->fileName);
+	if (mdf->fp == NULL) {
+		return -1;
+	}
+	map = ED_vfmap(mdf->fp, &mdf->len);
+	if (map == NULL) {
+		mdf->buf = ED_vfreadall(mdf->fp, &mdf->len);
+		ED_vfclose(mdf->fp);
+		mdf->fp = NULL;
+		if (mdf->buf == NULL) {
+			return -1;
+		}
+		map = mdf->buf;
+	}
+	mdf->map = (const unsigned char*)map;
+	if (len != 0 && len != mdf->len) {
+		/* The file changed since it was indexed */
+		closeFile(mdf);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/* Parse the channels of a channel group */
+static int parseChannels(MDFFile* mdf, size_t pos, size_t cg, size_t* budget)
+{
+	size_t capacity = mdf->nChannels;
+	MDFBlock blk;
+
+	while (pos != 0) {
+		MDFChannel* ch;
+		if ((*budget)-- == 0 || 0 != readBlock(mdf, pos, "CN", &blk) || blk.dataLen < 20 ||
+			0 != reserve((void**)&mdf->channels, &capacity, mdf->nChannels, sizeof(MDFChannel))) {
+			if (errno != ENOMEM) {
+				errno = EINVAL;
+			}
+			return -1;
+		}
+		ch = &mdf->channels[mdf->nChannels];
+		memset(ch, 0, sizeof(MDFChannel));
+		ch->name = readText(mdf, getLink(&blk, 2));
+		if (ch->name == NULL) {
+			return -1;
+		}
+		mdf->nChannels++;
+		ch->cg = cg;
+		ch->type = blk.data[0];
+		ch->dataType = blk.data[2];
+		ch->bitOffset = blk.data[3] & 7;
+		ch->byteOffset = (size_t)readLE32(blk.data + 4);
+		ch->bitCount = (size_t)readLE32(blk.data + 8);
+		ch->flags = readLE32(blk.data + 12);
+		ch->invalBitPos = (size_t)readLE32(blk.data + 16);
+		ch->cc = getLink(&blk, 4);
+		if ((ch->type == MDF_CN_MASTER || ch->type == MDF_CN_VIRTUAL_MASTER) &&
+			mdf->cgs[cg].master == MDF_NONE) {
+			mdf->cgs[cg].master = mdf->nChannels - 1;
+		}
+		pos = getLink(&blk, 0);
+	}
+	return 0;
+}
+
+/* Parse the block graph into the data groups, channel groups and channels */
+static int parseFile(MDFFile* mdf)
+{
+	size_t dgCapacity = 0;
+	size_t cgCapacity = 0;
+	/* Each block is visited once, more visits than blocks indicate a cycle */
+	size_t budget = mdf->len/MDF_BLOCK_HEADER_LENGTH;
+	size_t dgPos;
+	size_t i;
+	MDFBlock blk;
+
+	if (mdf->len < MDF_ID_LENGTH || 0 != memcmp(mdf->map, "MDF     ", 8) ||
+		readLE16(mdf->map + 28) < 400 || 0 != readBlock(mdf, MDF_ID_LENGTH, "HD", &blk)) {
+		errno = EINVAL;
+		return -1;
+	}
+	dgPos = getLink(&blk, 0);
+	while (dgPos != 0) {
+		MDFDataGroup* dg;
+		size_t cgPos;
+		if (budget-- == 0 || 0 != readBlock(mdf, dgPos, "DG", &blk) || blk.dataLen < 1 ||
+			0 != reserve((void**)&mdf->dgs, &dgCapacity, mdf->nDGs, sizeof(MDFDataGroup))) {
+			if (errno != ENOMEM) {
+				errno = EINVAL;
+			}
+			return -1;
+		}
+		dg = &mdf->dgs[mdf->nDGs++];
+		memset(dg, 0, sizeof(MDFDataGroup));
+		dg->data = getLink(&blk, 2);
+		dg->recIdSize = blk.data[0];
+		dg->firstCG = mdf->nCGs;
+		if (dg->recIdSize != 0 && dg->recIdSize != 1 && dg->recIdSize != 2 &&
+			dg->recIdSize != 4 && dg->recIdSize != 8) {
+			errno = EINVAL;
+			return -1;
+		}
+		cgPos = getLink(&blk, 1);
+		dgPos = getLink(&blk, 0);
+		while (cgPos != 0) {
+			MDFChannelGroup* cg;
+			if (budget-- == 0 || 0 != readBlock(mdf, cgPos, "CG", &blk) || blk.dataLen < 32 ||
+				0 != reserve((void**)&mdf->cgs, &cgCapacity, mdf->nCGs, sizeof(MDFChannelGroup))) {
+				if (errno != ENOMEM) {
+					errno = EINVAL;
+				}
+				return -1;
+			}
+			cg = &mdf->cgs[mdf->nCGs++];
+			memset(cg, 0, sizeof(MDFChannelGroup));
+			cg->dg = mdf->nDGs - 1;
+			cg->recordId = readLE64(blk.data);
+			cg->cycleCount = readLE64(blk.data + 8);
+			cg->vlsd = (readLE16(blk.data + 16) & 1) != 0;
+			cg->dataBytes = (size_t)readLE32(blk.data + 24);
+			cg->invalBytes = (size_t)readLE32(blk.data + 28);
+			cg->master = MDF_NONE;
+			mdf->dgs[cg->dg].nCGs++;
+			cgPos = getLink(&blk, 0);
+			if (!cg->vlsd && 0 != parseChannels(mdf, getLink(&blk, 1), mdf->nCGs - 1, &budget)) {
+				return -1;
+			}
+		}
+		if (mdf->dgs[mdf->nDGs - 1].recIdSize == 0 && mdf->dgs[mdf->nDGs - 1].nCGs > 1) {
+			/* Unsorted data groups need record ids */
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	/* The channels are hashed once the array is complete */
+	for (i = 0; i < mdf->nChannels; i++) {
+		MDFChannel* ch = &mdf->channels[i];
+		MDFChannel* iter;
+		HASH_FIND_STR(mdf->index, ch->name, iter);
+		if (iter == NULL) {
+			HASH_ADD_KEYPTR(hh, mdf->index, ch->name, strlen(ch->name), ch);
+		}
+	}
+	return 0;
+}
+
+/* Append the DT or DZ block at pos to the fragments of the record data */
+static int addFragment(const MDFFile* mdf, size_t pos, MDFFragments* work)
+{
+	MDFBlock blk;
+	MDFFragment* frag;
+
+	if (0 != readBlock(mdf, pos, NULL, &blk) ||
+		0 != reserve((void**)&work->frags, &work->capacity, work->nFrags, sizeof(MDFFragment))) {
+		return -1;
+	}
+	frag = &work->frags[work->nFrags];
+	memset(frag, 0, sizeof(MDFFragment));
+	if (0 == memcmp(blk.id, "DT", 2)) {
+		frag->src = blk.data;
+		frag->srcLen = blk.dataLen;
+		frag->len = blk.dataLen;
+	}
+	else if (0 == memcmp(blk.id, "DZ", 2)) {
+		int zipType;
+		if (blk.dataLen < MDF_DZ_HEADER_LENGTH || 0 != memcmp(blk.data, "DT", 2)) {
+			errno = EINVAL;
+			return -1;
+		}
+		zipType = blk.data[2];
+		frag->zipped = 1;
+		frag->columns = zipType == 1 ? (size_t)readLE32(blk.data + 4) : 0;
+		frag->len = readLE64(blk.data + 8);
+		frag->srcLen = readLE64(blk.data + 16);
+		frag->src = blk.data + MDF_DZ_HEADER_LENGTH;
+		if ((zipType != 0 && zipType != 1) || frag->srcLen > blk.dataLen - MDF_DZ_HEADER_LENGTH ||
+			frag->len == MDF_NONE) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	else {
+		errno = EINVAL;
+		return -1;
+	}
+	if (frag->len > (size_t)-1 - work->len) {
+		errno = EINVAL;
+		return -1;
+	}
+	frag->offset = work->len;
+	work->len += frag->len;
+	work->nFrags++;
+	return 0;
+}
+
+/* Collect the fragments of the data block at pos: DT, DZ or a list of
+ * them by DL or HL blocks
+ */
+static int collectFragments(const MDFFile* mdf, size_t pos, MDFFragments* work)
+{
+	size_t budget = mdf->len/MDF_BLOCK_HEADER_LENGTH;
+	MDFBlock blk;
+
+	if (0 != readBlock(mdf, pos, NULL, &blk)) {
+		return -1;
+	}
+	if (0 == memcmp(blk.id, "HL", 2)) {
+		pos = getLink(&blk, 0);
+		if (pos == 0) {
+			return 0;
+		}
+		if (0 != readBlock(mdf, pos, "DL", &blk)) {
+			return -1;
+		}
+	}
+	if (0 != memcmp(blk.id, "DL", 2)) {
+		return addFragment(mdf, pos, work);
+	}
+	while (pos != 0) {
+		size_t i;
+		if (budget-- == 0 || 0 != readBlock(mdf, pos, "DL", &blk)) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (i = 1; i < blk.nLinks; i++) {
+			size_t frag = getLink(&blk, i);
+			if (frag != 0 && 0 != addFragment(mdf, frag, work)) {
+				return -1;
+			}
+		}
+		pos = getLink(&blk, 0);
+	}
+	return 0;
+}
+
+/* Copy or inflate fragment i into the record data */
+static void loadFragment(void* data, size_t i)
+{
+	MDFFragments* work = (MDFFragments*)data;
+	MDFFragment* frag = &work->frags[i];
+	unsigned char* out = work->buf + frag->offset;
+	unsigned char* tmp = NULL;
+	uLongf len = (uLongf)frag->len;
+
+	if (!frag->zipped) {
+		memcpy(out, frag->src, frag->len);
+		return;
+	}
+	if ((size_t)len != frag->len || (size_t)(uLong)frag->srcLen != frag->srcLen) {
+		frag->rc = EINVAL;
+		return;
+	}
+	if (frag->columns > 1 && frag->len >= frag->columns) {
+		tmp = (unsigned char*)malloc(frag->len);
+		if (tmp == NULL) {
+			frag->rc = ENOMEM;
+			return;
+		}
+	}
+	if (Z_OK != uncompress(tmp != NULL ? tmp : out, &len, frag->src, (uLong)frag->srcLen) ||
+		(size_t)len != frag->len) {
+		free(tmp);
+		frag->rc = EINVAL;
+		return;
+	}
+	if (tmp != NULL) {
+		/* The leading rows*columns bytes are stored column by column */
+		size_t columns = frag->columns;
+		size_t rows = frag->len/columns;
+		size_t r, c;
+		for (c = 0; c < columns; c++) {
+			const unsigned char* col = tmp + c*rows;
+			for (r = 0; r < rows; r++) {
+				out[r*columns + c] = col[r];
+			}
+		}
+		memcpy(out + rows*columns, tmp + rows*columns, frag->len - rows*columns);
+		free(tmp);
+	}
+}
+
+/* Split the records of an unsorted data group by their record ids */
+static int splitRecords(MDFFile* mdf, MDFDataGroup* dg)
+{
+	size_t pass;
+	size_t j;
+
+	for (pass = 0; pass < 2; pass++) {
+		size_t pos = 0;
+		if (pass == 1) {
+			for (j = 0; j < dg->nCGs; j++) {
+				MDFChannelGroup* cg = &mdf->cgs[dg->firstCG + j];
+				cg->offsets = (size_t*)malloc((cg->nRecords > 0 ? cg->nRecords : 1)*sizeof(size_t));
+				if (cg->offsets == NULL) {
+					errno = ENOMEM;
+					return -1;
+				}
+				cg->nRecords = 0;
+			}
+		}
+		while (dg->len - pos > dg->recIdSize) {
+			const unsigned char* p = dg->records + pos;
+			size_t id = dg->recIdSize == 1 ? (size_t)p[0] :
+				dg->recIdSize == 2 ? readLE16(p) :
+				dg->recIdSize == 4 ? (size_t)readLE32(p) : readLE64(p);
+			MDFChannelGroup* cg = NULL;
+			size_t size;
+			for (j = 0; j < dg->nCGs; j++) {
+				if (mdf->cgs[dg->firstCG + j].recordId == id) {
+					cg = &mdf->cgs[dg->firstCG + j];
+					break;
+				}
+			}
+			if (cg == NULL) {
+				/* The length of the record is unknown */
+				errno = EINVAL;
+				return -1;
+			}
+			pos += dg->recIdSize;
+			if (cg->vlsd) {
+				if (dg->len - pos < 4) {
+					break;
+				}
+				size = 4 + (size_t)readLE32(dg->records + pos);
+			}
+			else {
+				size = cg->dataBytes + cg->invalBytes;
+			}
+			if (size > dg->len - pos) {
+				break;
+			}
+			if (pass == 1) {
+				cg->offsets[cg->nRecords] = pos;
+			}
+			cg->nRecords++;
+			pos += size;
+		}
+	}
+	return 0;
+}
+
+/* Assemble the record data of a data group and count the records of its
+ * channel groups
+ */
+static int loadRecords(MDFFile* mdf, MDFDataGroup* dg)
+{
+	MDFFragments work;
+	size_t j;
+
+	if (dg->records != NULL) {
+		return 0;
+	}
+	ED_TRACE_PARSE_BEGIN("loadRecords", mdf->fileName);
+	memset(&work, 0, sizeof(work));
+	if (dg->data != 0 && 0 != collectFragments(mdf, dg->data, &work)) {
+		free(work.frags);
+		return -1;
+	}
+	if (work.nFrags == 1 && !work.frags[0].zipped) {
+		dg->records = work.frags[0].src;
+	}
+	else {
+		size_t i;
+		work.buf = (unsigned char*)malloc(work.len > 0 ? work.len : 1);
+		if (work.buf == NULL) {
+			free(work.frags);
+			errno = ENOMEM;
+			return -1;
+		}
+		ED_parallelFor(work.nFrags, loadFragment, &work);
+		for (i = 0; i < work.nFrags; i++) {
+			if (work.frags[i].rc != 0) {
+				errno = work.frags[i].rc;
+				free(work.frags);
+				free(work.buf);
+				return -1;
+			}
+		}
+		dg->buf = work.buf;
+		dg->records = work.buf;
+	}
+	dg->len = work.len;
+	free(work.frags);
+	ED_TRACE_PARSE_END("loadRecords", mdf->fileName, work.len);
+
+	if (dg->recIdSize == 0) {
+		MDFChannelGroup* cg = &mdf->cgs[dg->firstCG];
+		size_t stride = cg->dataBytes + cg->invalBytes;
+		cg->nRecords = cg->cycleCount;
+		if (stride > 0 && cg->nRecords > dg->len/stride) {
+			cg->nRecords = dg->len/stride;
+		}
+		return 0;
+	}
+	for (j = 0; j < dg->nCGs; j++) {
+		mdf->cgs[dg->firstCG + j].nRecords = 0;
+	}
+	if (0 != splitRecords(mdf, dg)) {
+		for (j = 0; j < dg->nCGs; j++) {
+			free(mdf->cgs[dg->firstCG + j].offsets);
+			mdf->cgs[dg->firstCG + j].offsets = NULL;
+		}
+		free(dg->buf);
+		dg->buf = NULL;
+		dg->records = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+static const unsigned char* getRecord(const MDFFile* mdf, const MDFChannelGroup* cg, size_t i)
+{
+	const MDFDataGroup* dg = &mdf->dgs[cg->dg];
+	return dg->records + (cg->offsets != NULL ? cg->offsets[i] :
+		i*(cg->dataBytes + cg->invalBytes));
+}
+
+/* Release the record data and the mapping, the index is kept */
+static void trimMDF(void* _mdf)
+{
+	closeFile((MDFFile*)_mdf);
+}
+
+void* ED_createMDF(const char* fileName, int verbose)
+{
+	MDFFile* mdf;
+	ED_TRACE_CREATE_BEGIN("MDF", fileName);
+	mdf = (MDFFile*)calloc(1, sizeof(MDFFile));
+	if (mdf == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	mdf->fileName = strdup(fileName);
+	if (mdf->fileName == NULL) {
+		free(mdf);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	if (0 != openFile(mdf, 0)) {
+		free(mdf->fileName);
+		free(mdf);
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", fileName);
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("parseFile", fileName);
+	if (0 != parseFile(mdf)) {
+		int unfinalized = mdf->len >= 8 && 0 == memcmp(mdf->map, "UnFinMF ", 8);
+		int rc = errno;
+		freeIndex(mdf);
+		closeFile(mdf);
+		free(mdf->fileName);
+		free(mdf);
+		if (rc == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
+		else if (unfinalized) {
+			ModelicaFormatError("Cannot read unfinalized MDF file \"%s\"\n", fileName);
+		}
+		else {
+			ModelicaFormatError("Cannot parse file \"%s\": "
+				"Invalid or unsupported ASAM MDF 4 file\n", fileName);
+		}
+		return NULL;
+	}
+
+	ED_TRACE_PARSE_END("parseFile", fileName, mdf->len);
+
+	mdf->trim = ED_trimRegister(mdf, trimMDF);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("MDF", fileName, mdf);
+	return mdf;
+}
+
+void ED_destroyMDF(void* _mdf)
+{
+	MDFFile* mdf = (MDFFile*)_mdf;
+	if (mdf != NULL) {
+		ED_TRACE_DESTROY("MDF", mdf->fileName);
+		ED_trimUnregister(mdf->trim);
+		closeFile(mdf);
+		freeIndex(mdf);
+		free(mdf->fileName);
+		free(mdf);
+		ED_parallelRelease();
+	}
+}
+
+/* Prepare the decoding of a channel, raises an error if not numeric */
+static void initDecoder(const MDFFile* mdf, const MDFChannel* ch, MDFDecoder* dec)
+{
+	const MDFChannelGroup* cg = &mdf->cgs[ch->cg];
+	MDFBlock blk;
+
+	memset(dec, 0, sizeof(MDFDecoder));
+	if (ch->type == MDF_CN_VIRTUAL_MASTER || ch->type == MDF_CN_VIRTUAL_DATA) {
+		dec->kind = 3;
+	}
+	else if (ch->type == MDF_CN_VLSD || ch->dataType > MDF_FLOAT_BE ||
+		ch->bitCount == 0 || ch->bitCount > 64 ||
+		(ch->dataType >= MDF_FLOAT_LE && ((ch->bitCount != 32 && ch->bitCount != 64) || ch->bitOffset != 0))) {
+		ModelicaFormatError("Cannot read channel \"%s\" of non-numeric or "
+			"unsupported data type from file \"%s\"\n", ch->name, mdf->fileName);
+		return;
+	}
+	else {
+		dec->kind = ch->dataType >= MDF_FLOAT_LE ? 2 : ch->dataType >= MDF_INT_LE ? 1 : 0;
+		dec->bigEndian = ch->dataType == MDF_UINT_BE || ch->dataType == MDF_INT_BE ||
+			ch->dataType == MDF_FLOAT_BE;
+		dec->byteOffset = ch->byteOffset;
+		dec->bitOffset = ch->bitOffset;
+		dec->bitCount = ch->bitCount;
+		dec->nBytes = ((size_t)ch->bitOffset + ch->bitCount + 7)/8;
+		if (dec->byteOffset > cg->dataBytes || dec->nBytes > cg->dataBytes - dec->byteOffset) {
+			ModelicaFormatError("Cannot read channel \"%s\" beyond the record "
+				"of its channel group from file \"%s\"\n", ch->name, mdf->fileName);
+			return;
+		}
+	}
+	dec->allInvalid = (ch->flags & 1) != 0;
+	if ((ch->flags & 2) != 0 && ch->invalBitPos/8 < cg->invalBytes) {
+		dec->invalByte = cg->dataBytes + ch->invalBitPos/8;
+		dec->invalMask = (unsigned char)(1 << (ch->invalBitPos % 8));
+	}
+
+	dec->ccType = MDF_CC_IDENTITY;
+	if (ch->cc != 0) {
+		size_t nVal;
+		if (0 != readBlock(mdf, ch->cc, "CC", &blk) || blk.dataLen < 24 ||
+			8*readLE16(blk.data + 6) > blk.dataLen - 24) {
+			ModelicaFormatError("Cannot read conversion of channel \"%s\" "
+				"from file \"%s\"\n", ch->name, mdf->fileName);
+			return;
+		}
+		dec->ccType = blk.data[0];
+		dec->nVal = nVal = readLE16(blk.data + 6);
+		dec->val = blk.data + 24;
+		if ((dec->ccType == MDF_CC_LINEAR && nVal < 2) ||
+			(dec->ccType == MDF_CC_RATIONAL && nVal < 6) ||
+			((dec->ccType == MDF_CC_TAB_INTERP || dec->ccType == MDF_CC_TAB) && (nVal < 2 || nVal % 2 != 0)) ||
+			(dec->ccType == MDF_CC_RANGE && (nVal < 1 || nVal % 3 != 1)) ||
+			dec->ccType == 3 || dec->ccType > MDF_CC_RANGE) {
+			ModelicaFormatError("Cannot read channel \"%s\" with non-numeric or "
+				"unsupported conversion from file \"%s\"\n", ch->name, mdf->fileName);
+		}
+	}
+}
+
+static double getVal(const MDFDecoder* dec, size_t i)
+{
+	return readFloat(dec->val + 8*i, 8, 0);
+}
+
+/* Physical value of the raw value x */
+static double convert(const MDFDecoder* dec, double x)
+{
+	switch (dec->ccType) {
+		case MDF_CC_LINEAR:
+			return getVal(dec, 0) + getVal(dec, 1)*x;
+
+		case MDF_CC_RATIONAL:
+			return ((getVal(dec, 0)*x + getVal(dec, 1))*x + getVal(dec, 2))/
+				((getVal(dec, 3)*x + getVal(dec, 4))*x + getVal(dec, 5));
+
+		case MDF_CC_TAB_INTERP:
+		case MDF_CC_TAB: {
+			/* Pairs of raw and physical values sorted by raw value */
+			size_t n = dec->nVal/2;
+			size_t lo = 0;
+			size_t hi = n - 1;
+			double x0, x1;
+			if (x <= getVal(dec, 0)) {
+				return getVal(dec, 1);
+			}
+			if (x >= getVal(dec, 2*hi)) {
+				return getVal(dec, 2*hi + 1);
+			}
+			while (hi - lo > 1) {
+				size_t mid = lo + (hi - lo)/2;
+				if (getVal(dec, 2*mid) <= x) {
+					lo = mid;
+				}
+				else {
+					hi = mid;
+				}
+			}
+			x0 = getVal(dec, 2*lo);
+			x1 = getVal(dec, 2*hi);
+			if (dec->ccType == MDF_CC_TAB) {
+				return getVal(dec, 2*(x - x0 <= x1 - x ? lo : hi) + 1);
+			}
+			return getVal(dec, 2*lo + 1) + (x - x0)/(x1 - x0)*
+				(getVal(dec, 2*hi + 1) - getVal(dec, 2*lo + 1));
+		}
+
+		case MDF_CC_RANGE: {
+			/* Triples of lower and upper raw value and physical value,
+			 * followed by the default value
+			 */
+			size_t n = dec->nVal/3;
+			size_t i;
+			for (i = 0; i < n; i++) {
+				double lower = getVal(dec, 3*i);
+				double upper = getVal(dec, 3*i + 1);
+				if (x >= lower && (x < upper || (dec->kind != 2 && x == upper))) {
+					return getVal(dec, 3*i + 2);
+				}
+			}
+			return getVal(dec, 3*n);
+		}
+
+		default:
+			return x;
+	}
+}
+
+/* Keep the low bitCount bits of the 64-bit integer of the 32-bit halves
+ * lo and hi
+ */
+static void maskBits(unsigned long* lo, unsigned long* hi, size_t bitCount)
+{
+	if (bitCount < 32) {
+		*lo &= (1UL << bitCount) - 1;
+		*hi = 0;
+	}
+	else if (bitCount < 64) {
+		*hi &= (1UL << (bitCount - 32)) - 1;
+	}
+}
+
+/* Physical value of the channel in record rec with record index i */
+static double decode(const MDFDecoder* dec, const unsigned char* rec, size_t i)
+{
+	const unsigned char* p = rec + dec->byteOffset;
+	double x;
+
+	if (dec->kind == 3) {
+		x = (double)i;
+	}
+	else if (dec->kind == 2) {
+		x = readFloat(p, dec->nBytes, dec->bigEndian);
+	}
+	else {
+		unsigned char b[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+		unsigned long lo = 0;
+		unsigned long hi = 0;
+		size_t k;
+		for (k = 0; k < dec->nBytes; k++) {
+			b[k] = dec->bigEndian ? p[dec->nBytes - 1 - k] : p[k];
+		}
+		for (k = 0; k < 8; k++) {
+			unsigned long v = dec->bitOffset == 0 ? b[k] :
+				((b[k] >> dec->bitOffset) | (b[k + 1] << (8 - dec->bitOffset))) & 0xFFUL;
+			if (k < 4) {
+				lo |= v << (8*k);
+			}
+			else {
+				hi |= v << (8*(k - 4));
+			}
+		}
+		maskBits(&lo, &hi, dec->bitCount);
+		if (dec->kind == 1 && (dec->bitCount > 32 ?
+			(hi >> (dec->bitCount - 33)) & 1 : (lo >> (dec->bitCount - 1)) & 1)) {
+			/* Magnitude of the two's complement */
+			lo = ~lo & 0xFFFFFFFFUL;
+			hi = ~hi & 0xFFFFFFFFUL;
+			maskBits(&lo, &hi, dec->bitCount);
+			lo = (lo + 1) & 0xFFFFFFFFUL;
+			if (lo == 0) {
+				hi++;
+			}
+			x = -((double)hi*4294967296.0 + (double)lo);
+		}
+		else {
+			x = (double)hi*4294967296.0 + (double)lo;
+		}
+	}
+	return dec->ccType == MDF_CC_IDENTITY ? x : convert(dec, x);
+}
+
+static int isValid(const MDFDecoder* dec, const unsigned char* rec)
+{
+	return !dec->allInvalid && (dec->invalMask == 0 || (rec[dec->invalByte] & dec->invalMask) == 0);
+}
+
+/* Open and load the channel group of a channel, raises an error on failure */
+static const MDFChannel* findChannel(MDFFile* mdf, const char* channelName)
+{
+	MDFChannel* ch;
+	MDFDataGroup* dg;
+
+	if (mdf->map == NULL && 0 != openFile(mdf, mdf->len)) {
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", mdf->fileName);
+		return NULL;
+	}
+	HASH_FIND_STR(mdf->index, channelName, ch);
+	if (ch == NULL) {
+		ModelicaFormatError("Cannot find channel \"%s\" in file \"%s\"\n",
+			channelName, mdf->fileName);
+		return NULL;
+	}
+	if (mdf->cgs[ch->cg].master == MDF_NONE) {
+		ModelicaFormatError("Cannot read channel \"%s\" without master channel "
+			"from file \"%s\"\n", channelName, mdf->fileName);
+		return NULL;
+	}
+	dg = &mdf->dgs[mdf->cgs[ch->cg].dg];
+	if (0 != loadRecords(mdf, dg)) {
+		if (errno == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
+		else {
+			ModelicaFormatError("Cannot read data of channel \"%s\" from file \"%s\"\n",
+				channelName, mdf->fileName);
+		}
+		return NULL;
+	}
+	return ch;
+}
+
+/* Read the valid samples of a channel into a, up to m rows, and return
+ * their number (all of them if a is NULL)
+ */
+static size_t readSamples(const MDFFile* mdf, const MDFChannel* ch, double* a, size_t m)
+{
+	const MDFChannelGroup* cg = &mdf->cgs[ch->cg];
+	MDFDecoder x;
+	MDFDecoder t;
+	size_t i;
+	size_t k = 0;
+
+	initDecoder(mdf, ch, &x);
+	initDecoder(mdf, &mdf->channels[cg->master], &t);
+	if (a == NULL && !x.allInvalid && x.invalMask == 0) {
+		return cg->nRecords;
+	}
+	for (i = 0; i < cg->nRecords && (a == NULL || k < m); i++) {
+		const unsigned char* rec = getRecord(mdf, cg, i);
+		if (isValid(&x, rec)) {
+			if (a != NULL) {
+				a[2*k] = decode(&t, rec, i);
+				a[2*k + 1] = decode(&x, rec, i);
+			}
+			k++;
+		}
+	}
+	return k;
+}
+
+void ED_getTimeSeriesSizeFromMDF(void* _mdf, const char* channelName, int* dim)
+{
+	MDFFile* mdf = (MDFFile*)_mdf;
+	if (mdf != NULL) {
+		const MDFChannel* ch;
+		ED_TRACE_GET_BEGIN(mdf->fileName, channelName);
+		ED_trimEnter(mdf->trim);
+		ch = findChannel(mdf, channelName);
+		if (ch != NULL) {
+			dim[0] = (int)readSamples(mdf, ch, NULL, 0);
+			dim[1] = 2;
+		}
+		ED_TRACE_GET_END(mdf->fileName, channelName, 0);
+		ED_trimLeave(mdf->trim);
+	}
+}
+
+void ED_getTimeSeriesFromMDF(void* _mdf, const char* channelName, double* a, size_t m, size_t n)
+{
+	MDFFile* mdf = (MDFFile*)_mdf;
+	if (mdf != NULL) {
+		const MDFChannel* ch;
+		size_t nRows;
+		if (n != 2) {
+			ModelicaFormatError("Cannot read %lu columns of time series of channel \"%s\" "
+				"from file \"%s\", must be 2\n", (unsigned long)n, channelName, mdf->fileName);
+			return;
+		}
+		ED_TRACE_GET_BEGIN(mdf->fileName, channelName);
+		ED_trimEnter(mdf->trim);
+		ch = findChannel(mdf, channelName);
+		if (ch == NULL) {
+			return;
+		}
+		nRows = readSamples(mdf, ch, a, m);
+		if (nRows < m) {
+			ModelicaFormatError("Cannot read %lu rows of time series of channel \"%s(%lu,2)\" "
+				"from file \"%s\"\n", (unsigned long)m, channelName, (unsigned long)nRows,
+				mdf->fileName);
+			return;
+		}
+		ED_TRACE_GET_END(mdf->fileName, channelName, m*n);
+		ED_trimLeave(mdf->trim);
+	}
+}
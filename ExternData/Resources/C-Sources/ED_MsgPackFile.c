@@ -0,0 +1,463 @@
+/* ED_MsgPackFile.c - MessagePack functions
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#define strdup _strdup
+#endif
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_trace.h"
+#include "ED_bindoc.h"
+#include "ModelicaUtilities.h"
+#include "../Include/ED_trim.h"
+#include "../Include/ED_MsgPackFile.h"
+
+/* Reader of MessagePack documents. The file is mapped and the values are
+ * found by walking the maps of the dotted element name in place, without
+ * building a tree (see ED_bindoc.h). The mapping is released when the
+ * handle is trimmed.
+ */
+
+typedef struct {
+	char* fileName;
+	ED_VFILE* fp; /* Open while the content is mapped */
+	const unsigned char* map; /* Content, NULL if trimmed */
+	char* buf; /* Content if the file cannot be mapped */
+	size_t len;
+	ED_TrimEntry* trim;
+} MsgPackFile;
+
+/* Big-endian length of n (1, 2 or 4) bytes */
+static size_t readLength(const unsigned char* p, size_t n)
+{
+	size_t v = 0;
+	size_t k;
+	for (k = 0; k < n; k++) {
+		v = (v << 8) | p[k];
+	}
+	return v;
+}
+
+static int readMsgPack(const unsigned char* p, size_t len, size_t pos, ED_BinItem* item)
+{
+	unsigned int b;
+	size_t n = 0; /* Bytes of the length or the value */
+	size_t payload = 0; /* Bytes following the length */
+
+	if (pos >= len) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(item, 0, sizeof(ED_BinItem));
+	b = p[pos++];
+	if (b <= 0x7F || b >= 0xE0) {
+		/* Positive or negative fixint */
+		item->kind = ED_BINDOC_NUMBER;
+		item->isInt = 1;
+		item->value = b <= 0x7F ? (double)b : (double)b - 256.0;
+	}
+	else if (b <= 0x8F) {
+		item->kind = ED_BINDOC_MAP;
+		item->count = b & 0x0F;
+	}
+	else if (b <= 0x9F) {
+		item->kind = ED_BINDOC_ARRAY;
+		item->count = b & 0x0F;
+	}
+	else if (b <= 0xBF) {
+		item->kind = ED_BINDOC_STRING;
+		item->count = b & 0x1F;
+	}
+	else {
+		switch (b) {
+			case 0xC0:
+				item->kind = ED_BINDOC_NIL;
+				break;
+
+			case 0xC2:
+			case 0xC3:
+				item->kind = ED_BINDOC_BOOL;
+				item->isInt = 1;
+				item->value = b == 0xC3 ? 1.0 : 0.0;
+				break;
+
+			case 0xC4: /* bin 8, 16, 32 */
+			case 0xC5:
+			case 0xC6:
+				item->kind = ED_BINDOC_BYTES;
+				n = (size_t)1 << (b - 0xC4);
+				break;
+
+			case 0xC7: /* ext 8, 16, 32 */
+			case 0xC8:
+			case 0xC9:
+				item->kind = ED_BINDOC_OTHER;
+				n = (size_t)1 << (b - 0xC7);
+				payload = 1; /* Type */
+				break;
+
+			case 0xCA: /* float 32, 64 */
+			case 0xCB:
+			case 0xCC: /* uint 8, 16, 32, 64 */
+			case 0xCD:
+			case 0xCE:
+			case 0xCF:
+			case 0xD0: /* int 8, 16, 32, 64 */
+			case 0xD1:
+			case 0xD2:
+			case 0xD3:
+				n = b <= 0xCB ? (size_t)4 << (b - 0xCA) : (size_t)1 << ((b - 0xCC) & 3);
+				if (n > len - pos) {
+					errno = EINVAL;
+					return -1;
+				}
+				item->kind = ED_BINDOC_NUMBER;
+				if (b <= 0xCB) {
+					item->value = ED_bindocReadFloat(p + pos, n, 1);
+				}
+				else {
+					item->isInt = 1;
+					item->value = ED_bindocReadInt(p + pos, n, b >= 0xD0, 1);
+				}
+				pos += n;
+				n = 0;
+				break;
+
+			case 0xD4: /* fixext 1, 2, 4, 8, 16 */
+			case 0xD5:
+			case 0xD6:
+			case 0xD7:
+			case 0xD8:
+				item->kind = ED_BINDOC_OTHER;
+				item->count = ((size_t)1 << (b - 0xD4)) + 1;
+				break;
+
+			case 0xD9: /* str 8, 16, 32 */
+			case 0xDA:
+			case 0xDB:
+				item->kind = ED_BINDOC_STRING;
+				n = (size_t)1 << (b - 0xD9);
+				break;
+
+			case 0xDC: /* array 16, 32 */
+			case 0xDD:
+				item->kind = ED_BINDOC_ARRAY;
+				n = (size_t)2 << (b - 0xDC);
+				break;
+
+			case 0xDE: /* map 16, 32 */
+			case 0xDF:
+				item->kind = ED_BINDOC_MAP;
+				n = (size_t)2 << (b - 0xDE);
+				break;
+
+			default: /* 0xC1 is never used */
+				errno = EINVAL;
+				return -1;
+		}
+	}
+	if (n > 0) {
+		if (n > len - pos) {
+			errno = EINVAL;
+			return -1;
+		}
+		item->count = readLength(p + pos, n);
+		pos += n;
+	}
+	if (item->kind != ED_BINDOC_ARRAY && item->kind != ED_BINDOC_MAP) {
+		/* Skip the payload of strings, binary and extension data */
+		if (payload > len - pos || item->count > len - pos - payload) {
+			errno = EINVAL;
+			return -1;
+		}
+		item->data = p + pos + payload;
+		pos += payload + item->count;
+	}
+	item->next = pos;
+	return 0;
+}
+
+static void closeFile(MsgPackFile* mp)
+{
+	if (mp->fp != NULL) {
+		ED_vfclose(mp->fp);
+		mp->fp = NULL;
+	}
+	free(mp->buf);
+	mp->buf = NULL;
+	mp->map = NULL;
+}
+
+/* Map the file, or read it if it cannot be mapped */
+static int openFile(MsgPackFile* mp)
+{
+	const char* map;
+	mp->fp = ED_vfopen(mp->fileName);
+	if (mp->fp == NULL) {
+		return -1;
+	}
+	map = ED_vfmap(mp->fp, &mp->len);
+	if (map == NULL) {
+		mp->buf = ED_vfreadall(mp->fp, &mp->len);
+		ED_vfclose(mp->fp);
+		mp->fp = NULL;
+		if (mp->buf == NULL) {
+			return -1;
+		}
+		map = mp->buf;
+	}
+	mp->map = (const unsigned char*)map;
+	return 0;
+}
+
+/* Release the mapping, it is opened again on the next access */
+static void trimMsgPack(void* _mp)
+{
+	closeFile((MsgPackFile*)_mp);
+}
+
+void* ED_createMsgPack(const char* fileName, int verbose)
+{
+	ED_BinItem root;
+	MsgPackFile* mp;
+	ED_TRACE_CREATE_BEGIN("MsgPack", fileName);
+	mp = (MsgPackFile*)calloc(1, sizeof(MsgPackFile));
+	if (mp == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	mp->fileName = strdup(fileName);
+	if (mp->fileName == NULL) {
+		free(mp);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	if (0 != openFile(mp)) {
+		int rc = errno;
+		free(mp->fileName);
+		free(mp);
+		ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(rc));
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("readMsgPack", fileName);
+	if (0 != readMsgPack(mp->map, mp->len, 0, &root)) {
+		closeFile(mp);
+		free(mp->fileName);
+		free(mp);
+		ModelicaFormatError("Cannot parse file \"%s\": Invalid MessagePack document\n", fileName);
+		return NULL;
+	}
+
+	ED_TRACE_PARSE_END("readMsgPack", fileName, mp->len);
+
+	mp->trim = ED_trimRegister(mp, trimMsgPack);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("MsgPack", fileName, mp);
+	return mp;
+}
+
+void ED_destroyMsgPack(void* _mp)
+{
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_TRACE_DESTROY("MsgPack", mp->fileName);
+		ED_trimUnregister(mp->trim);
+		closeFile(mp);
+		free(mp->fileName);
+		free(mp);
+		ED_parallelRelease();
+	}
+}
+
+/* Raise the error of errno for the element varName, value is the kind of
+ * the expected value
+ */
+static void raiseError(const MsgPackFile* mp, const char* varName, const char* value)
+{
+	if (errno == ENOENT) {
+		ModelicaFormatError("Cannot read element \"%s\" from file \"%s\"\n",
+			varName, mp->fileName);
+	}
+	else if (errno == EDOM) {
+		ModelicaFormatError("Cannot read %s value of element \"%s\" from file \"%s\"\n",
+			value, varName, mp->fileName);
+	}
+	else {
+		ModelicaFormatError("Cannot parse file \"%s\": Invalid MessagePack document\n",
+			mp->fileName);
+	}
+}
+
+/* Document of the handle and offset of the value of varName, raises an
+ * error on failure
+ */
+static size_t findValue(MsgPackFile* mp, const char* varName, ED_BinDoc* doc)
+{
+	size_t pos = 0;
+	if (mp->map == NULL && 0 != openFile(mp)) {
+		ModelicaFormatError("Cannot read \"%s\": %s\n", mp->fileName, strerror(errno));
+		return 0;
+	}
+	doc->p = mp->map;
+	doc->len = mp->len;
+	doc->read = readMsgPack;
+	if (0 != ED_bindocFind(doc, varName, &pos)) {
+		raiseError(mp, varName, "");
+	}
+	return pos;
+}
+
+double ED_getDoubleFromMsgPack(void* _mp, const char* varName)
+{
+	double ret = 0.;
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(mp->fileName, varName);
+		ED_trimEnter(mp->trim);
+		pos = findValue(mp, varName, &doc);
+		if (0 != ED_bindocGetDouble(&doc, pos, &ret)) {
+			raiseError(mp, varName, "double");
+		}
+		ED_TRACE_GET_END(mp->fileName, varName, 1);
+		ED_trimLeave(mp->trim);
+	}
+	return ret;
+}
+
+const char* ED_getStringFromMsgPack(void* _mp, const char* varName)
+{
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_BinDoc doc;
+		ED_BinItem item;
+		size_t pos;
+		char* ret;
+		ED_TRACE_GET_BEGIN(mp->fileName, varName);
+		ED_trimEnter(mp->trim);
+		pos = findValue(mp, varName, &doc);
+		if (0 != doc.read(doc.p, doc.len, pos, &item)) {
+			raiseError(mp, varName, "string");
+		}
+		if (item.kind != ED_BINDOC_STRING) {
+			errno = EDOM;
+			raiseError(mp, varName, "string");
+		}
+		ret = ModelicaAllocateString(item.count);
+		memcpy(ret, item.data, item.count);
+		ret[item.count] = '\0';
+		ED_TRACE_GET_END(mp->fileName, varName, 1);
+		ED_trimLeave(mp->trim);
+		return (const char*)ret;
+	}
+	return "";
+}
+
+int ED_getIntFromMsgPack(void* _mp, const char* varName)
+{
+	int ret = 0;
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_BinDoc doc;
+		ED_BinItem item;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(mp->fileName, varName);
+		ED_trimEnter(mp->trim);
+		pos = findValue(mp, varName, &doc);
+		if (0 != doc.read(doc.p, doc.len, pos, &item)) {
+			raiseError(mp, varName, "int");
+		}
+		if ((item.kind != ED_BINDOC_NUMBER && item.kind != ED_BINDOC_BOOL) ||
+			!item.isInt || item.value < -2147483648.0 || item.value > 2147483647.0) {
+			errno = EDOM;
+			raiseError(mp, varName, "int");
+		}
+		ret = (int)item.value;
+		ED_TRACE_GET_END(mp->fileName, varName, 1);
+		ED_trimLeave(mp->trim);
+	}
+	return ret;
+}
+
+void ED_getArray2DSizeFromMsgPack(void* _mp, const char* varName, int* dim)
+{
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		size_t m = 0;
+		size_t n = 0;
+		ED_TRACE_GET_BEGIN(mp->fileName, varName);
+		ED_trimEnter(mp->trim);
+		pos = findValue(mp, varName, &doc);
+		if (0 != ED_bindocGetSize(&doc, pos, &m, &n)) {
+			raiseError(mp, varName, "numeric");
+		}
+		dim[0] = (int)m;
+		dim[1] = (int)n;
+		ED_TRACE_GET_END(mp->fileName, varName, 0);
+		ED_trimLeave(mp->trim);
+	}
+}
+
+void ED_getDoubleArray1DFromMsgPack(void* _mp, const char* varName, double* a, size_t n)
+{
+	MsgPackFile* mp = (MsgPackFile*)_mp;
+	if (mp != NULL) {
+		ED_BinDoc doc;
+		size_t pos;
+		ED_TRACE_GET_BEGIN(mp->fileName, varName);
+		ED_trimEnter(mp->trim);
+		pos = findValue(mp, varName, &doc);
+		if (0 != ED_bindocReadArray(&doc, pos, a, n)) {
+			if (errno == ERANGE) {
+				ModelicaFormatError("Cannot read %lu double values of element \"%s\" "
+					"from file \"%s\"\n", (unsigned long)n, varName, mp->fileName);
+			}
+			raiseError(mp, varName, "double");
+		}
+		ED_TRACE_GET_END(mp->fileName, varName, n);
+		ED_trimLeave(mp->trim);
+	}
+}
+
+void ED_getDoubleArray2DFromMsgPack(void* _mp, const char* varName, double* a, size_t m, size_t n)
+{
+	ED_getDoubleArray1DFromMsgPack(_mp, varName, a, m*n);
+}
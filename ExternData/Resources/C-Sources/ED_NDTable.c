@@ -0,0 +1,250 @@
+/* ED_NDTable.c - N-dimensional gridded lookup tables
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "ED_NDTable.h"
+
+/* Relative tolerance to detect equidistant grid points */
+#define ED_NDTABLE_UNIFORM_TOL (1e-12)
+
+typedef struct {
+	const double* x; /* Grid points */
+	size_t n; /* Number of grid points */
+	size_t last; /* Cached interval of the previous search */
+	int uniform; /* 1 if the grid points are equidistant */
+	double invDx; /* Inverse grid spacing of uniform axis */
+} NDAxis;
+
+struct ED_NDTable {
+	size_t nDims;
+	NDAxis axis[ED_NDTABLE_MAX_DIMS];
+	double* axisData[ED_NDTABLE_MAX_DIMS];
+	size_t stride[ED_NDTABLE_MAX_DIMS];
+	size_t active[ED_NDTABLE_MAX_DIMS]; /* Axes with more than one grid point */
+	size_t nActive;
+	double* data;
+	size_t* corner; /* Offsets of the 2^nActive cell corners from the base */
+	double* work; /* Corner values */
+	int extrapolation;
+};
+
+ED_NDTable* ED_ndtableCreate(size_t nDims, const size_t* n, double** axes,
+	double* data, int extrapolation)
+{
+	ED_NDTable* table;
+	size_t nCorners;
+	size_t d;
+	size_t stride = 1;
+
+	table = (ED_NDTable*)calloc(1, sizeof(ED_NDTable));
+	if (table == NULL || nDims == 0 || nDims > ED_NDTABLE_MAX_DIMS) {
+		for (d = 0; d < nDims; d++) {
+			free(axes[d]);
+		}
+		free(data);
+		free(table);
+		errno = table == NULL ? ENOMEM : EINVAL;
+		return NULL;
+	}
+	table->nDims = nDims;
+	table->data = data;
+	table->extrapolation = extrapolation;
+	for (d = 0; d < nDims; d++) {
+		NDAxis* ax = &table->axis[d];
+		table->axisData[d] = axes[d];
+		ax->x = axes[d];
+		ax->n = n[d];
+		table->stride[d] = stride;
+		stride *= n[d];
+		if (n[d] > 1) {
+			double x0 = ax->x[0];
+			double dx = (ax->x[n[d] - 1] - x0)/(double)(n[d] - 1);
+			size_t i;
+			ax->uniform = dx > 0;
+			for (i = 1; i < n[d] && ax->uniform; i++) {
+				if (fabs(ax->x[i] - (x0 + (double)i*dx)) > ED_NDTABLE_UNIFORM_TOL*(ax->x[n[d] - 1] - x0)) {
+					ax->uniform = 0;
+				}
+			}
+			ax->invDx = ax->uniform ? 1.0/dx : 0.0;
+			table->active[table->nActive++] = d;
+		}
+	}
+
+	/* Corner offsets only depend on the strides */
+	nCorners = (size_t)1 << table->nActive;
+	table->corner = (size_t*)malloc(nCorners*sizeof(size_t));
+	table->work = (double*)malloc(nCorners*sizeof(double));
+	if (table->corner == NULL || table->work == NULL) {
+		ED_ndtableFree(table);
+		errno = ENOMEM;
+		return NULL;
+	}
+	table->corner[0] = 0;
+	for (d = 0; d < table->nActive; d++) {
+		size_t half = (size_t)1 << d;
+		size_t j;
+		for (j = 0; j < half; j++) {
+			table->corner[half + j] = table->corner[j] + table->stride[table->active[d]];
+		}
+	}
+	return table;
+}
+
+void ED_ndtableFree(ED_NDTable* table)
+{
+	if (table != NULL) {
+		size_t d;
+		for (d = 0; d < table->nDims; d++) {
+			free(table->axisData[d]);
+		}
+		free(table->data);
+		free(table->corner);
+		free(table->work);
+		free(table);
+	}
+}
+
+size_t ED_ndtableDims(const ED_NDTable* table)
+{
+	return table != NULL ? table->nDims : 0;
+}
+
+/* Largest i in [lo, hi) with x[i] <= u */
+static size_t bisect(const double* x, size_t lo, size_t hi, double u)
+{
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo)/2;
+		if (x[mid] <= u) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Find the interval i with x[i] <= u < x[i + 1] and the weight of x[i + 1].
+ * Returns -1 if u is outside the grid and extrapolation is disabled.
+ */
+static int findInterval(NDAxis* ax, int extrapolation, double u, size_t* idx, double* t)
+{
+	const double* x = ax->x;
+	size_t n = ax->n;
+	size_t i;
+
+	if (u < x[0] || u > x[n - 1]) {
+		if (extrapolation == ED_NDTABLE_NO_EXTRAPOLATION) {
+			return -1;
+		}
+		else if (extrapolation == ED_NDTABLE_PERIODIC) {
+			double period = x[n - 1] - x[0];
+			u = fmod(u - x[0], period);
+			if (u < 0) {
+				u += period;
+			}
+			u += x[0];
+		}
+		else if (extrapolation == ED_NDTABLE_HOLD_LAST_POINT) {
+			u = u < x[0] ? x[0] : x[n - 1];
+		}
+	}
+
+	if (ax->uniform) {
+		/* Equidistant grid points: Direct index computation */
+		double k = (u - x[0])*ax->invDx;
+		if (!(k > 0)) {
+			i = 0;
+		}
+		else if (k >= (double)(n - 2)) {
+			i = n - 2;
+		}
+		else {
+			i = (size_t)k;
+		}
+		*idx = i;
+		*t = k - (double)i;
+		return 0;
+	}
+
+	/* Start from the cached interval, queries are mostly local */
+	i = ax->last;
+	if (u >= x[i]) {
+		if (i + 2 < n && u >= x[i + 1]) {
+			i = i + 3 < n && u >= x[i + 2] ? bisect(x, i + 2, n - 1, u) : i + 1;
+		}
+	}
+	else {
+		i = i > 0 && u >= x[i - 1] ? i - 1 : bisect(x, 0, i, u);
+	}
+	ax->last = i;
+	*idx = i;
+	*t = (u - x[i])/(x[i + 1] - x[i]);
+	return 0;
+}
+
+size_t ED_ndtableEval(ED_NDTable* table, const double* u, size_t nPoints, double* y)
+{
+	size_t p;
+	if (table == NULL) {
+		return 0;
+	}
+	for (p = 0; p < nPoints; p++) {
+		const double* up = u + p*table->nDims;
+		const double* base = table->data;
+		double* v = table->work;
+		double t[ED_NDTABLE_MAX_DIMS];
+		size_t nCorners = (size_t)1 << table->nActive;
+		size_t c;
+		size_t k;
+
+		for (k = 0; k < table->nActive; k++) {
+			size_t d = table->active[k];
+			size_t i;
+			if (0 != findInterval(&table->axis[d], table->extrapolation, up[d], &i, &t[k])) {
+				return p;
+			}
+			base += i*table->stride[d];
+		}
+
+		/* Gather the cell corners and reduce one axis after the other */
+		for (c = 0; c < nCorners; c++) {
+			v[c] = base[table->corner[c]];
+		}
+		for (k = 0; k < table->nActive; k++) {
+			double tk = t[k];
+			nCorners >>= 1;
+			for (c = 0; c < nCorners; c++) {
+				v[c] = v[2*c] + tk*(v[2*c + 1] - v[2*c]);
+			}
+		}
+		y[p] = v[0];
+	}
+	return nPoints;
+}
@@ -0,0 +1,63 @@
+/* ED_NDTable.h - N-dimensional gridded lookup tables
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_NDTABLE_H)
+#define ED_NDTABLE_H
+
+#include <stdlib.h>
+
+/* Maximum number of table dimensions */
+#define ED_NDTABLE_MAX_DIMS (16)
+
+/* Extrapolation, same order as Modelica.Blocks.Types.Extrapolation */
+enum {
+	ED_NDTABLE_HOLD_LAST_POINT = 1,
+	ED_NDTABLE_LAST_TWO_POINTS,
+	ED_NDTABLE_PERIODIC,
+	ED_NDTABLE_NO_EXTRAPOLATION
+};
+
+typedef struct ED_NDTable ED_NDTable;
+
+/* Create a table of nDims dimensions with n[d] grid points on axis d.
+ * axes[d] holds the strictly increasing grid points of axis d and data
+ * the grid values in column-major order (first axis varies fastest) as
+ * stored in MAT-files. Ownership of axes[d] and data passes to the table,
+ * also on failure. Returns NULL and sets errno on failure.
+ */
+ED_NDTable* ED_ndtableCreate(size_t nDims, const size_t* n, double** axes,
+	double* data, int extrapolation);
+void ED_ndtableFree(ED_NDTable* table);
+
+size_t ED_ndtableDims(const ED_NDTable* table);
+
+/* Multilinear interpolation at nPoints query points u (nDims values per
+ * point, row-wise) into y. Returns nPoints on success or the index of the
+ * first point outside the grid if extrapolation is disabled.
+ */
+size_t ED_ndtableEval(ED_NDTable* table, const double* u, size_t nPoints, double* y);
+
+#endif
@@ -0,0 +1,1019 @@
+/* ED_TDMSFile.c - TDMS functions
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_trace.h"
+#include "ModelicaUtilities.h"
+#define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
+#include "uthash.h"
+#include "../Include/ED_trim.h"
+#include "../Include/ED_TDMSFile.h"
+
+/* Reader of NI TDMS files. The segment lead-ins and the (incremental) meta
+ * data are scanned once when the file is opened, from the index file if
+ * present, into an index of the objects by path. Each segment adds an
+ * extent of the raw data, i.e. the offset, the number of values per chunk,
+ * the stride of the values and the number and size of the chunks, to each
+ * channel with data in the segment. Channels are read from the mapped file
+ * by strided copies of their extents.
+ */
+
+/* Length of the segment lead-in: tag, ToC, version and two offsets */
+#define TDMS_LEAD_IN_LENGTH (28)
+/* Unknown type size or incomplete segment */
+#define TDMS_NONE ((size_t)-1)
+
+/* Table of contents flags of the lead-in */
+#define TDMS_TOC_META_DATA (1UL << 1)
+#define TDMS_TOC_NEW_OBJ_LIST (1UL << 2)
+#define TDMS_TOC_RAW_DATA (1UL << 3)
+#define TDMS_TOC_INTERLEAVED_DATA (1UL << 5)
+#define TDMS_TOC_BIG_ENDIAN (1UL << 6)
+#define TDMS_TOC_DAQMX_RAW_DATA (1UL << 7)
+
+/* Raw data index of an object without or with unchanged raw data */
+#define TDMS_NO_RAW_DATA (0xFFFFFFFFUL)
+#define TDMS_SAME_RAW_DATA (0UL)
+
+/* Data types (tdsDataType) */
+#define TDMS_VOID (0x00)
+#define TDMS_I8 (0x01)
+#define TDMS_I16 (0x02)
+#define TDMS_I32 (0x03)
+#define TDMS_I64 (0x04)
+#define TDMS_U8 (0x05)
+#define TDMS_U16 (0x06)
+#define TDMS_U32 (0x07)
+#define TDMS_U64 (0x08)
+#define TDMS_SINGLE (0x09)
+#define TDMS_DOUBLE (0x0A)
+#define TDMS_EXTENDED (0x0B)
+#define TDMS_SINGLE_UNIT (0x19)
+#define TDMS_DOUBLE_UNIT (0x1A)
+#define TDMS_EXTENDED_UNIT (0x1B)
+#define TDMS_STRING (0x20)
+#define TDMS_BOOLEAN (0x21)
+#define TDMS_TIMESTAMP (0x44)
+#define TDMS_COMPLEX_SINGLE (0x08000CUL)
+#define TDMS_COMPLEX_DOUBLE (0x10000DUL)
+
+typedef double (*TDMSDecodeFunc)(const unsigned char* p, int bigEndian);
+
+typedef struct {
+	size_t offset; /* Offset of the first value in the file */
+	size_t nValues; /* Number of values per chunk */
+	size_t stride; /* Distance of the values in a chunk */
+	size_t nChunks;
+	size_t chunkSize; /* Distance of the chunks */
+	unsigned long dataType;
+	int bigEndian;
+} TDMSExtent;
+
+typedef struct {
+	char* path;
+	int hasIndex; /* Raw data index known */
+	unsigned long dataType; /* Raw data index of the last segment */
+	size_t nValues;
+	size_t nBytes; /* Raw data per chunk */
+	size_t slot; /* Position in the object list, TDMS_NONE if not listed */
+	TDMSExtent* extents;
+	size_t nExtents;
+	size_t capacity;
+	UT_hash_handle hh; /* Hashable structure */
+} TDMSObject;
+
+typedef struct {
+	TDMSObject* obj;
+	int hasData; /* Raw data in the segment */
+} TDMSListEntry;
+
+/* Object list of the current segment */
+typedef struct {
+	TDMSListEntry* entries;
+	size_t nEntries;
+	size_t capacity;
+} TDMSObjectList;
+
+typedef struct {
+	const unsigned char* p;
+	size_t len;
+	size_t pos;
+	int bigEndian;
+} TDMSCursor;
+
+typedef struct {
+	char* fileName;
+	ED_VFILE* fp; /* Open while the content is mapped */
+	const unsigned char* map; /* Content, NULL if trimmed */
+	char* buf; /* Content if the file cannot be mapped */
+	size_t len;
+	TDMSObject* index; /* Objects by path */
+	ED_TrimEntry* trim;
+} TDMSFile;
+
+static unsigned long readU32(const unsigned char* p, int bigEndian)
+{
+	if (bigEndian) {
+		return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16) |
+			((unsigned long)p[2] << 8) | (unsigned long)p[3];
+	}
+	return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+		((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+/* Low and high 32-bit halves of a 64-bit integer */
+static void readHalves(const unsigned char* p, int bigEndian, unsigned long* lo, unsigned long* hi)
+{
+	*lo = readU32(p + (bigEndian ? 4 : 0), bigEndian);
+	*hi = readU32(p + (bigEndian ? 0 : 4), bigEndian);
+}
+
+/* Offsets and counts beyond size_t are saturated, failing the bounds checks */
+static size_t readU64(const unsigned char* p, int bigEndian)
+{
+	unsigned long lo, hi;
+	size_t v;
+	readHalves(p, bigEndian, &lo, &hi);
+	v = (size_t)lo;
+	if (hi != 0) {
+		if (sizeof(size_t) <= 4) {
+			return TDMS_NONE;
+		}
+		v |= (size_t)hi << 16 << 16;
+	}
+	return v;
+}
+
+static int isBigEndianHost(void)
+{
+	const unsigned short one = 1;
+	return *(const unsigned char*)&one == 0;
+}
+
+/* Floating-point number of n (4 or 8) bytes in the given byte order */
+static double readFloat(const unsigned char* p, size_t n, int bigEndian)
+{
+	unsigned char b[8];
+	size_t k;
+	if (bigEndian != isBigEndianHost()) {
+		for (k = 0; k < n; k++) {
+			b[k] = p[n - 1 - k];
+		}
+	}
+	else {
+		memcpy(b, p, n);
+	}
+	if (n == 4) {
+		float f;
+		memcpy(&f, b, 4);
+		return (double)f;
+	}
+	else {
+		double d;
+		memcpy(&d, b, 8);
+		return d;
+	}
+}
+
+/* Size of a value of a data type, 0 for strings and TDMS_NONE if unknown */
+static size_t getTypeSize(unsigned long dataType)
+{
+	switch (dataType) {
+		case TDMS_VOID:
+		case TDMS_STRING:
+			return 0;
+
+		case TDMS_I8:
+		case TDMS_U8:
+		case TDMS_BOOLEAN:
+			return 1;
+
+		case TDMS_I16:
+		case TDMS_U16:
+			return 2;
+
+		case TDMS_I32:
+		case TDMS_U32:
+		case TDMS_SINGLE:
+		case TDMS_SINGLE_UNIT:
+			return 4;
+
+		case TDMS_I64:
+		case TDMS_U64:
+		case TDMS_DOUBLE:
+		case TDMS_DOUBLE_UNIT:
+		case TDMS_COMPLEX_SINGLE:
+			return 8;
+
+		case TDMS_EXTENDED:
+		case TDMS_EXTENDED_UNIT:
+		case TDMS_TIMESTAMP:
+		case TDMS_COMPLEX_DOUBLE:
+			return 16;
+
+		default:
+			return TDMS_NONE;
+	}
+}
+
+static double decodeI8(const unsigned char* p, int bigEndian)
+{
+	(void)bigEndian;
+	return p[0] < 128 ? (double)p[0] : (double)p[0] - 256.0;
+}
+
+static double decodeU8(const unsigned char* p, int bigEndian)
+{
+	(void)bigEndian;
+	return (double)p[0];
+}
+
+static double decodeBoolean(const unsigned char* p, int bigEndian)
+{
+	(void)bigEndian;
+	return p[0] != 0 ? 1.0 : 0.0;
+}
+
+static double decodeI16(const unsigned char* p, int bigEndian)
+{
+	unsigned int v = bigEndian ? ((unsigned int)p[0] << 8) | p[1] :
+		((unsigned int)p[1] << 8) | p[0];
+	return v < 32768U ? (double)v : (double)v - 65536.0;
+}
+
+static double decodeU16(const unsigned char* p, int bigEndian)
+{
+	return bigEndian ? (double)(((unsigned int)p[0] << 8) | p[1]) :
+		(double)(((unsigned int)p[1] << 8) | p[0]);
+}
+
+static double decodeI32(const unsigned char* p, int bigEndian)
+{
+	unsigned long v = readU32(p, bigEndian);
+	return v < 0x80000000UL ? (double)v : -(double)((~v + 1) & 0xFFFFFFFFUL);
+}
+
+static double decodeU32(const unsigned char* p, int bigEndian)
+{
+	return (double)readU32(p, bigEndian);
+}
+
+static double decodeI64(const unsigned char* p, int bigEndian)
+{
+	unsigned long lo, hi;
+	readHalves(p, bigEndian, &lo, &hi);
+	if (hi & 0x80000000UL) {
+		/* Magnitude of the two's complement */
+		lo = ~lo & 0xFFFFFFFFUL;
+		hi = ~hi & 0xFFFFFFFFUL;
+		lo = (lo + 1) & 0xFFFFFFFFUL;
+		if (lo == 0) {
+			hi = (hi + 1) & 0xFFFFFFFFUL;
+		}
+		return -((double)hi*4294967296.0 + (double)lo);
+	}
+	return (double)hi*4294967296.0 + (double)lo;
+}
+
+static double decodeU64(const unsigned char* p, int bigEndian)
+{
+	unsigned long lo, hi;
+	readHalves(p, bigEndian, &lo, &hi);
+	return (double)hi*4294967296.0 + (double)lo;
+}
+
+static double decodeSingle(const unsigned char* p, int bigEndian)
+{
+	return readFloat(p, 4, bigEndian);
+}
+
+static double decodeDouble(const unsigned char* p, int bigEndian)
+{
+	return readFloat(p, 8, bigEndian);
+}
+
+/* Seconds since 1904-01-01 00:00 UTC of the signed seconds and the
+ * positive fractions of 2^-64 s, in this order if big-endian
+ */
+static double decodeTimestamp(const unsigned char* p, int bigEndian)
+{
+	return decodeI64(p + (bigEndian ? 0 : 8), bigEndian) +
+		decodeU64(p + (bigEndian ? 8 : 0), bigEndian)/18446744073709551616.0;
+}
+
+/* Decoder of a data type, NULL if not numeric */
+static TDMSDecodeFunc getDecoder(unsigned long dataType)
+{
+	switch (dataType) {
+		case TDMS_I8: return decodeI8;
+		case TDMS_I16: return decodeI16;
+		case TDMS_I32: return decodeI32;
+		case TDMS_I64: return decodeI64;
+		case TDMS_U8: return decodeU8;
+		case TDMS_U16: return decodeU16;
+		case TDMS_U32: return decodeU32;
+		case TDMS_U64: return decodeU64;
+		case TDMS_SINGLE:
+		case TDMS_SINGLE_UNIT: return decodeSingle;
+		case TDMS_DOUBLE:
+		case TDMS_DOUBLE_UNIT: return decodeDouble;
+		case TDMS_BOOLEAN: return decodeBoolean;
+		case TDMS_TIMESTAMP: return decodeTimestamp;
+		default: return NULL;
+	}
+}
+
+/* Grow the array *p of *capacity elements to hold at least n + 1 elements */
+static int reserve(void** p, size_t* capacity, size_t n, size_t size)
+{
+	if (n >= *capacity) {
+		size_t newCapacity = *capacity > 0 ? 2*(*capacity) : 16;
+		void* tmp = realloc(*p, newCapacity*size);
+		if (tmp == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		*p = tmp;
+		*capacity = newCapacity;
+	}
+	return 0;
+}
+
+static int skip(TDMSCursor* c, size_t n)
+{
+	if (n > c->len - c->pos) {
+		errno = EINVAL;
+		return -1;
+	}
+	c->pos += n;
+	return 0;
+}
+
+static int getU32(TDMSCursor* c, unsigned long* v)
+{
+	if (0 != skip(c, 4)) {
+		return -1;
+	}
+	*v = readU32(c->p + c->pos - 4, c->bigEndian);
+	return 0;
+}
+
+static int getU64(TDMSCursor* c, size_t* v)
+{
+	if (0 != skip(c, 8)) {
+		return -1;
+	}
+	*v = readU64(c->p + c->pos - 8, c->bigEndian);
+	return 0;
+}
+
+/* Length-prefixed UTF-8 string, not null-terminated */
+static int getString(TDMSCursor* c, const unsigned char** str, size_t* n)
+{
+	unsigned long len;
+	if (0 != getU32(c, &len) || 0 != skip(c, (size_t)len)) {
+		return -1;
+	}
+	*str = c->p + c->pos - (size_t)len;
+	*n = (size_t)len;
+	return 0;
+}
+
+static void closeFile(TDMSFile* tdms)
+{
+	if (tdms->fp != NULL) {
+		ED_vfclose(tdms->fp);
+		tdms->fp = NULL;
+	}
+	free(tdms->buf);
+	tdms->buf = NULL;
+	tdms->map = NULL;
+}
+
+static void freeIndex(TDMSFile* tdms)
+{
+	TDMSObject* obj;
+	TDMSObject* tmp;
+	HASH_ITER(hh, tdms->index, obj, tmp) {
+		HASH_DEL(tdms->index, obj);
+		free(obj->extents);
+		free(obj->path);
+		free(obj);
+	}
+}
+
+/* Map a file, or read it if it cannot be mapped */
+static const unsigned char* mapFile(const char* fileName, ED_VFILE** fp, char** buf, size_t* len)
+{
+	const char* map;
+	*fp = ED_vfopen(fileName);
+	*buf = NULL;
+	if (*fp == NULL) {
+		return NULL;
+	}
+	map = ED_vfmap(*fp, len);
+	if (map == NULL) {
+		*buf = ED_vfreadall(*fp, len);
+		ED_vfclose(*fp);
+		*fp = NULL;
+		map = *buf;
+	}
+	return (const unsigned char*)map;
+}
+
+/* Map the file. len is the length of the indexed content, TDMS_NONE if not
+ * yet indexed.
+ */
+static int openFile(TDMSFile* tdms, size_t len)
+{
+	tdms->map = mapFile(tdms->fileName, &tdms->fp, &tdms->buf, &tdms->len);
+	if (tdms->map == NULL) {
+		return -1;
+	}
+	if (len != TDMS_NONE && len != tdms->len) {
+		/* The file changed since it was indexed */
+		closeFile(tdms);
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/* Parse the meta data of a segment, updating the object list */
+static int parseMetaData(TDMSFile* tdms, TDMSCursor* c, TDMSObjectList* list)
+{
+	unsigned long nObjects;
+	unsigned long i;
+
+	if (0 != getU32(c, &nObjects) || nObjects > (c->len - c->pos)/12) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < nObjects; i++) {
+		const unsigned char* path;
+		size_t n;
+		unsigned long rawIndex;
+		unsigned long nProps;
+		unsigned long k;
+		int hasData = 1;
+		TDMSObject* obj;
+
+		if (0 != getString(c, &path, &n) || 0 != getU32(c, &rawIndex)) {
+			return -1;
+		}
+		HASH_FIND(hh, tdms->index, path, n, obj);
+		if (obj == NULL) {
+			obj = (TDMSObject*)calloc(1, sizeof(TDMSObject));
+			if (obj == NULL) {
+				errno = ENOMEM;
+				return -1;
+			}
+			obj->path = (char*)malloc(n + 1);
+			if (obj->path == NULL) {
+				free(obj);
+				errno = ENOMEM;
+				return -1;
+			}
+			memcpy(obj->path, path, n);
+			obj->path[n] = '\0';
+			obj->slot = TDMS_NONE;
+			HASH_ADD_KEYPTR(hh, tdms->index, obj->path, n, obj);
+		}
+
+		if (rawIndex == TDMS_NO_RAW_DATA) {
+			hasData = 0;
+		}
+		else if (rawIndex == TDMS_SAME_RAW_DATA) {
+			if (!obj->hasIndex) {
+				errno = EINVAL;
+				return -1;
+			}
+		}
+		else {
+			/* The length includes the length field. DAQmx raw data indices
+			 * (0x69120000 and 0x69130000) are rejected by the length check.
+			 */
+			size_t end = c->pos + (size_t)rawIndex - 4;
+			unsigned long dataType;
+			unsigned long dim;
+			size_t nValues;
+			size_t nBytes;
+			size_t size;
+			if (rawIndex < 20 || (size_t)rawIndex - 4 > c->len - c->pos ||
+				0 != getU32(c, &dataType) || 0 != getU32(c, &dim) ||
+				0 != getU64(c, &nValues) || dim != 1) {
+				errno = EINVAL;
+				return -1;
+			}
+			size = getTypeSize(dataType);
+			if (dataType == TDMS_STRING) {
+				if (0 != getU64(c, &nBytes)) {
+					return -1;
+				}
+			}
+			else if (size == TDMS_NONE || (size > 0 && nValues > TDMS_NONE/size)) {
+				errno = EINVAL;
+				return -1;
+			}
+			else {
+				nBytes = nValues*size;
+			}
+			if (end < c->pos) {
+				errno = EINVAL;
+				return -1;
+			}
+			c->pos = end;
+			obj->hasIndex = 1;
+			obj->dataType = dataType;
+			obj->nValues = nValues;
+			obj->nBytes = nBytes;
+		}
+
+		if (obj->slot == TDMS_NONE) {
+			if (0 != reserve((void**)&list->entries, &list->capacity,
+				list->nEntries, sizeof(TDMSListEntry))) {
+				return -1;
+			}
+			obj->slot = list->nEntries++;
+			list->entries[obj->slot].obj = obj;
+		}
+		list->entries[obj->slot].hasData = hasData;
+
+		/* Properties are not indexed */
+		if (0 != getU32(c, &nProps)) {
+			return -1;
+		}
+		for (k = 0; k < nProps; k++) {
+			const unsigned char* name;
+			unsigned long dataType;
+			size_t size;
+			if (0 != getString(c, &name, &n) || 0 != getU32(c, &dataType)) {
+				return -1;
+			}
+			size = getTypeSize(dataType);
+			if (dataType == TDMS_STRING) {
+				if (0 != getString(c, &name, &n)) {
+					return -1;
+				}
+			}
+			else if (size == TDMS_NONE || 0 != skip(c, size)) {
+				errno = EINVAL;
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static int addExtent(TDMSObject* obj, size_t offset, size_t nValues, size_t stride,
+	size_t nChunks, size_t chunkSize, int bigEndian)
+{
+	TDMSExtent* ext;
+	if (nValues == 0 || nChunks == 0) {
+		return 0;
+	}
+	if (0 != reserve((void**)&obj->extents, &obj->capacity, obj->nExtents,
+		sizeof(TDMSExtent))) {
+		return -1;
+	}
+	ext = &obj->extents[obj->nExtents++];
+	ext->offset = offset;
+	ext->nValues = nValues;
+	ext->stride = stride;
+	ext->nChunks = nChunks;
+	ext->chunkSize = chunkSize;
+	ext->dataType = obj->dataType;
+	ext->bigEndian = bigEndian;
+	return 0;
+}
+
+/* Add the extents of the raw data at offset of len bytes of a segment. The
+ * raw data is a sequence of chunks of the listed objects with data, one
+ * after the other or interleaved value by value. A trailing incomplete
+ * chunk is ignored.
+ */
+static int addExtents(const TDMSObjectList* list, size_t offset, size_t len,
+	int interleaved, int bigEndian)
+{
+	size_t chunkSize = 0;
+	size_t pos = 0;
+	size_t i;
+
+	for (i = 0; i < list->nEntries; i++) {
+		const TDMSObject* obj = list->entries[i].obj;
+		if (list->entries[i].hasData) {
+			size_t n = interleaved ? getTypeSize(obj->dataType) : obj->nBytes;
+			if ((interleaved && (n == 0 || n == TDMS_NONE)) || n > TDMS_NONE - chunkSize) {
+				errno = EINVAL;
+				return -1;
+			}
+			chunkSize += n;
+		}
+	}
+	if (chunkSize == 0) {
+		return 0;
+	}
+	for (i = 0; i < list->nEntries; i++) {
+		TDMSObject* obj = list->entries[i].obj;
+		if (list->entries[i].hasData) {
+			size_t size = getTypeSize(obj->dataType);
+			int rc;
+			if (interleaved) {
+				/* Rows of the values of all objects */
+				rc = addExtent(obj, offset + pos, len/chunkSize, chunkSize, 1, 0, bigEndian);
+				pos += size;
+			}
+			else {
+				rc = obj->dataType == TDMS_STRING ? 0 : addExtent(obj, offset + pos,
+					obj->nValues, size, len/chunkSize, chunkSize, bigEndian);
+				pos += obj->nBytes;
+			}
+			if (rc != 0) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+static void clearList(TDMSObjectList* list)
+{
+	size_t i;
+	for (i = 0; i < list->nEntries; i++) {
+		list->entries[i].obj->slot = TDMS_NONE;
+	}
+	list->nEntries = 0;
+}
+
+/* Scan the segments of the file, or of the index file if isIndex. The
+ * segments of the index file consist of the lead-in and the meta data of
+ * the segments of the file.
+ */
+static int scanSegments(TDMSFile* tdms, const unsigned char* p, size_t len, int isIndex)
+{
+	TDMSObjectList list = {NULL, 0, 0};
+	size_t pos = 0;
+	size_t dataPos = 0;
+	int rc = 0;
+
+	while (rc == 0 && pos < len) {
+		unsigned long toc;
+		size_t next;
+		size_t rawOffset;
+		size_t end;
+		int bigEndian;
+
+		if (len - pos < TDMS_LEAD_IN_LENGTH ||
+			0 != memcmp(p + pos, isIndex ? "TDSh" : "TDSm", 4) ||
+			tdms->len - dataPos < TDMS_LEAD_IN_LENGTH) {
+			errno = EINVAL;
+			rc = -1;
+			break;
+		}
+		toc = readU32(p + pos + 4, 0);
+		next = readU64(p + pos + 12, 0);
+		rawOffset = readU64(p + pos + 20, 0);
+		bigEndian = (toc & TDMS_TOC_BIG_ENDIAN) != 0;
+		if (next == TDMS_NONE) {
+			/* Incomplete last segment, e.g. of an aborted acquisition */
+			end = tdms->len;
+		}
+		else if (next > tdms->len - dataPos - TDMS_LEAD_IN_LENGTH) {
+			errno = EINVAL;
+			rc = -1;
+			break;
+		}
+		else {
+			end = dataPos + TDMS_LEAD_IN_LENGTH + next;
+		}
+		if (rawOffset > end - dataPos - TDMS_LEAD_IN_LENGTH ||
+			rawOffset > len - pos - TDMS_LEAD_IN_LENGTH) {
+			errno = EINVAL;
+			rc = -1;
+			break;
+		}
+
+		if (toc & TDMS_TOC_NEW_OBJ_LIST) {
+			clearList(&list);
+		}
+		if (toc & TDMS_TOC_META_DATA) {
+			TDMSCursor c;
+			c.p = p + pos + TDMS_LEAD_IN_LENGTH;
+			c.len = rawOffset;
+			c.pos = 0;
+			c.bigEndian = bigEndian;
+			rc = parseMetaData(tdms, &c, &list);
+		}
+		if (rc == 0 && (toc & TDMS_TOC_RAW_DATA)) {
+			if (toc & TDMS_TOC_DAQMX_RAW_DATA) {
+				errno = EINVAL;
+				rc = -1;
+			}
+			else {
+				size_t offset = dataPos + TDMS_LEAD_IN_LENGTH + rawOffset;
+				rc = addExtents(&list, offset, end - offset,
+					(toc & TDMS_TOC_INTERLEAVED_DATA) != 0, bigEndian);
+			}
+		}
+
+		pos = isIndex ? pos + TDMS_LEAD_IN_LENGTH + rawOffset : end;
+		dataPos = end;
+		if (next == TDMS_NONE) {
+			break;
+		}
+	}
+	if (rc == 0 && isIndex && (pos != len || dataPos != tdms->len)) {
+		/* The index file does not match the file */
+		errno = EINVAL;
+		rc = -1;
+	}
+	clearList(&list);
+	free(list.entries);
+	return rc;
+}
+
+/* Scan the index file fileName_index, returns -1 if missing or not
+ * consistent with the file
+ */
+static int scanIndexFile(TDMSFile* tdms)
+{
+	ED_VFILE* fp;
+	char* buf;
+	size_t len = 0;
+	const unsigned char* map;
+	char* indexName = (char*)malloc(strlen(tdms->fileName) + 7);
+	int rc = -1;
+
+	if (indexName == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(indexName, tdms->fileName);
+	strcat(indexName, "_index");
+	map = mapFile(indexName, &fp, &buf, &len);
+	free(indexName);
+	if (map != NULL) {
+		rc = scanSegments(tdms, map, len, 1);
+		if (rc != 0) {
+			freeIndex(tdms);
+		}
+	}
+	if (fp != NULL) {
+		ED_vfclose(fp);
+	}
+	free(buf);
+	return rc;
+}
+
+/* Release the mapping, the index is kept */
+static void trimTDMS(void* _tdms)
+{
+	closeFile((TDMSFile*)_tdms);
+}
+
+void* ED_createTDMS(const char* fileName, int verbose)
+{
+	TDMSFile* tdms;
+	int rc;
+	ED_TRACE_CREATE_BEGIN("TDMS", fileName);
+	tdms = (TDMSFile*)calloc(1, sizeof(TDMSFile));
+	if (tdms == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	tdms->fileName = strdup(fileName);
+	if (tdms->fileName == NULL) {
+		free(tdms);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	if (0 != openFile(tdms, TDMS_NONE)) {
+		free(tdms->fileName);
+		free(tdms);
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", fileName);
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("scanSegments", fileName);
+	rc = scanIndexFile(tdms);
+	if (rc != 0 && errno != ENOMEM) {
+		rc = scanSegments(tdms, tdms->map, tdms->len, 0);
+	}
+	if (rc != 0) {
+		rc = errno;
+		freeIndex(tdms);
+		closeFile(tdms);
+		free(tdms->fileName);
+		free(tdms);
+		if (rc == ENOMEM) {
+			ModelicaError("Memory allocation error\n");
+		}
+		else {
+			ModelicaFormatError("Cannot parse file \"%s\": "
+				"Invalid or unsupported TDMS file\n", fileName);
+		}
+		return NULL;
+	}
+
+	ED_TRACE_PARSE_END("scanSegments", fileName, tdms->len);
+
+	tdms->trim = ED_trimRegister(tdms, trimTDMS);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("TDMS", fileName, tdms);
+	return tdms;
+}
+
+void ED_destroyTDMS(void* _tdms)
+{
+	TDMSFile* tdms = (TDMSFile*)_tdms;
+	if (tdms != NULL) {
+		ED_TRACE_DESTROY("TDMS", tdms->fileName);
+		ED_trimUnregister(tdms->trim);
+		closeFile(tdms);
+		freeIndex(tdms);
+		free(tdms->fileName);
+		free(tdms);
+		ED_parallelRelease();
+	}
+}
+
+/* Find a channel with numeric data and open the file, raises an error on
+ * failure
+ */
+static const TDMSObject* findChannel(TDMSFile* tdms, const char* groupName, const char* channelName)
+{
+	/* Path /'group'/'channel' with the quotes of the names doubled */
+	size_t len = 2*(strlen(groupName) + strlen(channelName)) + 7;
+	char* path = (char*)malloc(len + 1);
+	char* q;
+	const char* s;
+	TDMSObject* obj;
+	size_t i;
+
+	if (path == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	q = path;
+	*q++ = '/';
+	*q++ = '\'';
+	for (s = groupName; *s != '\0'; s++) {
+		if (*s == '\'') {
+			*q++ = '\'';
+		}
+		*q++ = *s;
+	}
+	*q++ = '\'';
+	*q++ = '/';
+	*q++ = '\'';
+	for (s = channelName; *s != '\0'; s++) {
+		if (*s == '\'') {
+			*q++ = '\'';
+		}
+		*q++ = *s;
+	}
+	*q++ = '\'';
+	*q = '\0';
+	HASH_FIND_STR(tdms->index, path, obj);
+	free(path);
+	if (obj == NULL) {
+		ModelicaFormatError("Cannot find channel \"%s/%s\" in file \"%s\"\n",
+			groupName, channelName, tdms->fileName);
+		return NULL;
+	}
+	for (i = 0; i < obj->nExtents; i++) {
+		if (getDecoder(obj->extents[i].dataType) == NULL) {
+			break;
+		}
+	}
+	if (i < obj->nExtents || (obj->nExtents == 0 && obj->hasIndex &&
+		getDecoder(obj->dataType) == NULL)) {
+		ModelicaFormatError("Cannot read channel \"%s/%s\" with non-numeric data "
+			"type from file \"%s\"\n", groupName, channelName, tdms->fileName);
+		return NULL;
+	}
+	if (tdms->map == NULL && 0 != openFile(tdms, tdms->len)) {
+		ModelicaFormatError("Not possible to open file \"%s\": "
+			"No such file or directory\n", tdms->fileName);
+		return NULL;
+	}
+	return obj;
+}
+
+static size_t countValues(const TDMSObject* obj)
+{
+	size_t n = 0;
+	size_t i;
+	for (i = 0; i < obj->nExtents; i++) {
+		n += obj->extents[i].nValues*obj->extents[i].nChunks;
+	}
+	return n;
+}
+
+/* Copy the first m values of a channel into a */
+static void readValues(const TDMSFile* tdms, const TDMSObject* obj, double* a, size_t m)
+{
+	size_t k = 0;
+	size_t i;
+	for (i = 0; i < obj->nExtents && k < m; i++) {
+		const TDMSExtent* ext = &obj->extents[i];
+		TDMSDecodeFunc decode = getDecoder(ext->dataType);
+		int inPlace = (ext->dataType == TDMS_DOUBLE || ext->dataType == TDMS_DOUBLE_UNIT) &&
+			ext->stride == sizeof(double) && ext->bigEndian == isBigEndianHost();
+		size_t c;
+		for (c = 0; c < ext->nChunks && k < m; c++) {
+			const unsigned char* p = tdms->map + ext->offset + c*ext->chunkSize;
+			size_t n = ext->nValues < m - k ? ext->nValues : m - k;
+			if (inPlace) {
+				memcpy(a + k, p, n*sizeof(double));
+				k += n;
+			}
+			else {
+				size_t j;
+				for (j = 0; j < n; j++) {
+					a[k++] = decode(p, ext->bigEndian);
+					p += ext->stride;
+				}
+			}
+		}
+	}
+}
+
+int ED_getArray1DSizeFromTDMS(void* _tdms, const char* groupName, const char* channelName)
+{
+	TDMSFile* tdms = (TDMSFile*)_tdms;
+	int n = 0;
+	if (tdms != NULL) {
+		const TDMSObject* obj;
+		ED_TRACE_GET_BEGIN(tdms->fileName, channelName);
+		ED_trimEnter(tdms->trim);
+		obj = findChannel(tdms, groupName, channelName);
+		if (obj != NULL) {
+			n = (int)countValues(obj);
+		}
+		ED_TRACE_GET_END(tdms->fileName, channelName, 0);
+		ED_trimLeave(tdms->trim);
+	}
+	return n;
+}
+
+void ED_getDoubleArray1DFromTDMS(void* _tdms, const char* groupName, const char* channelName, double* a, size_t m)
+{
+	TDMSFile* tdms = (TDMSFile*)_tdms;
+	if (tdms != NULL) {
+		const TDMSObject* obj;
+		size_t n;
+		ED_TRACE_GET_BEGIN(tdms->fileName, channelName);
+		ED_trimEnter(tdms->trim);
+		obj = findChannel(tdms, groupName, channelName);
+		if (obj == NULL) {
+			return;
+		}
+		n = countValues(obj);
+		if (n < m) {
+			ModelicaFormatError("Cannot read %lu values of channel \"%s/%s(%lu)\" "
+				"from file \"%s\"\n", (unsigned long)m, groupName, channelName,
+				(unsigned long)n, tdms->fileName);
+			return;
+		}
+		readValues(tdms, obj, a, m);
+		ED_TRACE_GET_END(tdms->fileName, channelName, m);
+		ED_trimLeave(tdms->trim);
+	}
+}
@@ -34,28 +34,50 @@
 #endif
 #include <ctype.h>
 #include "ED_locale.h"
+#include "ED_table.h"
+#include "ED_trace.h"
 #include "ModelicaUtilities.h"
 #include "libxls/xls.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_XLSFile.h"
 #define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
 #include "uthash.h"
 
 typedef struct {
 	char* sheetName;
-	xlsWorkSheet* pWS;
+	xlsWorkSheet* pWS; /* NULL if trimmed */
+	ED_Table* table; /* Cell values, built on demand */
 	UT_hash_handle hh; /* Hashable structure */
 } SheetShare;
 
 typedef struct {
 	char* fileName;
+	char* encoding;
 	ED_LOCALE_TYPE loc;
-	xlsWorkBook* pWB;
+	xlsWorkBook* pWB; /* NULL if trimmed */
 	SheetShare* sheets;
+	ED_TrimEntry* trim;
 } XLSFile;
 
+/* Close the workbook and its sheets, the tables are kept */
+static void trimXLS(void* _xls)
+{
+	XLSFile* xls = (XLSFile*)_xls;
+	SheetShare* iter;
+	SheetShare* tmp;
+	HASH_ITER(hh, xls->sheets, iter, tmp) {
+		xls_close_WS(iter->pWS);
+		iter->pWS = NULL;
+	}
+	xls_close(xls->pWB);
+	xls->pWB = NULL;
+}
+
 void* ED_createXLS(const char* fileName, const char* encoding, int verbose)
 {
-	XLSFile* xls = (XLSFile*)malloc(sizeof(XLSFile));
+	XLSFile* xls;
+	ED_TRACE_CREATE_BEGIN("XLS", fileName);
+	xls = (XLSFile*)malloc(sizeof(XLSFile));
 	if (xls == NULL) {
 		ModelicaError("Memory allocation error\n");
 		return NULL;
@@ -66,21 +88,33 @@ void* ED_createXLS(const char* fileName, const char* encoding, int verbose)
 		ModelicaError("Memory allocation error\n");
 		return NULL;
 	}
+	xls->encoding = strdup(encoding);
+	if (xls->encoding == NULL) {
+		free(xls->fileName);
+		free(xls);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
 
 	if (verbose == 1) {
 		/* Print info message, that file is loading */
 		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
 	}
 
+	ED_TRACE_PARSE_BEGIN("xls_open", fileName);
 	xls->pWB = xls_open(fileName, encoding);
 	if (xls->pWB == NULL) {
+		free(xls->encoding);
 		free(xls->fileName);
 		free(xls);
 		ModelicaFormatError("Cannot open file \"%s\"\n", fileName);
 		return NULL;
 	}
+	ED_TRACE_PARSE_END("xls_open", fileName, 0);
 	xls->sheets = NULL;
 	xls->loc = ED_INIT_LOCALE;
+	xls->trim = ED_trimRegister(xls, trimXLS);
+	ED_TRACE_CREATE_END("XLS", fileName, xls);
 	return xls;
 }
 
@@ -90,13 +124,17 @@ void ED_destroyXLS(void* _xls)
 	if (xls != NULL) {
 		SheetShare* iter;
 		SheetShare* tmp;
+		ED_TRACE_DESTROY("XLS", xls->fileName);
 		if (xls->fileName != NULL) {
 			free(xls->fileName);
 		}
+		free(xls->encoding);
 		ED_FREE_LOCALE(xls->loc);
+		ED_trimUnregister(xls->trim);
 		HASH_ITER(hh, xls->sheets, iter, tmp) {
 			free(iter->sheetName);
 			xls_close_WS(iter->pWS);
+			ED_tableFree(iter->table);
 			HASH_DEL(xls->sheets, iter);
 			free(iter);
 		}
@@ -124,6 +162,15 @@ static xlsWorkSheet* findSheet(XLSFile* xls, char** sheetName)
 	SheetShare* iter;
 	xlsWorkSheet* pWS = NULL;
 
+	if (xls->pWB == NULL) {
+		/* Reopen the trimmed workbook */
+		xls->pWB = xls_open(xls->fileName, xls->encoding);
+		if (xls->pWB == NULL) {
+			ModelicaFormatError("Cannot open file \"%s\"\n", xls->fileName);
+			return pWS;
+		}
+	}
+
 	if (xls->pWB->sheets.count == 0) {
 		ModelicaFormatError("Cannot find any sheet in file \"%s\"\n",
 			xls->fileName);
@@ -136,7 +183,7 @@ static xlsWorkSheet* findSheet(XLSFile* xls, char** sheetName)
 	}
 
 	HASH_FIND_STR(xls->sheets, *sheetName, iter);
-	if (iter != NULL) {
+	if (iter != NULL && iter->pWS != NULL) {
 		pWS = iter->pWS;
 	}
 	else {
@@ -156,11 +203,18 @@ static xlsWorkSheet* findSheet(XLSFile* xls, char** sheetName)
 		}
 		/* Open and parse the sheet */
 		pWS = xls_getWorkSheet(xls->pWB, sheet);
+		ED_TRACE_PARSE_BEGIN("xls_parseWorkSheet", xls->fileName);
 		xls_parseWorkSheet(pWS);
+		ED_TRACE_PARSE_END("xls_parseWorkSheet", xls->fileName, 0);
+		if (iter != NULL) {
+			iter->pWS = pWS;
+			return pWS;
+		}
 		iter = malloc(sizeof(SheetShare));
 		if (iter != NULL) {
 			iter->sheetName = strdup(*sheetName);
 			iter->pWS = pWS;
+			iter->table = NULL;
 			HASH_ADD_KEYPTR(hh, xls->sheets, iter->sheetName, strlen(iter->sheetName), iter);
 		}
 	}
@@ -179,10 +233,13 @@ const char* ED_getStringFromXLS(void* _xls, const char* cellAddress, const char*
 	XLSFile* xls = (XLSFile*)_xls;
 	if (xls != NULL) {
 		char* _sheetName = (char*)sheetName;
-		xlsWorkSheet* pWS = findSheet(xls, &_sheetName);
+		xlsWorkSheet* pWS;
 		xlsCell* cell;
 		WORD row = 0, col = 0;
 
+		ED_TRACE_GET_BEGIN(xls->fileName, cellAddress);
+		ED_trimEnter(xls->trim);
+		pWS = findSheet(xls, &_sheetName);
 		rc(cellAddress, &row, &col);
 		cell = xls_cell(pWS, row, col);
 		if (cell != NULL && !cell->isHidden) {
@@ -193,6 +250,8 @@ const char* ED_getStringFromXLS(void* _xls, const char* cellAddress, const char*
 						(0 != strcmp((char*)cell->str, "error"))) { /* formula is not in error */
 						char* ret = ModelicaAllocateString(strlen((char*)cell->str));
 						strcpy(ret, (char*)cell->str);
+						ED_TRACE_GET_END(xls->fileName, cellAddress, 1);
+						ED_trimLeave(xls->trim);
 						return (const char*)ret;
 					}
 				}
@@ -200,6 +259,8 @@ const char* ED_getStringFromXLS(void* _xls, const char* cellAddress, const char*
 			else if (cell->str != NULL) {
 				char* ret = ModelicaAllocateString(strlen((char*)cell->str));
 				strcpy(ret, (char*)cell->str);
+				ED_TRACE_GET_END(xls->fileName, cellAddress, 1);
+				ED_trimLeave(xls->trim);
 				return (const char*)ret;
 			}
 		}
@@ -207,6 +268,8 @@ const char* ED_getStringFromXLS(void* _xls, const char* cellAddress, const char*
 			ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
 				(unsigned int)row, (unsigned int)col, _sheetName, xls->fileName);
 		}
+		ED_TRACE_GET_END(xls->fileName, cellAddress, 0);
+		ED_trimLeave(xls->trim);
 	}
 	return "";
 }
@@ -217,10 +280,13 @@ int ED_getIntFromXLS(void* _xls, const char* cellAddress, const char* sheetName)
 	XLSFile* xls = (XLSFile*)_xls;
 	if (xls != NULL) {
 		char* _sheetName = (char*)sheetName;
-		xlsWorkSheet* pWS = findSheet(xls, &_sheetName);
+		xlsWorkSheet* pWS;
 		xlsCell* cell;
 		WORD row = 0, col = 0;
 
+		ED_TRACE_GET_BEGIN(xls->fileName, cellAddress);
+		ED_trimEnter(xls->trim);
+		pWS = findSheet(xls, &_sheetName);
 		rc(cellAddress, &row, &col);
 		cell = xls_cell(pWS, row, col);
 		if (cell != NULL && !cell->isHidden) {
@@ -259,61 +325,140 @@ int ED_getIntFromXLS(void* _xls, const char* cellAddress, const char* sheetName)
 			ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
 				(unsigned int)row, (unsigned int)col, _sheetName, xls->fileName);
 		}
+		ED_TRACE_GET_END(xls->fileName, cellAddress, 1);
+		ED_trimLeave(xls->trim);
 	}
 	return (int)ret;
 }
 
+/* Load the numeric cell values of the sheet: numbers, formula results,
+ * booleans as 0/1 and numeric strings. Other strings, including formula
+ * errors, are kept as text, hidden cells are missing.
+ */
+static ED_Table* buildTable(XLSFile* xls, xlsWorkSheet* pWS)
+{
+	ED_Table* table = ED_tableCreate();
+	DWORD i;
+	if (table == NULL) {
+		return NULL;
+	}
+	for (i = 0; i <= (DWORD)pWS->rows.lastrow && pWS->rows.row != NULL; i++) {
+		struct st_row_data* row = &pWS->rows.row[i];
+		DWORD j;
+		for (j = 0; j < (DWORD)row->lcell && j < row->cells.count; j++) {
+			xlsCell* cell = &row->cells.cell[j];
+			const char* str = NULL;
+			double val = 0.;
+			int err;
+			if (cell->isHidden) {
+				continue;
+			}
+			if (cell->id == XLS_RECORD_RK || cell->id == XLS_RECORD_MULRK || cell->id == XLS_RECORD_NUMBER) {
+				val = cell->d;
+			}
+			else if (cell->id == XLS_RECORD_FORMULA) {
+				if (cell->l == 0) { /* It is a number */
+					val = cell->d;
+				}
+				else if (0 == strcmp((char*)cell->str, "bool")) { /* It is boolean */
+					val = (int)cell->d ? 1. : 0.;
+				}
+				else if (0 == strcmp((char*)cell->str, "error") || /* Formula is in error */
+					ED_strtod((char*)cell->str, xls->loc, &val)) {
+					str = (char*)cell->str;
+				}
+			}
+			else if (cell->str != NULL) {
+				if (ED_strtod((char*)cell->str, xls->loc, &val)) {
+					str = (char*)cell->str;
+				}
+			}
+			err = str != NULL ? ED_tableSetString(table, i, j, str) :
+				ED_tableSetDouble(table, i, j, val);
+			if (err != 0) {
+				ED_tableFree(table);
+				return NULL;
+			}
+		}
+	}
+	if (ED_tableCompressionEnabled()) {
+		(void)ED_tableCompress(table);
+	}
+	return table;
+}
+
+/* Table of the sheet, pWS is NULL if the table was built before trimming */
+static ED_Table* findTable(XLSFile* xls, char** sheetName, xlsWorkSheet** pWS)
+{
+	SheetShare* iter;
+	if (strlen(*sheetName) > 0) {
+		HASH_FIND_STR(xls->sheets, *sheetName, iter);
+		if (iter != NULL && iter->table != NULL) {
+			*pWS = iter->pWS;
+			return iter->table;
+		}
+	}
+	*pWS = findSheet(xls, sheetName);
+	if (*pWS == NULL) {
+		return NULL;
+	}
+	HASH_FIND_STR(xls->sheets, *sheetName, iter);
+	if (iter == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	if (iter->table == NULL) {
+		iter->table = buildTable(xls, *pWS);
+		if (iter->table == NULL) {
+			ModelicaError("Memory allocation error\n");
+		}
+	}
+	return iter->table;
+}
+
 void ED_getDoubleArray2DFromXLS(void* _xls, const char* cellAddress, const char* sheetName, double* a, size_t m, size_t n)
 {
 	XLSFile* xls = (XLSFile*)_xls;
 	if (xls != NULL) {
 		char* _sheetName = (char*)sheetName;
-		xlsWorkSheet* pWS = findSheet(xls, &_sheetName);
+		xlsWorkSheet* pWS;
+		ED_Table* table;
 		WORD row = 0, col = 0;
-		WORD i, j;
 
+		ED_TRACE_GET_BEGIN(xls->fileName, cellAddress);
+		ED_trimEnter(xls->trim);
+		table = findTable(xls, &_sheetName, &pWS);
 		rc(cellAddress, &row, &col);
-		for (i = 0; i < m; i++) {
-			for (j = 0; j < n; j++) {
-				xlsCell* cell = xls_cell(pWS, row + i, col + j);
-				if (cell != NULL && !cell->isHidden) {
-					/* Get the value of the cell (either numeric or string) */
-					if (cell->id == XLS_RECORD_RK || cell->id == XLS_RECORD_MULRK || cell->id == XLS_RECORD_NUMBER) {
-						a[i*n + j] = cell->d;
-					}
-					else if (cell->id == XLS_RECORD_FORMULA) {
-						if (cell->l == 0) { /* It is a number */
-							a[i*n + j] = cell->d;
+		if (table != NULL && 0 != ED_tableGetDoubleArray2D(table, row, col, m, n, a)) {
+			size_t i, j;
+			/* Report the cells without numeric value */
+			for (i = 0; i < m; i++) {
+				for (j = 0; j < n; j++) {
+					const char* str = ED_tableGetString(table, row + i, col + j);
+					if (str != NULL) {
+						xlsCell* cell;
+						if (pWS == NULL) {
+							pWS = findSheet(xls, &_sheetName);
 						}
-						else {
-							if (0 == strcmp((char*)cell->str, "bool")) { /* It is boolean */
-								a[i*n + j] = (int)cell->d ? 1. : 0.;
-							}
-							else if (0 == strcmp((char*)cell->str, "error")) { /* Formula is in error */
-								ModelicaFormatError("Error in formula of cell (%u,%u) in sheet \"%s\" of file \"%s\"\n",
-									(unsigned int)(row + i), (unsigned int)(col + j), _sheetName, xls->fileName);
-							}
-							else { /* Valid formula result */
-								if (ED_strtod((char*)cell->str, xls->loc, &a[i*n + j])) {
-									ModelicaFormatError("Error in cell (%u,%u) when reading double value \"%s\" from sheet \"%s\" of file \"%s\"\n",
-										(unsigned int)(row + i), (unsigned int)(col + j), cell->str, _sheetName, xls->fileName);
-								}
-							}
+						cell = xls_cell(pWS, (WORD)(row + i), (WORD)(col + j));
+						if (cell != NULL && cell->id == XLS_RECORD_FORMULA && 0 == strcmp(str, "error")) {
+							ModelicaFormatError("Error in formula of cell (%u,%u) in sheet \"%s\" of file \"%s\"\n",
+								(unsigned int)(row + i), (unsigned int)(col + j), _sheetName, xls->fileName);
 						}
-					}
-					else if (cell->str != NULL) {
-						if (ED_strtod((char*)cell->str, xls->loc, &a[i*n + j])) {
+						else {
 							ModelicaFormatError("Error in cell (%u,%u) when reading double value \"%s\" from sheet \"%s\" of file \"%s\"\n",
-								(unsigned int)(row + i), (unsigned int)(col + j), cell->str, _sheetName, xls->fileName);
+								(unsigned int)(row + i), (unsigned int)(col + j), str, _sheetName, xls->fileName);
 						}
+						return;
+					}
+					if (ED_tableCellType(table, row + i, col + j) == ED_TABLE_EMPTY) {
+						ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
+							(unsigned int)(row + i), (unsigned int)(col + j), _sheetName, xls->fileName);
 					}
-				}
-				else {
-					a[i*n + j] = 0.;
-					ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
-						(unsigned int)(row + i), (unsigned int)(col + j), _sheetName, xls->fileName);
 				}
 			}
 		}
+		ED_TRACE_GET_END(xls->fileName, cellAddress, m*n);
+		ED_trimLeave(xls->trim);
 	}
 }
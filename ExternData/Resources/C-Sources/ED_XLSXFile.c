@@ -37,8 +37,12 @@
 #include "ED_locale.h"
 #include "bsxml.h"
 #include "ModelicaUtilities.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_XLSXFile.h"
 #include "unzip.h"
+#include "ED_parallel.h"
+#include "ED_table.h"
+#include "ED_trace.h"
 #define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
 #include "uthash.h"
 
@@ -53,23 +57,332 @@
 #define WB_XML "xl/workbook.xml"
 #define STR_XML "xl/sharedStrings.xml"
 
+/* Minimum size of a worksheet to parse its rows in parallel */
+#if !defined(ED_XLSX_PARALLEL_MIN)
+#define ED_XLSX_PARALLEL_MIN (1 << 20)
+#endif
+/* Number of row ranges per thread */
+#define ED_XLSX_CHUNKS_PER_THREAD (4)
+#define ED_XLSX_MAX_CHUNKS (ED_XLSX_CHUNKS_PER_THREAD*ED_PARALLEL_MAX_THREADS)
+
 typedef uint16_t WORD;
 
 typedef struct {
 	char* sheetName;
 	char* sheetId;
-	XmlNodeRef root;
+	XmlNodeRef root; /* Parsed on demand */
+	ED_Table* table; /* Cell values, built on demand */
 	UT_hash_handle hh; /* Hashable structure */
 } SheetShare;
 
+typedef struct {
+	const char* buf;
+	size_t split[ED_XLSX_MAX_CHUNKS + 1]; /* Offsets of the row ranges */
+	size_t nl[ED_XLSX_MAX_CHUNKS]; /* Number of newlines per row range */
+	size_t lineOffset[ED_XLSX_MAX_CHUNKS]; /* Number of newlines before each row range */
+	XmlNodeRef roots[ED_XLSX_MAX_CHUNKS]; /* Parsed row ranges */
+	size_t nChunks;
+} SheetChunks;
+
 typedef struct {
 	char* fileName;
 	ED_LOCALE_TYPE loc;
-	unzFile zfile;
+	unzFile zfile; /* NULL if trimmed */
 	XmlNodeRef sroot; /* Shared strings */
 	SheetShare* sheets;
+	ED_TrimEntry* trim;
 } XLSXFile;
 
+/* Find s in [p, end) */
+static const char* findStr(const char* p, const char* end, const char* s)
+{
+	size_t len = strlen(s);
+	while (p != NULL && (size_t)(end - p) >= len) {
+		p = (const char*)memchr(p, s[0], (size_t)(end - p) - len + 1);
+		if (p == NULL || 0 == memcmp(p, s, len)) {
+			return p;
+		}
+		p++;
+	}
+	return NULL;
+}
+
+static int isTag(const char* p, const char* end, const char* tag)
+{
+	size_t len = strlen(tag);
+	if ((size_t)(end - p) > len && 0 == memcmp(p, tag, len)) {
+		char c = p[len];
+		return c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+	return 0;
+}
+
+static size_t countNewlines(const char* p, const char* end)
+{
+	size_t n = 0;
+	while ((p = (const char*)memchr(p, '\n', (size_t)(end - p))) != NULL) {
+		n++;
+		p++;
+	}
+	return n;
+}
+
+/* Split the content of <sheetData> into ranges of whole rows of about
+ * equal size. Only markup can contain '<' (attribute values must not),
+ * so every '<' outside of CDATA sections, comments and processing
+ * instructions starts a tag. Returns 0 if the sheet cannot be split.
+ */
+static int splitRows(SheetChunks* chunks, size_t len, size_t* bodyStart, size_t* bodyEnd)
+{
+	const char* buf = chunks->buf;
+	const char* end = buf + len;
+	const char* p = buf;
+	const char* last;
+	size_t bodyLen = 0;
+	size_t k = 0;
+
+	last = NULL;
+	for (p = findStr(buf, end, "</sheetData>"); p != NULL; p = findStr(p + 1, end, "</sheetData>")) {
+		last = p;
+	}
+	if (last == NULL) {
+		return 0;
+	}
+	*bodyEnd = (size_t)(last - buf);
+	*bodyStart = 0;
+
+	p = buf;
+	while ((p = (const char*)memchr(p, '<', (size_t)(end - p))) != NULL) {
+		if (p + 1 < end && (p[1] == '!' || p[1] == '?')) {
+			const char* q;
+			if (0 == strncmp(p, "<![CDATA[", 9)) {
+				q = findStr(p + 9, end, "]]>");
+			}
+			else if (0 == strncmp(p, "<!--", 4)) {
+				q = findStr(p + 4, end, "-->");
+			}
+			else if (p[1] == '?') {
+				q = findStr(p + 2, end, "?>");
+			}
+			else {
+				/* Document type declarations may define entities */
+				return 0;
+			}
+			if (q == NULL) {
+				return 0;
+			}
+			p = q + 1;
+		}
+		else if (*bodyStart == 0) {
+			if (isTag(p, end, "<sheetData")) {
+				const char* q = (const char*)memchr(p, '>', (size_t)(end - p));
+				if (q == NULL || q[-1] == '/' || q + 1 > last) {
+					return 0;
+				}
+				*bodyStart = (size_t)(q + 1 - buf);
+				bodyLen = *bodyEnd - *bodyStart;
+				chunks->split[k++] = *bodyStart;
+				p = q + 1;
+			}
+			else {
+				p++;
+			}
+		}
+		else if (p == last) {
+			break;
+		}
+		else if (p[1] == '/' && isTag(p, end, "</sheetData")) {
+			/* Nested or misplaced end tag */
+			return 0;
+		}
+		else {
+			if (k < chunks->nChunks && isTag(p, end, "<row") &&
+				(size_t)(p - buf) > chunks->split[k - 1] &&
+				(size_t)(p - buf) - *bodyStart >= k*(bodyLen/chunks->nChunks)) {
+				chunks->split[k++] = (size_t)(p - buf);
+			}
+			p++;
+		}
+	}
+	if (p != last || k < 2) {
+		return 0;
+	}
+	chunks->nChunks = k;
+	chunks->split[k] = *bodyEnd;
+	return 1;
+}
+
+static void addLineOffset(XmlNodeRef node, int offset)
+{
+	asize_t i;
+	node->m_line += offset;
+	for (i = 0; i < XmlNode_getChildCount(node); i++) {
+		addLineOffset(XmlNode_getChild(node, i), offset);
+	}
+}
+
+static void parseRows(void* data, size_t k)
+{
+	SheetChunks* chunks = (SheetChunks*)data;
+	const char* start = chunks->buf + chunks->split[k];
+	size_t len = chunks->split[k + 1] - chunks->split[k];
+	char* xml = (char*)malloc(len + 25);
+	chunks->nl[k] = countNewlines(start, start + len);
+	chunks->roots[k] = NULL;
+	if (xml != NULL) {
+		XmlParser xmlParser;
+		strcpy(xml, "<sheetData>");
+		memcpy(xml + 11, start, len);
+		strcpy(xml + 11 + len, "</sheetData>");
+		chunks->roots[k] = XmlParser_parse_buffer(&xmlParser, xml, len + 23);
+		free(xml);
+	}
+}
+
+static void fixRowLines(void* data, size_t k)
+{
+	SheetChunks* chunks = (SheetChunks*)data;
+	XmlNodeRef root = chunks->roots[k];
+	asize_t i;
+	if (chunks->lineOffset[k] > 0) {
+		for (i = 0; i < XmlNode_getChildCount(root); i++) {
+			addLineOffset(XmlNode_getChild(root, i), (int)chunks->lineOffset[k]);
+		}
+	}
+}
+
+/* Parse the rows of a large worksheet in parallel and merge them in row
+ * order into the tree of the remaining document. Each chunk of rows is
+ * parsed into its own bsxml subtree, whose row nodes are then moved into
+ * <sheetData>, so the cell lookup works on the same tree as for a serial
+ * parse. Text between the rows is appended to <sheetData> in order, which
+ * joins it as the serial parse does; whitespace-only text (of indented
+ * sheets) is not stored by the tree builder at all. Returns NULL if the
+ * sheet cannot be split (e.g. for a document type declaration), a chunk
+ * fails to parse or memory runs out; the caller then parses the sheet
+ * serially, which also reports the error.
+ */
+static XmlNodeRef parseSheetParallel(const char* buf, size_t len)
+{
+	SheetChunks* chunks;
+	XmlNodeRef root = NULL;
+	XmlNodeRef sheetData = NULL;
+	size_t bodyStart;
+	size_t bodyEnd;
+	size_t k;
+	size_t nThreads = ED_parallelThreads();
+	int ok = 1;
+
+	if (len < ED_XLSX_PARALLEL_MIN || nThreads < 2) {
+		return NULL;
+	}
+	chunks = (SheetChunks*)calloc(1, sizeof(SheetChunks));
+	if (chunks == NULL) {
+		return NULL;
+	}
+	chunks->buf = buf;
+	chunks->nChunks = ED_XLSX_CHUNKS_PER_THREAD*nThreads;
+	if (!splitRows(chunks, len, &bodyStart, &bodyEnd)) {
+		free(chunks);
+		return NULL;
+	}
+
+	ED_parallelFor(chunks->nChunks, parseRows, chunks);
+
+	/* Parse the document without the rows */
+	{
+		size_t suffixLen = len - bodyEnd;
+		char* xml = (char*)malloc(bodyStart + suffixLen + 1);
+		if (xml != NULL) {
+			XmlParser xmlParser;
+			memcpy(xml, buf, bodyStart);
+			memcpy(xml + bodyStart, buf + bodyEnd, suffixLen);
+			xml[bodyStart + suffixLen] = '\0';
+			root = XmlParser_parse_buffer(&xmlParser, xml, bodyStart + suffixLen);
+			free(xml);
+		}
+	}
+	if (root != NULL) {
+		asize_t i;
+		size_t nl = countNewlines(buf, buf + bodyStart);
+		size_t nlBody = 0;
+		for (k = 0; k < chunks->nChunks; k++) {
+			nlBody += chunks->nl[k];
+		}
+		for (i = 0; i < XmlNode_getChildCount(root); i++) {
+			XmlNodeRef child = XmlNode_getChild(root, i);
+			if (sheetData != NULL) {
+				/* Account for the newlines of the removed rows */
+				addLineOffset(child, (int)nlBody);
+			}
+			else if (XmlNode_isTag(child, "sheetData") && XmlNode_getChildCount(child) == 0) {
+				sheetData = child;
+			}
+		}
+		for (k = 0; k < chunks->nChunks; k++) {
+			chunks->lineOffset[k] = nl;
+			nl += chunks->nl[k];
+			if (chunks->roots[k] == NULL) {
+				ok = 0;
+			}
+		}
+	}
+
+	if (root != NULL && sheetData != NULL && ok) {
+		/* Move the rows into the tree */
+		cpo_array_t* rows = sheetData->m_childs;
+		size_t nRows = 0;
+		asize_t i;
+		for (k = 0; k < chunks->nChunks; k++) {
+			nRows += XmlNode_getChildCount(chunks->roots[k]);
+		}
+		if (nRows > rows->max) {
+			void* v = realloc(rows->v, nRows*sizeof(XmlNode));
+			if (v != NULL) {
+				rows->v = v;
+				rows->max = nRows;
+			}
+			else {
+				ok = 0;
+			}
+		}
+		if (ok) {
+			ED_parallelFor(chunks->nChunks, fixRowLines, chunks);
+			for (k = 0; k < chunks->nChunks; k++) {
+				cpo_array_t* chunkRows = chunks->roots[k]->m_childs;
+				memcpy((XmlNode*)rows->v + rows->num, chunkRows->v, chunkRows->num*sizeof(XmlNode));
+				rows->num += chunkRows->num;
+				chunkRows->num = 0;
+				if (chunks->roots[k]->m_content != NULL) {
+					/* Text (e.g. CDATA) between the rows */
+					XmlNode_setValue(sheetData, chunks->roots[k]->m_content);
+				}
+			}
+			for (i = 0; i < rows->num; i++) {
+				XmlNodeRef row = XmlNode_getChild(sheetData, i);
+				asize_t j;
+				row->m_parent = sheetData;
+				for (j = 0; j < XmlNode_getChildCount(row); j++) {
+					XmlNode_getChild(row, j)->m_parent = row;
+				}
+			}
+		}
+	}
+	else {
+		ok = 0;
+	}
+
+	for (k = 0; k < chunks->nChunks; k++) {
+		XmlNode_deleteTree(chunks->roots[k]);
+	}
+	free(chunks);
+	if (!ok) {
+		XmlNode_deleteTree(root);
+		root = NULL;
+	}
+	return root;
+}
+
 static int parseXML(unzFile zfile, const char* fileName, XmlNodeRef* root)
 {
 	unz_file_info info;
@@ -98,7 +411,12 @@ static int parseXML(unzFile zfile, const char* fileName, XmlNodeRef* root)
 		return E_EREAD;
 	}
 	buf[info.uncompressed_size] = '\0';
-	*root = XmlParser_parse(&xmlParser, buf);
+	ED_TRACE_PARSE_BEGIN("XmlParser_parse", fileName);
+	*root = parseSheetParallel(buf, info.uncompressed_size);
+	if (*root == NULL) {
+		*root = XmlParser_parse(&xmlParser, buf);
+	}
+	ED_TRACE_PARSE_END("XmlParser_parse", fileName, info.uncompressed_size);
 	free(buf);
 	if (*root == NULL) {
 		return E_BAD_DATA;
@@ -107,13 +425,46 @@ static int parseXML(unzFile zfile, const char* fileName, XmlNodeRef* root)
 	return 0;
 }
 
+/* Close the archive and release the parsed sheets and shared strings, the
+ * tables are kept
+ */
+static void trimXLSX(void* _xlsx)
+{
+	XLSXFile* xlsx = (XLSXFile*)_xlsx;
+	SheetShare* iter;
+	SheetShare* tmp;
+	HASH_ITER(hh, xlsx->sheets, iter, tmp) {
+		XmlNode_deleteTree(iter->root);
+		iter->root = NULL;
+	}
+	XmlNode_deleteTree(xlsx->sroot);
+	xlsx->sroot = NULL;
+	unzClose(xlsx->zfile);
+	xlsx->zfile = NULL;
+}
+
+/* Reopen the archive and parse the shared strings again if trimmed */
+static void reloadXLSX(XLSXFile* xlsx)
+{
+	if (xlsx->zfile == NULL) {
+		xlsx->zfile = unzOpen(xlsx->fileName);
+		if (xlsx->zfile == NULL) {
+			ModelicaFormatError("Cannot open file \"%s\"\n", xlsx->fileName);
+			return;
+		}
+		parseXML(xlsx->zfile, STR_XML, &xlsx->sroot);
+	}
+}
+
 void* ED_createXLSX(const char* fileName, int verbose)
 {
 	size_t i;
 	int rc;
 	XmlNodeRef root;
 	XmlNodeRef sheets;
-	XLSXFile* xlsx = (XLSXFile*)malloc(sizeof(XLSXFile));
+	XLSXFile* xlsx;
+	ED_TRACE_CREATE_BEGIN("XLSX", fileName);
+	xlsx = (XLSXFile*)malloc(sizeof(XLSXFile));
 	if (xlsx == NULL) {
 		ModelicaError("Memory allocation error\n");
 		return NULL;
@@ -188,6 +539,7 @@ void* ED_createXLSX(const char* fileName, int verbose)
 					iter->sheetName = strdup(sheetName);
 					iter->sheetId = strdup(sheetId);
 					iter->root = NULL;
+					iter->table = NULL;
 					HASH_ADD_KEYPTR(hh, xlsx->sheets, iter->sheetName, strlen(iter->sheetName), iter);
 				}
 			}
@@ -198,6 +550,9 @@ void* ED_createXLSX(const char* fileName, int verbose)
 	parseXML(xlsx->zfile, STR_XML, &xlsx->sroot);
 
 	xlsx->loc = ED_INIT_LOCALE;
+	xlsx->trim = ED_trimRegister(xlsx, trimXLSX);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("XLSX", fileName, xlsx);
 	return xlsx;
 }
 
@@ -207,20 +562,26 @@ void ED_destroyXLSX(void* _xlsx)
 	if (xlsx != NULL) {
 		SheetShare* iter;
 		SheetShare* tmp;
+		ED_TRACE_DESTROY("XLSX", xlsx->fileName);
 		if (xlsx->fileName != NULL) {
 			free(xlsx->fileName);
 		}
 		ED_FREE_LOCALE(xlsx->loc);
-		unzClose(xlsx->zfile);
+		ED_trimUnregister(xlsx->trim);
+		if (xlsx->zfile != NULL) {
+			unzClose(xlsx->zfile);
+		}
 		HASH_ITER(hh, xlsx->sheets, iter, tmp) {
 			free(iter->sheetName);
 			free(iter->sheetId);
 			XmlNode_deleteTree(iter->root);
+			ED_tableFree(iter->table);
 			HASH_DEL(xlsx->sheets, iter);
 			free(iter);
 		}
 		XmlNode_deleteTree(xlsx->sroot);
 		free(xlsx);
+		ED_parallelRelease();
 	}
 }
 
@@ -238,22 +599,10 @@ static void rc(const char* cellAddress, WORD* row, WORD* col)
 	*row =  rowVal > 0 ? (rowVal - 1) : 0;
 }
 
-static void ca(char* colAddress, WORD idx)
+static void resolveSheetName(XLSXFile* xlsx, char** sheetName)
 {
-	char c = (idx % 26) + 'A';
-	WORD quotient = idx/26;
-	if (quotient > 0) {
-		ca(colAddress, quotient - 1);
-	}
-	strncat(colAddress, &c, 1);
-}
-
-static XmlNodeRef findSheet(XLSXFile* xlsx, char** sheetName)
-{
-	SheetShare* iter;
-	XmlNodeRef root;
-
 	if (strlen(*sheetName) == 0) {
+		SheetShare* iter;
 		SheetShare* tmp;
 		/* Resolve default sheet name */
 		HASH_ITER(hh, xlsx->sheets, iter, tmp) {
@@ -263,7 +612,15 @@ static XmlNodeRef findSheet(XLSXFile* xlsx, char** sheetName)
 			}
 		}
 	}
+}
 
+static XmlNodeRef findSheet(XLSXFile* xlsx, char** sheetName)
+{
+	SheetShare* iter;
+	XmlNodeRef root;
+
+	reloadXLSX(xlsx);
+	resolveSheetName(xlsx, sheetName);
 	HASH_FIND_STR(xlsx->sheets, *sheetName, iter);
 	if (iter == NULL) {
 		ModelicaFormatError("Cannot find sheet name \"%s\" in file \"%s\" of file \"%s\"\n",
@@ -311,10 +668,10 @@ static XmlNodeRef XmlNode_findRow(XmlNodeRef node, const char* row)
 	return ret;
 }
 
-static char* findCellValueFromRow(XLSXFile* xlsx, const char* cellAddress, XmlNodeRef root, const char* sheetName)
+/* Value of the cell node iter, resolving shared strings */
+static char* getCellValue(XLSXFile* xlsx, XmlNodeRef iter)
 {
 	char* token = NULL;
-	XmlNodeRef iter = XmlNode_findRow(root, cellAddress);
 	if (iter != NULL) {
 		char* t = XmlNode_getAttributeValue(iter, "t");
 		if (t != NULL && 0 == strncmp(t, "s", 1)) {
@@ -344,6 +701,11 @@ static char* findCellValueFromRow(XLSXFile* xlsx, const char* cellAddress, XmlNo
 	return token;
 }
 
+static char* findCellValueFromRow(XLSXFile* xlsx, const char* cellAddress, XmlNodeRef root, const char* sheetName)
+{
+	return getCellValue(xlsx, XmlNode_findRow(root, cellAddress));
+}
+
 static XmlNodeRef findRow(XLSXFile* xlsx, const char* cellAddress, XmlNodeRef root, const char* sheetName)
 {
 	XmlNodeRef iter = XmlNode_findChild(root, "sheetData");
@@ -375,7 +737,10 @@ double ED_getDoubleFromXLSX(void* _xlsx, const char* cellAddress, const char* sh
 	XLSXFile* xlsx = (XLSXFile*)_xlsx;
 	if (xlsx != NULL) {
 		char* _sheetName = (char*)sheetName;
-		XmlNodeRef root = findSheet(xlsx, &_sheetName);
+		XmlNodeRef root;
+		ED_TRACE_GET_BEGIN(xlsx->fileName, cellAddress);
+		ED_trimEnter(xlsx->trim);
+		root = findSheet(xlsx, &_sheetName);
 		if (root != NULL) {
 			char* token = findCellValue(xlsx, cellAddress, root, _sheetName);
 			if (token != NULL) {
@@ -391,6 +756,8 @@ double ED_getDoubleFromXLSX(void* _xlsx, const char* cellAddress, const char* sh
 					(unsigned int)row, (unsigned int)col, sheetName, xlsx->fileName);
 			}
 		}
+		ED_TRACE_GET_END(xlsx->fileName, cellAddress, 1);
+		ED_trimLeave(xlsx->trim);
 	}
 	return ret;
 }
@@ -400,12 +767,17 @@ const char* ED_getStringFromXLSX(void* _xlsx, const char* cellAddress, const cha
 	XLSXFile* xlsx = (XLSXFile*)_xlsx;
 	if (xlsx != NULL) {
 		char* _sheetName = (char*)sheetName;
-		XmlNodeRef root = findSheet(xlsx, &_sheetName);
+		XmlNodeRef root;
+		ED_TRACE_GET_BEGIN(xlsx->fileName, cellAddress);
+		ED_trimEnter(xlsx->trim);
+		root = findSheet(xlsx, &_sheetName);
 		if (root != NULL) {
 			char* token = findCellValue(xlsx, cellAddress, root, _sheetName);
 			if (token != NULL) {
 				char* ret = ModelicaAllocateString(strlen(token));
 				strcpy(ret, token);
+				ED_TRACE_GET_END(xlsx->fileName, cellAddress, 1);
+				ED_trimLeave(xlsx->trim);
 				return (const char*)ret;
 			}
 			else {
@@ -415,6 +787,8 @@ const char* ED_getStringFromXLSX(void* _xlsx, const char* cellAddress, const cha
 					(unsigned int)row, (unsigned int)col, sheetName, xlsx->fileName);
 			}
 		}
+		ED_TRACE_GET_END(xlsx->fileName, cellAddress, 0);
+		ED_trimLeave(xlsx->trim);
 	}
 	return "";
 }
@@ -425,7 +799,10 @@ int ED_getIntFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetNam
 	XLSXFile* xlsx = (XLSXFile*)_xlsx;
 	if (xlsx != NULL) {
 		char* _sheetName = (char*)sheetName;
-		XmlNodeRef root = findSheet(xlsx, &_sheetName);
+		XmlNodeRef root;
+		ED_TRACE_GET_BEGIN(xlsx->fileName, cellAddress);
+		ED_trimEnter(xlsx->trim);
+		root = findSheet(xlsx, &_sheetName);
 		if (root != NULL) {
 			char* token = findCellValue(xlsx, cellAddress, root, _sheetName);
 			if (token != NULL) {
@@ -441,42 +818,126 @@ int ED_getIntFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetNam
 					(unsigned int)row, (unsigned int)col, sheetName, xlsx->fileName);
 			}
 		}
+		ED_TRACE_GET_END(xlsx->fileName, cellAddress, 1);
+		ED_trimLeave(xlsx->trim);
 	}
 	return (int)ret;
 }
 
+/* Load the cell values of the sheet, values that are not numeric are kept
+ * as text. Rows and cells without reference follow their predecessor.
+ */
+static ED_Table* buildTable(XLSXFile* xlsx, XmlNodeRef root, const char* sheetName)
+{
+	ED_Table* table;
+	XmlNodeRef sheetData = XmlNode_findChild(root, "sheetData");
+	size_t i;
+	size_t row = 0;
+	if (sheetData == NULL) {
+		ModelicaFormatError("Cannot find \"sheetData\" in sheet \"%s\" from file \"%s\"\n",
+			sheetName, xlsx->fileName);
+		return NULL;
+	}
+	table = ED_tableCreate();
+	if (table == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	for (i = 0; i < XmlNode_getChildCount(sheetData); i++) {
+		XmlNodeRef rowNode = XmlNode_getChild(sheetData, (int)i);
+		char* r;
+		size_t j;
+		size_t col = 0;
+		if (!XmlNode_isTag(rowNode, "row")) {
+			continue;
+		}
+		r = XmlNode_getAttributeValue(rowNode, "r");
+		if (r != NULL && atoi(r) > 0) {
+			row = (size_t)atoi(r) - 1;
+		}
+		for (j = 0; j < XmlNode_getChildCount(rowNode); j++) {
+			XmlNodeRef cellNode = XmlNode_getChild(rowNode, (int)j);
+			char* token;
+			if (!XmlNode_isTag(cellNode, "c")) {
+				continue;
+			}
+			r = XmlNode_getAttributeValue(cellNode, "r");
+			if (r != NULL) {
+				WORD cellRow, cellCol;
+				rc(r, &cellRow, &cellCol);
+				col = cellCol;
+			}
+			token = getCellValue(xlsx, cellNode);
+			if (token != NULL) {
+				double val;
+				int err = ED_strtod(token, xlsx->loc, &val) ?
+					ED_tableSetString(table, row, col, token) :
+					ED_tableSetDouble(table, row, col, val);
+				if (err != 0) {
+					ED_tableFree(table);
+					ModelicaError("Memory allocation error\n");
+					return NULL;
+				}
+			}
+			col++;
+		}
+		row++;
+	}
+	if (ED_tableCompressionEnabled()) {
+		(void)ED_tableCompress(table);
+	}
+	return table;
+}
+
+static ED_Table* findTable(XLSXFile* xlsx, char** sheetName)
+{
+	SheetShare* iter;
+	XmlNodeRef root;
+	resolveSheetName(xlsx, sheetName);
+	HASH_FIND_STR(xlsx->sheets, *sheetName, iter);
+	if (iter != NULL && iter->table != NULL) {
+		return iter->table;
+	}
+	root = findSheet(xlsx, sheetName);
+	if (root == NULL) {
+		return NULL;
+	}
+	iter->table = buildTable(xlsx, root, *sheetName);
+	return iter->table;
+}
+
 void ED_getDoubleArray2DFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetName, double* a, size_t m, size_t n)
 {
 	XLSXFile* xlsx = (XLSXFile*)_xlsx;
 	if (xlsx != NULL) {
 		char* _sheetName = (char*)sheetName;
-		XmlNodeRef root = findSheet(xlsx, &_sheetName);
-		if (root != NULL) {
+		ED_Table* table;
+		ED_TRACE_GET_BEGIN(xlsx->fileName, cellAddress);
+		ED_trimEnter(xlsx->trim);
+		table = findTable(xlsx, &_sheetName);
+		if (table != NULL) {
 			WORD row = 0, col = 0;
-			WORD i, j;
-			char cell[63];
-			char tmp[63];
 			rc(cellAddress, &row, &col);
-			for (i = 0; i < m; i++) {
-				for (j = 0; j < n; j++) {
-					char* token;
-					tmp[0] = '\0';
-					ca(tmp, col + j);
-					sprintf(cell, "%s%u", tmp, (unsigned int)(row + i + 1));
-					token = findCellValue(xlsx, cell, root, _sheetName);
-					if (token != NULL) {
-						if (ED_strtod(token, xlsx->loc, &a[i*n + j])) {
+			if (0 != ED_tableGetDoubleArray2D(table, row, col, m, n, a)) {
+				size_t i, j;
+				/* Report the cells without numeric value */
+				for (i = 0; i < m; i++) {
+					for (j = 0; j < n; j++) {
+						const char* token = ED_tableGetString(table, row + i, col + j);
+						if (token != NULL) {
 							ModelicaFormatError("Error in cell (%u,%u) when reading double value \"%s\" from sheet \"%s\" of file \"%s\"\n",
 								(unsigned int)(row + i), (unsigned int)(col + j), token, _sheetName, xlsx->fileName);
+							return;
+						}
+						if (ED_tableCellType(table, row + i, col + j) == ED_TABLE_EMPTY) {
+							ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
+								(unsigned int)(row + i), (unsigned int)(col + j), _sheetName, xlsx->fileName);
 						}
-					}
-					else {
-						a[i*n + j] = 0.;
-						ModelicaFormatMessage("Cannot get cell (%u,%u) in sheet \"%s\" from file \"%s\"\n",
-							(unsigned int)(row +i), (unsigned int)(col + j), _sheetName, xlsx->fileName);
 					}
 				}
 			}
 		}
+		ED_TRACE_GET_END(xlsx->fileName, cellAddress, m*n);
+		ED_trimLeave(xlsx->trim);
 	}
 }
@@ -0,0 +1,705 @@
+/* ED_XLSXWriter.c - Excel XLSX write functions
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* The workbook is written as a zip archive in a single pass: the rows of
+ * the worksheet are deflated into the archive as they are written, each
+ * member is followed by a data descriptor with its checksum and sizes, and
+ * the shared strings and the central directory are written when the
+ * writer is destroyed. Only the shared strings are kept in memory.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#if defined(_MSC_VER)
+#define strdup _strdup
+#endif
+#include "zlib.h"
+#include "ED_locale.h"
+#include "ED_trace.h"
+#include "ModelicaUtilities.h"
+#include "../Include/ED_XLSXFile.h"
+#define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
+#include "uthash.h"
+
+/* Size of the text and the deflate buffer */
+#if !defined(ED_XLSX_WRITE_BUFFER)
+#define ED_XLSX_WRITE_BUFFER (1 << 16)
+#endif
+/* Compression level, the fastest level keeps writing ahead of deflate
+ * for the repetitive XML of the rows
+ */
+#if !defined(ED_XLSX_WRITE_LEVEL)
+#define ED_XLSX_WRITE_LEVEL Z_BEST_SPEED
+#endif
+/* Limits of a worksheet */
+#define ED_XLSX_MAX_ROWS (1048576UL)
+#define ED_XLSX_MAX_COLS (16384UL)
+/* Size of the letters of the last column "XFD" and the NUL */
+#define ED_XLSX_COL_NAME (4)
+/* Members of the archive */
+#define ED_XLSX_MAX_ENTRIES (8)
+/* Largest size or offset of a zip archive without Zip64 extensions */
+#define ZIP_MAX (0xFFFFFFFFUL)
+
+typedef struct {
+	const char* name;
+	unsigned long crc;
+	unsigned long size;
+	unsigned long compSize;
+	unsigned long offset; /* Offset of the local header */
+} ZipEntry;
+
+typedef struct {
+	char* str;
+	unsigned long index;
+	UT_hash_handle hh; /* Hashable structure, iterated in index order */
+} SharedString;
+
+typedef struct {
+	char* fileName;
+	char* sheetName;
+	FILE* fp;
+	ED_LOCALE_TYPE loc;
+	unsigned long offset; /* Number of bytes written to fp */
+	unsigned int dosTime;
+	unsigned int dosDate;
+	ZipEntry entries[ED_XLSX_MAX_ENTRIES];
+	size_t nEntries;
+	ZipEntry* entry; /* Member being deflated, NULL if none */
+	z_stream z;
+	char in[ED_XLSX_WRITE_BUFFER];
+	size_t inLen;
+	unsigned char out[ED_XLSX_WRITE_BUFFER];
+	unsigned long rows; /* Number of rows written */
+	SharedString* strings; /* Unique strings of the string cells */
+	unsigned long nStrings; /* Number of string cells */
+	int failed; /* Nonzero after an error, the archive is not finished */
+} XLSXWriter;
+
+static const char contentTypesXml[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+	"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+	"<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+	"<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+	"<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+	"<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>"
+	"<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+	"</Types>";
+
+static const char relsXml[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+	"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+	"</Relationships>";
+
+static const char workbookRelsXml[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+	"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+	"<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+	"<Relationship Id=\"rId3\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+	"</Relationships>";
+
+static const char stylesXml[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+	"<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+	"<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill><fill><patternFill patternType=\"gray125\"/></fill></fills>"
+	"<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+	"<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+	"<cellXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/></cellXfs>"
+	"</styleSheet>";
+
+static const char workbookXmlBegin[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+	"xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+	"<sheets><sheet name=\"";
+
+static const char workbookXmlEnd[] = "\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>";
+
+static const char sheetXmlBegin[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+	"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+
+static const char sheetXmlEnd[] = "</sheetData></worksheet>";
+
+static void putLE16(unsigned char* p, unsigned int val)
+{
+	p[0] = (unsigned char)(val & 0xFF);
+	p[1] = (unsigned char)((val >> 8) & 0xFF);
+}
+
+static void putLE32(unsigned char* p, unsigned long val)
+{
+	putLE16(p, (unsigned int)(val & 0xFFFF));
+	putLE16(p + 2, (unsigned int)((val >> 16) & 0xFFFF));
+}
+
+/* Write n bytes to the file, returns -1 and sets errno on failure */
+static int putBytes(XLSXWriter* w, const void* p, size_t n)
+{
+	if (n > ZIP_MAX - w->offset) {
+		errno = EFBIG;
+		return -1;
+	}
+	if (fwrite(p, 1, n, w->fp) != n) {
+		errno = EIO;
+		return -1;
+	}
+	w->offset += (unsigned long)n;
+	return 0;
+}
+
+/* Deflate the text buffer, up to the end of the member if flush is
+ * Z_FINISH
+ */
+static int deflateText(XLSXWriter* w, int flush)
+{
+	int rc;
+	w->entry->crc = crc32(w->entry->crc, (const Bytef*)w->in, (uInt)w->inLen);
+	w->z.next_in = (Bytef*)w->in;
+	w->z.avail_in = (uInt)w->inLen;
+	do {
+		size_t n;
+		w->z.next_out = w->out;
+		w->z.avail_out = (uInt)sizeof(w->out);
+		rc = deflate(&w->z, flush);
+		if (rc == Z_STREAM_ERROR) {
+			errno = EINVAL;
+			return -1;
+		}
+		n = sizeof(w->out) - w->z.avail_out;
+		if (n > ZIP_MAX - w->entry->compSize) {
+			errno = EFBIG;
+			return -1;
+		}
+		if (0 != putBytes(w, w->out, n)) {
+			return -1;
+		}
+		w->entry->compSize += (unsigned long)n;
+	} while (w->z.avail_out == 0 || (flush == Z_FINISH && rc != Z_STREAM_END));
+	w->inLen = 0;
+	return 0;
+}
+
+/* Append n bytes of text to the member being deflated */
+static int putText(XLSXWriter* w, const char* s, size_t n)
+{
+	if (n > ZIP_MAX - w->entry->size) {
+		errno = EFBIG;
+		return -1;
+	}
+	w->entry->size += (unsigned long)n;
+	while (n > 0) {
+		size_t len = sizeof(w->in) - w->inLen;
+		if (len > n) {
+			len = n;
+		}
+		memcpy(w->in + w->inLen, s, len);
+		w->inLen += len;
+		s += len;
+		n -= len;
+		if (w->inLen == sizeof(w->in) && 0 != deflateText(w, Z_NO_FLUSH)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int putString(XLSXWriter* w, const char* s)
+{
+	return putText(w, s, strlen(s));
+}
+
+/* Append the XML escaped text of the UTF-8 string s. Control characters,
+ * which XML does not allow, are escaped as _xHHHH_.
+ */
+static int putEscaped(XLSXWriter* w, const char* s)
+{
+	const char* p = s;
+	for (; *p != '\0'; p++) {
+		unsigned char c = (unsigned char)*p;
+		if (c == '&' || c == '<' || c == '>' || c == '"' ||
+			(c < ' ' && c != '\t' && c != '\n' && c != '\r')) {
+			char esc[8];
+			if (0 != putText(w, s, (size_t)(p - s))) {
+				return -1;
+			}
+			switch (c) {
+				case '&':
+					strcpy(esc, "&amp;");
+					break;
+				case '<':
+					strcpy(esc, "&lt;");
+					break;
+				case '>':
+					strcpy(esc, "&gt;");
+					break;
+				case '"':
+					strcpy(esc, "&quot;");
+					break;
+				default:
+					sprintf(esc, "_x%04X_", (unsigned int)c);
+					break;
+			}
+			if (0 != putString(w, esc)) {
+				return -1;
+			}
+			s = p + 1;
+		}
+	}
+	return putText(w, s, (size_t)(p - s));
+}
+
+/* Start the member name with a local header, whose checksum and sizes
+ * follow in the data descriptor
+ */
+static int beginEntry(XLSXWriter* w, const char* name)
+{
+	unsigned char h[30];
+	size_t len = strlen(name);
+	if (w->nEntries == ED_XLSX_MAX_ENTRIES) {
+		errno = EINVAL;
+		return -1;
+	}
+	w->entry = &w->entries[w->nEntries++];
+	w->entry->name = name;
+	w->entry->crc = crc32(0L, Z_NULL, 0);
+	w->entry->size = 0;
+	w->entry->compSize = 0;
+	w->entry->offset = w->offset;
+	putLE32(h, 0x04034b50UL);
+	putLE16(h + 4, 20); /* Version needed to extract */
+	putLE16(h + 6, 0x0008); /* Data descriptor follows */
+	putLE16(h + 8, Z_DEFLATED);
+	putLE16(h + 10, w->dosTime);
+	putLE16(h + 12, w->dosDate);
+	putLE32(h + 14, 0);
+	putLE32(h + 18, 0);
+	putLE32(h + 22, 0);
+	putLE16(h + 26, (unsigned int)len);
+	putLE16(h + 28, 0);
+	if (0 != putBytes(w, h, sizeof(h)) || 0 != putBytes(w, name, len)) {
+		return -1;
+	}
+	w->inLen = 0;
+	if (Z_OK != deflateReset(&w->z)) {
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+/* Finish the member being deflated with its data descriptor */
+static int endEntry(XLSXWriter* w)
+{
+	unsigned char d[16];
+	if (0 != deflateText(w, Z_FINISH)) {
+		return -1;
+	}
+	putLE32(d, 0x08074b50UL);
+	putLE32(d + 4, w->entry->crc);
+	putLE32(d + 8, w->entry->compSize);
+	putLE32(d + 12, w->entry->size);
+	w->entry = NULL;
+	return putBytes(w, d, sizeof(d));
+}
+
+static int putEntry(XLSXWriter* w, const char* name, const char* text)
+{
+	if (0 != beginEntry(w, name) || 0 != putString(w, text)) {
+		return -1;
+	}
+	return endEntry(w);
+}
+
+static int putCentralDirectory(XLSXWriter* w)
+{
+	unsigned long start = w->offset;
+	unsigned char e[46];
+	size_t i;
+	for (i = 0; i < w->nEntries; i++) {
+		ZipEntry* entry = &w->entries[i];
+		size_t len = strlen(entry->name);
+		putLE32(e, 0x02014b50UL);
+		putLE16(e + 4, 20); /* Version made by */
+		putLE16(e + 6, 20); /* Version needed to extract */
+		putLE16(e + 8, 0x0008);
+		putLE16(e + 10, Z_DEFLATED);
+		putLE16(e + 12, w->dosTime);
+		putLE16(e + 14, w->dosDate);
+		putLE32(e + 16, entry->crc);
+		putLE32(e + 20, entry->compSize);
+		putLE32(e + 24, entry->size);
+		putLE16(e + 28, (unsigned int)len);
+		memset(e + 30, 0, 12); /* Extra field, comment, disk, attributes */
+		putLE32(e + 42, entry->offset);
+		if (0 != putBytes(w, e, sizeof(e)) || 0 != putBytes(w, entry->name, len)) {
+			return -1;
+		}
+	}
+	putLE32(e, 0x06054b50UL);
+	putLE16(e + 4, 0);
+	putLE16(e + 6, 0);
+	putLE16(e + 8, (unsigned int)w->nEntries);
+	putLE16(e + 10, (unsigned int)w->nEntries);
+	putLE32(e + 12, w->offset - start);
+	putLE32(e + 16, start);
+	putLE16(e + 20, 0);
+	return putBytes(w, e, 22);
+}
+
+/* Write the shared strings in the order of their indices */
+static int putSharedStrings(XLSXWriter* w)
+{
+	SharedString* iter;
+	char buf[96];
+	if (0 != beginEntry(w, "xl/sharedStrings.xml")) {
+		return -1;
+	}
+	if (0 != putString(w, "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"")) {
+		return -1;
+	}
+	sprintf(buf, "%lu\" uniqueCount=\"%lu\">", w->nStrings, (unsigned long)HASH_COUNT(w->strings));
+	if (0 != putString(w, buf)) {
+		return -1;
+	}
+	for (iter = w->strings; iter != NULL; iter = (SharedString*)iter->hh.next) {
+		if (0 != putString(w, "<si><t xml:space=\"preserve\">") ||
+			0 != putEscaped(w, iter->str) || 0 != putString(w, "</t></si>")) {
+			return -1;
+		}
+	}
+	if (0 != putString(w, "</sst>")) {
+		return -1;
+	}
+	return endEntry(w);
+}
+
+/* Finish the worksheet and write the remaining members of the archive */
+static int finish(XLSXWriter* w)
+{
+	if (0 != putString(w, sheetXmlEnd) || 0 != endEntry(w) ||
+		0 != putSharedStrings(w) ||
+		0 != beginEntry(w, "xl/workbook.xml") || 0 != putString(w, workbookXmlBegin) ||
+		0 != putEscaped(w, w->sheetName) || 0 != putString(w, workbookXmlEnd) ||
+		0 != endEntry(w) ||
+		0 != putEntry(w, "xl/_rels/workbook.xml.rels", workbookRelsXml) ||
+		0 != putEntry(w, "xl/styles.xml", stylesXml) ||
+		0 != putEntry(w, "_rels/.rels", relsXml) ||
+		0 != putEntry(w, "[Content_Types].xml", contentTypesXml) ||
+		0 != putCentralDirectory(w)) {
+		return -1;
+	}
+	return 0;
+}
+
+static void freeWriter(XLSXWriter* w)
+{
+	SharedString* iter;
+	SharedString* tmp;
+	HASH_ITER(hh, w->strings, iter, tmp) {
+		HASH_DEL(w->strings, iter);
+		free(iter->str);
+		free(iter);
+	}
+	deflateEnd(&w->z);
+	ED_FREE_LOCALE(w->loc);
+	free(w->fileName);
+	free(w->sheetName);
+	free(w);
+}
+
+void* ED_createXLSXWriter(const char* fileName, const char* sheetName, int verbose)
+{
+	XLSXWriter* w;
+	time_t now = time(NULL);
+	struct tm* t = localtime(&now);
+	ED_TRACE_CREATE_BEGIN("XLSXWriter", fileName);
+	if (strlen(sheetName) == 0 || strlen(sheetName) > 31 || strpbrk(sheetName, "[]:*?/\\") != NULL) {
+		ModelicaFormatError("Invalid sheet name \"%s\" for file \"%s\"\n", sheetName, fileName);
+		return NULL;
+	}
+	w = (XLSXWriter*)calloc(1, sizeof(XLSXWriter));
+	if (w == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	w->fileName = strdup(fileName);
+	w->sheetName = strdup(sheetName);
+	if (w->fileName == NULL || w->sheetName == NULL ||
+		Z_OK != deflateInit2(&w->z, ED_XLSX_WRITE_LEVEL, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY)) {
+		free(w->fileName);
+		free(w->sheetName);
+		free(w);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	w->loc = ED_INIT_LOCALE;
+	if (t != NULL) {
+		w->dosTime = (unsigned int)((t->tm_hour << 11) | (t->tm_min << 5) | (t->tm_sec/2));
+		w->dosDate = (unsigned int)(((t->tm_year - 80) << 9) | ((t->tm_mon + 1) << 5) | t->tm_mday);
+	}
+
+	if (verbose == 1) {
+		/* Print info message, that file is writing */
+		ModelicaFormatMessage("... writing \"%s\"\n", fileName);
+	}
+
+	w->fp = fopen(fileName, "wb");
+	if (w->fp == NULL) {
+		freeWriter(w);
+		ModelicaFormatError("Not possible to open file \"%s\" for writing\n", fileName);
+		return NULL;
+	}
+	if (0 != beginEntry(w, "xl/worksheets/sheet1.xml") || 0 != putString(w, sheetXmlBegin)) {
+		fclose(w->fp);
+		freeWriter(w);
+		ModelicaFormatError("Cannot write file \"%s\"\n", fileName);
+		return NULL;
+	}
+	ED_TRACE_CREATE_END("XLSXWriter", fileName, w);
+	return w;
+}
+
+void ED_destroyXLSXWriter(void* _w)
+{
+	XLSXWriter* w = (XLSXWriter*)_w;
+	if (w != NULL) {
+		int failed;
+		int rc;
+		char* fileName = NULL;
+		ED_TRACE_DESTROY("XLSXWriter", w->fileName);
+		failed = w->failed;
+		rc = failed ? 0 : finish(w);
+		if (0 != fclose(w->fp)) {
+			rc = -1;
+		}
+		if (rc != 0) {
+			/* Keep the file name to report the error */
+			fileName = w->fileName;
+			w->fileName = NULL;
+		}
+		freeWriter(w);
+		if (fileName != NULL) {
+			ModelicaFormatError("Cannot write file \"%s\"\n", fileName);
+		}
+	}
+}
+
+/* Column letters of the zero-based column index col < ED_XLSX_MAX_COLS */
+static void columnName(size_t col, char* buf)
+{
+	char tmp[ED_XLSX_COL_NAME - 1];
+	size_t n = 0;
+	col++;
+	do {
+		col--;
+		tmp[n++] = (char)('A' + col % 26);
+		col /= 26;
+	} while (col > 0);
+	while (n > 0) {
+		*buf++ = tmp[--n];
+	}
+	*buf = '\0';
+}
+
+/* Shortest of %.15g and %.17g that converts back to val, with a decimal
+ * point regardless of the locale
+ */
+static void formatDouble(char* buf, double val, ED_LOCALE_TYPE loc)
+{
+	double tmp = 0.;
+	char* p;
+	sprintf(buf, "%.15g", val);
+	p = strchr(buf, ',');
+	if (p != NULL) {
+		*p = '.';
+	}
+	if (ED_strtod(buf, loc, &tmp) != ED_OK || tmp != val) {
+		sprintf(buf, "%.17g", val);
+		p = strchr(buf, ',');
+		if (p != NULL) {
+			*p = '.';
+		}
+	}
+}
+
+/* Start the next row of n cells */
+static int beginRow(XLSXWriter* w, size_t n)
+{
+	char buf[32];
+	if (w->rows == ED_XLSX_MAX_ROWS || n > ED_XLSX_MAX_COLS) {
+		errno = ERANGE;
+		return -1;
+	}
+	sprintf(buf, "<row r=\"%lu\">", ++w->rows);
+	return putString(w, buf);
+}
+
+static void raiseWriteError(XLSXWriter* w, size_t n)
+{
+	w->failed = 1;
+	if (errno == ERANGE) {
+		ModelicaFormatError("Cannot write row %lu of %lu cells to file \"%s\": "
+			"Too many rows or columns\n", w->rows + 1, (unsigned long)n, w->fileName);
+	}
+	else if (errno == ENOMEM) {
+		ModelicaError("Memory allocation error\n");
+	}
+	else if (errno == EFBIG) {
+		ModelicaFormatError("Cannot write file \"%s\": File too large\n", w->fileName);
+	}
+	else {
+		ModelicaFormatError("Cannot write file \"%s\"\n", w->fileName);
+	}
+}
+
+/* Append the rows of the m x n array a (row-major order) as numeric
+ * cells. NaN and infinity, which Excel does not have, are #NUM! errors.
+ */
+void ED_writeDoubleArray2DToXLSX(void* _w, const double* a, size_t m, size_t n)
+{
+	XLSXWriter* w = (XLSXWriter*)_w;
+	if (w != NULL && !w->failed) {
+		char* cols;
+		char buf[96];
+		size_t i, j;
+		if (n > ED_XLSX_MAX_COLS) {
+			errno = ERANGE;
+			raiseWriteError(w, n);
+			return;
+		}
+		cols = (char*)malloc(ED_XLSX_COL_NAME*(n > 0 ? n : 1));
+		if (cols == NULL) {
+			errno = ENOMEM;
+			raiseWriteError(w, n);
+			return;
+		}
+		for (j = 0; j < n; j++) {
+			columnName(j, cols + ED_XLSX_COL_NAME*j);
+		}
+		for (i = 0; i < m; i++) {
+			if (0 != beginRow(w, n)) {
+				free(cols);
+				raiseWriteError(w, n);
+				return;
+			}
+			for (j = 0; j < n; j++) {
+				double val = a[i*n + j];
+				int len;
+				if (val == val && val - val == 0.) {
+					char num[32];
+					formatDouble(num, val, w->loc);
+					len = sprintf(buf, "<c r=\"%s%lu\"><v>%s</v></c>", cols + ED_XLSX_COL_NAME*j, w->rows, num);
+				}
+				else {
+					len = sprintf(buf, "<c r=\"%s%lu\" t=\"e\"><v>#NUM!</v></c>", cols + ED_XLSX_COL_NAME*j, w->rows);
+				}
+				if (0 != putText(w, buf, (size_t)len)) {
+					free(cols);
+					raiseWriteError(w, n);
+					return;
+				}
+			}
+			if (0 != putString(w, "</row>")) {
+				free(cols);
+				raiseWriteError(w, n);
+				return;
+			}
+		}
+		free(cols);
+	}
+}
+
+void ED_writeDoubleArray1DToXLSX(void* _w, const double* a, size_t n)
+{
+	ED_writeDoubleArray2DToXLSX(_w, a, 1, n);
+}
+
+/* Index of the shared string str, which is added if it is new */
+static SharedString* findString(XLSXWriter* w, const char* str)
+{
+	SharedString* iter;
+	HASH_FIND_STR(w->strings, str, iter);
+	if (iter == NULL) {
+		iter = (SharedString*)malloc(sizeof(SharedString));
+		if (iter == NULL) {
+			return NULL;
+		}
+		iter->str = strdup(str);
+		if (iter->str == NULL) {
+			free(iter);
+			return NULL;
+		}
+		iter->index = (unsigned long)HASH_COUNT(w->strings);
+		HASH_ADD_KEYPTR(hh, w->strings, iter->str, strlen(iter->str), iter);
+	}
+	return iter;
+}
+
+/* Append a row of string cells, the strings are shared */
+void ED_writeStringArray1DToXLSX(void* _w, const char** s, size_t n)
+{
+	XLSXWriter* w = (XLSXWriter*)_w;
+	if (w != NULL && !w->failed) {
+		char col[ED_XLSX_COL_NAME];
+		char buf[64];
+		size_t j;
+		if (0 != beginRow(w, n)) {
+			raiseWriteError(w, n);
+			return;
+		}
+		for (j = 0; j < n; j++) {
+			SharedString* str = findString(w, s[j]);
+			int len;
+			if (str == NULL) {
+				errno = ENOMEM;
+				raiseWriteError(w, n);
+				return;
+			}
+			columnName(j, col);
+			len = sprintf(buf, "<c r=\"%s%lu\" t=\"s\"><v>%lu</v></c>", col, w->rows, str->index);
+			if (0 != putText(w, buf, (size_t)len)) {
+				raiseWriteError(w, n);
+				return;
+			}
+			w->nStrings++;
+		}
+		if (0 != putString(w, "</row>")) {
+			raiseWriteError(w, n);
+		}
+	}
+}
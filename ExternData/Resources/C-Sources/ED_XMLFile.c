@@ -28,13 +28,22 @@
 #define _GNU_SOURCE 1
 #endif
 
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
 #if defined(_MSC_VER)
 #define strdup _strdup
 #endif
 #include "ED_locale.h"
+#include "ED_vfile.h"
+#include "ED_parallel.h"
+#include "ED_share.h"
+#include "ED_trace.h"
 #include "bsxml.h"
 #include "ModelicaUtilities.h"
+#define uthash_fatal(msg) ModelicaFormatMessage("Error: %s\n", msg); break
+#include "uthash.h"
+#include "../Include/ED_trim.h"
 #include "../Include/ED_XMLFile.h"
 
 /* The standard way to detect posix is to check _POSIX_VERSION,
@@ -56,59 +65,346 @@
 #endif
 
 typedef struct {
+	char* key; /* Normalized variable name in lower case */
+	XmlNodeRef node; /* Element in the root of the overlay */
+	UT_hash_handle hh; /* Hashable structure */
+} XMLOverride;
+
+typedef struct XMLFile {
 	char* fileName;
 	XmlNodeRef root;
 	ED_LOCALE_TYPE loc;
+	struct XMLFile* base; /* Base of an overlay, NULL otherwise */
+	XMLOverride* overrides; /* Elements of an overlay by variable name */
+	int refCount; /* Number of owners, i.e. the callers and overlays */
+	ED_TrimEntry* trim; /* NULL for overlays */
 } XMLFile;
 
-void* ED_createXML(const char* fileName, int verbose)
+static size_t readXML(void* buf, size_t len, void* vf)
+{
+	return ED_vfread(buf, len, (ED_VFILE*)vf);
+}
+
+/* Parse the file, errors are raised */
+static XmlNodeRef parseXML(const char* fileName)
 {
 	XmlParser xmlParser;
-	XMLFile* xml = (XMLFile*)malloc(sizeof(XMLFile));
+	XmlNodeRef root;
+	ED_VFILE* vf;
+	const char* view;
+	size_t len;
+
+	vf = ED_vfopen(fileName);
+	if (vf == NULL) {
+		ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(errno));
+		return NULL;
+	}
+	ED_TRACE_PARSE_BEGIN("XmlParser_parse", fileName);
+	view = ED_vfmap(vf, &len);
+	if (view != NULL) {
+		root = XmlParser_parse_buffer(&xmlParser, view, len);
+	}
+	else {
+		root = XmlParser_parse_stream(&xmlParser, readXML, vf);
+		len = (size_t)ED_vftell(vf);
+	}
+	ED_vfclose(vf);
+	ED_TRACE_PARSE_END("XmlParser_parse", fileName, len);
+	if (root == NULL) {
+		if (XmlParser_getErrorLineSet(&xmlParser) != 0) {
+			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse file \"%s\"\n",
+				XmlParser_getErrorString(&xmlParser), XmlParser_getErrorLine(&xmlParser), fileName);
+		}
+		else {
+			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, XmlParser_getErrorString(&xmlParser));
+		}
+	}
+	return root;
+}
+
+/* Release the tree, it is parsed again on the next access */
+static void trimXML(void* _xml)
+{
+	XMLFile* xml = (XMLFile*)_xml;
+	XmlNode_deleteTree(xml->root);
+	xml->root = NULL;
+}
+
+void* ED_createXML(const char* fileName, int verbose)
+{
+	XmlNodeRef root;
+	XMLFile* xml;
+
+	ED_TRACE_CREATE_BEGIN("XML", fileName);
+	if (verbose == 1) {
+		/* Print info message, that file is loading */
+		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+	}
+
+	root = parseXML(fileName);
+	xml = (XMLFile*)malloc(sizeof(XMLFile));
 	if (xml == NULL) {
+		XmlNode_deleteTree(root);
 		ModelicaError("Memory allocation error\n");
 		return NULL;
 	}
 	xml->fileName = strdup(fileName);
 	if (xml->fileName == NULL) {
+		XmlNode_deleteTree(root);
 		free(xml);
 		ModelicaError("Memory allocation error\n");
 		return NULL;
 	}
+	xml->root = root;
+	xml->loc = ED_INIT_LOCALE;
+	xml->base = NULL;
+	xml->overrides = NULL;
+	xml->refCount = 1;
+	xml->trim = ED_trimRegister(xml, trimXML);
+	ED_parallelAcquire();
+	ED_TRACE_CREATE_END("XML", fileName, xml);
+	return xml;
+}
 
-	if (verbose == 1) {
-		/* Print info message, that file is loading */
-		ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+void ED_destroyXML(void* _xml)
+{
+	XMLFile* xml = (XMLFile*)_xml;
+	if (xml != NULL && ED_shareRelease(xml, &xml->refCount)) {
+		XMLOverride* iter;
+		XMLOverride* tmp;
+		ED_TRACE_DESTROY("XML", xml->fileName);
+		if (xml->fileName != NULL) {
+			free(xml->fileName);
+		}
+		ED_trimUnregister(xml->trim);
+		XmlNode_deleteTree(xml->root);
+		ED_FREE_LOCALE(xml->loc);
+		HASH_ITER(hh, xml->overrides, iter, tmp) {
+			HASH_DEL(xml->overrides, iter);
+			free(iter->key);
+			free(iter);
+		}
+		if (xml->base != NULL) {
+			ED_destroyXML(xml->base);
+		}
+		free(xml);
+		ED_parallelRelease();
+	}
+}
+
+/* Variable name in lower case (tags are compared case-insensitively) and
+ * without empty tokens, as they are skipped by findValue
+ */
+static char* normalizeName(const char* varName)
+{
+	char* key = (char*)malloc(strlen(varName) + 1);
+	if (key != NULL) {
+		const char* p = varName;
+		char* q = key;
+		while (*p != '\0') {
+			if (*p != '.' || (q > key && q[-1] != '.')) {
+				*q++ = (*p >= 'A' && *p <= 'Z') ? *p - 'A' + 'a' : *p;
+			}
+			p++;
+		}
+		if (q > key && q[-1] == '.') {
+			q--;
+		}
+		*q = '\0';
+	}
+	return key;
+}
+
+/* Add the descendants of node by their path. Like findValue, only the
+ * first element of a path is reachable.
+ */
+static int addOverrides(XMLFile* xml, XmlNodeRef node, const char* path)
+{
+	size_t len = strlen(path);
+	size_t i;
+	for (i = 0; i < XmlNode_getChildCount(node); i++) {
+		XMLOverride* iter;
+		XmlNodeRef child = XmlNode_getChild(node, i);
+		char* tag = XmlNode_getTag(child);
+		char* key = (char*)malloc(len + strlen(tag) + 2);
+		char* p;
+		if (key == NULL) {
+			return 0;
+		}
+		sprintf(key, len > 0 ? "%s.%s" : "%s%s", path, tag);
+		for (p = key + len; *p != '\0'; p++) {
+			if (*p >= 'A' && *p <= 'Z') {
+				*p = *p - 'A' + 'a';
+			}
+		}
+		HASH_FIND_STR(xml->overrides, key, iter);
+		if (iter != NULL) {
+			free(key);
+			continue;
+		}
+		iter = (XMLOverride*)malloc(sizeof(XMLOverride));
+		if (iter == NULL) {
+			free(key);
+			return 0;
+		}
+		iter->key = key;
+		iter->node = child;
+		HASH_ADD_KEYPTR(hh, xml->overrides, iter->key, strlen(iter->key), iter);
+		if (!addOverrides(xml, child, key)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Overlay of base with the elements of the XML file fileName or, if NULL,
+ * of the XML text str
+ */
+static XMLFile* createOverlay(XMLFile* base, const char* fileName, const char* str, int verbose)
+{
+	XmlParser xmlParser;
+	const char* name = fileName != NULL ? fileName : base->fileName;
+	XMLFile* xml = (XMLFile*)malloc(sizeof(XMLFile));
+	if (xml == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	xml->fileName = strdup(name);
+	if (xml->fileName == NULL) {
+		free(xml);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
 	}
 
-	xml->root = XmlParser_parse_file(&xmlParser, fileName);
+	if (fileName != NULL) {
+		ED_VFILE* vf;
+		const char* view;
+		size_t len;
+		if (verbose == 1) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileName);
+		}
+		vf = ED_vfopen(fileName);
+		if (vf == NULL) {
+			free(xml->fileName);
+			free(xml);
+			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(errno));
+			return NULL;
+		}
+		ED_TRACE_PARSE_BEGIN("XmlParser_parse", fileName);
+		view = ED_vfmap(vf, &len);
+		if (view != NULL) {
+			xml->root = XmlParser_parse_buffer(&xmlParser, view, len);
+		}
+		else {
+			xml->root = XmlParser_parse_stream(&xmlParser, readXML, vf);
+			len = (size_t)ED_vftell(vf);
+		}
+		ED_vfclose(vf);
+		ED_TRACE_PARSE_END("XmlParser_parse", fileName, len);
+	}
+	else {
+		xml->root = XmlParser_parse(&xmlParser, str);
+	}
 	if (xml->root == NULL) {
 		free(xml->fileName);
 		free(xml);
 		if (XmlParser_getErrorLineSet(&xmlParser) != 0) {
-			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse file \"%s\"\n",
-				XmlParser_getErrorString(&xmlParser), XmlParser_getErrorLine(&xmlParser), fileName);
+			ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse overrides of file \"%s\"\n",
+				XmlParser_getErrorString(&xmlParser), XmlParser_getErrorLine(&xmlParser), name);
 		}
 		else {
-			ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, XmlParser_getErrorString(&xmlParser));
+			ModelicaFormatError("Cannot read overrides of file \"%s\": %s\n", name, XmlParser_getErrorString(&xmlParser));
 		}
 		return NULL;
 	}
+	xml->overrides = NULL;
+	xml->base = base;
+	xml->refCount = 1;
+	xml->trim = NULL;
 	xml->loc = ED_INIT_LOCALE;
+	ED_parallelAcquire();
+	if (!addOverrides(xml, xml->root, "")) {
+		/* No reference of base is taken yet */
+		xml->base = NULL;
+		ED_destroyXML(xml);
+		ModelicaError("Memory allocation error\n");
+		return NULL;
+	}
+	ED_shareRetain(&base->refCount);
 	return xml;
 }
 
-void ED_destroyXML(void* _xml)
+void* ED_createXMLOverlay(void* _base, const char* fileName, const char* overrides, int verbose)
 {
-	XMLFile* xml = (XMLFile*)_xml;
-	if (xml != NULL) {
-		if (xml->fileName != NULL) {
-			free(xml->fileName);
+	XMLFile* base = (XMLFile*)_base;
+	XMLFile* xml = base;
+	if (base == NULL) {
+		return NULL;
+	}
+	ED_TRACE_CREATE_BEGIN("XMLOverlay", fileName != NULL ? fileName : "");
+	if (fileName != NULL && strlen(fileName) > 0) {
+		xml = createOverlay(base, fileName, NULL, verbose);
+	}
+	if (xml != NULL && overrides != NULL && strlen(overrides) > 0) {
+		XMLFile* overlay = createOverlay(xml, NULL, overrides, verbose);
+		if (xml != base) {
+			/* The overrides hold the reference of the file overlay */
+			ED_destroyXML(xml);
+		}
+		xml = overlay;
+	}
+	if (xml == base) {
+		ED_shareRetain(&base->refCount);
+	}
+	ED_TRACE_CREATE_END("XMLOverlay", fileName != NULL ? fileName : "", xml);
+	return xml;
+}
+
+void* ED_createXMLWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose)
+{
+	/* The base is shared by all variants of the file */
+	XMLFile* base = (XMLFile*)ED_shareFind("XML", fileName);
+	void* xml;
+	if (base == NULL) {
+		XMLFile* created = (XMLFile*)ED_createXML(fileName, verbose);
+		base = (XMLFile*)ED_shareAdd(created, &created->refCount, "XML", fileName);
+		if (base != created) {
+			ED_destroyXML(created);
 		}
-		XmlNode_deleteTree(xml->root);
-		ED_FREE_LOCALE(xml->loc);
-		free(xml);
 	}
+	xml = ED_createXMLOverlay(base, overlayFileName, overrides, verbose);
+	ED_destroyXML(base);
+	return xml;
+}
+
+/* Find the element of the dotted name buf (which is modified) below root.
+ * Returns 1 if found or else 0, root is set to the last element found.
+ */
+static int findElement(XmlNodeRef* root, char* buf)
+{
+	char* nextToken = NULL;
+	char* token = strtok_r(buf, ".", &nextToken);
+	if (token == NULL) {
+		return 0;
+	}
+	while (token != NULL) {
+		asize_t i;
+		int foundToken = 0;
+		for (i = 0; i < XmlNode_getChildCount(*root); i++) {
+			XmlNodeRef child = XmlNode_getChild(*root, i);
+			if (XmlNode_isTag(child, token)) {
+				*root = child;
+				token = strtok_r(NULL, ".", &nextToken);
+				foundToken = 1;
+				break;
+			}
+		}
+		if (foundToken == 0) {
+			return 0;
+		}
+	}
+	return 1;
 }
 
 static char* findValue(XmlNodeRef* root, const char* varName, const char* fileName)
@@ -116,30 +412,9 @@ static char* findValue(XmlNodeRef* root, const char* varName, const char* fileNa
 	char* token = NULL;
 	char* buf = strdup(varName);
 	if (buf != NULL) {
-		int elementError = 0;
-		char* nextToken = NULL;
-		token = strtok_r(buf, ".", &nextToken);
-		if (token == NULL) {
-			elementError = 1;
-		}
-		while (token != NULL && elementError == 0) {
-			size_t i;
-			int foundToken = 0;
-			for (i = 0; i < XmlNode_getChildCount(*root); i++) {
-				XmlNodeRef child = XmlNode_getChild(*root, i);
-				if (XmlNode_isTag(child, token)) {
-					*root = child;
-					token = strtok_r(NULL, ".", &nextToken);
-					foundToken = 1;
-					break;
-				}
-			}
-			if (foundToken == 0) {
-				elementError = 1;
-			}
-		}
+		int found = findElement(root, buf);
 		free(buf);
-		if (elementError == 1) {
+		if (found == 0) {
 			ModelicaFormatError("Error in line %i: Cannot find element \"%s\" in file \"%s\"\n",
 				XmlNode_getLine(*root), varName, fileName);
 		}
@@ -151,13 +426,48 @@ static char* findValue(XmlNodeRef* root, const char* varName, const char* fileNa
 	return token;
 }
 
+/* Value of varName in the overrides of the overlays or else in the base,
+ * xml is set to the handle and root to the element providing it
+ */
+static char* lookupValue(XMLFile** xml, XmlNodeRef* root, const char* varName)
+{
+	char* token = NULL;
+	if ((*xml)->base != NULL) {
+		char* key = normalizeName(varName);
+		if (key == NULL) {
+			ModelicaError("Memory allocation error\n");
+			return NULL;
+		}
+		do {
+			XMLOverride* iter;
+			HASH_FIND_STR((*xml)->overrides, key, iter);
+			if (iter != NULL) {
+				free(key);
+				*root = iter->node;
+				XmlNode_getValue(*root, &token);
+				return token;
+			}
+			*xml = (*xml)->base;
+		} while ((*xml)->base != NULL);
+		free(key);
+	}
+	ED_trimEnter((*xml)->trim);
+	if ((*xml)->root == NULL) {
+		(*xml)->root = parseXML((*xml)->fileName);
+	}
+	*root = (*xml)->root;
+	return findValue(root, varName, (*xml)->fileName);
+}
+
 double ED_getDoubleFromXML(void* _xml, const char* varName)
 {
 	double ret = 0.;
 	XMLFile* xml = (XMLFile*)_xml;
 	if (xml != NULL) {
-		XmlNodeRef root = xml->root;
-		char* token = findValue(&root, varName, xml->fileName);
+		XmlNodeRef root;
+		char* token;
+		ED_TRACE_GET_BEGIN(xml->fileName, varName);
+		token = lookupValue(&xml, &root, varName);
 		if (token != NULL) {
 			if (ED_strtod(token, xml->loc, &ret)) {
 				ModelicaFormatError("Error in line %i: Cannot read double value \"%s\" from file \"%s\"\n",
@@ -168,6 +478,8 @@ double ED_getDoubleFromXML(void* _xml, const char* varName)
 			ModelicaFormatError("Error in line %i: Cannot read double value from file \"%s\"\n",
 				XmlNode_getLine(root), xml->fileName);
 		}
+		ED_TRACE_GET_END(xml->fileName, varName, 1);
+		ED_trimLeave(xml->trim);
 	}
 	return ret;
 }
@@ -176,11 +488,15 @@ const char* ED_getStringFromXML(void* _xml, const char* varName)
 {
 	XMLFile* xml = (XMLFile*)_xml;
 	if (xml != NULL) {
-		XmlNodeRef root = xml->root;
-		char* token = findValue(&root, varName, xml->fileName);
+		XmlNodeRef root;
+		char* token;
+		ED_TRACE_GET_BEGIN(xml->fileName, varName);
+		token = lookupValue(&xml, &root, varName);
 		if (token != NULL) {
 			char* ret = ModelicaAllocateString(strlen(token));
 			strcpy(ret, token);
+			ED_TRACE_GET_END(xml->fileName, varName, 1);
+			ED_trimLeave(xml->trim);
 			return (const char*)ret;
 		}
 		else {
@@ -196,8 +512,10 @@ int ED_getIntFromXML(void* _xml, const char* varName)
 	long ret = 0;
 	XMLFile* xml = (XMLFile*)_xml;
 	if (xml != NULL) {
-		XmlNodeRef root = xml->root;
-		char* token = findValue(&root, varName, xml->fileName);
+		XmlNodeRef root;
+		char* token;
+		ED_TRACE_GET_BEGIN(xml->fileName, varName);
+		token = lookupValue(&xml, &root, varName);
 		if (token != NULL) {
 			if (ED_strtol(token, xml->loc, &ret)) {
 				ModelicaFormatError("Error in line %i: Cannot read int value \"%s\" from file \"%s\"\n",
@@ -208,6 +526,8 @@ int ED_getIntFromXML(void* _xml, const char* varName)
 			ModelicaFormatError("Error in line %i: Cannot read int value from file \"%s\"\n",
 				XmlNode_getLine(root), xml->fileName);
 		}
+		ED_TRACE_GET_END(xml->fileName, varName, 1);
+		ED_trimLeave(xml->trim);
 	}
 	return (int)ret;
 }
@@ -216,9 +536,11 @@ void ED_getDoubleArray1DFromXML(void* _xml, const char* varName, double* a, size
 {
 	XMLFile* xml = (XMLFile*)_xml;
 	if (xml != NULL) {
-		XmlNodeRef root = xml->root;
+		XmlNodeRef root;
 		int iLevel = 0;
-		char* token = findValue(&root, varName, xml->fileName);
+		char* token;
+		ED_TRACE_GET_BEGIN(xml->fileName, varName);
+		token = lookupValue(&xml, &root, varName);
 		while (token == NULL && XmlNode_getChildCount(root) > 0) {
 			/* Try children if root is empty */
 			root = XmlNode_getChild(root, 0);
@@ -302,6 +624,8 @@ void ED_getDoubleArray1DFromXML(void* _xml, const char* varName, double* a, size
 			ModelicaFormatError("Error in line %i: Cannot read empty element \"%s\" in file \"%s\"\n",
 				XmlNode_getLine(root), varName, xml->fileName);
 		}
+		ED_TRACE_GET_END(xml->fileName, varName, n);
+		ED_trimLeave(xml->trim);
 	}
 }
 
@@ -309,3 +633,180 @@ void ED_getDoubleArray2DFromXML(void* _xml, const char* varName, double* a, size
 {
 	ED_getDoubleArray1DFromXML(_xml, varName, a, m*n);
 }
+
+enum {
+	BULK_OK = 0,
+	BULK_READ_ERROR,
+	BULK_PARSE_ERROR,
+	BULK_ELEMENT_ERROR,
+	BULK_VALUE_ERROR,
+	BULK_MEMORY_ERROR
+};
+
+typedef struct {
+	size_t i; /* Index of the file */
+	size_t j; /* Index of the element */
+	int type; /* BULK_OK or the kind of error */
+	int errnum; /* BULK_READ_ERROR: errno */
+	const char* errorString; /* BULK_PARSE_ERROR: Parser message and line */
+	unsigned long errorLine;
+	int errorLineSet;
+	int line; /* BULK_ELEMENT_ERROR, BULK_VALUE_ERROR: Line of the element */
+} XMLBulkError;
+
+typedef struct {
+	const char** fileNames;
+	const char** varNames;
+	size_t n;
+	size_t k;
+	size_t nChunks;
+	size_t maxNameLen;
+	double* a;
+	ED_LOCALE_TYPE loc;
+	XMLBulkError* errors; /* First error per chunk */
+} XMLBulk;
+
+/* Number of chunks of files per thread */
+#define ED_XML_BULK_CHUNKS_PER_THREAD (4)
+
+/* Read the consecutive files of chunk c, reusing the element name buffer,
+ * and stop at the first error
+ */
+static void readBulkChunk(void* data, size_t c)
+{
+	XMLBulk* bulk = (XMLBulk*)data;
+	XMLBulkError* err = &bulk->errors[c];
+	size_t i = c*bulk->n/bulk->nChunks;
+	size_t iEnd = (c + 1)*bulk->n/bulk->nChunks;
+	char* name = (char*)malloc(bulk->maxNameLen + 1);
+	err->type = name != NULL ? BULK_OK : BULK_MEMORY_ERROR;
+	err->i = i;
+	for (; i < iEnd && err->type == BULK_OK; i++) {
+		XmlParser xmlParser;
+		XmlNodeRef root;
+		const char* view;
+		size_t len;
+		size_t j;
+		ED_VFILE* vf = ED_vfopen(bulk->fileNames[i]);
+		err->i = i;
+		if (vf == NULL) {
+			err->type = BULK_READ_ERROR;
+			err->errnum = errno;
+			break;
+		}
+		ED_TRACE_PARSE_BEGIN("XmlParser_parse", bulk->fileNames[i]);
+		view = ED_vfmap(vf, &len);
+		if (view != NULL) {
+			root = XmlParser_parse_buffer(&xmlParser, view, len);
+		}
+		else {
+			root = XmlParser_parse_stream(&xmlParser, readXML, vf);
+			len = (size_t)ED_vftell(vf);
+		}
+		ED_vfclose(vf);
+		ED_TRACE_PARSE_END("XmlParser_parse", bulk->fileNames[i], len);
+		if (root == NULL) {
+			err->type = BULK_PARSE_ERROR;
+			err->errorString = XmlParser_getErrorString(&xmlParser);
+			err->errorLine = XmlParser_getErrorLine(&xmlParser);
+			err->errorLineSet = XmlParser_getErrorLineSet(&xmlParser);
+			break;
+		}
+		for (j = 0; j < bulk->k; j++) {
+			XmlNodeRef node = root;
+			char* token = NULL;
+			strcpy(name, bulk->varNames[j]);
+			if (findElement(&node, name) == 0) {
+				err->type = BULK_ELEMENT_ERROR;
+			}
+			else {
+				XmlNode_getValue(node, &token);
+				if (token == NULL || ED_strtod(token, bulk->loc, &bulk->a[i*bulk->k + j])) {
+					err->type = BULK_VALUE_ERROR;
+				}
+			}
+			if (err->type != BULK_OK) {
+				err->j = j;
+				err->line = XmlNode_getLine(node);
+				break;
+			}
+		}
+		XmlNode_deleteTree(root);
+	}
+	free(name);
+}
+
+void ED_getDoubleArray2DFromXMLFiles(const char** fileNames, size_t n, const char** varNames, size_t k, double* a, int verbose)
+{
+	XMLBulk bulk;
+	size_t c;
+	if (n == 0 || k == 0) {
+		return;
+	}
+	if (verbose == 1) {
+		for (c = 0; c < n; c++) {
+			/* Print info message, that file is loading */
+			ModelicaFormatMessage("... loading \"%s\"\n", fileNames[c]);
+		}
+	}
+	bulk.fileNames = fileNames;
+	bulk.varNames = varNames;
+	bulk.n = n;
+	bulk.k = k;
+	bulk.a = a;
+	bulk.maxNameLen = 0;
+	for (c = 0; c < k; c++) {
+		size_t len = strlen(varNames[c]);
+		if (len > bulk.maxNameLen) {
+			bulk.maxNameLen = len;
+		}
+	}
+	bulk.nChunks = ED_XML_BULK_CHUNKS_PER_THREAD*ED_parallelThreads();
+	if (bulk.nChunks > n) {
+		bulk.nChunks = n;
+	}
+	bulk.errors = (XMLBulkError*)malloc(bulk.nChunks*sizeof(XMLBulkError));
+	if (bulk.errors == NULL) {
+		ModelicaError("Memory allocation error\n");
+		return;
+	}
+	bulk.loc = ED_INIT_LOCALE;
+	ED_parallelFor(bulk.nChunks, readBulkChunk, &bulk);
+	ED_FREE_LOCALE(bulk.loc);
+
+	/* Report the error of the first file that failed */
+	for (c = 0; c < bulk.nChunks; c++) {
+		XMLBulkError err = bulk.errors[c];
+		if (err.type != BULK_OK) {
+			const char* fileName = fileNames[err.i];
+			free(bulk.errors);
+			switch (err.type) {
+				case BULK_READ_ERROR:
+					ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, strerror(err.errnum));
+					break;
+				case BULK_PARSE_ERROR:
+					if (err.errorLineSet != 0) {
+						ModelicaFormatError("Error \"%s\" in line %lu: Cannot parse file \"%s\"\n",
+							err.errorString, err.errorLine, fileName);
+					}
+					else {
+						ModelicaFormatError("Cannot read \"%s\": %s\n", fileName, err.errorString);
+					}
+					break;
+				case BULK_ELEMENT_ERROR:
+					ModelicaFormatError("Error in line %i: Cannot find element \"%s\" in file \"%s\"\n",
+						err.line, varNames[err.j], fileName);
+					break;
+				case BULK_VALUE_ERROR:
+					ModelicaFormatError("Error in line %i: Cannot read double value of element \"%s\" from file \"%s\"\n",
+						err.line, varNames[err.j], fileName);
+					break;
+				default:
+					ModelicaError("Memory allocation error\n");
+					break;
+			}
+			return;
+		}
+	}
+	free(bulk.errors);
+}
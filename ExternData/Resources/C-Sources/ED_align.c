@@ -0,0 +1,340 @@
+/* ED_align.c - Alignment of time series onto a common time grid
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "ED_align.h"
+
+typedef struct {
+	ED_AlignSource source;
+	double* t; /* Time stamps of the window */
+	double* y; /* Values of the window, row by row */
+	size_t len; /* Number of samples in the window */
+	size_t pos; /* First sample of the window after the current time */
+	int eof; /* 1 if the source is read completely */
+} AlignCursor;
+
+struct ED_Align {
+	AlignCursor* cursor;
+	size_t nSources;
+	size_t nCols;
+	const double* grid; /* Target grid or NULL for the union grid */
+	size_t nGrid;
+	size_t iGrid; /* Next point of the target grid */
+	size_t* heap; /* Union grid: sources ordered by their next time stamp */
+	size_t nHeap;
+	size_t* due; /* Union grid: sources at the current time */
+	int started; /* 1 if the first windows are read */
+	size_t failed; /* Source of the last failure */
+};
+
+/* Read the next window of a source. From the second window on the last
+ * sample of the previous window is kept as first sample, so that the
+ * samples before and after the current time are always in the window.
+ */
+static int readWindow(AlignCursor* c)
+{
+	size_t nSignals = c->source.nSignals;
+	size_t first = 0;
+	size_t n = 0;
+	size_t i;
+
+	if (c->len > 0) {
+		c->t[0] = c->t[c->len - 1];
+		memmove(c->y, c->y + (c->len - 1)*nSignals, nSignals*sizeof(double));
+		first = 1;
+	}
+	if (c->source.read(c->source.src, c->t + first, c->y + first*nSignals,
+		ED_ALIGN_WINDOW, &n) != 0 || n > ED_ALIGN_WINDOW) {
+		errno = EIO;
+		return -1;
+	}
+	if (n == 0) {
+		if (first == 0) {
+			errno = EINVAL;
+			return -1;
+		}
+		c->eof = 1;
+	}
+	/* The comparisons also reject NaN time stamps */
+	if (first == 0 && !(c->t[0] == c->t[0])) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = first > 0 ? first : 1; i < first + n; i++) {
+		if (!(c->t[i] >= c->t[i - 1])) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	c->len = first + n;
+	c->pos = first;
+	return 0;
+}
+
+/* Move the cursor past all samples at or before time tau */
+static int advance(AlignCursor* c, double tau)
+{
+	for (;;) {
+		while (c->pos < c->len && c->t[c->pos] <= tau) {
+			c->pos++;
+		}
+		if (c->pos < c->len || c->eof) {
+			return 0;
+		}
+		if (readWindow(c) != 0) {
+			return -1;
+		}
+	}
+}
+
+/* Values of a source at time tau, with the cursor advanced to tau */
+static void evaluate(const AlignCursor* c, double tau, double* out)
+{
+	size_t nSignals = c->source.nSignals;
+	const double* y0;
+	const double* y1;
+	double t0, w;
+	size_t j;
+
+	if (c->pos == 0) {
+		memcpy(out, c->y, nSignals*sizeof(double));
+		return;
+	}
+	y0 = c->y + (c->pos - 1)*nSignals;
+	if (c->source.smoothness == ED_ALIGN_CONSTANT_SEGMENTS || c->pos == c->len) {
+		memcpy(out, y0, nSignals*sizeof(double));
+		return;
+	}
+	/* t[pos] > tau >= t[pos - 1] */
+	y1 = y0 + nSignals;
+	t0 = c->t[c->pos - 1];
+	w = (tau - t0)/(c->t[c->pos] - t0);
+	for (j = 0; j < nSignals; j++) {
+		out[j] = y0[j] + w*(y1[j] - y0[j]);
+	}
+}
+
+static double nextTime(const ED_Align* align, size_t s)
+{
+	const AlignCursor* c = &align->cursor[s];
+	return c->t[c->pos];
+}
+
+static void heapPush(ED_Align* align, size_t s)
+{
+	size_t i = align->nHeap++;
+	double t = nextTime(align, s);
+	while (i > 0) {
+		size_t parent = (i - 1)/2;
+		if (nextTime(align, align->heap[parent]) <= t) {
+			break;
+		}
+		align->heap[i] = align->heap[parent];
+		i = parent;
+	}
+	align->heap[i] = s;
+}
+
+static size_t heapPop(ED_Align* align)
+{
+	size_t top = align->heap[0];
+	size_t s = align->heap[--align->nHeap];
+	size_t n = align->nHeap;
+	size_t i = 0;
+	double t;
+
+	if (n == 0) {
+		return top;
+	}
+	t = nextTime(align, s);
+	for (;;) {
+		size_t child = 2*i + 1;
+		if (child >= n) {
+			break;
+		}
+		if (child + 1 < n && nextTime(align, align->heap[child + 1]) <
+			nextTime(align, align->heap[child])) {
+			child++;
+		}
+		if (t <= nextTime(align, align->heap[child])) {
+			break;
+		}
+		align->heap[i] = align->heap[child];
+		i = child;
+	}
+	align->heap[i] = s;
+	return top;
+}
+
+ED_Align* ED_alignCreate(const ED_AlignSource* sources, size_t nSources,
+	const double* grid, size_t nGrid)
+{
+	ED_Align* align;
+	size_t s;
+
+	for (s = 0; s < nSources; s++) {
+		if (sources[s].read == NULL ||
+			(sources[s].smoothness != ED_ALIGN_LINEAR_SEGMENTS &&
+			sources[s].smoothness != ED_ALIGN_CONSTANT_SEGMENTS)) {
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+	if (grid != NULL) {
+		for (s = 1; s < nGrid; s++) {
+			if (!(grid[s] >= grid[s - 1])) {
+				errno = EINVAL;
+				return NULL;
+			}
+		}
+		if (nGrid > 0 && !(grid[0] == grid[0])) {
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+
+	align = (ED_Align*)calloc(1, sizeof(ED_Align));
+	if (align == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	align->nSources = nSources;
+	align->grid = grid;
+	align->nGrid = grid != NULL ? nGrid : 0;
+	align->nCols = 1;
+	align->cursor = (AlignCursor*)calloc(nSources > 0 ? nSources : 1, sizeof(AlignCursor));
+	align->heap = (size_t*)malloc((nSources > 0 ? nSources : 1)*sizeof(size_t));
+	align->due = (size_t*)malloc((nSources > 0 ? nSources : 1)*sizeof(size_t));
+	if (align->cursor == NULL || align->heap == NULL || align->due == NULL) {
+		ED_alignFree(align);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (s = 0; s < nSources; s++) {
+		AlignCursor* c = &align->cursor[s];
+		size_t nSignals = sources[s].nSignals;
+		c->source = sources[s];
+		c->t = (double*)malloc((ED_ALIGN_WINDOW + 1)*sizeof(double));
+		c->y = (double*)malloc((ED_ALIGN_WINDOW + 1)*(nSignals > 0 ? nSignals : 1)*sizeof(double));
+		if (c->t == NULL || c->y == NULL) {
+			ED_alignFree(align);
+			errno = ENOMEM;
+			return NULL;
+		}
+		align->nCols += nSignals;
+	}
+	return align;
+}
+
+void ED_alignFree(ED_Align* align)
+{
+	if (align != NULL) {
+		if (align->cursor != NULL) {
+			size_t s;
+			for (s = 0; s < align->nSources; s++) {
+				free(align->cursor[s].t);
+				free(align->cursor[s].y);
+			}
+			free(align->cursor);
+		}
+		free(align->heap);
+		free(align->due);
+		free(align);
+	}
+}
+
+size_t ED_alignCols(const ED_Align* align)
+{
+	return align != NULL ? align->nCols : 0;
+}
+
+size_t ED_alignFailedSource(const ED_Align* align)
+{
+	return align != NULL ? align->failed : 0;
+}
+
+int ED_alignNext(ED_Align* align, double* a, size_t maxRows, size_t* nRows)
+{
+	size_t s;
+
+	*nRows = 0;
+	if (!align->started) {
+		for (s = 0; s < align->nSources; s++) {
+			if (readWindow(&align->cursor[s]) != 0) {
+				align->failed = s;
+				return -1;
+			}
+			if (align->grid == NULL) {
+				heapPush(align, s);
+			}
+		}
+		align->started = 1;
+	}
+
+	while (*nRows < maxRows) {
+		double* row = a + (*nRows)*align->nCols;
+		size_t nDue = 0;
+		size_t col = 1;
+		double tau;
+
+		if (align->grid != NULL) {
+			if (align->iGrid == align->nGrid) {
+				break;
+			}
+			tau = align->grid[align->iGrid++];
+		}
+		else {
+			if (align->nHeap == 0) {
+				break;
+			}
+			/* Only the sources with the smallest next time stamp move */
+			tau = nextTime(align, align->heap[0]);
+			while (align->nHeap > 0 && nextTime(align, align->heap[0]) == tau) {
+				align->due[nDue++] = heapPop(align);
+			}
+		}
+
+		row[0] = tau;
+		for (s = 0; s < align->nSources; s++) {
+			AlignCursor* c = &align->cursor[s];
+			if (advance(c, tau) != 0) {
+				align->failed = s;
+				return -1;
+			}
+			evaluate(c, tau, row + col);
+			col += c->source.nSignals;
+		}
+		for (s = 0; s < nDue; s++) {
+			AlignCursor* c = &align->cursor[align->due[s]];
+			if (c->pos < c->len) {
+				heapPush(align, align->due[s]);
+			}
+		}
+		(*nRows)++;
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+/* ED_align.h - Alignment of time series onto a common time grid
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_ALIGN_H)
+#define ED_ALIGN_H
+
+#include <stdlib.h>
+
+/* Alignment of the time series of several sources with different time
+ * stamps onto a common time grid, which is either the union of all time
+ * stamps (sorted k-way merge) or a given target grid. The sources are read
+ * in windows of at most ED_ALIGN_WINDOW samples and the aligned rows are
+ * computed in chunks of the caller, so that the memory is bounded by the
+ * window size and not by the number of samples.
+ */
+
+/* Maximum number of samples of a source held in memory */
+#define ED_ALIGN_WINDOW (4096)
+
+/* Interpolation of a source between its time stamps, same values as
+ * Modelica.Blocks.Types.Smoothness. Before the first and after the last
+ * sample of a source its first or last sample is held.
+ */
+enum {
+	ED_ALIGN_LINEAR_SEGMENTS = 1,
+	ED_ALIGN_CONSTANT_SEGMENTS = 3 /* Hold of the previous sample */
+};
+
+/* Read at most maxRows samples of a source into the time stamps t and row
+ * by row into the values y (nSignals values per sample), and set nRows to
+ * the number of samples read (0 at the end of the source). Returns 0 on
+ * success or -1 on failure.
+ */
+typedef int (*ED_alignReadFunc)(void* src, double* t, double* y, size_t maxRows, size_t* nRows);
+
+typedef struct {
+	ED_alignReadFunc read;
+	void* src;
+	size_t nSignals;
+	int smoothness;
+} ED_AlignSource;
+
+typedef struct ED_Align ED_Align;
+
+/* Create the alignment of nSources sources, whose time stamps must not
+ * decrease, onto the non-decreasing target grid of nGrid time points, or
+ * onto the union of the time stamps of all sources if grid is NULL. The
+ * grid and the sources must stay valid until the alignment is freed.
+ * Returns NULL and sets errno on failure.
+ */
+ED_Align* ED_alignCreate(const ED_AlignSource* sources, size_t nSources,
+	const double* grid, size_t nGrid);
+void ED_alignFree(ED_Align* align);
+
+/* Number of values of an aligned row: the time and the signals of all
+ * sources in the order of the sources
+ */
+size_t ED_alignCols(const ED_Align* align);
+
+/* Compute the next at most maxRows aligned rows row by row into a and set
+ * nRows to the number of rows computed (0 at the end of the grid). Returns
+ * 0 on success or -1 and sets errno on failure: EINVAL if a source is
+ * empty or its time stamps decrease, EIO if a source cannot be read. The
+ * alignment cannot be continued after a failure.
+ */
+int ED_alignNext(ED_Align* align, double* a, size_t maxRows, size_t* nRows);
+
+/* Index of the source that caused the last failure of ED_alignNext */
+size_t ED_alignFailedSource(const ED_Align* align);
+
+#endif
@@ -0,0 +1,430 @@
+/* ED_bindoc.c - Navigation in binary documents
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include "ED_bindoc.h"
+
+/* Multi-dimensional view of a numeric array or scalar */
+typedef struct {
+	size_t m; /* Rows */
+	size_t n; /* Columns */
+	int order;
+	int rows; /* Array of rows */
+	int scalar;
+	double value; /* Scalar */
+	ED_BinItem data; /* Flat (typed) array of the elements or array of rows */
+} BinArray;
+
+static int isBigEndianHost(void)
+{
+	const unsigned short one = 1;
+	return *(const unsigned char*)&one == 0;
+}
+
+/* Double of the 32-bit halves hi and lo of its IEEE 754 representation */
+static double fromBits(unsigned long hi, unsigned long lo)
+{
+	unsigned char b[8];
+	double d;
+	int k;
+	for (k = 0; k < 4; k++) {
+		b[k] = (unsigned char)(lo >> (8*k));
+		b[k + 4] = (unsigned char)(hi >> (8*k));
+	}
+	if (isBigEndianHost()) {
+		for (k = 0; k < 4; k++) {
+			unsigned char c = b[k];
+			b[k] = b[7 - k];
+			b[7 - k] = c;
+		}
+	}
+	memcpy(&d, b, 8);
+	return d;
+}
+
+/* Value of an IEEE 754 half-precision number */
+static double fromHalf(unsigned int h)
+{
+	unsigned long sign = (unsigned long)(h >> 15) & 1UL;
+	unsigned int e = (h >> 10) & 31U;
+	unsigned long f = (unsigned long)h & 1023UL;
+	if (e == 0) {
+		/* Zero or subnormal */
+		double x = ldexp((double)f, -24);
+		return sign ? -x : x;
+	}
+	return fromBits((sign << 31) | ((unsigned long)(e == 31 ? 2047 : e + 1008) << 20) | (f << 10), 0);
+}
+
+/* Low and high 32-bit halves of an integer of n bytes */
+static void readHalves(const unsigned char* p, size_t n, int bigEndian, unsigned long* lo, unsigned long* hi)
+{
+	size_t k;
+	*lo = 0;
+	*hi = 0;
+	for (k = 0; k < n; k++) {
+		unsigned long b = p[bigEndian ? n - 1 - k : k];
+		if (k < 4) {
+			*lo |= b << (8*k);
+		}
+		else {
+			*hi |= b << (8*(k - 4));
+		}
+	}
+}
+
+double ED_bindocReadFloat(const unsigned char* p, size_t n, int bigEndian)
+{
+	unsigned long lo, hi;
+	readHalves(p, n, bigEndian, &lo, &hi);
+	if (n == 2) {
+		return fromHalf((unsigned int)lo);
+	}
+	else if (n == 4) {
+		/* Widen the single-precision number */
+		unsigned long e = (lo >> 23) & 255UL;
+		unsigned long f = lo & 0x7FFFFFUL;
+		if (e == 0) {
+			double x = ldexp((double)f, -149);
+			return (lo >> 31) ? -x : x;
+		}
+		return fromBits((lo & 0x80000000UL) | ((e == 255 ? 2047 : e + 896) << 20) | (f >> 3),
+			(f & 7UL) << 29);
+	}
+	return fromBits(hi, lo);
+}
+
+double ED_bindocReadInt(const unsigned char* p, size_t n, int isSigned, int bigEndian)
+{
+	unsigned long lo, hi;
+	readHalves(p, n, bigEndian, &lo, &hi);
+	if (isSigned && (p[bigEndian ? 0 : n - 1] & 0x80)) {
+		if (n < 8) {
+			return (double)lo - ldexp(1.0, (int)(8*n));
+		}
+		/* Magnitude of the two's complement */
+		lo = ~lo & 0xFFFFFFFFUL;
+		hi = ~hi & 0xFFFFFFFFUL;
+		lo = (lo + 1) & 0xFFFFFFFFUL;
+		if (lo == 0) {
+			hi = (hi + 1) & 0xFFFFFFFFUL;
+		}
+		return -((double)hi*4294967296.0 + (double)lo);
+	}
+	return (double)hi*4294967296.0 + (double)lo;
+}
+
+/* Element k of a typed array */
+static double getTypedValue(const ED_BinItem* item, size_t k)
+{
+	const unsigned char* p = item->data + k*item->elemSize;
+	if (item->elemType == ED_BINDOC_FLOAT) {
+		return ED_bindocReadFloat(p, item->elemSize, item->bigEndian);
+	}
+	return ED_bindocReadInt(p, item->elemSize, item->elemType == ED_BINDOC_SINT, item->bigEndian);
+}
+
+int ED_bindocSkip(const ED_BinDoc* doc, size_t pos, size_t* next)
+{
+	/* Number of items still to skip, each of them takes at least one byte */
+	size_t remaining = 1;
+	while (remaining > 0) {
+		ED_BinItem item;
+		if (0 != doc->read(doc->p, doc->len, pos, &item)) {
+			return -1;
+		}
+		remaining--;
+		if (item.kind == ED_BINDOC_ARRAY || item.kind == ED_BINDOC_MAP) {
+			size_t n = item.count;
+			if (n > doc->len - item.next ||
+				(item.kind == ED_BINDOC_MAP && n > (doc->len - item.next)/2)) {
+				errno = EINVAL;
+				return -1;
+			}
+			if (item.kind == ED_BINDOC_MAP) {
+				n *= 2;
+			}
+			if (remaining > doc->len - item.next - n) {
+				errno = EINVAL;
+				return -1;
+			}
+			remaining += n;
+		}
+		pos = item.next;
+	}
+	*next = pos;
+	return 0;
+}
+
+int ED_bindocFind(const ED_BinDoc* doc, const char* varName, size_t* pos)
+{
+	const char* token = varName;
+	*pos = 0;
+	while (*token != '\0') {
+		size_t len = 0;
+		ED_BinItem item;
+		size_t kp;
+		size_t i;
+		if (*token == '.') {
+			token++;
+			continue;
+		}
+		while (token[len] != '\0' && token[len] != '.') {
+			len++;
+		}
+		if (0 != doc->read(doc->p, doc->len, *pos, &item)) {
+			return -1;
+		}
+		if (item.kind != ED_BINDOC_MAP) {
+			errno = ENOENT;
+			return -1;
+		}
+		kp = item.next;
+		for (i = 0; i < item.count; i++) {
+			ED_BinItem key;
+			size_t vp;
+			if (0 != doc->read(doc->p, doc->len, kp, &key)) {
+				return -1;
+			}
+			if (key.kind == ED_BINDOC_STRING && key.count == len &&
+				0 == memcmp(key.data, token, len)) {
+				break;
+			}
+			if (0 != ED_bindocSkip(doc, kp, &vp) || 0 != ED_bindocSkip(doc, vp, &kp)) {
+				return -1;
+			}
+		}
+		if (i == item.count) {
+			errno = ENOENT;
+			return -1;
+		}
+		/* The value follows the key string */
+		if (0 != ED_bindocSkip(doc, kp, pos)) {
+			return -1;
+		}
+		token += len;
+	}
+	return 0;
+}
+
+static int getNumber(const ED_BinDoc* doc, size_t pos, ED_BinItem* item)
+{
+	if (0 != doc->read(doc->p, doc->len, pos, item)) {
+		return -1;
+	}
+	if (item->kind != ED_BINDOC_NUMBER && item->kind != ED_BINDOC_BOOL) {
+		errno = EDOM;
+		return -1;
+	}
+	return 0;
+}
+
+int ED_bindocGetDouble(const ED_BinDoc* doc, size_t pos, double* x)
+{
+	ED_BinItem item;
+	if (0 != getNumber(doc, pos, &item)) {
+		return -1;
+	}
+	*x = item.value;
+	return 0;
+}
+
+/* Dimensions and elements of the numeric array at pos */
+static int getArray(const ED_BinDoc* doc, size_t pos, BinArray* arr)
+{
+	ED_BinItem item;
+	if (0 != doc->read(doc->p, doc->len, pos, &item)) {
+		return -1;
+	}
+	memset(arr, 0, sizeof(BinArray));
+	switch (item.kind) {
+		case ED_BINDOC_NUMBER:
+		case ED_BINDOC_BOOL:
+			arr->m = 1;
+			arr->n = 1;
+			arr->scalar = 1;
+			arr->value = item.value;
+			return 0;
+
+		case ED_BINDOC_TYPED_ARRAY:
+			arr->m = item.count;
+			arr->n = 1;
+			arr->data = item;
+			return 0;
+
+		case ED_BINDOC_ARRAY:
+			if (item.order != ED_BINDOC_PLAIN) {
+				/* Array of the dimensions and the elements */
+				ED_BinItem dims;
+				ED_BinItem dim;
+				size_t next;
+				if (item.count != 2 || 0 != doc->read(doc->p, doc->len, item.next, &dims) ||
+					dims.kind != ED_BINDOC_ARRAY || dims.order != ED_BINDOC_PLAIN ||
+					dims.count < 1 || dims.count > 2) {
+					errno = EINVAL;
+					return -1;
+				}
+				next = dims.next;
+				arr->n = 1;
+				if (0 != getNumber(doc, next, &dim) || !dim.isInt || dim.value < 0 ||
+					dim.value > (double)doc->len) {
+					errno = EINVAL;
+					return -1;
+				}
+				arr->m = (size_t)dim.value;
+				if (dims.count == 2) {
+					next = dim.next;
+					if (0 != getNumber(doc, next, &dim) || !dim.isInt || dim.value < 0 ||
+						dim.value > (double)doc->len) {
+						errno = EINVAL;
+						return -1;
+					}
+					arr->n = (size_t)dim.value;
+				}
+				if (0 != doc->read(doc->p, doc->len, dim.next, &arr->data) ||
+					(arr->data.kind != ED_BINDOC_ARRAY && arr->data.kind != ED_BINDOC_TYPED_ARRAY) ||
+					arr->data.order != ED_BINDOC_PLAIN ||
+					(arr->n != 0 && arr->m > arr->data.count/arr->n) ||
+					arr->m*arr->n != arr->data.count) {
+					errno = EINVAL;
+					return -1;
+				}
+				arr->order = item.order;
+				return 0;
+			}
+			arr->m = item.count;
+			arr->n = 1;
+			arr->data = item;
+			if (item.count > 0) {
+				ED_BinItem first;
+				if (0 != doc->read(doc->p, doc->len, item.next, &first)) {
+					return -1;
+				}
+				if (first.kind == ED_BINDOC_ARRAY && first.order == ED_BINDOC_PLAIN) {
+					arr->rows = 1;
+					arr->n = first.count;
+					if (arr->n != 0 && arr->m > ((size_t)-1)/arr->n) {
+						errno = EINVAL;
+						return -1;
+					}
+				}
+			}
+			return 0;
+
+		default:
+			errno = EDOM;
+			return -1;
+	}
+}
+
+int ED_bindocGetSize(const ED_BinDoc* doc, size_t pos, size_t* m, size_t* n)
+{
+	BinArray arr;
+	if (0 != getArray(doc, pos, &arr)) {
+		return -1;
+	}
+	*m = arr.m;
+	*n = arr.n;
+	return 0;
+}
+
+int ED_bindocReadArray(const ED_BinDoc* doc, size_t pos, double* a, size_t n)
+{
+	BinArray arr;
+	int colMajor;
+	size_t k;
+
+	if (0 != getArray(doc, pos, &arr)) {
+		return -1;
+	}
+	if (n > arr.m*arr.n) {
+		errno = ERANGE;
+		return -1;
+	}
+	colMajor = arr.order == ED_BINDOC_COLUMN_MAJOR;
+	if (arr.scalar) {
+		if (n > 0) {
+			a[0] = arr.value;
+		}
+	}
+	else if (arr.data.kind == ED_BINDOC_TYPED_ARRAY) {
+		if (!colMajor && arr.data.elemType == ED_BINDOC_FLOAT && arr.data.elemSize == 8 &&
+			arr.data.bigEndian == isBigEndianHost()) {
+			memcpy(a, arr.data.data, n*sizeof(double));
+		}
+		else {
+			for (k = 0; k < n; k++) {
+				a[k] = getTypedValue(&arr.data, colMajor ? (k % arr.n)*arr.m + k/arr.n : k);
+			}
+		}
+	}
+	else if (arr.rows) {
+		size_t i;
+		pos = arr.data.next;
+		for (i = 0; i < arr.m && i*arr.n < n; i++) {
+			ED_BinItem row;
+			size_t j;
+			if (0 != doc->read(doc->p, doc->len, pos, &row)) {
+				return -1;
+			}
+			if (row.kind != ED_BINDOC_ARRAY || row.order != ED_BINDOC_PLAIN) {
+				errno = EDOM;
+				return -1;
+			}
+			if (row.count != arr.n) {
+				errno = ERANGE;
+				return -1;
+			}
+			pos = row.next;
+			for (j = 0; j < arr.n && i*arr.n + j < n; j++) {
+				ED_BinItem item;
+				if (0 != getNumber(doc, pos, &item)) {
+					return -1;
+				}
+				a[i*arr.n + j] = item.value;
+				pos = item.next;
+			}
+		}
+	}
+	else {
+		size_t total = colMajor ? arr.m*arr.n : n;
+		pos = arr.data.next;
+		for (k = 0; k < total; k++) {
+			ED_BinItem item;
+			size_t t = colMajor ? (k % arr.m)*arr.n + k/arr.m : k;
+			if (0 != getNumber(doc, pos, &item)) {
+				return -1;
+			}
+			if (t < n) {
+				a[t] = item.value;
+			}
+			pos = item.next;
+		}
+	}
+	return 0;
+}
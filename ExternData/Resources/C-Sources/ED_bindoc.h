@@ -0,0 +1,126 @@
+/* ED_bindoc.h - Navigation in binary documents
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_BINDOC_H)
+#define ED_BINDOC_H
+
+#include <stdlib.h>
+
+/* Navigation in binary documents of length-prefixed items (MessagePack,
+ * CBOR) in place, without building a tree. A format provides the decoder
+ * of a single item header, all other operations are shared: the values of
+ * dotted element names are found by walking the maps of the path and
+ * skipping the values of the other keys, and numeric arrays are decoded
+ * straight into the output.
+ */
+
+/* Item kinds */
+enum {
+	ED_BINDOC_NIL = 0,
+	ED_BINDOC_BOOL,
+	ED_BINDOC_NUMBER,
+	ED_BINDOC_STRING, /* UTF-8 text */
+	ED_BINDOC_BYTES,
+	ED_BINDOC_ARRAY,
+	ED_BINDOC_MAP,
+	ED_BINDOC_TYPED_ARRAY, /* Packed numbers in a byte string */
+	ED_BINDOC_OTHER /* Extension types, simple values, ... */
+};
+
+/* Element types of typed arrays */
+enum {
+	ED_BINDOC_UINT = 0,
+	ED_BINDOC_SINT,
+	ED_BINDOC_FLOAT
+};
+
+/* Array orders of multi-dimensional arrays, i.e. arrays of the dimensions
+ * and the flat elements
+ */
+enum {
+	ED_BINDOC_PLAIN = 0, /* Array of elements or of rows */
+	ED_BINDOC_ROW_MAJOR,
+	ED_BINDOC_COLUMN_MAJOR
+};
+
+typedef struct {
+	int kind;
+	int isInt; /* Integral number */
+	double value; /* Numbers and booleans */
+	size_t count; /* Elements of (typed) arrays, pairs of maps, bytes of strings */
+	const unsigned char* data; /* Strings and typed arrays */
+	int elemType; /* Typed arrays */
+	size_t elemSize; /* Typed arrays: 1, 2, 4 or 8 */
+	int bigEndian; /* Typed arrays */
+	int order; /* Arrays */
+	size_t next; /* Offset of the first element of containers, of the next
+	              * item otherwise */
+} ED_BinItem;
+
+/* Decode the header of the item at pos of the document p of len bytes.
+ * Returns 0 on success or -1 and sets errno if invalid or unsupported.
+ */
+typedef int (*ED_bindocReadFunc)(const unsigned char* p, size_t len, size_t pos, ED_BinItem* item);
+
+typedef struct {
+	const unsigned char* p;
+	size_t len;
+	ED_bindocReadFunc read;
+} ED_BinDoc;
+
+/* All functions return 0 on success or -1 and set errno on failure:
+ * ENOENT if an element is not found, EDOM if a value is not numeric (or
+ * not a string), ERANGE if an array has fewer values than requested and
+ * EINVAL if the document is invalid.
+ */
+
+/* Offset after the item at pos and all its elements */
+int ED_bindocSkip(const ED_BinDoc* doc, size_t pos, size_t* next);
+
+/* Offset of the value of the dotted element name varName, empty tokens
+ * are skipped
+ */
+int ED_bindocFind(const ED_BinDoc* doc, const char* varName, size_t* pos);
+
+/* Number or boolean at pos */
+int ED_bindocGetDouble(const ED_BinDoc* doc, size_t pos, double* x);
+
+/* Dimensions of the numeric array at pos: the number of elements and 1 of
+ * a flat array, the number of rows and columns of an array of rows or of
+ * a multi-dimensional array, 1 and 1 of a scalar
+ */
+int ED_bindocGetSize(const ED_BinDoc* doc, size_t pos, size_t* m, size_t* n);
+
+/* Read the first n values of the numeric array at pos in row-major order */
+int ED_bindocReadArray(const ED_BinDoc* doc, size_t pos, double* a, size_t n);
+
+/* IEEE 754 number of n (2, 4 or 8) bytes */
+double ED_bindocReadFloat(const unsigned char* p, size_t n, int bigEndian);
+
+/* Integer of n (1, 2, 4 or 8) bytes, exact up to 2^53 */
+double ED_bindocReadInt(const unsigned char* p, size_t n, int isSigned, int bigEndian);
+
+#endif
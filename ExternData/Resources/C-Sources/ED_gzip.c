@@ -0,0 +1,514 @@
+/* ED_gzip.c - gzip and BGZF (blocked gzip) decoding
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include "zlib.h"
+#include "ED_parallel.h"
+#include "ED_gzip.h"
+
+/* Uncompressed size of a BGZF block is at most 64 KiB */
+#define ED_BGZF_MAX_BLOCK (65536)
+/* Tasks per thread for load balancing of the block inflation */
+#define ED_BGZF_TASKS_PER_THREAD (4)
+/* Length of the fixed gzip header up to the extra field */
+#define GZIP_HEADER_LENGTH (12)
+/* Length of the gzip trailer (CRC32 and ISIZE) */
+#define GZIP_TRAILER_LENGTH (8)
+
+typedef struct {
+	size_t cOffset; /* Offset of the block in the compressed data */
+	size_t cLen; /* Compressed length of the block including header and trailer */
+	size_t uOffset; /* Offset of the block in the uncompressed data */
+	size_t uLen; /* Uncompressed length of the block */
+} BGZFBlock;
+
+struct ED_BGZF {
+	const unsigned char* src;
+	size_t srcLen;
+	BGZFBlock* blocks;
+	size_t nBlocks;
+	unsigned char* done; /* Per block: 1 if inflated */
+	size_t prefix; /* Number of leading blocks that are all inflated */
+	char* data;
+	size_t size;
+};
+
+typedef struct {
+	ED_BGZF* bgzf;
+	const size_t* todo;
+	size_t nTodo;
+	size_t nTasks;
+	int rc[ED_BGZF_TASKS_PER_THREAD*ED_PARALLEL_MAX_THREADS];
+} BGZFWork;
+
+static size_t readLE16(const unsigned char* p)
+{
+	return (size_t)p[0] | ((size_t)p[1] << 8);
+}
+
+static unsigned long readLE32(const unsigned char* p)
+{
+	return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+		((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static size_t readLE64(const unsigned char* p, int* overflow)
+{
+	size_t v = (size_t)readLE32(p);
+	unsigned long high = readLE32(p + 4);
+	if (high != 0) {
+		if (sizeof(size_t) <= 4) {
+			*overflow = 1;
+		}
+		else {
+			v |= (size_t)high << 16 << 16;
+		}
+	}
+	return v;
+}
+
+int ED_gzipIsMember(const void* src, size_t len)
+{
+	const unsigned char* p = (const unsigned char*)src;
+	return p != NULL && len >= 3 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8;
+}
+
+char* ED_gzipDecompress(const void* src, size_t len, size_t* dstLen)
+{
+	const unsigned char* in = (const unsigned char*)src;
+	z_stream zs;
+	unsigned char* dst;
+	size_t cap;
+	size_t inPos = 0;
+	size_t pos = 0;
+	int failed = 0;
+
+	if (!ED_gzipIsMember(src, len)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	/* ISIZE of the last member is a good guess for single member files */
+	cap = len >= 18 ? (size_t)readLE32(in + len - 4) : 0;
+	if (cap < 4*len) {
+		cap = 4*len;
+	}
+	dst = (unsigned char*)malloc(cap + 1);
+	if (dst == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	memset(&zs, 0, sizeof(zs));
+	if (Z_OK != inflateInit2(&zs, 16 + MAX_WBITS)) {
+		free(dst);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (;;) {
+		size_t inChunk = len - inPos;
+		size_t outChunk;
+		int rc;
+		if (cap == pos) {
+			unsigned char* tmp = (unsigned char*)realloc(dst, 2*cap + 1);
+			if (tmp == NULL) {
+				errno = ENOMEM;
+				failed = 1;
+				break;
+			}
+			dst = tmp;
+			cap *= 2;
+		}
+		outChunk = cap - pos;
+		if (inChunk > 0x7fffffffU) {
+			inChunk = 0x7fffffffU;
+		}
+		if (outChunk > 0x7fffffffU) {
+			outChunk = 0x7fffffffU;
+		}
+		zs.next_in = (Bytef*)(in + inPos);
+		zs.avail_in = (uInt)inChunk;
+		zs.next_out = (Bytef*)(dst + pos);
+		zs.avail_out = (uInt)outChunk;
+		rc = inflate(&zs, Z_NO_FLUSH);
+		inPos += inChunk - zs.avail_in;
+		pos += outChunk - zs.avail_out;
+		if (rc == Z_STREAM_END) {
+			/* Continue with the next member, trailing garbage is ignored */
+			if (ED_gzipIsMember(in + inPos, len - inPos)) {
+				inflateReset(&zs);
+				continue;
+			}
+			break;
+		}
+		if ((rc == Z_OK || rc == Z_BUF_ERROR) && zs.avail_out == 0) {
+			continue;
+		}
+		if (rc != Z_OK || inPos == len) {
+			errno = rc == Z_MEM_ERROR ? ENOMEM : EINVAL;
+			failed = 1;
+			break;
+		}
+	}
+	inflateEnd(&zs);
+	if (failed) {
+		free(dst);
+		return NULL;
+	}
+	dst[pos] = '\0';
+	if (dstLen != NULL) {
+		*dstLen = pos;
+	}
+	return (char*)dst;
+}
+
+/* Return the length of the BGZF block at p or 0 if p is not a BGZF block */
+static size_t blockLength(const unsigned char* p, size_t len, size_t* xlen)
+{
+	size_t i;
+	if (len < GZIP_HEADER_LENGTH || p[0] != 0x1f || p[1] != 0x8b ||
+		p[2] != 8 || p[3] != 4) {
+		return 0;
+	}
+	*xlen = readLE16(p + 10);
+	if (len - GZIP_HEADER_LENGTH < *xlen) {
+		return 0;
+	}
+	/* Look for the "BC" subfield holding BSIZE */
+	for (i = GZIP_HEADER_LENGTH; i + 4 <= GZIP_HEADER_LENGTH + *xlen;) {
+		size_t slen = readLE16(p + i + 2);
+		if (p[i] == 'B' && p[i + 1] == 'C' && slen == 2 && i + 6 <= GZIP_HEADER_LENGTH + *xlen) {
+			return readLE16(p + i + 4) + 1;
+		}
+		i += 4 + slen;
+	}
+	return 0;
+}
+
+int ED_bgzfIsBlocked(const void* src, size_t len)
+{
+	size_t xlen;
+	return src != NULL && blockLength((const unsigned char*)src, len, &xlen) != 0;
+}
+
+static int pushBlock(ED_BGZF* bgzf, size_t* cap, size_t cOffset, size_t cLen,
+	size_t uOffset, size_t uLen)
+{
+	BGZFBlock* blk;
+	if (bgzf->nBlocks == *cap) {
+		BGZFBlock* tmp = (BGZFBlock*)realloc(bgzf->blocks, 2*(*cap)*sizeof(BGZFBlock));
+		if (tmp == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		bgzf->blocks = tmp;
+		*cap *= 2;
+	}
+	blk = &bgzf->blocks[bgzf->nBlocks++];
+	blk->cOffset = cOffset;
+	blk->cLen = cLen;
+	blk->uOffset = uOffset;
+	blk->uLen = uLen;
+	return 0;
+}
+
+/* Seed the block index from a .gzi index: number of entries followed by
+ * pairs of compressed and uncompressed offsets of all but the first block
+ * (all 64-bit little endian)
+ */
+static void readIndex(ED_BGZF* bgzf, size_t* cap, const unsigned char* gzi, size_t gziLen,
+	size_t* cPos, size_t* uPos)
+{
+	size_t n;
+	size_t i;
+	size_t c = 0;
+	size_t u = 0;
+	int overflow = 0;
+	if (gzi == NULL || gziLen < 8) {
+		return;
+	}
+	n = readLE64(gzi, &overflow);
+	if (overflow || n > (gziLen - 8)/16 || gziLen != 8 + 16*n) {
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		size_t cNext = readLE64(gzi + 8 + 16*i, &overflow);
+		size_t uNext = readLE64(gzi + 16 + 16*i, &overflow);
+		if (overflow || cNext <= c || uNext < u || cNext > bgzf->srcLen ||
+			uNext - u > ED_BGZF_MAX_BLOCK) {
+			/* Invalid index: Scan from the last valid block */
+			break;
+		}
+		if (0 != pushBlock(bgzf, cap, c, cNext - c, u, uNext - u)) {
+			break;
+		}
+		c = cNext;
+		u = uNext;
+	}
+	*cPos = c;
+	*uPos = u;
+}
+
+ED_BGZF* ED_bgzfOpen(const void* src, size_t len, const void* gzi, size_t gziLen)
+{
+	const unsigned char* p = (const unsigned char*)src;
+	ED_BGZF* bgzf;
+	size_t cap = 64;
+	size_t cPos = 0;
+	size_t uPos = 0;
+	size_t i;
+
+	if (src == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	bgzf = (ED_BGZF*)calloc(1, sizeof(ED_BGZF));
+	if (bgzf == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	bgzf->src = p;
+	bgzf->srcLen = len;
+	bgzf->blocks = (BGZFBlock*)malloc(cap*sizeof(BGZFBlock));
+	if (bgzf->blocks == NULL) {
+		free(bgzf);
+		errno = ENOMEM;
+		return NULL;
+	}
+	/* Released by ED_bgzfClose, also on the errors below */
+	ED_parallelAcquire();
+
+	readIndex(bgzf, &cap, (const unsigned char*)gzi, gziLen, &cPos, &uPos);
+	/* Scan the remaining block headers */
+	while (cPos < len) {
+		size_t xlen;
+		size_t bl = blockLength(p + cPos, len - cPos, &xlen);
+		size_t uLen;
+		if (bl == 0 || bl > len - cPos ||
+			bl < GZIP_HEADER_LENGTH + xlen + GZIP_TRAILER_LENGTH) {
+			ED_bgzfClose(bgzf);
+			errno = EINVAL;
+			return NULL;
+		}
+		uLen = (size_t)readLE32(p + cPos + bl - 4);
+		if (uLen > ED_BGZF_MAX_BLOCK || 0 != pushBlock(bgzf, &cap, cPos, bl, uPos, uLen)) {
+			ED_bgzfClose(bgzf);
+			errno = uLen > ED_BGZF_MAX_BLOCK ? EINVAL : ENOMEM;
+			return NULL;
+		}
+		cPos += bl;
+		uPos += uLen;
+	}
+
+	bgzf->size = uPos;
+	bgzf->done = (unsigned char*)calloc(bgzf->nBlocks + 1, 1);
+	bgzf->data = (char*)malloc(bgzf->size + 1);
+	if (bgzf->done == NULL || bgzf->data == NULL) {
+		ED_bgzfClose(bgzf);
+		errno = ENOMEM;
+		return NULL;
+	}
+	bgzf->data[bgzf->size] = '\0';
+	for (i = 0; i < bgzf->nBlocks; i++) {
+		if (bgzf->blocks[i].uLen == 0) {
+			bgzf->done[i] = 1;
+		}
+	}
+	return bgzf;
+}
+
+void ED_bgzfClose(ED_BGZF* bgzf)
+{
+	if (bgzf != NULL) {
+		free(bgzf->blocks);
+		free(bgzf->done);
+		free(bgzf->data);
+		free(bgzf);
+		ED_parallelRelease();
+	}
+}
+
+size_t ED_bgzfSize(const ED_BGZF* bgzf)
+{
+	return bgzf != NULL ? bgzf->size : 0;
+}
+
+const char* ED_bgzfData(const ED_BGZF* bgzf)
+{
+	return bgzf != NULL ? bgzf->data : NULL;
+}
+
+static int inflateBlock(z_stream* zs, ED_BGZF* bgzf, size_t i)
+{
+	const BGZFBlock* blk = &bgzf->blocks[i];
+	const unsigned char* p = bgzf->src + blk->cOffset;
+	size_t hdr = GZIP_HEADER_LENGTH + readLE16(p + 10);
+	unsigned char* out = (unsigned char*)bgzf->data + blk->uOffset;
+
+	if (blk->cLen < hdr + GZIP_TRAILER_LENGTH || Z_OK != inflateReset(zs)) {
+		return -1;
+	}
+	zs->next_in = (Bytef*)(p + hdr);
+	zs->avail_in = (uInt)(blk->cLen - hdr - GZIP_TRAILER_LENGTH);
+	zs->next_out = (Bytef*)out;
+	zs->avail_out = (uInt)blk->uLen;
+	if (Z_STREAM_END != inflate(zs, Z_FINISH) || zs->avail_out != 0) {
+		return -1;
+	}
+	if (crc32(0L, out, (uInt)blk->uLen) != readLE32(p + blk->cLen - GZIP_TRAILER_LENGTH)) {
+		return -1;
+	}
+	return 0;
+}
+
+/* Task k inflates its contiguous range of the blocks with its own stream */
+static void runWorker(void* data, size_t k)
+{
+	BGZFWork* work = (BGZFWork*)data;
+	z_stream zs;
+	size_t i;
+	memset(&zs, 0, sizeof(zs));
+	if (Z_OK != inflateInit2(&zs, -MAX_WBITS)) {
+		work->rc[k] = ENOMEM;
+		return;
+	}
+	for (i = k*work->nTodo/work->nTasks; i < (k + 1)*work->nTodo/work->nTasks; i++) {
+		if (0 != inflateBlock(&zs, work->bgzf, work->todo[i])) {
+			work->rc[k] = EINVAL;
+			break;
+		}
+		work->bgzf->done[work->todo[i]] = 1;
+	}
+	inflateEnd(&zs);
+}
+
+/* Inflate the listed blocks, split into contiguous ranges of several tasks
+ * per thread, which the scheduler balances over the worker threads
+ */
+static int inflateBlocks(ED_BGZF* bgzf, const size_t* todo, size_t nTodo)
+{
+	BGZFWork work;
+	size_t k;
+
+	work.bgzf = bgzf;
+	work.todo = todo;
+	work.nTodo = nTodo;
+	work.nTasks = ED_parallelThreads();
+	if (work.nTasks > 1) {
+		work.nTasks *= ED_BGZF_TASKS_PER_THREAD;
+	}
+	if (work.nTasks > nTodo) {
+		work.nTasks = nTodo;
+	}
+	for (k = 0; k < work.nTasks; k++) {
+		work.rc[k] = 0;
+	}
+	ED_parallelFor(work.nTasks, runWorker, &work);
+	for (k = 0; k < work.nTasks; k++) {
+		if (work.rc[k] != 0) {
+			errno = work.rc[k];
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Index of the block containing the uncompressed offset pos */
+static size_t findBlock(const ED_BGZF* bgzf, size_t pos)
+{
+	size_t lo = 0;
+	size_t hi = bgzf->nBlocks;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo)/2;
+		if (bgzf->blocks[mid].uOffset <= pos) {
+			lo = mid;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+int ED_bgzfEnsure(ED_BGZF* bgzf, size_t pos, size_t len, size_t readAhead)
+{
+	size_t end;
+	size_t first;
+	size_t i;
+	size_t nTodo = 0;
+	size_t* todo;
+	int missing = 0;
+	int rc;
+
+	if (bgzf == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (pos >= bgzf->size || len == 0) {
+		return 0;
+	}
+	end = bgzf->size - pos < len ? bgzf->size : pos + len;
+	first = findBlock(bgzf, pos);
+	/* Fast path: Everything is inflated already */
+	if (first < bgzf->prefix &&
+		(bgzf->prefix == bgzf->nBlocks || end <= bgzf->blocks[bgzf->prefix].uOffset)) {
+		return 0;
+	}
+	for (i = first; i < bgzf->nBlocks && bgzf->blocks[i].uOffset < end; i++) {
+		if (!bgzf->done[i]) {
+			missing = 1;
+			break;
+		}
+	}
+	if (!missing) {
+		return 0;
+	}
+
+	end = bgzf->size - end < readAhead ? bgzf->size : end + readAhead;
+	for (i = first; i < bgzf->nBlocks && bgzf->blocks[i].uOffset < end; i++) {
+		nTodo++;
+	}
+	todo = (size_t*)malloc(nTodo*sizeof(size_t));
+	if (todo == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	nTodo = 0;
+	for (i = first; i < bgzf->nBlocks && bgzf->blocks[i].uOffset < end; i++) {
+		if (!bgzf->done[i]) {
+			todo[nTodo++] = i;
+		}
+	}
+	rc = inflateBlocks(bgzf, todo, nTodo);
+	free(todo);
+	while (bgzf->prefix < bgzf->nBlocks && bgzf->done[bgzf->prefix]) {
+		bgzf->prefix++;
+	}
+	return rc;
+}
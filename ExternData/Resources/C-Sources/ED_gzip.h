@@ -0,0 +1,71 @@
+/* ED_gzip.h - gzip and BGZF (blocked gzip) decoding
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_GZIP_H)
+#define ED_GZIP_H
+
+#include <stdlib.h>
+
+/* Return 1 if src starts with a gzip member */
+int ED_gzipIsMember(const void* src, size_t len);
+
+/* Inflate all (concatenated) gzip members of src into a newly allocated,
+ * null-terminated buffer that must be released by free. Returns NULL and
+ * sets errno on failure.
+ */
+char* ED_gzipDecompress(const void* src, size_t len, size_t* dstLen);
+
+/* BGZF is gzip with independently inflatable members of at most 64 KiB
+ * whose compressed size is stored in the extra field of the header.
+ * The blocks are inflated lazily and in parallel on demand.
+ */
+typedef struct ED_BGZF ED_BGZF;
+
+/* Return 1 if src starts with a BGZF block */
+int ED_bgzfIsBlocked(const void* src, size_t len);
+
+/* Build the block index of src, which must stay valid until ED_bgzfClose.
+ * The index is read from the optional .gzi file content (gzi, gziLen) or
+ * else scanned from the block headers. Returns NULL and sets errno on
+ * failure.
+ */
+ED_BGZF* ED_bgzfOpen(const void* src, size_t len, const void* gzi, size_t gziLen);
+void ED_bgzfClose(ED_BGZF* bgzf);
+
+/* Uncompressed size */
+size_t ED_bgzfSize(const ED_BGZF* bgzf);
+
+/* Buffer of the uncompressed content, only ranges passed to ED_bgzfEnsure
+ * are valid
+ */
+const char* ED_bgzfData(const ED_BGZF* bgzf);
+
+/* Inflate all blocks overlapping the range [pos, pos + len) plus readAhead
+ * following bytes. Returns 0 on success or -1 and sets errno on failure.
+ */
+int ED_bgzfEnsure(ED_BGZF* bgzf, size_t pos, size_t len, size_t readAhead);
+
+#endif
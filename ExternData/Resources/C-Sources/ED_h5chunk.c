@@ -0,0 +1,758 @@
+/* ED_h5chunk.c - Parallel reading of chunked HDF5 datasets
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+#if !defined(_FILE_OFFSET_BITS)
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "zlib.h"
+#include "ED_parallel.h"
+#include "ED_h5chunk.h"
+
+/* Minimum number of chunks of a dataset for the parallel read */
+#define ED_H5_MIN_CHUNKS (2)
+/* Maximum number of raw chunk bytes per batch (at least one chunk) */
+#define ED_H5_BATCH_SIZE (64*1024*1024)
+/* Tasks per thread for load balancing of the chunk inflation */
+#define ED_H5_TASKS_PER_THREAD (4)
+/* Maximum size of an object header block or B-tree node */
+#define ED_H5_MAX_BLOCK (1024*1024)
+/* Maximum number of object header blocks (continuation messages) */
+#define ED_H5_MAX_BLOCKS (64)
+
+/* Object header message types */
+#define MSG_LAYOUT (0x0008)
+#define MSG_CONTINUATION (0x0010)
+
+/* Native element types */
+enum {
+	T_NONE = 0,
+	T_DOUBLE,
+	T_FLOAT,
+	T_SCHAR,
+	T_UCHAR,
+	T_SHORT,
+	T_USHORT,
+	T_INT,
+	T_UINT,
+	T_LLONG,
+	T_ULLONG
+};
+
+typedef struct {
+	unsigned long long addr; /* Absolute file address of the raw chunk */
+	size_t size; /* Size of the raw chunk */
+	unsigned int mask; /* Bit i is set if filter i was skipped */
+	size_t iOffset; /* Index of the chunk position in H5Read.offsets */
+	size_t pos; /* Position of the raw chunk in the batch buffer */
+} H5Chunk;
+
+typedef struct {
+	FILE* fp;
+	unsigned long long base; /* Absolute address of the superblock */
+	size_t sizeofAddr;
+	size_t sizeofSize;
+	int rank;
+	hsize_t dims[H5S_MAX_RANK];
+	hsize_t chunkDims[H5S_MAX_RANK];
+	hsize_t dimStride[H5S_MAX_RANK]; /* Element strides of the dataset */
+	hsize_t chunkStride[H5S_MAX_RANK]; /* Element strides of a chunk */
+	size_t elemSize; /* Size of an element in the file */
+	size_t memSize; /* Size of an element in data */
+	int srcType;
+	int dstType;
+	size_t chunkBytes; /* Size of an unfiltered chunk */
+	int nFilters;
+	H5Z_filter_t filters[H5Z_MAX_NFILTERS];
+	H5Chunk* chunks;
+	size_t nChunks;
+	size_t maxChunks; /* Number of chunks of the dataspace */
+	hsize_t* offsets; /* Positions of the chunks, rank elements per chunk */
+	unsigned char* batch;
+	size_t first; /* First chunk of the batch */
+	size_t nBatch; /* Number of chunks of the batch */
+	size_t nTasks;
+	int* rc; /* Per task: 0 on success */
+	unsigned char* data;
+} H5Read;
+
+static unsigned long long readLE(const unsigned char* p, size_t n)
+{
+	unsigned long long v = 0;
+	while (n-- > 0) {
+		v = (v << 8) | p[n];
+	}
+	return v;
+}
+
+static int seekFile(FILE* fp, unsigned long long pos)
+{
+#if defined(_MSC_VER)
+	return _fseeki64(fp, (__int64)pos, SEEK_SET);
+#else
+	return fseeko(fp, (off_t)pos, SEEK_SET);
+#endif
+}
+
+static int readAt(FILE* fp, unsigned long long pos, void* buf, size_t len)
+{
+	if (0 != seekFile(fp, pos) || len != fread(buf, 1, len, fp)) {
+		return -1;
+	}
+	return 0;
+}
+
+static int nativeType(hid_t type)
+{
+	static const int types[] = {T_DOUBLE, T_FLOAT, T_SCHAR, T_UCHAR, T_SHORT,
+		T_USHORT, T_INT, T_UINT, T_LLONG, T_ULLONG};
+	hid_t natives[10];
+	int i;
+	natives[0] = H5T_NATIVE_DOUBLE;
+	natives[1] = H5T_NATIVE_FLOAT;
+	natives[2] = H5T_NATIVE_SCHAR;
+	natives[3] = H5T_NATIVE_UCHAR;
+	natives[4] = H5T_NATIVE_SHORT;
+	natives[5] = H5T_NATIVE_USHORT;
+	natives[6] = H5T_NATIVE_INT;
+	natives[7] = H5T_NATIVE_UINT;
+	natives[8] = H5T_NATIVE_LLONG;
+	natives[9] = H5T_NATIVE_ULLONG;
+	for (i = 0; i < 10; i++) {
+		if (H5Tequal(type, natives[i]) > 0) {
+			return types[i];
+		}
+	}
+	return T_NONE;
+}
+
+/* Find the address of the chunk B-tree in the layout message of the object
+ * header at addr (version 1 or 2). Returns 0 on success.
+ */
+static int readLayout(H5Read* r, unsigned long long addr, unsigned long long* btree)
+{
+	unsigned long long blockAddr[ED_H5_MAX_BLOCKS];
+	size_t blockLen[ED_H5_MAX_BLOCKS];
+	unsigned char hdr[32];
+	size_t nBlocks = 1;
+	size_t iBlock;
+	int version;
+	int trackOrder = 0;
+
+	if (0 != readAt(r->fp, r->base + addr, hdr, 16)) {
+		return -1;
+	}
+	if (0 == memcmp(hdr, "OHDR", 4)) {
+		size_t p = 6;
+		size_t n = (size_t)1 << (hdr[5] & 0x03);
+		version = hdr[4];
+		if (version != 2 || 0 != readAt(r->fp, r->base + addr, hdr, sizeof(hdr))) {
+			return -1;
+		}
+		trackOrder = (hdr[5] & 0x04) != 0;
+		if (hdr[5] & 0x20) {
+			/* Access, modification, change and birth times */
+			p += 16;
+		}
+		if (hdr[5] & 0x10) {
+			/* Maximum compact and minimum dense attributes */
+			p += 4;
+		}
+		blockLen[0] = (size_t)readLE(hdr + p, n);
+		blockAddr[0] = r->base + addr + p + n;
+	}
+	else if (hdr[0] == 1) {
+		version = 1;
+		blockLen[0] = (size_t)readLE(hdr + 8, 4);
+		blockAddr[0] = r->base + addr + 16;
+	}
+	else {
+		return -1;
+	}
+
+	for (iBlock = 0; iBlock < nBlocks; iBlock++) {
+		size_t len = blockLen[iBlock];
+		size_t p = 0;
+		size_t end = len;
+		size_t msgHdrLen = version == 1 ? 8 : (trackOrder ? 6 : 4);
+		unsigned char* buf;
+		if (len > ED_H5_MAX_BLOCK || NULL == (buf = (unsigned char*)malloc(len > 0 ? len : 1))) {
+			return -1;
+		}
+		if (0 != readAt(r->fp, blockAddr[iBlock], buf, len)) {
+			free(buf);
+			return -1;
+		}
+		if (version == 2 && iBlock > 0) {
+			/* Continuation block with signature and checksum */
+			if (len < 8 || 0 != memcmp(buf, "OCHK", 4)) {
+				free(buf);
+				return -1;
+			}
+			p = 4;
+			end = len - 4;
+		}
+		while (p + msgHdrLen <= end) {
+			unsigned int type;
+			size_t size;
+			const unsigned char* msg;
+			if (version == 1) {
+				type = (unsigned int)readLE(buf + p, 2);
+				size = (size_t)readLE(buf + p + 2, 2);
+			}
+			else {
+				type = buf[p];
+				size = (size_t)readLE(buf + p + 1, 2);
+			}
+			msg = buf + p + msgHdrLen;
+			if (size > end - p - msgHdrLen) {
+				break;
+			}
+			if (type == MSG_CONTINUATION && size >= r->sizeofAddr + r->sizeofSize) {
+				if (nBlocks == ED_H5_MAX_BLOCKS) {
+					free(buf);
+					return -1;
+				}
+				blockAddr[nBlocks] = r->base + readLE(msg, r->sizeofAddr);
+				blockLen[nBlocks] = (size_t)readLE(msg + r->sizeofAddr, r->sizeofSize);
+				nBlocks++;
+			}
+			else if (type == MSG_LAYOUT) {
+				int d;
+				/* Version 3 of the layout message for chunked storage */
+				if (size < 3 + r->sizeofAddr + 4*((size_t)r->rank + 1) ||
+					msg[0] != 3 || msg[1] != 2 || msg[2] != r->rank + 1) {
+					free(buf);
+					return -1;
+				}
+				*btree = readLE(msg + 3, r->sizeofAddr);
+				for (d = 0; d < r->rank; d++) {
+					if (readLE(msg + 3 + r->sizeofAddr + 4*d, 4) != r->chunkDims[d]) {
+						free(buf);
+						return -1;
+					}
+				}
+				free(buf);
+				return 0;
+			}
+			p += msgHdrLen + size;
+		}
+		free(buf);
+	}
+	return -1;
+}
+
+/* Collect the chunks of the version 1 B-tree node at addr. Returns 0 on
+ * success.
+ */
+static int readNode(H5Read* r, unsigned long long addr, int level)
+{
+	size_t hdrLen = 8 + 2*r->sizeofAddr;
+	size_t keyLen = 8 + 8*((size_t)r->rank + 1);
+	unsigned char hdr[8];
+	unsigned char* buf;
+	size_t nEntries;
+	size_t len;
+	size_t i;
+	int nodeLevel;
+
+	if (0 != readAt(r->fp, r->base + addr, hdr, sizeof(hdr)) ||
+		0 != memcmp(hdr, "TREE", 4) || hdr[4] != 1) {
+		return -1;
+	}
+	nodeLevel = hdr[5];
+	if ((level >= 0 && nodeLevel != level) || nodeLevel > 64) {
+		return -1;
+	}
+	nEntries = (size_t)readLE(hdr + 6, 2);
+	len = nEntries*(keyLen + r->sizeofAddr) + keyLen;
+	if (len > ED_H5_MAX_BLOCK || NULL == (buf = (unsigned char*)malloc(len))) {
+		return -1;
+	}
+	if (0 != readAt(r->fp, r->base + addr + hdrLen, buf, len)) {
+		free(buf);
+		return -1;
+	}
+	for (i = 0; i < nEntries; i++) {
+		const unsigned char* key = buf + i*(keyLen + r->sizeofAddr);
+		unsigned long long child = readLE(key + keyLen, r->sizeofAddr);
+		if (nodeLevel > 0) {
+			if (0 != readNode(r, child, nodeLevel - 1)) {
+				free(buf);
+				return -1;
+			}
+		}
+		else {
+			H5Chunk* chunk;
+			hsize_t* offset;
+			int d;
+			if (r->nChunks == r->maxChunks) {
+				/* More chunks than the dataspace can hold */
+				free(buf);
+				return -1;
+			}
+			chunk = &r->chunks[r->nChunks];
+			offset = &r->offsets[r->nChunks*(size_t)r->rank];
+			chunk->addr = r->base + child;
+			chunk->size = (size_t)readLE(key, 4);
+			chunk->mask = (unsigned int)readLE(key + 4, 4);
+			chunk->iOffset = r->nChunks;
+			for (d = 0; d < r->rank; d++) {
+				offset[d] = (hsize_t)readLE(key + 8 + 8*d, 8);
+				if (offset[d] >= r->dims[d] || offset[d] % r->chunkDims[d] != 0) {
+					free(buf);
+					return -1;
+				}
+			}
+			if (chunk->size == 0 || chunk->size > ED_H5_BATCH_SIZE) {
+				free(buf);
+				return -1;
+			}
+			r->nChunks++;
+		}
+	}
+	free(buf);
+	return 0;
+}
+
+static int compareChunk(const void* a, const void* b)
+{
+	const H5Chunk* chunkA = (const H5Chunk*)a;
+	const H5Chunk* chunkB = (const H5Chunk*)b;
+	return chunkA->addr < chunkB->addr ? -1 : (chunkA->addr > chunkB->addr ? 1 : 0);
+}
+
+/* Undo the shuffle filter, which stores the i-th bytes of all elements
+ * consecutively
+ */
+static void unshuffle(unsigned char* dst, const unsigned char* src, size_t len, size_t elemSize)
+{
+	size_t n = len/elemSize;
+	size_t i;
+	size_t j;
+	for (j = 0; j < elemSize; j++) {
+		const unsigned char* s = src + j*n;
+		unsigned char* d = dst + j;
+		for (i = 0; i < n; i++) {
+			d[i*elemSize] = s[i];
+		}
+	}
+	/* Trailing bytes are not shuffled */
+	memcpy(dst + n*elemSize, src + n*elemSize, len - n*elemSize);
+}
+
+#define CONVERT(type) { \
+	const type* s = (const type*)src; \
+	for (i = 0; i < n; i++) { \
+		dst[i] = (double)s[i]; \
+	} \
+	break; \
+}
+
+/* Copy n elements, converting them to double if the types differ */
+static void convert(const H5Read* r, unsigned char* _dst, const unsigned char* src, size_t n)
+{
+	double* dst = (double*)_dst;
+	size_t i;
+	if (r->srcType == r->dstType) {
+		memcpy(_dst, src, n*r->elemSize);
+		return;
+	}
+	switch (r->srcType) {
+		case T_FLOAT: CONVERT(float)
+		case T_SCHAR: CONVERT(signed char)
+		case T_UCHAR: CONVERT(unsigned char)
+		case T_SHORT: CONVERT(short)
+		case T_USHORT: CONVERT(unsigned short)
+		case T_INT: CONVERT(int)
+		case T_UINT: CONVERT(unsigned int)
+		case T_LLONG: CONVERT(long long)
+		case T_ULLONG: CONVERT(unsigned long long)
+		default:
+			break;
+	}
+}
+
+#undef CONVERT
+
+/* Copy the part of the unfiltered chunk src inside the dataspace to data */
+static void scatterChunk(const H5Read* r, const hsize_t* offset, const unsigned char* src)
+{
+	hsize_t idx[H5S_MAX_RANK];
+	hsize_t extent[H5S_MAX_RANK];
+	int last = r->rank - 1;
+	int d;
+	for (d = 0; d < r->rank; d++) {
+		idx[d] = 0;
+		extent[d] = r->dims[d] - offset[d];
+		if (extent[d] > r->chunkDims[d]) {
+			extent[d] = r->chunkDims[d];
+		}
+	}
+	for (;;) {
+		hsize_t srcPos = 0;
+		hsize_t dstPos = offset[last];
+		for (d = 0; d < last; d++) {
+			srcPos += idx[d]*r->chunkStride[d];
+			dstPos += (offset[d] + idx[d])*r->dimStride[d];
+		}
+		convert(r, r->data + (size_t)dstPos*r->memSize, src + (size_t)srcPos*r->elemSize,
+			(size_t)extent[last]);
+		for (d = last - 1; d >= 0; d--) {
+			if (++idx[d] < extent[d]) {
+				break;
+			}
+			idx[d] = 0;
+		}
+		if (d < 0) {
+			break;
+		}
+	}
+}
+
+/* Run the filters of the pipeline backwards on the raw chunk and copy the
+ * result to data. Returns 0 on success.
+ */
+static int readChunk(const H5Read* r, z_stream* zs, const H5Chunk* chunk,
+	unsigned char* scratch[2])
+{
+	const hsize_t* offset = &r->offsets[chunk->iOffset*(size_t)r->rank];
+	const unsigned char* src = r->batch + chunk->pos;
+	size_t len = chunk->size;
+	unsigned char* direct = NULL;
+	int lastFilter = -1;
+	int iScratch = 0;
+	int f;
+	int d;
+
+	/* A chunk that spans whole rows of the dataspace is contiguous in data */
+	if (r->srcType == r->dstType && offset[0] + r->chunkDims[0] <= r->dims[0]) {
+		hsize_t pos = offset[0]*r->dimStride[0];
+		for (d = 1; d < r->rank && r->chunkDims[d] == r->dims[d]; d++) {
+		}
+		if (d == r->rank) {
+			direct = r->data + (size_t)pos*r->memSize;
+		}
+	}
+	for (f = 0; f < r->nFilters; f++) {
+		if ((chunk->mask & (1U << f)) == 0) {
+			lastFilter = f;
+			break;
+		}
+	}
+
+	for (f = r->nFilters - 1; f >= 0; f--) {
+		unsigned char* dst;
+		if (chunk->mask & (1U << f)) {
+			continue;
+		}
+		dst = (f == lastFilter && direct != NULL) ? direct : scratch[iScratch];
+		if (r->filters[f] == H5Z_FILTER_DEFLATE) {
+			if (Z_OK != inflateReset(zs)) {
+				return -1;
+			}
+			zs->next_in = (Bytef*)src;
+			zs->avail_in = (uInt)len;
+			zs->next_out = (Bytef*)dst;
+			zs->avail_out = (uInt)r->chunkBytes;
+			if (Z_STREAM_END != inflate(zs, Z_FINISH) || zs->avail_out != 0) {
+				return -1;
+			}
+		}
+		else {
+			if (len != r->chunkBytes) {
+				return -1;
+			}
+			unshuffle(dst, src, len, r->elemSize);
+		}
+		src = dst;
+		len = r->chunkBytes;
+		iScratch = 1 - iScratch;
+	}
+	if (len != r->chunkBytes) {
+		return -1;
+	}
+	if (direct != NULL) {
+		if (src != direct) {
+			memcpy(direct, src, len);
+		}
+	}
+	else {
+		if (r->srcType != r->dstType && src == r->batch + chunk->pos) {
+			/* Align the elements of an unfiltered chunk */
+			memcpy(scratch[0], src, len);
+			src = scratch[0];
+		}
+		scatterChunk(r, offset, src);
+	}
+	return 0;
+}
+
+/* Task k reads a contiguous range of the chunks of the batch */
+static void readChunks(void* data, size_t k)
+{
+	H5Read* r = (H5Read*)data;
+	z_stream zs;
+	unsigned char* scratch[2];
+	size_t i;
+	memset(&zs, 0, sizeof(zs));
+	scratch[0] = (unsigned char*)malloc(r->chunkBytes);
+	scratch[1] = (unsigned char*)malloc(r->chunkBytes);
+	if (scratch[0] == NULL || scratch[1] == NULL || Z_OK != inflateInit(&zs)) {
+		free(scratch[0]);
+		free(scratch[1]);
+		r->rc[k] = -1;
+		return;
+	}
+	for (i = k*r->nBatch/r->nTasks; i < (k + 1)*r->nBatch/r->nTasks; i++) {
+		if (0 != readChunk(r, &zs, &r->chunks[r->first + i], scratch)) {
+			r->rc[k] = -1;
+			break;
+		}
+	}
+	inflateEnd(&zs);
+	free(scratch[0]);
+	free(scratch[1]);
+}
+
+/* Read the chunks in batches of consecutive file addresses */
+static int readBatches(H5Read* r)
+{
+	size_t batchLen = 0;
+	size_t nThreads = ED_parallelThreads();
+	size_t k;
+
+	r->rc = (int*)malloc(nThreads*ED_H5_TASKS_PER_THREAD*sizeof(int));
+	if (r->rc == NULL) {
+		return -1;
+	}
+	qsort(r->chunks, r->nChunks, sizeof(H5Chunk), compareChunk);
+	for (r->first = 0; r->first < r->nChunks; r->first += r->nBatch) {
+		size_t pos = 0;
+		size_t i;
+		for (i = r->first; i < r->nChunks; i++) {
+			if (i > r->first && pos + r->chunks[i].size > ED_H5_BATCH_SIZE) {
+				break;
+			}
+			r->chunks[i].pos = pos;
+			pos += r->chunks[i].size;
+		}
+		r->nBatch = i - r->first;
+		if (pos > batchLen) {
+			unsigned char* batch = (unsigned char*)realloc(r->batch, pos);
+			if (batch == NULL) {
+				return -1;
+			}
+			r->batch = batch;
+			batchLen = pos;
+		}
+		for (i = r->first; i < r->first + r->nBatch; i++) {
+			if (0 != readAt(r->fp, r->chunks[i].addr, r->batch + r->chunks[i].pos, r->chunks[i].size)) {
+				return -1;
+			}
+		}
+		r->nTasks = nThreads*ED_H5_TASKS_PER_THREAD;
+		if (r->nTasks > r->nBatch) {
+			r->nTasks = r->nBatch;
+		}
+		for (k = 0; k < r->nTasks; k++) {
+			r->rc[k] = 0;
+		}
+		ED_parallelFor(r->nTasks, readChunks, r);
+		for (k = 0; k < r->nTasks; k++) {
+			if (r->rc[k] != 0) {
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Check the dataset properties and fill r. Returns 0 if supported. */
+static int checkProperties(H5Read* r, hid_t dset, hid_t memType, hid_t dcpl,
+	hid_t space, hid_t type, hid_t fid, hid_t fapl, hid_t fcpl,
+	char** fileName, unsigned long long* addr)
+{
+	H5D_fill_value_t fill;
+	H5O_info_t info;
+	hsize_t userBlock;
+	unsigned int intent;
+	ssize_t len;
+	int rank;
+	int nFilters;
+	int f;
+	int d;
+
+	if (H5Pget_layout(dcpl) != H5D_CHUNKED || H5Pget_driver(fapl) != H5FD_SEC2 ||
+		H5Sget_simple_extent_type(space) != H5S_SIMPLE) {
+		return -1;
+	}
+	rank = H5Sget_simple_extent_ndims(space);
+	nFilters = H5Pget_nfilters(dcpl);
+	r->srcType = nativeType(type);
+	r->dstType = nativeType(memType);
+	r->elemSize = H5Tget_size(type);
+	r->memSize = H5Tget_size(memType);
+	if (rank < 1 || rank > H5S_MAX_RANK || rank != H5Pget_chunk(dcpl, H5S_MAX_RANK, r->chunkDims) ||
+		r->srcType == T_NONE || r->dstType == T_NONE ||
+		(r->srcType != r->dstType && r->dstType != T_DOUBLE) ||
+		nFilters < 0 || nFilters > H5Z_MAX_NFILTERS ||
+		H5Pfill_value_defined(dcpl, &fill) < 0 || fill == H5D_FILL_VALUE_USER_DEFINED ||
+		H5Pget_userblock(fcpl, &userBlock) < 0 ||
+		H5Pget_sizes(fcpl, &r->sizeofAddr, &r->sizeofSize) < 0 ||
+		r->sizeofAddr < 1 || r->sizeofAddr > 8 || r->sizeofSize < 1 || r->sizeofSize > 8 ||
+		H5Fget_intent(fid, &intent) < 0 || H5Oget_info(dset, &info) < 0) {
+		/* Missing chunks would need a user-defined fill value */
+		return -1;
+	}
+	r->rank = rank;
+	H5Sget_simple_extent_dims(space, r->dims, NULL);
+	r->nFilters = nFilters;
+	for (f = 0; f < nFilters; f++) {
+		unsigned int flags;
+		unsigned int cd[8];
+		size_t nCd = 8;
+		r->filters[f] = H5Pget_filter2(dcpl, (unsigned int)f, &flags, &nCd, cd, 0, NULL, NULL);
+		if (r->filters[f] != H5Z_FILTER_DEFLATE && r->filters[f] != H5Z_FILTER_SHUFFLE) {
+			return -1;
+		}
+	}
+	r->chunkBytes = r->elemSize;
+	r->maxChunks = 1;
+	for (d = rank - 1; d >= 0; d--) {
+		if (r->chunkDims[d] == 0 || r->dims[d] == 0) {
+			return -1;
+		}
+		r->chunkStride[d] = d == rank - 1 ? 1 : r->chunkStride[d + 1]*r->chunkDims[d + 1];
+		r->dimStride[d] = d == rank - 1 ? 1 : r->dimStride[d + 1]*r->dims[d + 1];
+		r->chunkBytes *= (size_t)r->chunkDims[d];
+		r->maxChunks *= (size_t)((r->dims[d] + r->chunkDims[d] - 1)/r->chunkDims[d]);
+	}
+	if (r->maxChunks < ED_H5_MIN_CHUNKS) {
+		return -1;
+	}
+	if (intent & H5F_ACC_RDWR) {
+		/* Chunks could still be in the cache of HDF5 */
+		H5Fflush(dset, H5F_SCOPE_LOCAL);
+	}
+	r->base = (unsigned long long)userBlock;
+	*addr = (unsigned long long)info.addr;
+	len = H5Fget_name(fid, NULL, 0);
+	if (len <= 0) {
+		return -1;
+	}
+	*fileName = (char*)malloc((size_t)len + 1);
+	if (*fileName == NULL || H5Fget_name(fid, *fileName, (size_t)len + 1) != len) {
+		return -1;
+	}
+	return 0;
+}
+
+/* Query the dataset properties from HDF5. Returns 0 if supported. */
+static int readProperties(H5Read* r, hid_t dset, hid_t memType, char** fileName,
+	unsigned long long* addr)
+{
+	int ret = -1;
+	hid_t dcpl = H5Dget_create_plist(dset);
+	hid_t space = H5Dget_space(dset);
+	hid_t type = H5Dget_type(dset);
+	hid_t fid = H5Iget_file_id(dset);
+	hid_t fapl = fid >= 0 ? H5Fget_access_plist(fid) : -1;
+	hid_t fcpl = fid >= 0 ? H5Fget_create_plist(fid) : -1;
+
+	if (dcpl >= 0 && space >= 0 && type >= 0 && fapl >= 0 && fcpl >= 0) {
+		ret = checkProperties(r, dset, memType, dcpl, space, type, fid, fapl, fcpl,
+			fileName, addr);
+	}
+	if (fcpl >= 0) {
+		H5Pclose(fcpl);
+	}
+	if (fapl >= 0) {
+		H5Pclose(fapl);
+	}
+	if (fid >= 0) {
+		H5Fclose(fid);
+	}
+	if (type >= 0) {
+		H5Tclose(type);
+	}
+	if (space >= 0) {
+		H5Sclose(space);
+	}
+	if (dcpl >= 0) {
+		H5Pclose(dcpl);
+	}
+	return ret;
+}
+
+int ED_h5ReadChunked(hid_t dset, hid_t memType, void* data)
+{
+	H5Read r;
+	char* fileName = NULL;
+	unsigned long long addr = 0;
+	unsigned long long btree = 0;
+	int ret = -1;
+
+	if (ED_parallelThreads() < 2) {
+		return -1;
+	}
+	memset(&r, 0, sizeof(r));
+	r.data = (unsigned char*)data;
+	if (0 != readProperties(&r, dset, memType, &fileName, &addr)) {
+		free(fileName);
+		return -1;
+	}
+	r.fp = fopen(fileName, "rb");
+	free(fileName);
+	if (r.fp == NULL) {
+		return -1;
+	}
+	r.chunks = (H5Chunk*)malloc(r.maxChunks*sizeof(H5Chunk));
+	r.offsets = (hsize_t*)malloc(r.maxChunks*(size_t)r.rank*sizeof(hsize_t));
+	if (r.chunks != NULL && r.offsets != NULL &&
+		0 == readLayout(&r, addr, &btree) && 0 == readNode(&r, btree, -1) &&
+		r.nChunks >= ED_H5_MIN_CHUNKS) {
+		if (r.nChunks < r.maxChunks) {
+			/* Chunks that were never written hold the default fill value */
+			memset(data, 0, (size_t)(r.dimStride[0]*r.dims[0])*r.memSize);
+		}
+		ED_parallelAcquire();
+		ret = readBatches(&r);
+		ED_parallelRelease();
+	}
+	fclose(r.fp);
+	free(r.chunks);
+	free(r.offsets);
+	free(r.batch);
+	free(r.rc);
+	return ret;
+}
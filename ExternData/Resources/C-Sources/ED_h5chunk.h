@@ -0,0 +1,45 @@
+/* ED_h5chunk.h - Parallel reading of chunked HDF5 datasets
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_H5CHUNK_H)
+#define ED_H5CHUNK_H
+
+#include <hdf5.h>
+
+/* Read all elements of the chunked dataset dset as the native numeric type
+ * memType into data, in the order of H5Dread with H5S_ALL. The chunk index
+ * is read from the file on the calling thread, which is the only one that
+ * calls into HDF5, and the raw chunks are fetched in batches. The chunks of
+ * a batch are inflated, unshuffled and converted to memType in parallel
+ * straight into data.
+ * Returns 0 on success or -1 if the dataset cannot be read this way (e.g.
+ * small, contiguous, other filters or conversions, a file driver other than
+ * sec2, or corrupt chunks). data is then undefined and must be read by
+ * H5Dread.
+ */
+int ED_h5ReadChunked(hid_t dset, hid_t memType, void* data);
+
+#endif
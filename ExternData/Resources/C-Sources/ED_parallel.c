@@ -0,0 +1,542 @@
+/* ED_parallel.c - Work-stealing scheduler for parallel loops
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdlib.h>
+#include <ctype.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE_CC__)
+#include <unistd.h>
+#endif
+#if !defined(_POSIX_) && defined(_POSIX_VERSION)
+#define _POSIX_ 1
+#endif
+#if defined(_POSIX_) && !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "ED_parallel.h"
+
+/* The scheduler needs threads, atomic operations and thread-local storage */
+#if defined(_WIN32) && defined(_MSC_VER)
+#define ED_PARALLEL_POOL 1
+#define ED_TLS __declspec(thread)
+typedef LONGLONG AtomicInt;
+#define atomicLoad(p) InterlockedCompareExchange64((p), 0, 0)
+#define atomicStore(p, v) ((void)InterlockedExchange64((p), (v)))
+#define atomicAdd(p, v) InterlockedExchangeAdd64((p), (v))
+#define atomicCAS(p, e, v) (InterlockedCompareExchange64((p), (v), (e)) == (e))
+#define atomicLoadPtr(p) InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define atomicStorePtr(p, v) ((void)InterlockedExchangePointer((PVOID volatile*)(p), (v)))
+#elif (defined(_WIN32) || defined(_POSIX_)) && defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define ED_PARALLEL_POOL 1
+#define ED_TLS __thread
+typedef long long AtomicInt;
+#define atomicLoad(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define atomicStore(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define atomicAdd(p, v) __atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST)
+#define atomicCAS(p, e, v) __atomic_compare_exchange_n((p), &(e), (v), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define atomicLoadPtr(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define atomicStorePtr(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#endif
+
+/* Maximum number of concurrent ED_parallelFor callers that are not worker
+ * threads, further callers run their loops serially
+ */
+#define ED_PARALLEL_MAX_CALLERS (16)
+
+/* Capacity of a task deque, must be a power of two */
+#define ED_PARALLEL_DEQUE_SIZE (256)
+
+/* Spins before an idle worker goes to sleep */
+#define ED_PARALLEL_SPINS (64)
+
+static size_t threadCount(void)
+{
+	size_t n = 0;
+	const char* env = getenv("EXTERNDATA_THREADS");
+	if (env != NULL) {
+		char* endptr;
+		long nEnv = strtol(env, &endptr, 10);
+		while (isspace((unsigned char)*endptr)) {
+			endptr++;
+		}
+		if (endptr != env && *endptr == '\0' && nEnv > 0) {
+			n = (size_t)nEnv;
+		}
+	}
+	if (n == 0) {
+#if defined(_WIN32)
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		n = (size_t)si.dwNumberOfProcessors;
+#elif defined(_POSIX_) && defined(_SC_NPROCESSORS_ONLN)
+		long nProc = sysconf(_SC_NPROCESSORS_ONLN);
+		if (nProc > 0) {
+			n = (size_t)nProc;
+		}
+#endif
+	}
+	if (n < 1) {
+		n = 1;
+	}
+	else if (n > ED_PARALLEL_MAX_THREADS) {
+		n = ED_PARALLEL_MAX_THREADS;
+	}
+	return n;
+}
+
+#if defined(ED_PARALLEL_POOL)
+
+typedef struct ParallelLoop ParallelLoop;
+
+typedef struct {
+	ParallelLoop* loop;
+	size_t i;
+} Task;
+
+struct ParallelLoop {
+	ED_parallelFunc func;
+	void* data;
+	AtomicInt remaining; /* Number of unfinished tasks */
+};
+
+/* Chase-Lev deque: the owning thread pushes and pops at the bottom,
+ * other threads steal from the top
+ */
+typedef struct {
+	AtomicInt top;
+	AtomicInt bottom;
+	AtomicInt owned; /* Caller slot in use */
+	Task* buf[ED_PARALLEL_DEQUE_SIZE];
+} Deque;
+
+#if defined(_WIN32)
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Cond;
+typedef HANDLE Thread;
+#define mutexInit(m) InitializeCriticalSection(m)
+#define mutexDestroy(m) DeleteCriticalSection(m)
+#define mutexLock(m) EnterCriticalSection(m)
+#define mutexUnlock(m) LeaveCriticalSection(m)
+#define condInit(c) InitializeConditionVariable(c)
+#define condDestroy(c)
+#define condWait(c, m) SleepConditionVariableCS((c), (m), INFINITE)
+#define condBroadcast(c) WakeAllConditionVariable(c)
+#define yieldThread() SwitchToThread()
+#else
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+typedef pthread_t Thread;
+#define mutexInit(m) pthread_mutex_init((m), NULL)
+#define mutexDestroy(m) pthread_mutex_destroy(m)
+#define mutexLock(m) pthread_mutex_lock(m)
+#define mutexUnlock(m) pthread_mutex_unlock(m)
+#define condInit(c) pthread_cond_init((c), NULL)
+#define condDestroy(c) pthread_cond_destroy(c)
+#define condWait(c, m) pthread_cond_wait((c), (m))
+#define condBroadcast(c) pthread_cond_broadcast(c)
+#define yieldThread() sched_yield()
+#endif
+
+static struct {
+	int started;
+	size_t users; /* Number of ED_parallelAcquire references */
+	size_t nWorkers;
+	size_t nSlots; /* nWorkers deques of the workers plus the caller slots */
+	Deque* slots;
+	Thread threads[ED_PARALLEL_MAX_THREADS];
+	AtomicInt stop;
+	AtomicInt epoch; /* Incremented whenever tasks are pushed */
+	AtomicInt sleepers; /* Number of workers waiting for wake */
+	Mutex lock;
+	Cond wake; /* Signaled when tasks are pushed or on shutdown */
+	Cond done; /* Signaled when a loop is finished */
+} pool;
+
+/* Deque of the current thread (worker or caller) */
+static ED_TLS Deque* tlsDeque = NULL;
+static ED_TLS unsigned int tlsSeed = 0;
+
+/* Serializes start and shutdown of the workers */
+#if defined(_WIN32)
+static volatile LONG lifeLock = 0;
+static void lifeLockAcquire(void)
+{
+	while (InterlockedCompareExchange(&lifeLock, 1, 0) != 0) {
+		Sleep(1);
+	}
+}
+static void lifeLockRelease(void)
+{
+	InterlockedExchange(&lifeLock, 0);
+}
+#else
+static pthread_mutex_t lifeLock = PTHREAD_MUTEX_INITIALIZER;
+#define lifeLockAcquire() pthread_mutex_lock(&lifeLock)
+#define lifeLockRelease() pthread_mutex_unlock(&lifeLock)
+#endif
+
+static int dequePush(Deque* d, Task* task)
+{
+	AtomicInt b = atomicLoad(&d->bottom);
+	AtomicInt t = atomicLoad(&d->top);
+	if (b - t >= ED_PARALLEL_DEQUE_SIZE) {
+		return 0;
+	}
+	atomicStorePtr(&d->buf[b & (ED_PARALLEL_DEQUE_SIZE - 1)], task);
+	atomicStore(&d->bottom, b + 1);
+	return 1;
+}
+
+static Task* dequePop(Deque* d)
+{
+	Task* task = NULL;
+	AtomicInt b = atomicLoad(&d->bottom) - 1;
+	AtomicInt t;
+	atomicStore(&d->bottom, b);
+	t = atomicLoad(&d->top);
+	if (t <= b) {
+		task = (Task*)atomicLoadPtr(&d->buf[b & (ED_PARALLEL_DEQUE_SIZE - 1)]);
+		if (t == b) {
+			/* Last task, race against the thieves */
+			if (!atomicCAS(&d->top, t, t + 1)) {
+				task = NULL;
+			}
+			atomicStore(&d->bottom, b + 1);
+		}
+	}
+	else {
+		atomicStore(&d->bottom, b + 1);
+	}
+	return task;
+}
+
+static Task* dequeSteal(Deque* d)
+{
+	AtomicInt t = atomicLoad(&d->top);
+	AtomicInt b = atomicLoad(&d->bottom);
+	if (t < b) {
+		Task* task = (Task*)atomicLoadPtr(&d->buf[t & (ED_PARALLEL_DEQUE_SIZE - 1)]);
+		if (atomicCAS(&d->top, t, t + 1)) {
+			return task;
+		}
+	}
+	return NULL;
+}
+
+/* Pop from the own deque or else steal from a random victim */
+static Task* findTask(Deque* self)
+{
+	Task* task = dequePop(self);
+	if (task == NULL) {
+		size_t k;
+		size_t start;
+		tlsSeed = tlsSeed*1103515245u + 12345u;
+		start = (size_t)(tlsSeed >> 16) % pool.nSlots;
+		for (k = 0; k < pool.nSlots && task == NULL; k++) {
+			Deque* victim = &pool.slots[(start + k) % pool.nSlots];
+			if (victim != self) {
+				task = dequeSteal(victim);
+			}
+		}
+	}
+	return task;
+}
+
+static void runTask(Task* task)
+{
+	ParallelLoop* loop = task->loop;
+	loop->func(loop->data, task->i);
+	if (atomicAdd(&loop->remaining, -1) == 1) {
+		mutexLock(&pool.lock);
+		condBroadcast(&pool.done);
+		mutexUnlock(&pool.lock);
+	}
+}
+
+static void notifyWorkers(void)
+{
+	atomicAdd(&pool.epoch, 1);
+	if (atomicLoad(&pool.sleepers) > 0) {
+		mutexLock(&pool.lock);
+		condBroadcast(&pool.wake);
+		mutexUnlock(&pool.lock);
+	}
+}
+
+static void workerLoop(Deque* self)
+{
+	int spins = 0;
+	tlsDeque = self;
+	tlsSeed = (unsigned int)(self - pool.slots) + 1;
+	for (;;) {
+		AtomicInt epoch = atomicLoad(&pool.epoch);
+		Task* task = findTask(self);
+		if (task != NULL) {
+			runTask(task);
+			spins = 0;
+			continue;
+		}
+		if (atomicLoad(&pool.stop)) {
+			break;
+		}
+		if (++spins < ED_PARALLEL_SPINS) {
+			yieldThread();
+			continue;
+		}
+		/* Sleep unless tasks were pushed since the scan */
+		mutexLock(&pool.lock);
+		atomicAdd(&pool.sleepers, 1);
+		if (atomicLoad(&pool.epoch) == epoch && !atomicLoad(&pool.stop)) {
+			condWait(&pool.wake, &pool.lock);
+		}
+		atomicAdd(&pool.sleepers, -1);
+		mutexUnlock(&pool.lock);
+		spins = 0;
+	}
+	tlsDeque = NULL;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI workerThread(LPVOID arg)
+{
+	workerLoop((Deque*)arg);
+	return 0;
+}
+#else
+static void* workerThread(void* arg)
+{
+	workerLoop((Deque*)arg);
+	return NULL;
+}
+#endif
+
+/* Start the workers, must be called with the life lock held */
+static void startPool(void)
+{
+	size_t n = threadCount() - 1;
+	size_t w;
+	if (n == 0) {
+		return;
+	}
+	pool.slots = (Deque*)calloc(n + ED_PARALLEL_MAX_CALLERS, sizeof(Deque));
+	if (pool.slots == NULL) {
+		return;
+	}
+	pool.nSlots = n + ED_PARALLEL_MAX_CALLERS;
+	atomicStore(&pool.stop, 0);
+	atomicStore(&pool.sleepers, 0);
+	mutexInit(&pool.lock);
+	condInit(&pool.wake);
+	condInit(&pool.done);
+	pool.nWorkers = 0;
+	for (w = 0; w < n; w++) {
+		Deque* d = &pool.slots[pool.nWorkers];
+#if defined(_WIN32)
+		pool.threads[pool.nWorkers] = CreateThread(NULL, 0, workerThread, d, 0, NULL);
+		if (pool.threads[pool.nWorkers] != NULL) {
+			pool.nWorkers++;
+		}
+#else
+		if (0 == pthread_create(&pool.threads[pool.nWorkers], NULL, workerThread, d)) {
+			pool.nWorkers++;
+		}
+#endif
+	}
+	/* Unused worker deques are left empty and serve as no caller slots */
+	for (w = pool.nWorkers; w < n; w++) {
+		atomicStore(&pool.slots[w].owned, 1);
+	}
+	pool.started = 1;
+}
+
+/* Stop and join the workers, must be called with the life lock held */
+static void stopPool(void)
+{
+	size_t w;
+	atomicStore(&pool.stop, 1);
+	mutexLock(&pool.lock);
+	condBroadcast(&pool.wake);
+	mutexUnlock(&pool.lock);
+	for (w = 0; w < pool.nWorkers; w++) {
+#if defined(_WIN32)
+		WaitForSingleObject(pool.threads[w], INFINITE);
+		CloseHandle(pool.threads[w]);
+#else
+		pthread_join(pool.threads[w], NULL);
+#endif
+	}
+	condDestroy(&pool.done);
+	condDestroy(&pool.wake);
+	mutexDestroy(&pool.lock);
+	free(pool.slots);
+	pool.slots = NULL;
+	pool.nSlots = 0;
+	pool.nWorkers = 0;
+	pool.started = 0;
+}
+
+/* Get a free caller slot, the worker deques are skipped since the owned
+ * flag of a started worker is never set
+ */
+static Deque* acquireSlot(void)
+{
+	size_t s;
+	for (s = pool.nWorkers; s < pool.nSlots; s++) {
+		AtomicInt expected = 0;
+		if (atomicCAS(&pool.slots[s].owned, expected, 1)) {
+			return &pool.slots[s];
+		}
+	}
+	return NULL;
+}
+
+#endif /* ED_PARALLEL_POOL */
+
+size_t ED_parallelThreads(void)
+{
+#if defined(ED_PARALLEL_POOL)
+	size_t n;
+	lifeLockAcquire();
+	n = pool.started ? pool.nWorkers + 1 : threadCount();
+	lifeLockRelease();
+	return n;
+#else
+	return 1;
+#endif
+}
+
+void ED_parallelAcquire(void)
+{
+#if defined(ED_PARALLEL_POOL)
+	lifeLockAcquire();
+	pool.users++;
+	lifeLockRelease();
+#endif
+}
+
+void ED_parallelRelease(void)
+{
+#if defined(ED_PARALLEL_POOL)
+	lifeLockAcquire();
+	if (pool.users > 0) {
+		pool.users--;
+		if (pool.users == 0 && pool.started) {
+			stopPool();
+		}
+	}
+	lifeLockRelease();
+#endif
+}
+
+void ED_parallelFor(size_t n, ED_parallelFunc func, void* data)
+{
+#if defined(ED_PARALLEL_POOL)
+	Deque* self = NULL;
+	int ownSlot = 0;
+	Task* tasks = NULL;
+
+	if (n > 1) {
+		ED_parallelAcquire();
+		lifeLockAcquire();
+		if (!pool.started) {
+			startPool();
+		}
+		lifeLockRelease();
+		self = tlsDeque;
+		if (self == NULL && pool.started) {
+			self = acquireSlot();
+			ownSlot = self != NULL;
+		}
+		if (self != NULL) {
+			tasks = (Task*)malloc(n*sizeof(Task));
+		}
+	}
+	if (tasks != NULL) {
+		ParallelLoop loop;
+		size_t pushed = 0;
+		loop.func = func;
+		loop.data = data;
+		atomicStore(&loop.remaining, (AtomicInt)n);
+		if (ownSlot) {
+			tlsDeque = self;
+		}
+		while (atomicLoad(&loop.remaining) > 0) {
+			Task* task;
+			/* Refill the deque with the tasks not yet pushed */
+			if (pushed < n) {
+				while (pushed < n) {
+					tasks[pushed].loop = &loop;
+					tasks[pushed].i = pushed;
+					if (!dequePush(self, &tasks[pushed])) {
+						break;
+					}
+					pushed++;
+				}
+				notifyWorkers();
+			}
+			task = findTask(self);
+			if (task != NULL) {
+				runTask(task);
+			}
+			else if (pushed == n) {
+				/* The remaining tasks are running on other threads */
+				mutexLock(&pool.lock);
+				if (atomicLoad(&loop.remaining) > 0) {
+					condWait(&pool.done, &pool.lock);
+				}
+				mutexUnlock(&pool.lock);
+			}
+		}
+		if (ownSlot) {
+			tlsDeque = NULL;
+			atomicStore(&self->owned, 0);
+		}
+		free(tasks);
+		ED_parallelRelease();
+		return;
+	}
+	if (n > 1) {
+		if (ownSlot) {
+			atomicStore(&self->owned, 0);
+		}
+		ED_parallelRelease();
+	}
+#endif
+	{
+		size_t i;
+		for (i = 0; i < n; i++) {
+			func(data, i);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+/* ED_parallel.h - Work-stealing scheduler for parallel loops
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_PARALLEL_H)
+#define ED_PARALLEL_H
+
+#include <stdlib.h>
+
+/* Internal work-stealing scheduler for parallel loops. The worker threads
+ * are started lazily by the first parallel loop and stopped when the last
+ * reference is released (see ED_parallelAcquire). Loops may be nested and
+ * called from any number of threads without oversubscription, since all
+ * loops share the same workers.
+ */
+
+/* Maximum number of threads */
+#define ED_PARALLEL_MAX_THREADS (64)
+
+typedef void (*ED_parallelFunc)(void* data, size_t i);
+
+/* Number of threads that run the calls of ED_parallelFor, the calling
+ * thread included (at least 1). Defaults to the number of processors and
+ * can be overridden by the environment variable EXTERNDATA_THREADS.
+ */
+size_t ED_parallelThreads(void);
+
+/* Call func(data, i) for i = 0, ..., n - 1 on the worker threads and the
+ * calling thread, and return when all calls are done. The calls may run
+ * in any order. Runs serially if no threads are available.
+ */
+void ED_parallelFor(size_t n, ED_parallelFunc func, void* data);
+
+/* Keep the worker threads alive until the matching ED_parallelRelease,
+ * e.g. from the creation to the destruction of an external object. The
+ * workers are stopped when the last reference is released, so that the
+ * library can be safely unloaded afterwards.
+ */
+void ED_parallelAcquire(void);
+void ED_parallelRelease(void);
+
+#endif
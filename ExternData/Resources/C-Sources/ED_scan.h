@@ -0,0 +1,121 @@
+/* ED_scan.h - Fast path of the conversion of decimal numbers
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_SCAN_H)
+#define ED_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Powers of ten that are exact doubles */
+static const double ED_exactPow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Convert the decimal number at the start of [p, end) of at most 15
+ * significant digits and a power of ten of at most 22 in magnitude. Both
+ * the digits and the power are exact doubles, so their product or quotient
+ * is correctly rounded. The digits are accumulated as integer, which is
+ * exact for 15 digits. Returns the end of the number or NULL for any other
+ * number.
+ */
+static const char* ED_scanDecimalPrefix(const char* p, const char* end, double* val)
+{
+	uint64_t digits = 0;
+	double w;
+	int nDigits = 0; /* Significant digits */
+	int nAll = 0;
+	int e = 0;
+	int neg = 0;
+	if (p < end && (*p == '-' || *p == '+')) {
+		neg = *p++ == '-';
+	}
+	for (; p < end && *p >= '0' && *p <= '9'; p++, nAll++) {
+		if (nDigits > 0 || *p != '0') {
+			if (++nDigits > 15) {
+				return NULL;
+			}
+			digits = 10*digits + (uint64_t)(*p - '0');
+		}
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, nAll++) {
+			if (nDigits > 0 || *p != '0') {
+				if (++nDigits > 15) {
+					return NULL;
+				}
+				digits = 10*digits + (uint64_t)(*p - '0');
+			}
+			e--;
+		}
+	}
+	if (nAll == 0) {
+		return NULL;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char* q;
+		int x = 0;
+		int negX = 0;
+		p++;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negX = *p++ == '-';
+		}
+		for (q = p; p < end && *p >= '0' && *p <= '9'; p++) {
+			if (x < 1000) {
+				x = 10*x + (*p - '0');
+			}
+		}
+		if (p == q) {
+			return NULL;
+		}
+		e += negX ? -x : x;
+	}
+	w = (double)digits;
+	if (w != 0.) {
+		if (e < -22 || e > 22) {
+			return NULL;
+		}
+		w = e < 0 ? w/ED_exactPow10[-e] : w*ED_exactPow10[e];
+	}
+	*val = neg ? -w : w;
+	return p;
+}
+
+/* Convert the decimal number [p, end) as ED_scanDecimalPrefix, returns 0
+ * if it is not covered
+ */
+static int ED_scanDecimal(const char* p, const char* end, double* val)
+{
+	double x;
+	if (ED_scanDecimalPrefix(p, end, &x) != end) {
+		return 0;
+	}
+	*val = x;
+	return 1;
+}
+
+#endif
@@ -0,0 +1,155 @@
+/* ED_share.c - Sharing of the handles of whole files
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE_CC__)
+#include <unistd.h>
+#endif
+#if !defined(_POSIX_) && defined(_POSIX_VERSION)
+#define _POSIX_ 1
+#endif
+#if defined(_POSIX_) && !defined(_WIN32)
+#include <pthread.h>
+#endif
+#include "ED_share.h"
+
+typedef struct ShareEntry {
+	void* obj;
+	int* refCount;
+	const char* type;
+	char* fileName;
+	struct ShareEntry* next;
+} ShareEntry;
+
+/* The registry lock protects the entries and all reference counts */
+#if defined(_WIN32)
+static volatile LONG registryLock = 0;
+static void lockAcquire(void)
+{
+	while (InterlockedCompareExchange(&registryLock, 1, 0) != 0) {
+		Sleep(1);
+	}
+}
+#define lockRelease() InterlockedExchange(&registryLock, 0)
+#elif defined(_POSIX_)
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+#define lockAcquire() pthread_mutex_lock(&registryLock)
+#define lockRelease() pthread_mutex_unlock(&registryLock)
+#else
+#define lockAcquire()
+#define lockRelease()
+#endif
+
+static ShareEntry* entries = NULL;
+
+/* Entry of type and fileName, must be called with the lock held */
+static ShareEntry* findEntry(const char* type, const char* fileName)
+{
+	ShareEntry* entry;
+	for (entry = entries; entry != NULL; entry = entry->next) {
+		if (0 == strcmp(entry->type, type) && 0 == strcmp(entry->fileName, fileName)) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+void* ED_shareFind(const char* type, const char* fileName)
+{
+	ShareEntry* entry;
+	void* obj = NULL;
+	lockAcquire();
+	entry = findEntry(type, fileName);
+	if (entry != NULL) {
+		(*entry->refCount)++;
+		obj = entry->obj;
+	}
+	lockRelease();
+	return obj;
+}
+
+void* ED_shareAdd(void* obj, int* refCount, const char* type, const char* fileName)
+{
+	ShareEntry* entry;
+	lockAcquire();
+	entry = findEntry(type, fileName);
+	if (entry != NULL) {
+		(*entry->refCount)++;
+		obj = entry->obj;
+	}
+	else {
+		entry = (ShareEntry*)malloc(sizeof(ShareEntry));
+		if (entry != NULL) {
+			entry->fileName = (char*)malloc(strlen(fileName) + 1);
+			if (entry->fileName != NULL) {
+				strcpy(entry->fileName, fileName);
+				entry->obj = obj;
+				entry->refCount = refCount;
+				entry->type = type;
+				entry->next = entries;
+				entries = entry;
+			}
+			else {
+				free(entry);
+			}
+		}
+	}
+	lockRelease();
+	return obj;
+}
+
+void ED_shareRetain(int* refCount)
+{
+	lockAcquire();
+	(*refCount)++;
+	lockRelease();
+}
+
+int ED_shareRelease(void* obj, int* refCount)
+{
+	int last;
+	lockAcquire();
+	last = --(*refCount) == 0;
+	if (last) {
+		ShareEntry** iter = &entries;
+		while (*iter != NULL && (*iter)->obj != obj) {
+			iter = &(*iter)->next;
+		}
+		if (*iter != NULL) {
+			ShareEntry* entry = *iter;
+			*iter = entry->next;
+			free(entry->fileName);
+			free(entry);
+		}
+	}
+	lockRelease();
+	return last;
+}
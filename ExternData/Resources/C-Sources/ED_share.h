@@ -0,0 +1,58 @@
+/* ED_share.h - Sharing of the handles of whole files
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_SHARE_H)
+#define ED_SHARE_H
+
+/* The handles of whole files, i.e. the bases of overlays, are shared by
+ * all external objects of the same file, so that the variants of a
+ * parameter set parse the base file only once. The registry is kept by
+ * each shared library. The reference counts of the handles, registered or
+ * not, are only modified under the lock of the registry, so that a handle
+ * found there is not destroyed meanwhile.
+ */
+
+/* Registered handle of type and fileName with a new reference, NULL if
+ * there is none
+ */
+void* ED_shareFind(const char* type, const char* fileName);
+
+/* Register the handle obj of type and fileName, whose reference count is
+ * *refCount. If a handle of the file was registered meanwhile, it is
+ * returned with a new reference and obj is left to the caller. Otherwise
+ * obj is returned, which is not registered if out of memory.
+ */
+void* ED_shareAdd(void* obj, int* refCount, const char* type, const char* fileName);
+
+/* Take a reference of a handle */
+void ED_shareRetain(int* refCount);
+
+/* Drop a reference of the handle obj. Returns 1 if it was the last, obj
+ * is then unregistered and to be destroyed by the caller.
+ */
+int ED_shareRelease(void* obj, int* refCount);
+
+#endif
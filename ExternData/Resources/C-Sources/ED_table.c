@@ -0,0 +1,1006 @@
+/* ED_table.c - Typed columnar tables
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "ED_table.h"
+
+/* Size of the output tile of a block read in bytes, such that the rows
+ * written while the columns are traversed stay in the cache
+ */
+#if !defined(ED_TABLE_TILE_SIZE)
+#define ED_TABLE_TILE_SIZE (1 << 15)
+#endif
+
+/* Number of rows of a block of a compressed column */
+#if !defined(ED_TABLE_BLOCK_ROWS)
+#define ED_TABLE_BLOCK_ROWS (1024)
+#endif
+
+/* Bound of the size of an encoded block in bytes: 64 bits of the first
+ * value and at most 77 bits of each other value
+ */
+#define ED_TABLE_BLOCK_BYTES (10*ED_TABLE_BLOCK_ROWS + 8)
+
+/* Number of zero bytes following the encoded blocks, read ahead by the
+ * decoders
+ */
+#define ED_TABLE_PADDING (16)
+
+/* Initial number of rows of a column */
+#define ED_TABLE_MIN_ROWS (16)
+
+/* Largest magnitude of consecutive integers exactly representable as
+ * double
+ */
+#define ED_TABLE_MAX_EXACT (9007199254740992.)
+
+typedef struct {
+	char** str; /* Strings by code - 1 */
+	size_t n;
+	size_t cap;
+	uint32_t* slots; /* Open addressing hash of the codes, 0 if unused */
+	size_t nSlots;
+} Dictionary;
+
+typedef struct {
+	size_t nRows; /* Number of rows up to the last set cell */
+	size_t cap;
+	size_t nNumeric; /* Number of numeric cells */
+	size_t nText; /* Number of text cells */
+	double* f64; /* Numeric values, if not integral */
+	int64_t* i64; /* Numeric values, while integral */
+	unsigned char* valid; /* Bitmap of present cells, NULL if all present */
+	uint32_t* codes; /* Dictionary codes of text cells, 0 if numeric */
+	Dictionary dict;
+	int view; /* 1 if the values are a slice of the table data */
+	int packedType; /* Type of the encoded values, ED_TABLE_EMPTY if not compressed */
+	size_t packedRow; /* First encoded row, the arrays above hold the rows before */
+	unsigned char* packed; /* Encoded blocks, followed by the padding */
+	size_t* blocks; /* Offset of each block in packed */
+} Column;
+
+struct ED_Table {
+	Column* cols;
+	size_t nCols;
+	size_t capCols;
+	size_t nRows;
+	double* data; /* Column-major values of all columns or NULL */
+	size_t nPacked; /* Number of compressed columns */
+};
+
+static uint32_t hashString(const char* s)
+{
+	/* FNV-1a */
+	uint32_t h = 2166136261U;
+	while (*s != '\0') {
+		h ^= (unsigned char)*s++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static int dictRehash(Dictionary* dict, size_t nSlots)
+{
+	uint32_t* slots = (uint32_t*)calloc(nSlots, sizeof(uint32_t));
+	size_t k;
+	if (slots == NULL) {
+		return -1;
+	}
+	for (k = 0; k < dict->n; k++) {
+		size_t s = hashString(dict->str[k]) & (nSlots - 1);
+		while (slots[s] != 0) {
+			s = (s + 1) & (nSlots - 1);
+		}
+		slots[s] = (uint32_t)(k + 1);
+	}
+	free(dict->slots);
+	dict->slots = slots;
+	dict->nSlots = nSlots;
+	return 0;
+}
+
+/* Return the code of str (added if new) or 0 on failure */
+static uint32_t dictAdd(Dictionary* dict, const char* str)
+{
+	size_t s;
+	size_t len;
+	char* copy;
+
+	if (2*(dict->n + 1) > dict->nSlots) {
+		if (dict->n >= UINT32_MAX - 1 ||
+			0 != dictRehash(dict, dict->nSlots > 0 ? 2*dict->nSlots : 64)) {
+			return 0;
+		}
+	}
+	s = hashString(str) & (dict->nSlots - 1);
+	while (dict->slots[s] != 0) {
+		if (0 == strcmp(dict->str[dict->slots[s] - 1], str)) {
+			return dict->slots[s];
+		}
+		s = (s + 1) & (dict->nSlots - 1);
+	}
+	if (dict->n == dict->cap) {
+		size_t cap = dict->cap > 0 ? 2*dict->cap : 16;
+		char** tmp = (char**)realloc(dict->str, cap*sizeof(char*));
+		if (tmp == NULL) {
+			return 0;
+		}
+		dict->str = tmp;
+		dict->cap = cap;
+	}
+	len = strlen(str);
+	copy = (char*)malloc(len + 1);
+	if (copy == NULL) {
+		return 0;
+	}
+	memcpy(copy, str, len + 1);
+	dict->str[dict->n++] = copy;
+	dict->slots[s] = (uint32_t)dict->n;
+	return (uint32_t)dict->n;
+}
+
+static void dictFree(Dictionary* dict)
+{
+	size_t k;
+	for (k = 0; k < dict->n; k++) {
+		free(dict->str[k]);
+	}
+	free(dict->str);
+	free(dict->slots);
+}
+
+static int isPacked(const Column* c, size_t row)
+{
+	return c->packedType != ED_TABLE_EMPTY && row >= c->packedRow;
+}
+
+static int isPresent(const Column* c, size_t row)
+{
+	return row < c->nRows && (c->valid == NULL || isPacked(c, row) ||
+		(c->valid[row >> 3] >> (row & 7)) & 1);
+}
+
+static int isText(const Column* c, size_t row)
+{
+	return c->codes != NULL && !isPacked(c, row) && c->codes[row] != 0;
+}
+
+/* Value of the cell row that is not encoded, returns 0 if it is missing or
+ * text
+ */
+static int getCell(const Column* c, size_t row, double* val)
+{
+	if (isPresent(c, row) && !isText(c, row)) {
+		*val = c->f64 != NULL ? c->f64[row] : (double)c->i64[row];
+		return 1;
+	}
+	*val = 0.;
+	return 0;
+}
+
+static int numericType(const Column* c)
+{
+	if (c->packedType != ED_TABLE_EMPTY) {
+		return c->packedType;
+	}
+	return c->i64 != NULL ? ED_TABLE_INT64 : ED_TABLE_FLOAT64;
+}
+
+static int isIntegral(double val)
+{
+	static const double zero = 0.;
+	if (val >= -ED_TABLE_MAX_EXACT && val <= ED_TABLE_MAX_EXACT &&
+		(double)(int64_t)val == val) {
+		/* Keep the sign of -0 */
+		return val != 0. || 0 == memcmp(&val, &zero, sizeof(double));
+	}
+	return 0;
+}
+
+/* Grow the arrays of c to hold the cell row */
+static int growColumn(Column* c, size_t row)
+{
+	size_t cap;
+	if (row < c->cap) {
+		return 0;
+	}
+	cap = c->cap > 0 ? 2*c->cap : ED_TABLE_MIN_ROWS;
+	if (cap <= row) {
+		cap = row + 1;
+	}
+	if (c->f64 != NULL) {
+		double* tmp = (double*)realloc(c->f64, cap*sizeof(double));
+		if (tmp == NULL) {
+			return -1;
+		}
+		c->f64 = tmp;
+	}
+	if (c->i64 != NULL) {
+		int64_t* tmp = (int64_t*)realloc(c->i64, cap*sizeof(int64_t));
+		if (tmp == NULL) {
+			return -1;
+		}
+		c->i64 = tmp;
+	}
+	if (c->codes != NULL) {
+		uint32_t* tmp = (uint32_t*)realloc(c->codes, cap*sizeof(uint32_t));
+		if (tmp == NULL) {
+			return -1;
+		}
+		memset(tmp + c->cap, 0, (cap - c->cap)*sizeof(uint32_t));
+		c->codes = tmp;
+	}
+	{
+		size_t oldBytes = (c->cap + 7)/8;
+		size_t bytes = (cap + 7)/8;
+		unsigned char* tmp = (unsigned char*)realloc(c->valid, bytes);
+		if (tmp == NULL) {
+			return -1;
+		}
+		memset(tmp + oldBytes, 0, bytes - oldBytes);
+		c->valid = tmp;
+	}
+	c->cap = cap;
+	return 0;
+}
+
+/* Return the column col, added if new, or NULL on failure */
+static Column* getColumn(ED_Table* table, size_t row, size_t col)
+{
+	Column* c;
+	if (table->data != NULL || table->nPacked > 0) {
+		/* Columns are slices of the table data or encoded */
+		errno = EINVAL;
+		return NULL;
+	}
+	if (col >= table->capCols) {
+		size_t cap = table->capCols > 0 ? 2*table->capCols : 16;
+		Column* tmp;
+		if (cap <= col) {
+			cap = col + 1;
+		}
+		tmp = (Column*)realloc(table->cols, cap*sizeof(Column));
+		if (tmp == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		memset(tmp + table->capCols, 0, (cap - table->capCols)*sizeof(Column));
+		table->cols = tmp;
+		table->capCols = cap;
+	}
+	c = &table->cols[col];
+	if (0 != growColumn(c, row)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	if (col >= table->nCols) {
+		table->nCols = col + 1;
+	}
+	if (row >= table->nRows) {
+		table->nRows = row + 1;
+	}
+	if (row >= c->nRows) {
+		c->nRows = row + 1;
+	}
+	return c;
+}
+
+/* Forget the previous value of the cell row */
+static void clearCell(Column* c, size_t row)
+{
+	if ((c->valid[row >> 3] >> (row & 7)) & 1) {
+		if (isText(c, row)) {
+			c->codes[row] = 0;
+			c->nText--;
+		}
+		else {
+			c->nNumeric--;
+		}
+	}
+	c->valid[row >> 3] |= (unsigned char)(1 << (row & 7));
+}
+
+/* Bits are written and read most significant first */
+static void writeBits(unsigned char* buf, size_t* pos, uint64_t v, unsigned n)
+{
+	while (n > 0) {
+		const unsigned room = 8 - (unsigned)(*pos & 7);
+		const unsigned k = n < room ? n : room;
+		const unsigned bits = (unsigned)(v >> (n - k)) & ((1U << k) - 1);
+		buf[*pos >> 3] |= (unsigned char)(bits << (room - k));
+		*pos += k;
+		n -= k;
+	}
+}
+
+static uint64_t load64(const unsigned char* p)
+{
+	return (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 |
+		(uint64_t)p[3] << 32 | (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 |
+		(uint64_t)p[6] << 8 | (uint64_t)p[7];
+}
+
+/* The decoders hold the next count bits of a block in bits, most
+ * significant first. ED_TABLE_REFILL tops them up to at least 56 bits
+ * without a branch, such that the load does not wait for the bits taken
+ * before. It reads up to 15 bytes past the bits taken, hence the padding.
+ * At most 56 bits can be taken between refills.
+ */
+#define ED_TABLE_REFILL(p, bits, count) \
+	(bits) |= load64(p) >> (count); \
+	(p) += (63 - (count)) >> 3; \
+	(count) |= 56
+
+/* Take 0 <= n <= 56 bits */
+#define ED_TABLE_SKIP(bits, count, n) \
+	(bits) <<= (n); \
+	(count) -= (n)
+
+static unsigned leadingZeros(uint64_t x)
+{
+	unsigned n = 0;
+	while (!(x >> 63)) {
+		x <<= 1;
+		n++;
+	}
+	return n;
+}
+
+static unsigned trailingZeros(uint64_t x)
+{
+	unsigned n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+}
+
+/* Encode len > 0 float64 values by the XOR with the previous value (as in
+ * Gorilla): 0 if equal, else 10 and the meaningful bits if these fit into
+ * the previous window, else 11, 5 bits of the leading zeros, 6 bits of the
+ * number of meaningful bits - 1 and the meaningful bits. Returns the number
+ * of bits written to buf, which is zeroed.
+ */
+static size_t encodeFloat64(const double* val, size_t len, unsigned char* buf)
+{
+	size_t pos = 0;
+	size_t i;
+	uint64_t prev;
+	unsigned lead = 65; /* No window yet */
+	unsigned trail = 0;
+	memcpy(&prev, &val[0], sizeof(uint64_t));
+	writeBits(buf, &pos, prev, 64);
+	for (i = 1; i < len; i++) {
+		uint64_t cur;
+		uint64_t x;
+		memcpy(&cur, &val[i], sizeof(uint64_t));
+		x = cur ^ prev;
+		prev = cur;
+		if (x == 0) {
+			writeBits(buf, &pos, 0, 1);
+		}
+		else {
+			unsigned l = leadingZeros(x);
+			unsigned t = trailingZeros(x);
+			if (l > 31) {
+				l = 31;
+			}
+			if (l >= lead && t >= trail) {
+				writeBits(buf, &pos, 2, 2);
+				writeBits(buf, &pos, x >> trail, 64 - lead - trail);
+			}
+			else {
+				writeBits(buf, &pos, 3, 2);
+				writeBits(buf, &pos, l, 5);
+				writeBits(buf, &pos, 63 - l - t, 6);
+				writeBits(buf, &pos, x >> t, 64 - l - t);
+				lead = l;
+				trail = t;
+			}
+		}
+	}
+	return pos;
+}
+
+/* Prefix length of the float64 values by the next 2 bits ctl (1, 1, 2 or
+ * 13), looked up in a register rather than in memory
+ */
+#define ED_TABLE_XOR_PREFIX(ctl) ((0x0D020101UL >> 8*(ctl)) & 0xFF)
+
+/* Decode the values [0, first + len) of a block of float64 values and store
+ * the values from first on in dst with stride
+ */
+static void decodeFloat64(const unsigned char* buf, size_t first, size_t len, double* dst, size_t stride)
+{
+	const unsigned char* p = buf;
+	uint64_t bits = 0;
+	unsigned count = 0;
+	uint64_t v;
+	unsigned shift = 0;
+	unsigned width = 64;
+	const size_t end = first + len;
+	size_t i;
+	ED_TABLE_REFILL(p, bits, count);
+	v = bits >> 32 << 32;
+	ED_TABLE_SKIP(bits, count, 32);
+	ED_TABLE_REFILL(p, bits, count);
+	v |= bits >> 32;
+	ED_TABLE_SKIP(bits, count, 32);
+	if (first == 0) {
+		memcpy(dst, &v, sizeof(double));
+		dst += stride;
+	}
+	for (i = 1; i < end; i++) {
+		unsigned ctl;
+		uint64_t mask;
+		ED_TABLE_REFILL(p, bits, count);
+		ctl = (unsigned)(bits >> 62);
+		if (ctl == 3) {
+			/* New window */
+			width = (unsigned)(bits >> 51 & 63) + 1;
+			shift = 64 - (unsigned)(bits >> 57 & 31) - width;
+		}
+		mask = 0 - (uint64_t)(ctl >> 1);
+		ED_TABLE_SKIP(bits, count, ED_TABLE_XOR_PREFIX(ctl));
+		ED_TABLE_REFILL(p, bits, count);
+		if (width > 56) {
+			v ^= (bits >> 32 << (width - 32 + shift)) & mask;
+			ED_TABLE_SKIP(bits, count, 32 & (unsigned)mask);
+			ED_TABLE_REFILL(p, bits, count);
+			v ^= (bits >> (96 - width) << shift) & mask;
+			ED_TABLE_SKIP(bits, count, (width - 32) & (unsigned)mask);
+		}
+		else {
+			v ^= (bits >> (64 - width) << shift) & mask;
+			ED_TABLE_SKIP(bits, count, width & (unsigned)mask);
+		}
+		if (i >= first) {
+			memcpy(dst, &v, sizeof(double));
+			dst += stride;
+		}
+	}
+}
+
+/* Classes of the zigzag-encoded differences of consecutive differences of
+ * int64 values: 0, 10 and 7 bits, 110 and 9 bits, 1110 and 16 bits, 11110
+ * and 32 bits, 11111 and 64 bits
+ */
+static const unsigned char dodPrefix[6] = {1, 2, 3, 4, 5, 5};
+static const unsigned char dodWidth[6] = {0, 7, 9, 16, 32, 64};
+
+/* Prefix length and width of the class by the next 5 bits, such that the
+ * decoder looks up a single table
+ */
+static const unsigned char dodPrefixByBits[32] = {
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 5, 5
+};
+static const unsigned char dodWidthByBits[32] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	7, 7, 7, 7, 7, 7, 7, 7, 9, 9, 9, 9, 16, 16, 32, 64
+};
+
+/* Encode len > 0 int64 values by the differences of consecutive
+ * differences (as in Gorilla), the first difference is taken to 0.
+ * Returns the number of bits written to buf, which is zeroed.
+ */
+static size_t encodeInt64(const int64_t* val, size_t len, unsigned char* buf)
+{
+	size_t pos = 0;
+	size_t i;
+	uint64_t delta = 0;
+	writeBits(buf, &pos, (uint64_t)val[0], 64);
+	for (i = 1; i < len; i++) {
+		const uint64_t d = (uint64_t)val[i] - (uint64_t)val[i - 1];
+		const uint64_t dod = d - delta;
+		const uint64_t z = (dod << 1) ^ (0 - (dod >> 63));
+		unsigned k = 0;
+		while (k < 5 && (k == 0 ? z != 0 : z >> dodWidth[k] != 0)) {
+			k++;
+		}
+		writeBits(buf, &pos, (1U << dodPrefix[k]) - 2 + (k == 5), dodPrefix[k]);
+		if (k > 0) {
+			writeBits(buf, &pos, z, dodWidth[k]);
+		}
+		delta = d;
+	}
+	return pos;
+}
+
+/* Decode the values [0, first + len) of a block of int64 values and store
+ * the values from first on as double in dst with stride
+ */
+static void decodeInt64(const unsigned char* buf, size_t first, size_t len, double* dst, size_t stride)
+{
+	const unsigned char* p = buf;
+	uint64_t bits = 0;
+	unsigned count = 0;
+	uint64_t v;
+	uint64_t delta = 0;
+	const size_t end = first + len;
+	size_t i;
+	ED_TABLE_REFILL(p, bits, count);
+	v = bits >> 32 << 32;
+	ED_TABLE_SKIP(bits, count, 32);
+	ED_TABLE_REFILL(p, bits, count);
+	v |= bits >> 32;
+	ED_TABLE_SKIP(bits, count, 32);
+	if (first == 0) {
+		*dst = (double)(int64_t)v;
+		dst += stride;
+	}
+	for (i = 1; i < end; i++) {
+		size_t k;
+		unsigned width;
+		ED_TABLE_REFILL(p, bits, count);
+		k = (size_t)(bits >> 59);
+		width = dodWidthByBits[k];
+		ED_TABLE_SKIP(bits, count, dodPrefixByBits[k]);
+		if (width > 0) {
+			uint64_t z;
+			if (width < 64) {
+				z = bits >> (64 - width);
+				ED_TABLE_SKIP(bits, count, width);
+			}
+			else {
+				z = bits >> 32 << 32;
+				ED_TABLE_SKIP(bits, count, 32);
+				ED_TABLE_REFILL(p, bits, count);
+				z |= bits >> 32;
+				ED_TABLE_SKIP(bits, count, 32);
+			}
+			delta += (z >> 1) ^ (0 - (z & 1));
+		}
+		v += delta;
+		if (i >= first) {
+			*dst = (double)(int64_t)v;
+			dst += stride;
+		}
+	}
+}
+
+/* Decode the encoded rows [row, row + len) of c, which lie in one block.
+ * The blocks are aligned to multiples of ED_TABLE_BLOCK_ROWS, the first
+ * block starts at packedRow.
+ */
+static void decodeRows(const Column* c, size_t row, size_t len, double* dst, size_t stride)
+{
+	const size_t b = row/ED_TABLE_BLOCK_ROWS;
+	const size_t start = b*ED_TABLE_BLOCK_ROWS > c->packedRow ? b*ED_TABLE_BLOCK_ROWS : c->packedRow;
+	const unsigned char* buf = c->packed + c->blocks[b - c->packedRow/ED_TABLE_BLOCK_ROWS];
+	if (c->packedType == ED_TABLE_INT64) {
+		decodeInt64(buf, row - start, len, dst, stride);
+	}
+	else {
+		decodeFloat64(buf, row - start, len, dst, stride);
+	}
+}
+
+/* Shrink the array p to size > 0 bytes, kept as it is on failure */
+static void* shrinkArray(void* p, size_t size)
+{
+	void* tmp = p != NULL ? realloc(p, size) : NULL;
+	return tmp != NULL ? tmp : p;
+}
+
+/* Encode the numeric values of c from the row after the last missing or
+ * text cell on, if this is smaller. Returns 1 if encoded, 0 if not or -1
+ * on failure.
+ */
+static int packColumn(Column* c, unsigned char* scratch)
+{
+	size_t head = c->nRows;
+	size_t b0;
+	size_t nBlocks;
+	size_t plain;
+	unsigned char* packed = NULL;
+	size_t size = 0;
+	size_t cap = 0;
+	size_t b;
+	size_t* blocks;
+	while (head > 0 && isPresent(c, head - 1) && !isText(c, head - 1)) {
+		head--;
+	}
+	if (head == c->nRows) {
+		return 0;
+	}
+	b0 = head/ED_TABLE_BLOCK_ROWS;
+	nBlocks = (c->nRows - 1)/ED_TABLE_BLOCK_ROWS + 1 - b0;
+	plain = (c->nRows - head)*sizeof(double);
+	blocks = (size_t*)malloc(nBlocks*sizeof(size_t));
+	if (blocks == NULL) {
+		return -1;
+	}
+	for (b = 0; b < nBlocks; b++) {
+		const size_t end = (b0 + b + 1)*ED_TABLE_BLOCK_ROWS < c->nRows ?
+			(b0 + b + 1)*ED_TABLE_BLOCK_ROWS : c->nRows;
+		const size_t row = b == 0 ? head : (b0 + b)*ED_TABLE_BLOCK_ROWS;
+		size_t bytes;
+		memset(scratch, 0, ED_TABLE_BLOCK_BYTES);
+		bytes = (7 + (c->i64 != NULL ? encodeInt64(c->i64 + row, end - row, scratch) :
+			encodeFloat64(c->f64 + row, end - row, scratch)))/8;
+		if (size + bytes + ED_TABLE_PADDING >= plain) {
+			/* Not smaller */
+			free(packed);
+			free(blocks);
+			return 0;
+		}
+		if (size + bytes + ED_TABLE_PADDING > cap) {
+			unsigned char* tmp;
+			cap = 2*cap > size + bytes + ED_TABLE_PADDING ? 2*cap : size + bytes + ED_TABLE_PADDING;
+			if (cap > plain) {
+				cap = plain;
+			}
+			tmp = (unsigned char*)realloc(packed, cap);
+			if (tmp == NULL) {
+				free(packed);
+				free(blocks);
+				return -1;
+			}
+			packed = tmp;
+		}
+		memcpy(packed + size, scratch, bytes);
+		blocks[b] = size;
+		size += bytes;
+	}
+	memset(packed + size, 0, ED_TABLE_PADDING);
+	c->packed = (unsigned char*)shrinkArray(packed, size + ED_TABLE_PADDING);
+	c->blocks = blocks;
+	c->packedType = c->i64 != NULL ? ED_TABLE_INT64 : ED_TABLE_FLOAT64;
+	c->packedRow = head;
+	if (head > 0) {
+		/* Keep the cells before */
+		c->f64 = (double*)shrinkArray(c->f64, head*sizeof(double));
+		c->i64 = (int64_t*)shrinkArray(c->i64, head*sizeof(int64_t));
+		c->codes = (uint32_t*)shrinkArray(c->codes, head*sizeof(uint32_t));
+		c->valid = (unsigned char*)shrinkArray(c->valid, (head + 7)/8);
+	}
+	else {
+		free(c->f64);
+		free(c->i64);
+		free(c->valid);
+		free(c->codes);
+		dictFree(&c->dict);
+		c->f64 = NULL;
+		c->i64 = NULL;
+		c->valid = NULL;
+		c->codes = NULL;
+		memset(&c->dict, 0, sizeof(Dictionary));
+	}
+	c->cap = head;
+	return 1;
+}
+
+ED_Table* ED_tableCreate(void)
+{
+	ED_Table* table = (ED_Table*)calloc(1, sizeof(ED_Table));
+	if (table == NULL) {
+		errno = ENOMEM;
+	}
+	return table;
+}
+
+ED_Table* ED_tableCreateColumnMajor(double* data, size_t nRows, size_t nCols)
+{
+	ED_Table* table = (ED_Table*)calloc(1, sizeof(ED_Table));
+	size_t j;
+	if (table != NULL && nCols > 0) {
+		table->cols = (Column*)calloc(nCols, sizeof(Column));
+		if (table->cols == NULL) {
+			free(table);
+			table = NULL;
+		}
+	}
+	if (table == NULL) {
+		free(data);
+		errno = ENOMEM;
+		return NULL;
+	}
+	table->data = data;
+	table->nRows = nRows;
+	table->nCols = nCols;
+	table->capCols = nCols;
+	for (j = 0; j < nCols; j++) {
+		Column* c = &table->cols[j];
+		c->nRows = nRows;
+		c->cap = nRows;
+		c->nNumeric = nRows;
+		c->f64 = data + j*nRows;
+		c->view = 1;
+	}
+	return table;
+}
+
+void ED_tableFree(ED_Table* table)
+{
+	if (table != NULL) {
+		size_t j;
+		for (j = 0; j < table->nCols; j++) {
+			Column* c = &table->cols[j];
+			if (!c->view) {
+				free(c->f64);
+				free(c->i64);
+				free(c->valid);
+				free(c->codes);
+				dictFree(&c->dict);
+				free(c->packed);
+				free(c->blocks);
+			}
+		}
+		free(table->cols);
+		free(table->data);
+		free(table);
+	}
+}
+
+int ED_tableSetDouble(ED_Table* table, size_t row, size_t col, double val)
+{
+	Column* c = getColumn(table, row, col);
+	if (c == NULL) {
+		return -1;
+	}
+	if (c->i64 == NULL && c->f64 == NULL) {
+		/* First numeric cell */
+		if (isIntegral(val)) {
+			c->i64 = (int64_t*)malloc(c->cap*sizeof(int64_t));
+		}
+		else {
+			c->f64 = (double*)malloc(c->cap*sizeof(double));
+		}
+		if (c->i64 == NULL && c->f64 == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+	else if (c->i64 != NULL && !isIntegral(val)) {
+		/* Promote to float64 */
+		size_t i;
+		c->f64 = (double*)malloc(c->cap*sizeof(double));
+		if (c->f64 == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		for (i = 0; i < c->nRows; i++) {
+			if (isPresent(c, i) && !isText(c, i)) {
+				c->f64[i] = (double)c->i64[i];
+			}
+		}
+		free(c->i64);
+		c->i64 = NULL;
+	}
+	clearCell(c, row);
+	if (c->i64 != NULL) {
+		c->i64[row] = (int64_t)val;
+	}
+	else {
+		c->f64[row] = val;
+	}
+	c->nNumeric++;
+	return 0;
+}
+
+int ED_tableSetString(ED_Table* table, size_t row, size_t col, const char* str)
+{
+	uint32_t code;
+	Column* c = getColumn(table, row, col);
+	if (c == NULL) {
+		return -1;
+	}
+	if (c->codes == NULL) {
+		c->codes = (uint32_t*)calloc(c->cap, sizeof(uint32_t));
+		if (c->codes == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+	code = dictAdd(&c->dict, str);
+	if (code == 0) {
+		errno = ENOMEM;
+		return -1;
+	}
+	clearCell(c, row);
+	c->codes[row] = code;
+	c->nText++;
+	return 0;
+}
+
+size_t ED_tableRows(const ED_Table* table)
+{
+	return table->nRows;
+}
+
+size_t ED_tableCols(const ED_Table* table)
+{
+	return table->nCols;
+}
+
+int ED_tableColumnType(const ED_Table* table, size_t col)
+{
+	if (col < table->nCols) {
+		const Column* c = &table->cols[col];
+		if (c->nNumeric > 0) {
+			return numericType(c);
+		}
+		if (c->nText > 0) {
+			return ED_TABLE_STRING;
+		}
+	}
+	return ED_TABLE_EMPTY;
+}
+
+int ED_tableCellType(const ED_Table* table, size_t row, size_t col)
+{
+	if (col < table->nCols) {
+		const Column* c = &table->cols[col];
+		if (isPresent(c, row)) {
+			if (isText(c, row)) {
+				return ED_TABLE_STRING;
+			}
+			return numericType(c);
+		}
+	}
+	return ED_TABLE_EMPTY;
+}
+
+const double* ED_tableColumnSlice(const ED_Table* table, size_t col, size_t row, size_t len)
+{
+	if (col < table->nCols) {
+		const Column* c = &table->cols[col];
+		if (c->f64 != NULL && c->packedType == ED_TABLE_EMPTY && row <= c->nRows && len <= c->nRows - row) {
+			if (c->nNumeric < c->nRows) {
+				size_t i;
+				for (i = row; i < row + len; i++) {
+					if (!isPresent(c, i) || isText(c, i)) {
+						return NULL;
+					}
+				}
+			}
+			return c->f64 + row;
+		}
+	}
+	return NULL;
+}
+
+const char* ED_tableGetString(const ED_Table* table, size_t row, size_t col)
+{
+	if (col < table->nCols) {
+		const Column* c = &table->cols[col];
+		if (isPresent(c, row) && isText(c, row)) {
+			return c->dict.str[c->codes[row] - 1];
+		}
+	}
+	return NULL;
+}
+
+size_t ED_tableGetDoubleArray2D(const ED_Table* table, size_t row, size_t col, size_t m, size_t n, double* a)
+{
+	size_t nInvalid = 0;
+	size_t tile;
+	size_t mt;
+	size_t i0;
+
+	if (m == 0 || n == 0) {
+		return 0;
+	}
+	tile = ED_TABLE_TILE_SIZE/(n*sizeof(double));
+	if (tile == 0) {
+		tile = 1;
+	}
+	if (table->nPacked > 0) {
+		/* Tiles are the blocks, such that each touched block is decoded once */
+		tile = ED_TABLE_BLOCK_ROWS;
+	}
+	for (i0 = 0; i0 < m; i0 += mt) {
+		const size_t r0 = row + i0;
+		size_t j;
+		mt = m - i0 < tile ? m - i0 : tile;
+		if (table->nPacked > 0 && mt > ED_TABLE_BLOCK_ROWS - r0 % ED_TABLE_BLOCK_ROWS) {
+			mt = ED_TABLE_BLOCK_ROWS - r0 % ED_TABLE_BLOCK_ROWS;
+		}
+		for (j = 0; j < n; j++) {
+			double* dst = a + i0*n + j;
+			const Column* c = col + j < table->nCols ? &table->cols[col + j] : NULL;
+			size_t i;
+			if (c != NULL && c->packedType != ED_TABLE_EMPTY) {
+				/* Rows [head, to) of the tile are encoded, the rows before are
+				 * kept as they are and the rows past the column are missing
+				 */
+				const size_t to = r0 >= c->nRows ? 0 : mt < c->nRows - r0 ? mt : c->nRows - r0;
+				const size_t head = r0 >= c->packedRow ? 0 : mt < c->packedRow - r0 ? mt : c->packedRow - r0;
+				for (i = 0; i < head; i++) {
+					nInvalid += !getCell(c, r0 + i, &dst[i*n]);
+				}
+				if (head < to) {
+					decodeRows(c, r0 + head, to - head, dst + head*n, n);
+				}
+				for (i = head > to ? head : to; i < mt; i++) {
+					dst[i*n] = 0.;
+					nInvalid++;
+				}
+			}
+			else if (c != NULL && c->nNumeric == c->nRows && r0 < c->nRows && mt <= c->nRows - r0) {
+				/* All cells are numeric */
+				if (c->f64 != NULL) {
+					const double* src = c->f64 + r0;
+					for (i = 0; i < mt; i++) {
+						dst[i*n] = src[i];
+					}
+				}
+				else {
+					const int64_t* src = c->i64 + r0;
+					for (i = 0; i < mt; i++) {
+						dst[i*n] = (double)src[i];
+					}
+				}
+			}
+			else {
+				for (i = 0; i < mt; i++) {
+					if (c == NULL) {
+						dst[i*n] = 0.;
+						nInvalid++;
+					}
+					else {
+						nInvalid += !getCell(c, r0 + i, &dst[i*n]);
+					}
+				}
+			}
+		}
+	}
+	return nInvalid;
+}
+
+size_t ED_tableCompress(ED_Table* table)
+{
+	unsigned char* scratch;
+	size_t j;
+	if (table->data != NULL) {
+		/* Columns are slices of the table data */
+		return table->nPacked;
+	}
+	scratch = (unsigned char*)malloc(ED_TABLE_BLOCK_BYTES);
+	if (scratch == NULL) {
+		return table->nPacked;
+	}
+	for (j = 0; j < table->nCols; j++) {
+		Column* c = &table->cols[j];
+		if (!c->view && c->packedType == ED_TABLE_EMPTY && c->nNumeric > 0 &&
+			1 == packColumn(c, scratch)) {
+			table->nPacked++;
+		}
+	}
+	free(scratch);
+	return table->nPacked;
+}
+
+int ED_tableCompressionEnabled(void)
+{
+	const char* env = getenv("EXTERNDATA_TABLE_COMPRESS");
+	return env != NULL && 0 == strcmp(env, "1");
+}
@@ -0,0 +1,108 @@
+/* ED_table.h - Typed columnar tables
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_TABLE_H)
+#define ED_TABLE_H
+
+#include <stdlib.h>
+
+/* In-memory table of typed columns shared by the tabular formats. A cell
+ * is missing, numeric or text. The numeric cells of a column are stored
+ * as int64 while all of them are integral and as float64 otherwise, the
+ * text cells as codes into the dictionary of the column, so that repeated
+ * labels are stored once. The present cells are marked in the validity
+ * bitmap of the column. A column can hold numeric and text cells, e.g. a
+ * header line.
+ */
+
+/* Column and cell types */
+enum {
+	ED_TABLE_EMPTY = 0, /* Missing cell or column without cells */
+	ED_TABLE_INT64,
+	ED_TABLE_FLOAT64,
+	ED_TABLE_STRING /* Text cell or column with text cells only */
+};
+
+typedef struct ED_Table ED_Table;
+
+/* Create an empty table, which grows with the cells set. Returns NULL and
+ * sets errno on failure.
+ */
+ED_Table* ED_tableCreate(void);
+
+/* Create a table of nRows x nCols float64 values stored in column-major
+ * order (as in MAT-files), whose columns are slices of data without
+ * copying. Ownership of data passes to the table, also on failure. The
+ * cells of such a table cannot be set. Returns NULL and sets errno on
+ * failure.
+ */
+ED_Table* ED_tableCreateColumnMajor(double* data, size_t nRows, size_t nCols);
+void ED_tableFree(ED_Table* table);
+
+/* Set the cell (row, col) to a numeric value or a copy of the text str.
+ * Returns 0 on success or -1 and sets errno on failure.
+ */
+int ED_tableSetDouble(ED_Table* table, size_t row, size_t col, double val);
+int ED_tableSetString(ED_Table* table, size_t row, size_t col, const char* str);
+
+size_t ED_tableRows(const ED_Table* table);
+size_t ED_tableCols(const ED_Table* table);
+int ED_tableColumnType(const ED_Table* table, size_t col);
+int ED_tableCellType(const ED_Table* table, size_t row, size_t col);
+
+/* Values of the rows [row, row + len) of a float64 column without
+ * copying, or NULL if the column is not of type float64 or any of the
+ * cells is not numeric
+ */
+const double* ED_tableColumnSlice(const ED_Table* table, size_t col, size_t row, size_t len);
+
+/* Text of a text cell or NULL */
+const char* ED_tableGetString(const ED_Table* table, size_t row, size_t col);
+
+/* Copy the m x n block of cells starting at (row, col) as double values in
+ * row-major order into a. Missing and text cells are set to 0. Returns the
+ * number of such cells, i.e. 0 if all cells of the block are numeric.
+ */
+size_t ED_tableGetDoubleArray2D(const ED_Table* table, size_t row, size_t col, size_t m, size_t n, double* a);
+
+/* Encode the numeric cells of each column that follow its last missing or
+ * text cell (e.g. a header line) in blocks of 1024 rows, the float64 values
+ * by the XOR of consecutive values and the int64 values by the differences
+ * of consecutive differences, where this is smaller than the plain values.
+ * Each block starts afresh, so that a block read decodes the touched blocks
+ * only. The cells of a compressed table cannot be set and
+ * ED_tableColumnSlice returns NULL for compressed columns. Returns the
+ * number of compressed columns, columns that cannot be encoded for lack of
+ * memory are kept as they are.
+ */
+size_t ED_tableCompress(ED_Table* table);
+
+/* 1 if the environment variable EXTERNDATA_TABLE_COMPRESS is set to 1, i.e.
+ * the cached tables of the file handles are to be compressed
+ */
+int ED_tableCompressionEnabled(void);
+
+#endif
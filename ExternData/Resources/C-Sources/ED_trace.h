@@ -0,0 +1,80 @@
+/* ED_trace.h - Static tracepoints
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_TRACE_H)
+#define ED_TRACE_H
+
+/* USDT (user-level statically defined tracing) probes of the provider
+ * externdata, which bpftrace, perf or SystemTap attach to in a running
+ * process, e.g.
+ *
+ *   bpftrace -e 'usdt:./libED_XMLFile.so:externdata:parse__end
+ *     { printf("%s %s %d\n", str(arg0), str(arg1), arg2); }'
+ *
+ * An untraced probe is a single nop, its arguments stay in registers or
+ * memory without being evaluated by extra code. The probes are compiled in
+ * if <sys/sdt.h> of SystemTap is available and ED_NO_USDT is not defined,
+ * otherwise they expand to nothing.
+ *
+ * create__begin(kind, fileName)     Constructor of the handle of kind
+ * create__end(kind, fileName, obj)  Handle obj is created
+ * destroy(kind, fileName)           Handle is destroyed
+ * parse__begin(phase, fileName)     Parse phase (e.g. "XmlParser_parse")
+ * parse__end(phase, fileName, len)  Parse phase done, len bytes parsed
+ *                                   (0 if not known)
+ * get__begin(fileName, key)         Getter of the value of key
+ * get__end(fileName, key, n)        Getter done, n values read
+ *
+ * Strings are const char*, counts are size_t. The end probes are not hit
+ * if an error is raised.
+ */
+
+#if !defined(ED_NO_USDT) && !defined(ED_USDT) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define ED_USDT 1
+#endif
+#endif
+
+#if defined(ED_USDT)
+#include <sys/sdt.h>
+#define ED_TRACE_CREATE_BEGIN(kind, fileName) DTRACE_PROBE2(externdata, create__begin, kind, fileName)
+#define ED_TRACE_CREATE_END(kind, fileName, obj) DTRACE_PROBE3(externdata, create__end, kind, fileName, obj)
+#define ED_TRACE_DESTROY(kind, fileName) DTRACE_PROBE2(externdata, destroy, kind, fileName)
+#define ED_TRACE_PARSE_BEGIN(phase, fileName) DTRACE_PROBE2(externdata, parse__begin, phase, fileName)
+#define ED_TRACE_PARSE_END(phase, fileName, len) DTRACE_PROBE3(externdata, parse__end, phase, fileName, (size_t)(len))
+#define ED_TRACE_GET_BEGIN(fileName, key) DTRACE_PROBE2(externdata, get__begin, fileName, key)
+#define ED_TRACE_GET_END(fileName, key, n) DTRACE_PROBE3(externdata, get__end, fileName, key, (size_t)(n))
+#else
+#define ED_TRACE_CREATE_BEGIN(kind, fileName) ((void)0)
+#define ED_TRACE_CREATE_END(kind, fileName, obj) ((void)0)
+#define ED_TRACE_DESTROY(kind, fileName) ((void)0)
+#define ED_TRACE_PARSE_BEGIN(phase, fileName) ((void)0)
+#define ED_TRACE_PARSE_END(phase, fileName, len) ((void)0)
+#define ED_TRACE_GET_BEGIN(fileName, key) ((void)0)
+#define ED_TRACE_GET_END(fileName, key, n) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,337 @@
+/* ED_trim.c - Release of parse structures of idle handles
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE_CC__)
+#include <unistd.h>
+#endif
+#if !defined(_POSIX_) && defined(_POSIX_VERSION)
+#define _POSIX_ 1
+#endif
+#if defined(_POSIX_) && !defined(_WIN32)
+#include <pthread.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "../Include/ED_trim.h"
+
+/* Shortest wait of the watchdog in seconds */
+#define ED_TRIM_MIN_WAIT (1.)
+
+struct ED_TrimEntry {
+	void* obj;
+	ED_trimFunc func;
+	time_t lastAccess;
+	int busy; /* Number of accesses in progress */
+	int loaded; /* Accessed since the last release */
+	ED_TrimEntry* next;
+};
+
+/* The registry lock protects the entries and is held while releasing, the
+ * life lock serializes start and shutdown of the watchdog
+ */
+#if defined(_WIN32)
+#define ED_TRIM_WATCHDOG 1
+static volatile LONG registryLock = 0;
+static volatile LONG lifeLock = 0;
+static void spinAcquire(volatile LONG* lock)
+{
+	while (InterlockedCompareExchange(lock, 1, 0) != 0) {
+		Sleep(1);
+	}
+}
+#define lockAcquire() spinAcquire(&registryLock)
+#define lockRelease() InterlockedExchange(&registryLock, 0)
+#define lifeLockAcquire() spinAcquire(&lifeLock)
+#define lifeLockRelease() InterlockedExchange(&lifeLock, 0)
+#elif defined(_POSIX_)
+#define ED_TRIM_WATCHDOG 1
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t lifeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+#define lockAcquire() pthread_mutex_lock(&registryLock)
+#define lockRelease() pthread_mutex_unlock(&registryLock)
+#define lifeLockAcquire() pthread_mutex_lock(&lifeLock)
+#define lifeLockRelease() pthread_mutex_unlock(&lifeLock)
+#else
+#define lockAcquire()
+#define lockRelease()
+#define lifeLockAcquire()
+#define lifeLockRelease()
+#endif
+
+static ED_TrimEntry* entries = NULL;
+
+/* Return the heap pages freed by the released structures to the system */
+static void trimHeap(void)
+{
+#if defined(__GLIBC__)
+	(void)malloc_trim(0);
+#endif
+}
+
+/* Release the structures of the idle entries, must be called with the
+ * registry lock held. Returns the time until the next entry becomes idle,
+ * or idle if there is none.
+ */
+static double releaseIdle(double idle)
+{
+	double wait = idle;
+	int released = 0;
+	time_t now = time(NULL);
+	ED_TrimEntry* iter;
+	for (iter = entries; iter != NULL; iter = iter->next) {
+		if (iter->loaded && iter->busy == 0) {
+			double t = difftime(now, iter->lastAccess);
+			if (t >= idle) {
+				iter->func(iter->obj);
+				iter->loaded = 0;
+				released = 1;
+			}
+			else if (idle - t < wait) {
+				wait = idle - t;
+			}
+		}
+	}
+	if (released) {
+		trimHeap();
+	}
+	return wait;
+}
+
+#if defined(ED_TRIM_WATCHDOG)
+
+static struct {
+	int started;
+	int stop;
+	double idle; /* Idle period in seconds */
+#if defined(_WIN32)
+	HANDLE thread;
+	HANDLE stopEvent;
+#else
+	pthread_t thread;
+#endif
+} watchdog;
+
+/* Idle period set by EXTERNDATA_TRIM_IDLE, 0 if not set */
+static double idlePeriod(void)
+{
+	const char* env = getenv("EXTERNDATA_TRIM_IDLE");
+	if (env != NULL) {
+		char* endptr;
+		double idle = strtod(env, &endptr);
+		while (isspace((unsigned char)*endptr)) {
+			endptr++;
+		}
+		if (endptr != env && *endptr == '\0' && idle > 0.) {
+			return idle;
+		}
+	}
+	return 0.;
+}
+
+static void watchdogLoop(void)
+{
+	lockAcquire();
+	while (!watchdog.stop) {
+		double wait = releaseIdle(watchdog.idle);
+		if (wait < ED_TRIM_MIN_WAIT) {
+			wait = ED_TRIM_MIN_WAIT;
+		}
+#if defined(_WIN32)
+		lockRelease();
+		(void)WaitForSingleObject(watchdog.stopEvent, (DWORD)(wait*1000.));
+		lockAcquire();
+#else
+		{
+			struct timespec ts;
+			ts.tv_sec = time(NULL) + (time_t)wait + 1;
+			ts.tv_nsec = 0;
+			(void)pthread_cond_timedwait(&wake, &registryLock, &ts);
+		}
+#endif
+	}
+	lockRelease();
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI watchdogThread(LPVOID arg)
+{
+	(void)arg;
+	watchdogLoop();
+	return 0;
+}
+#else
+static void* watchdogThread(void* arg)
+{
+	(void)arg;
+	watchdogLoop();
+	return NULL;
+}
+#endif
+
+/* Start the watchdog if an idle period is set, must be called with the
+ * life lock held
+ */
+static void startWatchdog(void)
+{
+	watchdog.idle = idlePeriod();
+	if (watchdog.idle <= 0.) {
+		return;
+	}
+	watchdog.stop = 0;
+#if defined(_WIN32)
+	watchdog.stopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (watchdog.stopEvent == NULL) {
+		return;
+	}
+	watchdog.thread = CreateThread(NULL, 0, watchdogThread, NULL, 0, NULL);
+	if (watchdog.thread == NULL) {
+		CloseHandle(watchdog.stopEvent);
+		return;
+	}
+#else
+	if (0 != pthread_create(&watchdog.thread, NULL, watchdogThread, NULL)) {
+		return;
+	}
+#endif
+	watchdog.started = 1;
+}
+
+/* Stop and join the watchdog, must be called with the life lock held */
+static void stopWatchdog(void)
+{
+	lockAcquire();
+	watchdog.stop = 1;
+#if defined(_WIN32)
+	lockRelease();
+	SetEvent(watchdog.stopEvent);
+	WaitForSingleObject(watchdog.thread, INFINITE);
+	CloseHandle(watchdog.thread);
+	CloseHandle(watchdog.stopEvent);
+#else
+	pthread_cond_broadcast(&wake);
+	lockRelease();
+	pthread_join(watchdog.thread, NULL);
+#endif
+	watchdog.started = 0;
+}
+
+#endif /* ED_TRIM_WATCHDOG */
+
+ED_TrimEntry* ED_trimRegister(void* obj, ED_trimFunc func)
+{
+	ED_TrimEntry* entry = (ED_TrimEntry*)malloc(sizeof(ED_TrimEntry));
+	if (entry == NULL) {
+		return NULL;
+	}
+	entry->obj = obj;
+	entry->func = func;
+	entry->lastAccess = time(NULL);
+	entry->busy = 0;
+	entry->loaded = 1;
+	lifeLockAcquire();
+	lockAcquire();
+	entry->next = entries;
+	entries = entry;
+	lockRelease();
+#if defined(ED_TRIM_WATCHDOG)
+	if (!watchdog.started) {
+		startWatchdog();
+	}
+#endif
+	lifeLockRelease();
+	return entry;
+}
+
+void ED_trimUnregister(ED_TrimEntry* entry)
+{
+	ED_TrimEntry** iter;
+	int empty;
+	if (entry == NULL) {
+		return;
+	}
+	lifeLockAcquire();
+	lockAcquire();
+	for (iter = &entries; *iter != NULL; iter = &(*iter)->next) {
+		if (*iter == entry) {
+			*iter = entry->next;
+			break;
+		}
+	}
+	empty = entries == NULL;
+	lockRelease();
+#if defined(ED_TRIM_WATCHDOG)
+	if (empty && watchdog.started) {
+		stopWatchdog();
+	}
+#else
+	(void)empty;
+#endif
+	lifeLockRelease();
+	free(entry);
+}
+
+void ED_trimEnter(ED_TrimEntry* entry)
+{
+	if (entry != NULL) {
+		lockAcquire();
+		entry->busy++;
+		entry->loaded = 1;
+		entry->lastAccess = time(NULL);
+		lockRelease();
+	}
+}
+
+void ED_trimLeave(ED_TrimEntry* entry)
+{
+	if (entry != NULL) {
+		lockAcquire();
+		if (entry->busy > 0) {
+			entry->busy--;
+		}
+		entry->lastAccess = time(NULL);
+		lockRelease();
+	}
+}
+
+void ED_trim(void)
+{
+	lockAcquire();
+	(void)releaseIdle(0.);
+	lockRelease();
+}
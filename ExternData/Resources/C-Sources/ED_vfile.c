@@ -0,0 +1,798 @@
+/* ED_vfile.c - Virtual file layer for plain files and archive members
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__gnu_linux__)
+#define _GNU_SOURCE 1
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE_CC__)
+#include <unistd.h>
+#endif
+#if !defined(_POSIX_) && defined(_POSIX_VERSION)
+#define _POSIX_ 1
+#endif
+#if defined(_POSIX_)
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+#include "unzip.h"
+#include "ED_zstd.h"
+#include "ED_gzip.h"
+#include "ED_vfile.h"
+
+#if !defined(ED_VFILE_BUFFER_LENGTH)
+#define ED_VFILE_BUFFER_LENGTH (65536)
+#endif
+
+/* Maximum chunk size passed to unzReadCurrentFile */
+#define ED_VFILE_MAX_CHUNK (1UL << 30)
+
+/* Number of bytes inflated ahead of sequential reads of BGZF content */
+#if !defined(ED_VFILE_READAHEAD)
+#define ED_VFILE_READAHEAD (1UL << 22)
+#endif
+
+/* File name suffix of the BGZF block index */
+#define ED_VFILE_GZI_EXT ".gzi"
+
+enum {
+	VF_MAP = 0, /* Memory-mapped plain file, stored archive member or decoded content */
+	VF_STDIO, /* Plain file if memory-mapping is not available */
+	VF_ZIP, /* Deflated archive member */
+	VF_BGZF /* BGZF content inflated on demand */
+};
+
+struct ED_VFILE {
+	int type;
+	const char* data; /* VF_MAP: Mapped content, VF_BGZF: Uncompressed content */
+	size_t size; /* VF_MAP: Size of mapped content, VF_ZIP, VF_BGZF: Uncompressed size */
+	size_t pos; /* VF_MAP, VF_ZIP, VF_BGZF: Logical read position */
+	void* base; /* VF_MAP, VF_BGZF: Aligned start address of the mapping */
+	char* mem; /* VF_MAP: Decoded content, VF_BGZF: Compressed content owned by the handle */
+	size_t baseLen; /* VF_MAP, VF_BGZF: Length of the mapping */
+	FILE* fp; /* VF_STDIO */
+	unzFile zfile; /* VF_ZIP */
+	ED_BGZF* bgzf; /* VF_BGZF */
+	char* buf; /* VF_ZIP: Inflate buffer */
+	size_t bufLen; /* VF_ZIP: Number of bytes in inflate buffer */
+	size_t bufPos; /* VF_ZIP: Read position in inflate buffer */
+	int plain; /* VF_MAP, VF_STDIO: Plain file, not an archive member or decoded */
+};
+
+static int isRegularFile(const char* fileName)
+{
+	struct stat st;
+	if (0 == stat(fileName, &st)) {
+		return (st.st_mode & S_IFMT) == S_IFREG;
+	}
+	return 0;
+}
+
+/* Map len bytes of file fileName starting at offset, len < 0 maps until EOF */
+static int mapFile(ED_VFILE* vf, const char* fileName, ZPOS64_T offset, long long len)
+{
+#if defined(_WIN32)
+	HANDLE hFile;
+	HANDLE hMap;
+	LARGE_INTEGER fileSize;
+	SYSTEM_INFO si;
+	ZPOS64_T alignedOffset;
+	void* base;
+
+	hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		errno = ENOENT;
+		return 1;
+	}
+	if (!GetFileSizeEx(hFile, &fileSize) || (ZPOS64_T)fileSize.QuadPart < offset) {
+		CloseHandle(hFile);
+		errno = EIO;
+		return 1;
+	}
+	if (len < 0) {
+		len = (long long)((ZPOS64_T)fileSize.QuadPart - offset);
+	}
+	else if ((ZPOS64_T)len > (ZPOS64_T)fileSize.QuadPart - offset) {
+		/* Range beyond the end of the file, e.g. of a truncated archive */
+		CloseHandle(hFile);
+		errno = EIO;
+		return 1;
+	}
+	if (len == 0) {
+		CloseHandle(hFile);
+		vf->data = "";
+		vf->size = 0;
+		vf->base = NULL;
+		vf->baseLen = 0;
+		return 0;
+	}
+	hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (hMap == NULL) {
+		errno = EIO;
+		return 1;
+	}
+	GetSystemInfo(&si);
+	alignedOffset = offset - offset % si.dwAllocationGranularity;
+	base = MapViewOfFile(hMap, FILE_MAP_READ, (DWORD)(alignedOffset >> 32),
+		(DWORD)(alignedOffset & 0xFFFFFFFF), (SIZE_T)(offset - alignedOffset + len));
+	CloseHandle(hMap);
+	if (base == NULL) {
+		errno = ENOMEM;
+		return 1;
+	}
+	vf->base = base;
+	vf->baseLen = (size_t)(offset - alignedOffset + len);
+	vf->data = (const char*)base + (offset - alignedOffset);
+	vf->size = (size_t)len;
+	return 0;
+#elif defined(_POSIX_)
+	int fd;
+	struct stat st;
+	ZPOS64_T alignedOffset;
+	void* base;
+
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0) {
+		return 1;
+	}
+	if (0 != fstat(fd, &st) || (ZPOS64_T)st.st_size < offset) {
+		close(fd);
+		errno = EIO;
+		return 1;
+	}
+	if (len < 0) {
+		len = (long long)((ZPOS64_T)st.st_size - offset);
+	}
+	else if ((ZPOS64_T)len > (ZPOS64_T)st.st_size - offset) {
+		/* Range beyond the end of the file, e.g. of a truncated archive */
+		close(fd);
+		errno = EIO;
+		return 1;
+	}
+	if (len == 0) {
+		close(fd);
+		vf->data = "";
+		vf->size = 0;
+		vf->base = NULL;
+		vf->baseLen = 0;
+		return 0;
+	}
+	alignedOffset = offset - offset % (ZPOS64_T)sysconf(_SC_PAGESIZE);
+	base = mmap(NULL, (size_t)(offset - alignedOffset + len), PROT_READ,
+		MAP_PRIVATE, fd, (off_t)alignedOffset);
+	close(fd);
+	if (base == MAP_FAILED) {
+		return 1;
+	}
+#if defined(MADV_SEQUENTIAL)
+	(void)madvise(base, (size_t)(offset - alignedOffset + len), MADV_SEQUENTIAL);
+#endif
+	vf->base = base;
+	vf->baseLen = (size_t)(offset - alignedOffset + len);
+	vf->data = (const char*)base + (offset - alignedOffset);
+	vf->size = (size_t)len;
+	return 0;
+#else
+	errno = ENOSYS;
+	return 1;
+#endif
+}
+
+static void unmapFile(ED_VFILE* vf)
+{
+	if (vf->base != NULL) {
+#if defined(_WIN32)
+		UnmapViewOfFile(vf->base);
+#elif defined(_POSIX_)
+		munmap(vf->base, vf->baseLen);
+#endif
+		vf->base = NULL;
+	}
+}
+
+static ED_VFILE* openFile(const char* fileName)
+{
+	ED_VFILE* vf = (ED_VFILE*)calloc(1, sizeof(ED_VFILE));
+	if (vf == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	vf->plain = 1;
+	if (0 == mapFile(vf, fileName, 0, -1)) {
+		vf->type = VF_MAP;
+		return vf;
+	}
+	vf->fp = fopen(fileName, "rb");
+	if (vf->fp == NULL) {
+		free(vf);
+		return NULL;
+	}
+	vf->type = VF_STDIO;
+	return vf;
+}
+
+static ED_VFILE* openArchiveMember(const char* archiveName, const char* memberName)
+{
+	unz_file_info64 info;
+	ED_VFILE* vf;
+	unzFile zfile = unzOpen64(archiveName);
+	if (zfile == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	while (*memberName == '/') {
+		memberName++;
+	}
+	if (UNZ_OK != unzLocateFile(zfile, memberName, 1)) {
+		unzClose(zfile);
+		errno = ENOENT;
+		return NULL;
+	}
+	if (UNZ_OK != unzGetCurrentFileInfo64(zfile, &info, NULL, 0, NULL, 0, NULL, 0) ||
+		UNZ_OK != unzOpenCurrentFile(zfile)) {
+		unzClose(zfile);
+		errno = EIO;
+		return NULL;
+	}
+	vf = (ED_VFILE*)calloc(1, sizeof(ED_VFILE));
+	if (vf == NULL) {
+		unzCloseCurrentFile(zfile);
+		unzClose(zfile);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if (info.compression_method == 0 && (info.flag & 1) == 0) {
+		/* Stored and not encrypted: Map the member in place */
+		ZPOS64_T offset = unzGetCurrentFileZStreamPos64(zfile);
+		if (offset != 0 &&
+			0 == mapFile(vf, archiveName, offset, (long long)info.uncompressed_size)) {
+			unzCloseCurrentFile(zfile);
+			unzClose(zfile);
+			vf->type = VF_MAP;
+			return vf;
+		}
+	}
+
+	/* Inflate while reading */
+	vf->buf = (char*)malloc(ED_VFILE_BUFFER_LENGTH);
+	if (vf->buf == NULL) {
+		unzCloseCurrentFile(zfile);
+		unzClose(zfile);
+		free(vf);
+		errno = ENOMEM;
+		return NULL;
+	}
+	vf->type = VF_ZIP;
+	vf->zfile = zfile;
+	vf->size = (size_t)info.uncompressed_size;
+	return vf;
+}
+
+static ED_VFILE* openArchiveOrFile(const char* fileName);
+
+/* Read the BGZF block index of fileName if available, NULL otherwise */
+static char* readIndex(const char* fileName, size_t* len)
+{
+	char* gzi = NULL;
+	char* gziName = (char*)malloc(strlen(fileName) + strlen(ED_VFILE_GZI_EXT) + 1);
+	if (gziName != NULL) {
+		ED_VFILE* vf;
+		strcpy(gziName, fileName);
+		strcat(gziName, ED_VFILE_GZI_EXT);
+		vf = openArchiveOrFile(gziName);
+		if (vf != NULL) {
+			gzi = ED_vfreadall(vf, len);
+			ED_vfclose(vf);
+		}
+		free(gziName);
+	}
+	return gzi;
+}
+
+/* Transparently decode Zstandard or gzip compressed content */
+static ED_VFILE* decodeContent(ED_VFILE* vf, const char* fileName)
+{
+	char magic[4];
+	char* buf = NULL;
+	const char* src;
+	size_t len;
+	char* dst;
+	size_t dstLen;
+	ED_VFILE* dec;
+	int isFrame;
+	int isGzip;
+
+	if (vf->type == VF_MAP) {
+		isFrame = ED_zstdIsFrame(vf->data, vf->size);
+		isGzip = ED_gzipIsMember(vf->data, vf->size);
+		if (!isFrame && !isGzip) {
+			return vf;
+		}
+		src = vf->data;
+		len = vf->size;
+	}
+	else {
+		size_t n = ED_vfread(magic, sizeof(magic), vf);
+		isFrame = ED_zstdIsFrame(magic, n);
+		isGzip = ED_gzipIsMember(magic, n);
+		if (0 != ED_vfseek(vf, 0)) {
+			ED_vfclose(vf);
+			errno = EIO;
+			return NULL;
+		}
+		if (!isFrame && !isGzip) {
+			return vf;
+		}
+		buf = ED_vfreadall(vf, &len);
+		if (buf == NULL) {
+			ED_vfclose(vf);
+			return NULL;
+		}
+		src = buf;
+	}
+
+	dec = (ED_VFILE*)calloc(1, sizeof(ED_VFILE));
+	if (dec == NULL) {
+		free(buf);
+		ED_vfclose(vf);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if (isGzip && ED_bgzfIsBlocked(src, len)) {
+		/* Index the blocks, these are inflated in parallel when accessed */
+		size_t gziLen = 0;
+		char* gzi = readIndex(fileName, &gziLen);
+		dec->bgzf = ED_bgzfOpen(src, len, gzi, gziLen);
+		free(gzi);
+		if (dec->bgzf != NULL) {
+			dec->type = VF_BGZF;
+			dec->data = ED_bgzfData(dec->bgzf);
+			dec->size = ED_bgzfSize(dec->bgzf);
+			/* Take over the compressed content */
+			if (buf != NULL) {
+				dec->mem = buf;
+			}
+			else {
+				dec->base = vf->base;
+				dec->baseLen = vf->baseLen;
+				vf->base = NULL;
+			}
+			ED_vfclose(vf);
+			return dec;
+		}
+		else if (errno == ENOMEM) {
+			free(buf);
+			free(dec);
+			ED_vfclose(vf);
+			errno = ENOMEM;
+			return NULL;
+		}
+		/* Fall back to serial inflation */
+	}
+
+	if (isFrame) {
+		dst = ED_zstdDecompress(src, len, &dstLen);
+	}
+	else {
+		dst = ED_gzipDecompress(src, len, &dstLen);
+	}
+	free(buf);
+	if (dst == NULL) {
+		int err = errno;
+		free(dec);
+		ED_vfclose(vf);
+		errno = err;
+		return NULL;
+	}
+	ED_vfclose(vf);
+	dec->type = VF_MAP;
+	dec->data = dst;
+	dec->size = dstLen;
+	dec->mem = dst;
+	return dec;
+}
+
+static ED_VFILE* openArchiveOrFile(const char* fileName)
+{
+	const char* sep;
+	sep = strstr(fileName, ED_VFILE_ARCHIVE_SEP);
+	while (sep != NULL) {
+		size_t len = (size_t)(sep - fileName);
+		char* archiveName = (char*)malloc(len + 1);
+		if (archiveName == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		memcpy(archiveName, fileName, len);
+		archiveName[len] = '\0';
+		if (isRegularFile(archiveName)) {
+			ED_VFILE* vf = openArchiveMember(archiveName,
+				sep + strlen(ED_VFILE_ARCHIVE_SEP));
+			free(archiveName);
+			return vf;
+		}
+		free(archiveName);
+		sep = strstr(sep + 1, ED_VFILE_ARCHIVE_SEP);
+	}
+	return openFile(fileName);
+}
+
+ED_VFILE* ED_vfopen(const char* fileName)
+{
+	ED_VFILE* vf;
+	if (fileName == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	vf = openArchiveOrFile(fileName);
+	return vf != NULL ? decodeContent(vf, fileName) : NULL;
+}
+
+void ED_vfclose(ED_VFILE* vf)
+{
+	if (vf != NULL) {
+		switch (vf->type) {
+			case VF_MAP:
+				unmapFile(vf);
+				free(vf->mem);
+				break;
+			case VF_STDIO:
+				fclose(vf->fp);
+				break;
+			case VF_ZIP:
+				unzCloseCurrentFile(vf->zfile);
+				unzClose(vf->zfile);
+				free(vf->buf);
+				break;
+			case VF_BGZF:
+				ED_bgzfClose(vf->bgzf);
+				unmapFile(vf);
+				free(vf->mem);
+				break;
+			default:
+				break;
+		}
+		free(vf);
+	}
+}
+
+/* Inflate directly into buf, returns number of bytes or -1 on error */
+static long long inflateZip(ED_VFILE* vf, char* buf, size_t len)
+{
+	long long total = 0;
+	while (len > 0) {
+		unsigned chunk = (unsigned)(len > ED_VFILE_MAX_CHUNK ? ED_VFILE_MAX_CHUNK : len);
+		int rc = unzReadCurrentFile(vf->zfile, buf, chunk);
+		if (rc < 0) {
+			errno = EIO;
+			return -1;
+		}
+		if (rc == 0) {
+			break;
+		}
+		total += rc;
+		buf += rc;
+		len -= (size_t)rc;
+	}
+	return total;
+}
+
+/* Refill the inflate buffer, returns number of available bytes */
+static size_t fillZip(ED_VFILE* vf)
+{
+	if (vf->bufPos >= vf->bufLen) {
+		long long n = inflateZip(vf, vf->buf, ED_VFILE_BUFFER_LENGTH);
+		vf->bufPos = 0;
+		vf->bufLen = n > 0 ? (size_t)n : 0;
+	}
+	return vf->bufLen - vf->bufPos;
+}
+
+size_t ED_vfread(void* buf, size_t len, ED_VFILE* vf)
+{
+	size_t nRead = 0;
+	if (vf == NULL || buf == NULL) {
+		return 0;
+	}
+	switch (vf->type) {
+		case VF_MAP:
+		case VF_BGZF:
+			if (vf->pos < vf->size) {
+				nRead = vf->size - vf->pos;
+				if (nRead > len) {
+					nRead = len;
+				}
+				if (vf->type == VF_BGZF &&
+					0 != ED_bgzfEnsure(vf->bgzf, vf->pos, nRead, ED_VFILE_READAHEAD)) {
+					nRead = 0;
+					break;
+				}
+				memcpy(buf, vf->data + vf->pos, nRead);
+				vf->pos += nRead;
+			}
+			break;
+
+		case VF_STDIO:
+			nRead = fread(buf, 1, len, vf->fp);
+			break;
+
+		case VF_ZIP: {
+			char* p = (char*)buf;
+			/* Drain the inflate buffer */
+			if (vf->bufPos < vf->bufLen) {
+				nRead = vf->bufLen - vf->bufPos;
+				if (nRead > len) {
+					nRead = len;
+				}
+				memcpy(p, vf->buf + vf->bufPos, nRead);
+				vf->bufPos += nRead;
+			}
+			if (nRead < len) {
+				if (len - nRead >= ED_VFILE_BUFFER_LENGTH) {
+					/* Large request: Inflate straight into the destination,
+					 * which invalidates the drained inflate buffer for seeks
+					 */
+					long long n = inflateZip(vf, p + nRead, len - nRead);
+					vf->bufPos = 0;
+					vf->bufLen = 0;
+					if (n > 0) {
+						nRead += (size_t)n;
+					}
+				}
+				else {
+					while (nRead < len && fillZip(vf) > 0) {
+						size_t n = vf->bufLen - vf->bufPos;
+						if (n > len - nRead) {
+							n = len - nRead;
+						}
+						memcpy(p + nRead, vf->buf + vf->bufPos, n);
+						vf->bufPos += n;
+						nRead += n;
+					}
+				}
+			}
+			vf->pos += nRead;
+			break;
+		}
+
+		default:
+			break;
+	}
+	return nRead;
+}
+
+char* ED_vfgets(char* buf, int len, ED_VFILE* vf)
+{
+	size_t maxLen;
+	size_t nRead = 0;
+	if (vf == NULL || buf == NULL || len <= 0) {
+		return NULL;
+	}
+	if (vf->type == VF_STDIO) {
+		return fgets(buf, len, vf->fp);
+	}
+
+	maxLen = (size_t)len - 1;
+	if (vf->type == VF_MAP || vf->type == VF_BGZF) {
+		if (vf->pos >= vf->size) {
+			return NULL;
+		}
+		nRead = vf->size - vf->pos;
+		if (nRead > maxLen) {
+			nRead = maxLen;
+		}
+		if (vf->type == VF_BGZF &&
+			0 != ED_bgzfEnsure(vf->bgzf, vf->pos, nRead, ED_VFILE_READAHEAD)) {
+			return NULL;
+		}
+		{
+			const char* nl = (const char*)memchr(vf->data + vf->pos, '\n', nRead);
+			if (nl != NULL) {
+				nRead = (size_t)(nl - (vf->data + vf->pos)) + 1;
+			}
+		}
+		memcpy(buf, vf->data + vf->pos, nRead);
+		vf->pos += nRead;
+	}
+	else if (vf->type == VF_ZIP) {
+		while (nRead < maxLen && fillZip(vf) > 0) {
+			const char* p = vf->buf + vf->bufPos;
+			const char* nl;
+			size_t n = vf->bufLen - vf->bufPos;
+			if (n > maxLen - nRead) {
+				n = maxLen - nRead;
+			}
+			nl = (const char*)memchr(p, '\n', n);
+			if (nl != NULL) {
+				n = (size_t)(nl - p) + 1;
+			}
+			memcpy(buf + nRead, p, n);
+			vf->bufPos += n;
+			nRead += n;
+			if (nl != NULL) {
+				break;
+			}
+		}
+		vf->pos += nRead;
+		if (nRead == 0) {
+			return NULL;
+		}
+	}
+	buf[nRead] = '\0';
+	return buf;
+}
+
+long ED_vftell(ED_VFILE* vf)
+{
+	if (vf == NULL) {
+		return -1;
+	}
+	if (vf->type == VF_STDIO) {
+		return ftell(vf->fp);
+	}
+	return (long)vf->pos;
+}
+
+int ED_vfseek(ED_VFILE* vf, long pos)
+{
+	if (vf == NULL || pos < 0) {
+		return -1;
+	}
+	switch (vf->type) {
+		case VF_MAP:
+		case VF_BGZF:
+			vf->pos = (size_t)pos < vf->size ? (size_t)pos : vf->size;
+			return 0;
+
+		case VF_STDIO:
+			return fseek(vf->fp, pos, SEEK_SET);
+
+		case VF_ZIP: {
+			size_t bufStart = vf->pos - vf->bufPos;
+			if ((size_t)pos >= bufStart && (size_t)pos <= bufStart + vf->bufLen) {
+				/* Target is inside the inflate buffer */
+				vf->bufPos = (size_t)pos - bufStart;
+				vf->pos = (size_t)pos;
+				return 0;
+			}
+			if ((size_t)pos < vf->pos) {
+				/* Rewind: Restart inflating from the beginning */
+				unzCloseCurrentFile(vf->zfile);
+				if (UNZ_OK != unzOpenCurrentFile(vf->zfile)) {
+					return -1;
+				}
+				vf->pos = 0;
+				vf->bufPos = 0;
+				vf->bufLen = 0;
+			}
+			/* Skip forward */
+			vf->pos += vf->bufLen - vf->bufPos;
+			vf->bufPos = vf->bufLen;
+			while (vf->pos < (size_t)pos) {
+				size_t n = fillZip(vf);
+				if (n == 0) {
+					return -1;
+				}
+				if (n > (size_t)pos - vf->pos) {
+					n = (size_t)pos - vf->pos;
+				}
+				vf->bufPos += n;
+				vf->pos += n;
+			}
+			return 0;
+		}
+
+		default:
+			break;
+	}
+	return -1;
+}
+
+const char* ED_vfmap(ED_VFILE* vf, size_t* len)
+{
+	if (vf != NULL && vf->type == VF_BGZF &&
+		0 != ED_bgzfEnsure(vf->bgzf, 0, vf->size, 0)) {
+		return NULL;
+	}
+	if (vf != NULL && (vf->type == VF_MAP || vf->type == VF_BGZF)) {
+		if (len != NULL) {
+			*len = vf->size;
+		}
+		return vf->data;
+	}
+	return NULL;
+}
+
+int ED_vfplain(ED_VFILE* vf)
+{
+	return vf != NULL && vf->plain;
+}
+
+char* ED_vfreadall(ED_VFILE* vf, size_t* len)
+{
+	char* buf = NULL;
+	size_t nRead = 0;
+	if (vf == NULL) {
+		return NULL;
+	}
+	if (vf->type == VF_MAP || vf->type == VF_ZIP || vf->type == VF_BGZF) {
+		/* Size is known in advance */
+		size_t size = vf->size > vf->pos ? vf->size - vf->pos : 0;
+		buf = (char*)malloc(size + 1);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		nRead = ED_vfread(buf, size, vf);
+		if (nRead != size) {
+			free(buf);
+			errno = EIO;
+			return NULL;
+		}
+	}
+	else {
+		size_t bufLen = ED_VFILE_BUFFER_LENGTH;
+		buf = (char*)malloc(bufLen + 1);
+		while (buf != NULL) {
+			nRead += ED_vfread(buf + nRead, bufLen - nRead, vf);
+			if (nRead < bufLen) {
+				break;
+			}
+			else {
+				char* tmp = (char*)realloc(buf, 2*bufLen + 1);
+				if (tmp == NULL) {
+					free(buf);
+					buf = NULL;
+					break;
+				}
+				buf = tmp;
+				bufLen *= 2;
+			}
+		}
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+	}
+	buf[nRead] = '\0';
+	if (len != NULL) {
+		*len = nRead;
+	}
+	return buf;
+}
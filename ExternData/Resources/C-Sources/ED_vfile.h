@@ -0,0 +1,74 @@
+/* ED_vfile.h - Virtual file layer for plain files and archive members
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_VFILE_H)
+#define ED_VFILE_H
+
+#include <stdlib.h>
+
+/* Separator between the archive path and the member path, e.g.
+ * "model.fmu!/resources/table.csv"
+ */
+#define ED_VFILE_ARCHIVE_SEP "!/"
+
+typedef struct ED_VFILE ED_VFILE;
+
+/* Open a plain file or a member of a zip archive (FMU) for reading.
+ * Plain files and stored archive members are memory-mapped, deflated
+ * archive members are inflated on the fly while reading. Zstandard and
+ * gzip compressed content is detected by its magic number and decoded.
+ * BGZF blocks are inflated in parallel on access, using the block index
+ * fileName.gzi if present.
+ * Returns NULL and sets errno on failure.
+ */
+ED_VFILE* ED_vfopen(const char* fileName);
+void ED_vfclose(ED_VFILE* vf);
+
+/* Read up to len bytes, returns the number of bytes read (0 on EOF or error) */
+size_t ED_vfread(void* buf, size_t len, ED_VFILE* vf);
+
+/* Same semantics as fgets */
+char* ED_vfgets(char* buf, int len, ED_VFILE* vf);
+
+long ED_vftell(ED_VFILE* vf);
+int ED_vfseek(ED_VFILE* vf, long pos);
+
+/* Direct read-only view of the entire content if the file is mapped,
+ * NULL otherwise. The view is not null-terminated.
+ */
+const char* ED_vfmap(ED_VFILE* vf, size_t* len);
+
+/* Non-zero for a plain file, which is cheap to open again, zero for an
+ * archive member or decoded content
+ */
+int ED_vfplain(ED_VFILE* vf);
+
+/* Read the (remaining) content into a newly allocated, null-terminated
+ * buffer that must be released by free. Returns NULL on failure.
+ */
+char* ED_vfreadall(ED_VFILE* vf, size_t* len);
+
+#endif
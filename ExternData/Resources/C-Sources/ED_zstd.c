@@ -0,0 +1,1437 @@
+/* ED_zstd.c - Zstandard frame decoder
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Decoder for the Zstandard compression format as specified in RFC 8878.
+ * Dictionaries are not supported.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "ED_zstd.h"
+
+typedef unsigned char BYTE;
+typedef unsigned short U16;
+typedef unsigned int U32;
+#if defined(_MSC_VER) && _MSC_VER < 1600
+typedef unsigned __int64 U64;
+#else
+typedef unsigned long long U64;
+#endif
+
+#define ZSTD_MAGIC (0xFD2FB528U)
+#define ZSTD_SKIPPABLE_MAGIC (0x184D2A50U)
+#define ZSTD_SKIPPABLE_MASK (0xFFFFFFF0U)
+#define ZSTD_BLOCKSIZE_MAX (1 << 17)
+#define ZSTD_WILDCOPY_OVERLENGTH (16)
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+	defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64)
+#define ZSTD_LITTLE_ENDIAN 1
+#endif
+
+#define HUF_MAX_BITS (11)
+#define HUF_MAX_SYMBS (256)
+#define HUF_WEIGHTS_MAX_AL (6)
+
+#define FSE_MAX_AL (9)
+#define LL_MAX_AL (9)
+#define ML_MAX_AL (9)
+#define OF_MAX_AL (8)
+#define LL_MAX_CODE (35)
+#define ML_MAX_CODE (52)
+#define OF_MAX_CODE (31)
+
+enum {
+	ZSTD_OK = 0,
+	ZSTD_CORRUPT,
+	ZSTD_UNSUPPORTED,
+	ZSTD_NOMEM,
+	ZSTD_NOSPACE
+};
+
+typedef struct {
+	BYTE symbol;
+	BYTE nbBits;
+	U16 base; /* Next state is base + nbBits read bits */
+} FSEEntry;
+
+typedef struct {
+	FSEEntry table[1 << FSE_MAX_AL];
+	unsigned al;
+} FSETable;
+
+typedef struct {
+	BYTE symbol;
+	BYTE nbBits;
+} HUFEntry;
+
+typedef struct {
+	HUFEntry table[1 << HUF_MAX_BITS];
+	unsigned maxBits;
+} HUFTable;
+
+typedef struct {
+	BYTE* dst;
+	size_t cap; /* Capacity of dst (without the terminating null) */
+	size_t pos;
+	int growable;
+	size_t frameStart;
+	U32 rep[3];
+	int hasHuf;
+	int hasLL;
+	int hasOF;
+	int hasML;
+	HUFTable huf;
+	FSETable ll;
+	FSETable of;
+	FSETable ml;
+	BYTE lit[ZSTD_BLOCKSIZE_MAX];
+} ZSTDContext;
+
+typedef struct {
+	U64 contentSize;
+	int hasContentSize;
+	int hasChecksum;
+	size_t headerSize;
+} FrameHeader;
+
+/* Predefined distributions */
+static const short llDefault[LL_MAX_CODE + 1] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1
+};
+static const short mlDefault[ML_MAX_CODE + 1] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1
+};
+static const short ofDefault[29] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1, -1
+};
+
+/* Baselines and number of extra bits of literals length and match length codes */
+static const U32 llBase[LL_MAX_CODE + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+	8192, 16384, 32768, 65536
+};
+static const BYTE llBits[LL_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16
+};
+static const U32 mlBase[ML_MAX_CODE + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539
+};
+static const BYTE mlBits[ML_MAX_CODE + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16
+};
+
+static U32 readLE16(const BYTE* p)
+{
+	return (U32)p[0] | ((U32)p[1] << 8);
+}
+
+static U32 readLE24(const BYTE* p)
+{
+	return (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16);
+}
+
+static U32 readLE32(const BYTE* p)
+{
+	return (U32)p[0] | ((U32)p[1] << 8) | ((U32)p[2] << 16) | ((U32)p[3] << 24);
+}
+
+static U64 readLE64(const BYTE* p)
+{
+#if defined(ZSTD_LITTLE_ENDIAN)
+	U64 v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+#else
+	return (U64)readLE32(p) | ((U64)readLE32(p + 4) << 32);
+#endif
+}
+
+static unsigned highBit(U32 x)
+{
+	unsigned n = 0;
+	while (x >>= 1) {
+		n++;
+	}
+	return n;
+}
+
+/* XXH64 (seed 0) for the content checksum */
+
+#define XXH_P1 (0x9E3779B185EBCA87ULL)
+#define XXH_P2 (0xC2B2AE3D27D4EB4FULL)
+#define XXH_P3 (0x165667B19E3779F9ULL)
+#define XXH_P4 (0x85EBCA77C2B2AE63ULL)
+#define XXH_P5 (0x27D4EB2F165667C5ULL)
+#define XXH_ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static U64 xxhRound(U64 acc, U64 input)
+{
+	acc += input*XXH_P2;
+	acc = XXH_ROTL(acc, 31);
+	return acc*XXH_P1;
+}
+
+static U64 xxhMerge(U64 acc, U64 val)
+{
+	acc ^= xxhRound(0, val);
+	return acc*XXH_P1 + XXH_P4;
+}
+
+static U64 xxh64(const BYTE* p, size_t len)
+{
+	const BYTE* end = p + len;
+	U64 h;
+	if (len >= 32) {
+		U64 v1 = XXH_P1 + XXH_P2;
+		U64 v2 = XXH_P2;
+		U64 v3 = 0;
+		U64 v4 = 0 - XXH_P1;
+		do {
+			v1 = xxhRound(v1, readLE64(p));
+			v2 = xxhRound(v2, readLE64(p + 8));
+			v3 = xxhRound(v3, readLE64(p + 16));
+			v4 = xxhRound(v4, readLE64(p + 24));
+			p += 32;
+		} while (end - p >= 32);
+		h = XXH_ROTL(v1, 1) + XXH_ROTL(v2, 7) + XXH_ROTL(v3, 12) + XXH_ROTL(v4, 18);
+		h = xxhMerge(h, v1);
+		h = xxhMerge(h, v2);
+		h = xxhMerge(h, v3);
+		h = xxhMerge(h, v4);
+	}
+	else {
+		h = XXH_P5;
+	}
+	h += (U64)len;
+	while (end - p >= 8) {
+		h ^= xxhRound(0, readLE64(p));
+		h = XXH_ROTL(h, 27)*XXH_P1 + XXH_P4;
+		p += 8;
+	}
+	if (end - p >= 4) {
+		h ^= (U64)readLE32(p)*XXH_P1;
+		h = XXH_ROTL(h, 23)*XXH_P2 + XXH_P3;
+		p += 4;
+	}
+	while (p < end) {
+		h ^= (U64)(*p)*XXH_P5;
+		h = XXH_ROTL(h, 11)*XXH_P1;
+		p++;
+	}
+	h ^= h >> 33;
+	h *= XXH_P2;
+	h ^= h >> 29;
+	h *= XXH_P3;
+	h ^= h >> 32;
+	return h;
+}
+
+/* Backward bit stream as used by Huffman and FSE coded streams: Read from
+ * the end towards the start, the highest set bit of the last byte marks
+ * the beginning. Bits before the start of the stream read as zero.
+ */
+
+typedef struct {
+	U64 container;
+	unsigned consumed; /* Number of consumed bits of container (from the top) */
+	const BYTE* ptr;
+	const BYTE* start;
+} BitReader;
+
+static int bitInit(BitReader* br, const BYTE* src, size_t len)
+{
+	BYTE last;
+	if (len == 0) {
+		return ZSTD_CORRUPT;
+	}
+	last = src[len - 1];
+	if (last == 0) {
+		return ZSTD_CORRUPT;
+	}
+	br->start = src;
+	if (len >= 8) {
+		br->ptr = src + len - 8;
+		br->container = readLE64(br->ptr);
+		br->consumed = 0;
+	}
+	else {
+		size_t i;
+		br->ptr = src;
+		br->container = 0;
+		for (i = 0; i < len; i++) {
+			br->container |= (U64)src[i] << (8*i);
+		}
+		br->consumed = (unsigned)(8 - len)*8;
+	}
+	/* Skip the padding */
+	br->consumed += 8 - highBit(last);
+	return ZSTD_OK;
+}
+
+/* Peek 1 <= n <= 56 bits */
+static U64 bitLook(const BitReader* br, unsigned n)
+{
+	if (br->consumed >= 64) {
+		return 0;
+	}
+	return (br->container << br->consumed) >> (64 - n);
+}
+
+static U64 bitRead(BitReader* br, unsigned n)
+{
+	U64 v;
+	if (n == 0) {
+		return 0;
+	}
+	v = bitLook(br, n);
+	br->consumed += n;
+	return v;
+}
+
+static void bitReload(BitReader* br)
+{
+	size_t nbBytes;
+	if (br->consumed > 64) {
+		return;
+	}
+	nbBytes = br->consumed >> 3;
+	if ((size_t)(br->ptr - br->start) < nbBytes) {
+		nbBytes = (size_t)(br->ptr - br->start);
+	}
+	if (nbBytes > 0) {
+		br->ptr -= nbBytes;
+		br->consumed -= (unsigned)nbBytes*8;
+		br->container = readLE64(br->ptr);
+	}
+}
+
+static int bitFinished(const BitReader* br)
+{
+	return br->ptr == br->start && br->consumed == 64;
+}
+
+static int bitOverflow(const BitReader* br)
+{
+	return br->ptr == br->start && br->consumed > 64;
+}
+
+/* FSE */
+
+static int buildFSETable(FSETable* t, const short* norm, unsigned nbSymbs, unsigned al)
+{
+	U16 symbNext[HUF_MAX_SYMBS];
+	const U32 size = 1U << al;
+	const U32 mask = size - 1;
+	const U32 step = (size >> 1) + (size >> 3) + 3;
+	U32 high = size;
+	U32 pos = 0;
+	U32 i;
+	unsigned s;
+
+	for (s = 0; s < nbSymbs; s++) {
+		if (norm[s] == -1) {
+			t->table[--high].symbol = (BYTE)s;
+			symbNext[s] = 1;
+		}
+	}
+	for (s = 0; s < nbSymbs; s++) {
+		int j;
+		for (j = 0; j < norm[s]; j++) {
+			t->table[pos].symbol = (BYTE)s;
+			do {
+				pos = (pos + step) & mask;
+			} while (pos >= high);
+		}
+		if (norm[s] > 0) {
+			symbNext[s] = (U16)norm[s];
+		}
+	}
+	if (pos != 0) {
+		return ZSTD_CORRUPT;
+	}
+	for (i = 0; i < size; i++) {
+		U32 next = symbNext[t->table[i].symbol]++;
+		unsigned nbBits = al - highBit(next);
+		t->table[i].nbBits = (BYTE)nbBits;
+		t->table[i].base = (U16)((next << nbBits) - size);
+	}
+	t->al = al;
+	return ZSTD_OK;
+}
+
+static void buildRLETable(FSETable* t, BYTE symbol)
+{
+	t->table[0].symbol = symbol;
+	t->table[0].nbBits = 0;
+	t->table[0].base = 0;
+	t->al = 0;
+}
+
+/* Peek n <= 16 bits of a forward bit stream, bits beyond len read as zero */
+static U32 fwdLook(const BYTE* src, size_t len, size_t bitPos, unsigned n)
+{
+	size_t byte = bitPos >> 3;
+	U32 v = 0;
+	unsigned i;
+	for (i = 0; i < 4 && byte + i < len; i++) {
+		v |= (U32)src[byte + i] << (8*i);
+	}
+	return (v >> (bitPos & 7)) & ((1U << n) - 1);
+}
+
+/* Read a FSE table description, returns the number of consumed bytes in *consumed */
+static int readFSETable(FSETable* t, const BYTE* src, size_t len,
+	unsigned maxAL, unsigned maxSymb, size_t* consumed)
+{
+	short norm[HUF_MAX_SYMBS];
+	size_t bitPos = 4;
+	unsigned al;
+	unsigned s = 0;
+	int remaining;
+
+	if (len == 0) {
+		return ZSTD_CORRUPT;
+	}
+	al = fwdLook(src, len, 0, 4) + 5;
+	if (al > maxAL) {
+		return ZSTD_CORRUPT;
+	}
+	remaining = 1 << al;
+	while (remaining > 0) {
+		unsigned nbBits = highBit((U32)remaining + 1) + 1;
+		U32 val = fwdLook(src, len, bitPos, nbBits);
+		U32 lowerMask = (1U << (nbBits - 1)) - 1;
+		U32 threshold = (1U << nbBits) - 1 - ((U32)remaining + 1);
+		int proba;
+		if (s > maxSymb) {
+			return ZSTD_CORRUPT;
+		}
+		if ((val & lowerMask) < threshold) {
+			val &= lowerMask;
+			bitPos += nbBits - 1;
+		}
+		else {
+			if (val > lowerMask) {
+				val -= threshold;
+			}
+			bitPos += nbBits;
+		}
+		proba = (int)val - 1;
+		remaining -= proba < 0 ? -proba : proba;
+		norm[s++] = (short)proba;
+		if (proba == 0) {
+			U32 repeat;
+			do {
+				U32 i;
+				repeat = fwdLook(src, len, bitPos, 2);
+				bitPos += 2;
+				for (i = 0; i < repeat; i++) {
+					if (s > maxSymb) {
+						return ZSTD_CORRUPT;
+					}
+					norm[s++] = 0;
+				}
+			} while (repeat == 3);
+		}
+	}
+	*consumed = (bitPos + 7) >> 3;
+	if (remaining != 0 || *consumed > len) {
+		return ZSTD_CORRUPT;
+	}
+	return buildFSETable(t, norm, s, al);
+}
+
+/* Huffman */
+
+static int buildHufTable(HUFTable* t, const BYTE* weights, unsigned nbWeights)
+{
+	BYTE bits[HUF_MAX_SYMBS];
+	U32 rankCount[HUF_MAX_BITS + 1];
+	U32 rankIdx[HUF_MAX_BITS + 1];
+	U32 sum = 0;
+	U32 rest;
+	unsigned maxBits;
+	unsigned i;
+
+	if (nbWeights + 1 > HUF_MAX_SYMBS) {
+		return ZSTD_CORRUPT;
+	}
+	for (i = 0; i < nbWeights; i++) {
+		if (weights[i] > HUF_MAX_BITS) {
+			return ZSTD_CORRUPT;
+		}
+		if (weights[i] > 0) {
+			sum += 1U << (weights[i] - 1);
+		}
+	}
+	if (sum == 0) {
+		return ZSTD_CORRUPT;
+	}
+	maxBits = highBit(sum) + 1;
+	if (maxBits > HUF_MAX_BITS) {
+		return ZSTD_CORRUPT;
+	}
+	/* The weight of the last symbol is implied */
+	rest = (1U << maxBits) - sum;
+	if ((rest & (rest - 1)) != 0) {
+		return ZSTD_CORRUPT;
+	}
+	memset(rankCount, 0, sizeof(rankCount));
+	for (i = 0; i < nbWeights; i++) {
+		bits[i] = (BYTE)(weights[i] > 0 ? maxBits + 1 - weights[i] : 0);
+		rankCount[bits[i]]++;
+	}
+	bits[nbWeights] = (BYTE)(maxBits - highBit(rest));
+	rankCount[bits[nbWeights]]++;
+
+	/* Longest codes come first */
+	rankIdx[maxBits] = 0;
+	for (i = maxBits; i >= 1; i--) {
+		U32 j;
+		rankIdx[i - 1] = rankIdx[i] + rankCount[i]*(1U << (maxBits - i));
+		for (j = rankIdx[i]; j < rankIdx[i - 1]; j++) {
+			t->table[j].nbBits = (BYTE)i;
+		}
+	}
+	if (rankIdx[0] != (1U << maxBits)) {
+		return ZSTD_CORRUPT;
+	}
+	for (i = 0; i <= nbWeights; i++) {
+		if (bits[i] > 0) {
+			U32 len = 1U << (maxBits - bits[i]);
+			U32 j;
+			for (j = 0; j < len; j++) {
+				t->table[rankIdx[bits[i]] + j].symbol = (BYTE)i;
+			}
+			rankIdx[bits[i]] += len;
+		}
+	}
+	t->maxBits = maxBits;
+	return ZSTD_OK;
+}
+
+static int readHufTable(HUFTable* t, const BYTE* src, size_t len, size_t* consumed)
+{
+	BYTE weights[HUF_MAX_SYMBS];
+	unsigned nbWeights = 0;
+	unsigned header;
+
+	if (len == 0) {
+		return ZSTD_CORRUPT;
+	}
+	header = src[0];
+	if (header >= 128) {
+		/* Direct representation as 4 bit weights */
+		unsigned i;
+		nbWeights = header - 127;
+		*consumed = 1 + (nbWeights + 1)/2;
+		if (*consumed > len) {
+			return ZSTD_CORRUPT;
+		}
+		for (i = 0; i < nbWeights; i++) {
+			BYTE b = src[1 + i/2];
+			weights[i] = (BYTE)(i % 2 == 0 ? b >> 4 : b & 15);
+		}
+	}
+	else {
+		/* FSE compressed weights, decoded by two interleaved states */
+		FSETable fse;
+		BitReader br;
+		size_t tableLen;
+		U32 state1;
+		U32 state2;
+		int rc;
+		*consumed = 1 + header;
+		if (*consumed > len) {
+			return ZSTD_CORRUPT;
+		}
+		rc = readFSETable(&fse, src + 1, header, HUF_WEIGHTS_MAX_AL, HUF_MAX_BITS, &tableLen);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		rc = bitInit(&br, src + 1 + tableLen, header - tableLen);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		state1 = (U32)bitRead(&br, fse.al);
+		state2 = (U32)bitRead(&br, fse.al);
+		bitReload(&br);
+		for (;;) {
+			if (nbWeights >= HUF_MAX_SYMBS - 2) {
+				return ZSTD_CORRUPT;
+			}
+			weights[nbWeights++] = fse.table[state1].symbol;
+			state1 = fse.table[state1].base + (U32)bitRead(&br, fse.table[state1].nbBits);
+			bitReload(&br);
+			if (bitOverflow(&br)) {
+				weights[nbWeights++] = fse.table[state2].symbol;
+				break;
+			}
+			weights[nbWeights++] = fse.table[state2].symbol;
+			state2 = fse.table[state2].base + (U32)bitRead(&br, fse.table[state2].nbBits);
+			bitReload(&br);
+			if (bitOverflow(&br)) {
+				weights[nbWeights++] = fse.table[state1].symbol;
+				break;
+			}
+		}
+	}
+	return buildHufTable(t, weights, nbWeights);
+}
+
+static int decodeHufStream(const HUFTable* t, const BYTE* src, size_t len, BYTE* out, size_t n)
+{
+	BitReader br;
+	const unsigned maxBits = t->maxBits;
+	size_t i = 0;
+	int rc = bitInit(&br, src, len);
+	if (rc != ZSTD_OK) {
+		return rc;
+	}
+	/* At most 4*HUF_MAX_BITS bits are consumed between reloads */
+	while (i + 4 <= n) {
+		const HUFEntry* e;
+		e = &t->table[bitLook(&br, maxBits)];
+		br.consumed += e->nbBits;
+		out[i++] = e->symbol;
+		e = &t->table[bitLook(&br, maxBits)];
+		br.consumed += e->nbBits;
+		out[i++] = e->symbol;
+		e = &t->table[bitLook(&br, maxBits)];
+		br.consumed += e->nbBits;
+		out[i++] = e->symbol;
+		e = &t->table[bitLook(&br, maxBits)];
+		br.consumed += e->nbBits;
+		out[i++] = e->symbol;
+		bitReload(&br);
+	}
+	while (i < n) {
+		const HUFEntry* e = &t->table[bitLook(&br, maxBits)];
+		br.consumed += e->nbBits;
+		out[i++] = e->symbol;
+	}
+	bitReload(&br);
+	return bitFinished(&br) ? ZSTD_OK : ZSTD_CORRUPT;
+}
+
+/* Output */
+
+static int reserve(ZSTDContext* ctx, size_t n)
+{
+	if (ctx->cap - ctx->pos >= n) {
+		return ZSTD_OK;
+	}
+	if (ctx->growable) {
+		size_t cap = 2*ctx->cap;
+		BYTE* tmp;
+		if (cap - ctx->pos < n) {
+			cap = ctx->pos + n;
+		}
+		tmp = (BYTE*)realloc(ctx->dst, cap + 1);
+		if (tmp == NULL) {
+			return ZSTD_NOMEM;
+		}
+		ctx->dst = tmp;
+		ctx->cap = cap;
+		return ZSTD_OK;
+	}
+	return ZSTD_NOSPACE;
+}
+
+/* Blocks */
+
+static int decodeLiterals(ZSTDContext* ctx, const BYTE* src, size_t len,
+	const BYTE** lit, size_t* litLen, size_t* consumed)
+{
+	const unsigned type = src[0] & 3;
+	const unsigned sizeFormat = (src[0] >> 2) & 3;
+
+	if (type == 0 || type == 1) {
+		/* Raw or RLE literals */
+		size_t headerSize;
+		size_t regenSize;
+		switch (sizeFormat) {
+			case 1:
+				headerSize = 2;
+				break;
+			case 3:
+				headerSize = 3;
+				break;
+			default:
+				headerSize = 1;
+				break;
+		}
+		if (len < headerSize) {
+			return ZSTD_CORRUPT;
+		}
+		switch (headerSize) {
+			case 1:
+				regenSize = src[0] >> 3;
+				break;
+			case 2:
+				regenSize = readLE16(src) >> 4;
+				break;
+			default:
+				regenSize = readLE24(src) >> 4;
+				break;
+		}
+		if (regenSize > ZSTD_BLOCKSIZE_MAX) {
+			return ZSTD_CORRUPT;
+		}
+		if (type == 0) {
+			if (len - headerSize < regenSize) {
+				return ZSTD_CORRUPT;
+			}
+			*lit = src + headerSize;
+			*consumed = headerSize + regenSize;
+		}
+		else {
+			if (len - headerSize < 1) {
+				return ZSTD_CORRUPT;
+			}
+			memset(ctx->lit, src[headerSize], regenSize);
+			*lit = ctx->lit;
+			*consumed = headerSize + 1;
+		}
+		*litLen = regenSize;
+	}
+	else {
+		/* Huffman compressed literals, type 3 reuses the previous table */
+		size_t headerSize;
+		size_t regenSize;
+		size_t compSize;
+		size_t treeSize = 0;
+		unsigned nbStreams = sizeFormat == 0 ? 1 : 4;
+		int rc;
+		switch (sizeFormat) {
+			case 0:
+			case 1:
+				headerSize = 3;
+				break;
+			case 2:
+				headerSize = 4;
+				break;
+			default:
+				headerSize = 5;
+				break;
+		}
+		if (len < headerSize) {
+			return ZSTD_CORRUPT;
+		}
+		switch (headerSize) {
+			case 3: {
+				U32 h = readLE24(src);
+				regenSize = (h >> 4) & 0x3FF;
+				compSize = h >> 14;
+				break;
+			}
+			case 4: {
+				U32 h = readLE32(src);
+				regenSize = (h >> 4) & 0x3FFF;
+				compSize = h >> 18;
+				break;
+			}
+			default: {
+				U64 h = (U64)readLE32(src) | ((U64)src[4] << 32);
+				regenSize = (size_t)((h >> 4) & 0x3FFFF);
+				compSize = (size_t)(h >> 22);
+				break;
+			}
+		}
+		if (regenSize > ZSTD_BLOCKSIZE_MAX || len - headerSize < compSize) {
+			return ZSTD_CORRUPT;
+		}
+		src += headerSize;
+		if (type == 2) {
+			rc = readHufTable(&ctx->huf, src, compSize, &treeSize);
+			if (rc != ZSTD_OK) {
+				return rc;
+			}
+			ctx->hasHuf = 1;
+		}
+		else if (!ctx->hasHuf) {
+			return ZSTD_CORRUPT;
+		}
+		if (nbStreams == 1) {
+			rc = decodeHufStream(&ctx->huf, src + treeSize, compSize - treeSize,
+				ctx->lit, regenSize);
+		}
+		else {
+			const BYTE* p = src + treeSize;
+			size_t total = compSize - treeSize;
+			size_t sizes[4];
+			size_t segment = (regenSize + 3)/4;
+			unsigned i;
+			if (total < 6 || 3*segment > regenSize) {
+				return ZSTD_CORRUPT;
+			}
+			sizes[0] = readLE16(p);
+			sizes[1] = readLE16(p + 2);
+			sizes[2] = readLE16(p + 4);
+			if (sizes[0] + sizes[1] + sizes[2] > total - 6) {
+				return ZSTD_CORRUPT;
+			}
+			sizes[3] = total - 6 - sizes[0] - sizes[1] - sizes[2];
+			p += 6;
+			rc = ZSTD_OK;
+			for (i = 0; i < 4 && rc == ZSTD_OK; i++) {
+				size_t n = i < 3 ? segment : regenSize - 3*segment;
+				rc = decodeHufStream(&ctx->huf, p, sizes[i], ctx->lit + i*segment, n);
+				p += sizes[i];
+			}
+		}
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		*lit = ctx->lit;
+		*litLen = regenSize;
+		*consumed = headerSize + compSize;
+	}
+	return ZSTD_OK;
+}
+
+/* Select the decoding table of a sequence code (LL, OF or ML) by mode */
+static int selectTable(FSETable* t, int* valid, unsigned mode, const short* def,
+	unsigned defSymbs, unsigned defAL, unsigned maxAL, unsigned maxSymb,
+	const BYTE* src, size_t len, size_t* consumed)
+{
+	int rc = ZSTD_OK;
+	*consumed = 0;
+	switch (mode) {
+		case 0:
+			rc = buildFSETable(t, def, defSymbs, defAL);
+			break;
+		case 1:
+			if (len < 1 || src[0] > maxSymb) {
+				return ZSTD_CORRUPT;
+			}
+			buildRLETable(t, src[0]);
+			*consumed = 1;
+			break;
+		case 2:
+			rc = readFSETable(t, src, len, maxAL, maxSymb, consumed);
+			break;
+		default:
+			if (!*valid) {
+				return ZSTD_CORRUPT;
+			}
+			break;
+	}
+	*valid = rc == ZSTD_OK;
+	return rc;
+}
+
+/* Copy n bytes in chunks of ZSTD_WILDCOPY_OVERLENGTH, may read and write
+ * up to ZSTD_WILDCOPY_OVERLENGTH - 1 bytes beyond
+ */
+static void wildCopy(BYTE* d, const BYTE* s, size_t n)
+{
+	BYTE* const end = d + n;
+	do {
+		memcpy(d, s, ZSTD_WILDCOPY_OVERLENGTH);
+		d += ZSTD_WILDCOPY_OVERLENGTH;
+		s += ZSTD_WILDCOPY_OVERLENGTH;
+	} while (d < end);
+}
+
+static int execSequence(ZSTDContext* ctx, const BYTE** lit, const BYTE* litEnd,
+	size_t ll, size_t ml, size_t offset)
+{
+	BYTE* d;
+	int rc;
+	if ((size_t)(litEnd - *lit) < ll || offset == 0 ||
+		offset > ctx->pos + ll - ctx->frameStart) {
+		return ZSTD_CORRUPT;
+	}
+	rc = reserve(ctx, ll + ml);
+	if (rc != ZSTD_OK) {
+		return rc;
+	}
+	d = ctx->dst + ctx->pos;
+	if (ctx->cap - ctx->pos >= ll + ml + ZSTD_WILDCOPY_OVERLENGTH) {
+		/* Fast path with enough room for overlength copies */
+		if ((size_t)(litEnd - *lit) >= ll + ZSTD_WILDCOPY_OVERLENGTH) {
+			wildCopy(d, *lit, ll);
+		}
+		else {
+			memcpy(d, *lit, ll);
+		}
+		*lit += ll;
+		d += ll;
+		ctx->pos += ll + ml;
+		if (offset >= ZSTD_WILDCOPY_OVERLENGTH) {
+			wildCopy(d, d - offset, ml);
+			return ZSTD_OK;
+		}
+	}
+	else {
+		memcpy(d, *lit, ll);
+		*lit += ll;
+		d += ll;
+		ctx->pos += ll + ml;
+	}
+	if (offset >= ml) {
+		memcpy(d, d - offset, ml);
+	}
+	else {
+		/* Overlapping match: Copy in non-overlapping chunks */
+		while (ml > 0) {
+			size_t n = ml < offset ? ml : offset;
+			memcpy(d, d - offset, n);
+			d += n;
+			ml -= n;
+		}
+	}
+	return ZSTD_OK;
+}
+
+static int decodeSequences(ZSTDContext* ctx, const BYTE* src, size_t len,
+	const BYTE* lit, size_t litLen)
+{
+	const BYTE* litEnd = lit + litLen;
+	size_t nbSeq;
+	size_t pos;
+	size_t n;
+	size_t i;
+	unsigned modes;
+	U32 llState;
+	U32 ofState;
+	U32 mlState;
+	BitReader br;
+	int rc;
+
+	if (len < 1) {
+		return ZSTD_CORRUPT;
+	}
+	nbSeq = src[0];
+	pos = 1;
+	if (nbSeq >= 255) {
+		if (len < 3) {
+			return ZSTD_CORRUPT;
+		}
+		nbSeq = readLE16(src + 1) + 0x7F00;
+		pos = 3;
+	}
+	else if (nbSeq >= 128) {
+		if (len < 2) {
+			return ZSTD_CORRUPT;
+		}
+		nbSeq = ((nbSeq - 128) << 8) + src[1];
+		pos = 2;
+	}
+
+	if (nbSeq > 0) {
+		if (len - pos < 1) {
+			return ZSTD_CORRUPT;
+		}
+		modes = src[pos++];
+		if ((modes & 3) != 0) {
+			return ZSTD_CORRUPT;
+		}
+		rc = selectTable(&ctx->ll, &ctx->hasLL, modes >> 6, llDefault,
+			LL_MAX_CODE + 1, 6, LL_MAX_AL, LL_MAX_CODE, src + pos, len - pos, &n);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		pos += n;
+		rc = selectTable(&ctx->of, &ctx->hasOF, (modes >> 4) & 3, ofDefault,
+			29, 5, OF_MAX_AL, OF_MAX_CODE, src + pos, len - pos, &n);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		pos += n;
+		rc = selectTable(&ctx->ml, &ctx->hasML, (modes >> 2) & 3, mlDefault,
+			ML_MAX_CODE + 1, 6, ML_MAX_AL, ML_MAX_CODE, src + pos, len - pos, &n);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		pos += n;
+
+		rc = bitInit(&br, src + pos, len - pos);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		llState = (U32)bitRead(&br, ctx->ll.al);
+		ofState = (U32)bitRead(&br, ctx->of.al);
+		mlState = (U32)bitRead(&br, ctx->ml.al);
+		bitReload(&br);
+
+		for (i = 0; i < nbSeq; i++) {
+			const FSEEntry* llE = &ctx->ll.table[llState];
+			const FSEEntry* ofE = &ctx->of.table[ofState];
+			const FSEEntry* mlE = &ctx->ml.table[mlState];
+			const unsigned ofCode = ofE->symbol;
+			U32 offsetValue;
+			size_t offset;
+			size_t ml;
+			size_t ll;
+
+			if (ofCode > OF_MAX_CODE) {
+				return ZSTD_CORRUPT;
+			}
+			offsetValue = (1U << ofCode) + (U32)bitRead(&br, ofCode);
+			if (ofCode + mlBits[mlE->symbol] + llBits[llE->symbol] > 56) {
+				bitReload(&br);
+			}
+			ml = mlBase[mlE->symbol] + (size_t)bitRead(&br, mlBits[mlE->symbol]);
+			ll = llBase[llE->symbol] + (size_t)bitRead(&br, llBits[llE->symbol]);
+
+			/* Repeat offsets */
+			if (offsetValue > 3) {
+				offset = offsetValue - 3;
+				ctx->rep[2] = ctx->rep[1];
+				ctx->rep[1] = ctx->rep[0];
+				ctx->rep[0] = (U32)offset;
+			}
+			else {
+				unsigned idx = offsetValue - 1 + (ll == 0 ? 1 : 0);
+				if (idx == 0) {
+					offset = ctx->rep[0];
+				}
+				else {
+					offset = idx == 3 ? ctx->rep[0] - 1 : ctx->rep[idx];
+					if (idx != 1) {
+						ctx->rep[2] = ctx->rep[1];
+					}
+					ctx->rep[1] = ctx->rep[0];
+					ctx->rep[0] = (U32)offset;
+				}
+			}
+
+			rc = execSequence(ctx, &lit, litEnd, ll, ml, offset);
+			if (rc != ZSTD_OK) {
+				return rc;
+			}
+
+			if (i + 1 < nbSeq) {
+				bitReload(&br);
+				llState = llE->base + (U32)bitRead(&br, llE->nbBits);
+				mlState = mlE->base + (U32)bitRead(&br, mlE->nbBits);
+				ofState = ofE->base + (U32)bitRead(&br, ofE->nbBits);
+				bitReload(&br);
+			}
+		}
+		if (!bitFinished(&br)) {
+			return ZSTD_CORRUPT;
+		}
+	}
+
+	/* Remaining literals */
+	n = (size_t)(litEnd - lit);
+	rc = reserve(ctx, n);
+	if (rc != ZSTD_OK) {
+		return rc;
+	}
+	memcpy(ctx->dst + ctx->pos, lit, n);
+	ctx->pos += n;
+	return ZSTD_OK;
+}
+
+static int decodeBlock(ZSTDContext* ctx, const BYTE* src, size_t len)
+{
+	const BYTE* lit;
+	size_t litLen;
+	size_t consumed;
+	int rc;
+	if (len == 0) {
+		return ZSTD_CORRUPT;
+	}
+	rc = decodeLiterals(ctx, src, len, &lit, &litLen, &consumed);
+	if (rc != ZSTD_OK) {
+		return rc;
+	}
+	return decodeSequences(ctx, src + consumed, len - consumed, lit, litLen);
+}
+
+/* Frames */
+
+static int readFrameHeader(const BYTE* src, size_t len, FrameHeader* fh)
+{
+	static const unsigned dictIDSizes[4] = {0, 1, 2, 4};
+	static const unsigned fcsSizes[4] = {0, 2, 4, 8};
+	unsigned fhd;
+	unsigned singleSegment;
+	unsigned dictIDSize;
+	unsigned fcsSize;
+	size_t pos = 5;
+
+	if (len < 5 || readLE32(src) != ZSTD_MAGIC) {
+		return ZSTD_CORRUPT;
+	}
+	fhd = src[4];
+	if ((fhd & 0x08) != 0) {
+		return ZSTD_CORRUPT;
+	}
+	singleSegment = (fhd >> 5) & 1;
+	dictIDSize = dictIDSizes[fhd & 3];
+	fcsSize = fcsSizes[fhd >> 6];
+	if (fcsSize == 0 && singleSegment) {
+		fcsSize = 1;
+	}
+	if (!singleSegment) {
+		/* Window descriptor, not needed as the whole content is kept */
+		pos++;
+	}
+	if (len < pos + dictIDSize + fcsSize) {
+		return ZSTD_CORRUPT;
+	}
+	if (dictIDSize > 0) {
+		U32 dictID = 0;
+		unsigned i;
+		for (i = 0; i < dictIDSize; i++) {
+			dictID |= (U32)src[pos + i] << (8*i);
+		}
+		if (dictID != 0) {
+			return ZSTD_UNSUPPORTED;
+		}
+		pos += dictIDSize;
+	}
+	fh->hasContentSize = fcsSize > 0;
+	switch (fcsSize) {
+		case 1:
+			fh->contentSize = src[pos];
+			break;
+		case 2:
+			fh->contentSize = readLE16(src + pos) + 256;
+			break;
+		case 4:
+			fh->contentSize = readLE32(src + pos);
+			break;
+		case 8:
+			fh->contentSize = readLE64(src + pos);
+			break;
+		default:
+			fh->contentSize = 0;
+			break;
+	}
+	pos += fcsSize;
+	fh->hasChecksum = (fhd >> 2) & 1;
+	fh->headerSize = pos;
+	return ZSTD_OK;
+}
+
+/* Compute the total content size of all frames without decoding, returns
+ * ZSTD_UNSUPPORTED if a frame does not declare its content size
+ */
+static int scanFrames(const BYTE* src, size_t len, U64* total)
+{
+	*total = 0;
+	while (len > 0) {
+		U32 magic;
+		size_t pos;
+		FrameHeader fh;
+		int rc;
+		if (len < 8) {
+			return ZSTD_CORRUPT;
+		}
+		magic = readLE32(src);
+		if ((magic & ZSTD_SKIPPABLE_MASK) == ZSTD_SKIPPABLE_MAGIC) {
+			size_t size = readLE32(src + 4);
+			if (len - 8 < size) {
+				return ZSTD_CORRUPT;
+			}
+			src += 8 + size;
+			len -= 8 + size;
+			continue;
+		}
+		rc = readFrameHeader(src, len, &fh);
+		if (rc != ZSTD_OK) {
+			return rc;
+		}
+		if (!fh.hasContentSize) {
+			return ZSTD_UNSUPPORTED;
+		}
+		*total += fh.contentSize;
+		pos = fh.headerSize;
+		for (;;) {
+			U32 bh;
+			size_t size;
+			if (len - pos < 3) {
+				return ZSTD_CORRUPT;
+			}
+			bh = readLE24(src + pos);
+			pos += 3;
+			size = ((bh >> 1) & 3) == 1 ? 1 : bh >> 3;
+			if (len - pos < size) {
+				return ZSTD_CORRUPT;
+			}
+			pos += size;
+			if (bh & 1) {
+				break;
+			}
+		}
+		if (fh.hasChecksum) {
+			pos += 4;
+		}
+		if (pos > len) {
+			return ZSTD_CORRUPT;
+		}
+		src += pos;
+		len -= pos;
+	}
+	return ZSTD_OK;
+}
+
+static int decodeFrame(ZSTDContext* ctx, const BYTE* src, size_t len, size_t* consumed)
+{
+	FrameHeader fh;
+	size_t pos;
+	int rc = readFrameHeader(src, len, &fh);
+	if (rc != ZSTD_OK) {
+		return rc;
+	}
+	pos = fh.headerSize;
+	ctx->frameStart = ctx->pos;
+	ctx->rep[0] = 1;
+	ctx->rep[1] = 4;
+	ctx->rep[2] = 8;
+	ctx->hasHuf = 0;
+	ctx->hasLL = 0;
+	ctx->hasOF = 0;
+	ctx->hasML = 0;
+
+	for (;;) {
+		U32 bh;
+		unsigned last;
+		size_t size;
+		if (len - pos < 3) {
+			return ZSTD_CORRUPT;
+		}
+		bh = readLE24(src + pos);
+		pos += 3;
+		last = bh & 1;
+		size = bh >> 3;
+		switch ((bh >> 1) & 3) {
+			case 0: /* Raw block */
+				if (len - pos < size) {
+					return ZSTD_CORRUPT;
+				}
+				rc = reserve(ctx, size);
+				if (rc != ZSTD_OK) {
+					return rc;
+				}
+				memcpy(ctx->dst + ctx->pos, src + pos, size);
+				ctx->pos += size;
+				pos += size;
+				break;
+
+			case 1: /* RLE block */
+				if (len - pos < 1) {
+					return ZSTD_CORRUPT;
+				}
+				rc = reserve(ctx, size);
+				if (rc != ZSTD_OK) {
+					return rc;
+				}
+				memset(ctx->dst + ctx->pos, src[pos], size);
+				ctx->pos += size;
+				pos++;
+				break;
+
+			case 2: /* Compressed block */
+				if (len - pos < size || size > ZSTD_BLOCKSIZE_MAX) {
+					return ZSTD_CORRUPT;
+				}
+				rc = decodeBlock(ctx, src + pos, size);
+				if (rc != ZSTD_OK) {
+					return rc;
+				}
+				pos += size;
+				break;
+
+			default:
+				return ZSTD_CORRUPT;
+		}
+		if (last) {
+			break;
+		}
+	}
+
+	if (fh.hasContentSize && fh.contentSize != (U64)(ctx->pos - ctx->frameStart)) {
+		return ZSTD_CORRUPT;
+	}
+	if (fh.hasChecksum) {
+		U32 checksum;
+		if (len - pos < 4) {
+			return ZSTD_CORRUPT;
+		}
+		checksum = (U32)xxh64(ctx->dst + ctx->frameStart, ctx->pos - ctx->frameStart);
+		if (checksum != readLE32(src + pos)) {
+			return ZSTD_CORRUPT;
+		}
+		pos += 4;
+	}
+	*consumed = pos;
+	return ZSTD_OK;
+}
+
+static int decodeFrames(ZSTDContext* ctx, const BYTE* src, size_t len)
+{
+	while (len > 0) {
+		size_t consumed;
+		if (len < 4) {
+			return ZSTD_CORRUPT;
+		}
+		if ((readLE32(src) & ZSTD_SKIPPABLE_MASK) == ZSTD_SKIPPABLE_MAGIC) {
+			if (len < 8 || len - 8 < readLE32(src + 4)) {
+				return ZSTD_CORRUPT;
+			}
+			consumed = 8 + (size_t)readLE32(src + 4);
+		}
+		else {
+			int rc = decodeFrame(ctx, src, len, &consumed);
+			if (rc != ZSTD_OK) {
+				return rc;
+			}
+		}
+		src += consumed;
+		len -= consumed;
+	}
+	return ZSTD_OK;
+}
+
+static void setErrno(int rc)
+{
+	switch (rc) {
+		case ZSTD_NOMEM:
+			errno = ENOMEM;
+			break;
+		case ZSTD_NOSPACE:
+			errno = ERANGE;
+			break;
+		default:
+			errno = EINVAL;
+			break;
+	}
+}
+
+int ED_zstdIsFrame(const void* src, size_t len)
+{
+	U32 magic;
+	if (src == NULL || len < 4) {
+		return 0;
+	}
+	magic = readLE32((const BYTE*)src);
+	return magic == ZSTD_MAGIC ||
+		(magic & ZSTD_SKIPPABLE_MASK) == ZSTD_SKIPPABLE_MAGIC;
+}
+
+char* ED_zstdDecompress(const void* src, size_t len, size_t* dstLen)
+{
+	ZSTDContext* ctx;
+	U64 total;
+	char* dst;
+	int rc;
+
+	if (src == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	ctx = (ZSTDContext*)malloc(sizeof(ZSTDContext));
+	if (ctx == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	rc = scanFrames((const BYTE*)src, len, &total);
+	if (rc == ZSTD_OK && total == (U64)(size_t)total && (size_t)total + 1 != 0) {
+		/* Content size is known in advance */
+		ctx->cap = (size_t)total;
+		ctx->growable = 0;
+	}
+	else if (rc == ZSTD_OK || rc == ZSTD_UNSUPPORTED) {
+		ctx->cap = ZSTD_BLOCKSIZE_MAX > 4*len ? ZSTD_BLOCKSIZE_MAX : 4*len;
+		ctx->growable = 1;
+	}
+	else {
+		free(ctx);
+		setErrno(rc);
+		return NULL;
+	}
+	ctx->dst = (BYTE*)malloc(ctx->cap + 1);
+	if (ctx->dst == NULL) {
+		free(ctx);
+		errno = ENOMEM;
+		return NULL;
+	}
+	ctx->pos = 0;
+	rc = decodeFrames(ctx, (const BYTE*)src, len);
+	if (rc != ZSTD_OK) {
+		free(ctx->dst);
+		free(ctx);
+		setErrno(rc);
+		return NULL;
+	}
+	dst = (char*)ctx->dst;
+	dst[ctx->pos] = '\0';
+	if (dstLen != NULL) {
+		*dstLen = ctx->pos;
+	}
+	free(ctx);
+	return dst;
+}
+
+size_t ED_zstdDecompressTo(void* dst, size_t dstCap, const void* src, size_t len)
+{
+	ZSTDContext* ctx;
+	size_t dstLen;
+	int rc;
+
+	if (dst == NULL || src == NULL) {
+		errno = EINVAL;
+		return (size_t)-1;
+	}
+	ctx = (ZSTDContext*)malloc(sizeof(ZSTDContext));
+	if (ctx == NULL) {
+		errno = ENOMEM;
+		return (size_t)-1;
+	}
+	ctx->dst = (BYTE*)dst;
+	ctx->cap = dstCap;
+	ctx->pos = 0;
+	ctx->growable = 0;
+	rc = decodeFrames(ctx, (const BYTE*)src, len);
+	dstLen = ctx->pos;
+	free(ctx);
+	if (rc != ZSTD_OK) {
+		setErrno(rc);
+		return (size_t)-1;
+	}
+	return dstLen;
+}
@@ -0,0 +1,52 @@
+/* ED_zstd.h - Zstandard frame decoder
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_ZSTD_H)
+#define ED_ZSTD_H
+
+#include <stdlib.h>
+
+/* Dependency-free decoder for Zstandard frames (RFC 8878) without
+ * dictionaries. Concatenated and skippable frames are supported, the
+ * optional content checksum is verified.
+ */
+
+/* Return 1 if src starts with a Zstandard (or skippable) frame */
+int ED_zstdIsFrame(const void* src, size_t len);
+
+/* Decompress all frames of src into a newly allocated, null-terminated
+ * buffer that must be released by free. Returns NULL and sets errno
+ * on failure.
+ */
+char* ED_zstdDecompress(const void* src, size_t len, size_t* dstLen);
+
+/* Decompress all frames of src into dst of capacity dstCap, e.g. for
+ * cached data of known size. Returns the number of decompressed bytes
+ * or (size_t)-1 and sets errno on failure.
+ */
+size_t ED_zstdDecompressTo(void* dst, size_t dstCap, const void* src, size_t len);
+
+#endif
@@ -57,8 +57,9 @@ static int cpo_array_preallocate(cpo_array_t *a, asize_t elements)
     void *newv;
     asize_t newmax = a->max;
 
+    /* grow geometrically to keep repeated pushes linear */
     while (elements >= newmax) {
-        newmax = (newmax + 1);
+        newmax = newmax < 4 ? newmax + 4 : newmax + newmax/2;
     }
 
     newv = realloc(a->v, newmax * a->elem_size);
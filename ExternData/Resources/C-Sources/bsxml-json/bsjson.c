@@ -621,6 +621,12 @@ static void JsonParser_stripCommentsFromBuffer(char *buff, long size)
     }
 }
 
+JsonNode * JsonParser_parseBuffer(struct JsonParser *parser, char * buffer, long length)
+{
+    JsonParser_stripCommentsFromBuffer(buffer, length);
+    return JsonParser_parse(parser, buffer);
+}
+
 JsonNode * JsonParser_parseFile(struct JsonParser *parser, const char * fileName)
 {
     JsonNode * root = NULL;
@@ -640,8 +646,7 @@ JsonNode * JsonParser_parseFile(struct JsonParser *parser, const char * fileName
         }
         fclose (f);
         if (read == length) {
-            JsonParser_stripCommentsFromBuffer(buffer, length);
-            root = JsonParser_parse(parser,  buffer);
+            root = JsonParser_parseBuffer(parser, buffer, length);
         } else {
             parser->m_errorString = strerror(errno);
             parser->m_errorLine = 0;
@@ -78,6 +78,8 @@ struct JsonParser {
 
 JsonNode *JsonParser_parse(JsonParser *parser, const char * json);
 JsonNode *JsonParser_parseFile(JsonParser *parser, const char *fileName);
+/* parse a null-terminated buffer of length bytes, comments are stripped in place */
+JsonNode *JsonParser_parseBuffer(JsonParser *parser, char *buffer, long length);
 String JsonParser_getErrorString(JsonParser *parser);
 int JsonParser_getErrorLine(JsonParser *parser);
 int JsonParser_getErrorLineSet(JsonParser *parser);
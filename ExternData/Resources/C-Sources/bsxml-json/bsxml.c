@@ -34,6 +34,9 @@
 #define XMLTREE_CHILDSIZE   8
 #define XMLTREE_ATTRSIZE    4
 #define XMLTREE_STACKSIZE   32
+/* chunk sizes for incremental parsing */
+#define XMLTREE_STREAMCHUNK 65536
+#define XMLTREE_MAXCHUNK    (1 << 30)
 
 #define ENC_TYPE_UTF8   "UTF-8"
 
@@ -452,12 +455,11 @@ void XmlNode_toFile(struct XmlNode *node, const char *fileName)
     }
 }
 /*parser */
-static void startElement(void *userData, const char *name, const char **atts)
+static void XmlParser_startNode(XmlParser *parser, const char *name, const char **atts, int line)
 {
     asize_t i = 0;
     void *ptr = NULL;
     XmlNodeRef parent= NULL, node=NULL;
-    XmlParser *parser = (XmlParser *)userData;
 
     if (parser->m_nodeStack->num > 0) {
         ptr = stack_back(parser->m_nodeStack);
@@ -477,7 +479,7 @@ static void startElement(void *userData, const char *name, const char **atts)
         ARR_VAL(ptr) = ARR_VAL2PTR(node);
     }
 
-    XmlNode_setLine(node, XML_GetCurrentLineNumber( parser->m_parser ) );
+    XmlNode_setLine(node, line);
 
     // Call start element callback.
     while (atts[i] != 0) {
@@ -486,6 +488,41 @@ static void startElement(void *userData, const char *name, const char **atts)
     }
 }
 
+static void XmlParser_characters(XmlParser *parser, const char *s, size_t len)
+{
+    if (parser->m_nodeStack->num > 0) {
+        void *ptr = stack_back(parser->m_nodeStack);
+        XmlNode *node = (XmlNode*) ARR_VAL(ptr);
+        char *str;
+        if (node->m_content == NULL) {
+            /* first piece, store it directly as XmlNode_setValue would */
+            size_t i;
+            for (i = 0; i < len; i++) {
+                if (s[i] != ' ' && s[i] != '\r' && s[i] != '\n' && s[i] != '\t') {
+                    break;
+                }
+            }
+            if (i < len && (node->m_content = (char*)malloc(len + 1)) != NULL) {
+                memcpy(node->m_content, s, len);
+                node->m_content[len] = 0;
+            }
+            return;
+        }
+        str = (char*)malloc(len + 1);
+        if (!str) return;
+        memcpy(str,s,len);
+        str[len] = 0;
+        XmlNode_setValue(node, str);
+        free(str);
+    }
+}
+
+static void startElement(void *userData, const char *name, const char **atts)
+{
+    XmlParser *parser = (XmlParser *)userData;
+    XmlParser_startNode(parser, name, atts, (int)XML_GetCurrentLineNumber( parser->m_parser ) );
+}
+
 static void endElement(void *userData, const char *name )
 {
     XmlParser *parser = (XmlParser *)userData;
@@ -498,20 +535,823 @@ static void endElement(void *userData, const char *name )
 
 static void characterData( void *userData, const char *s, int len )
 {
-    XmlParser *parser = (XmlParser *)userData;
+    XmlParser_characters((XmlParser *)userData, s, (size_t)len);
+}
 
-    if (parser->m_nodeStack->num > 0) {
-        void *ptr = stack_back(parser->m_nodeStack);
-        XmlNode *node = (XmlNode*) ARR_VAL(ptr);
-        char *str = (char*)malloc(len + 1);
-        if (!str) return;
-        strncpy(str,s,len);
-        str[len] = 0;
-        XmlNode_setValue(node, str);
-        free(str);
+/* fast path parser
+ *
+ * Most documents we read (XLSX parts, generated data files) are DTD-free
+ * UTF-8 with only the predefined entities. For these the tokenizer below
+ * builds the same tree as expat: character data is reported in the same
+ * pieces (split at line breaks and references, CDATA also at ']') so that
+ * XmlNode_setValue joins them identically, and line numbers are counted the
+ * same way. Runs of text, attribute values, comments, PIs and CDATA are
+ * scanned 16 bytes at a time with SSE2 where available. Anything else
+ * (DOCTYPE, other encodings, non-ASCII names, undefined entities, malformed
+ * input) makes XmlFast_parse give up and the document is parsed by expat,
+ * which also reports the errors.
+ */
+#if !defined(XMLTREE_NO_FASTPARSE)
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMLTREE_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+typedef struct XmlFast {
+    XmlParser *parser;
+    const unsigned char *p;
+    const unsigned char *end;
+    int line;
+    /* scratch for the null-terminated tag and attribute names and values */
+    char *buf;
+    size_t bufLen;
+    size_t bufCap;
+    /* offsets into buf of tag name and attribute name/value pairs */
+    size_t *off;
+    size_t offCap;
+    const char **atts;
+} XmlFast;
+
+#define isSpace(c) \
+    (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+
+#define isNameStart(c) \
+    (isAlpha(c) || c == '_' || c == ':')
+
+#define isNameChar(c) \
+    (isAlphaNumeric(c) || c == '_' || c == ':' || c == '-' || c == '.')
+
+#if defined(XMLTREE_SSE2)
+static int XmlFast_firstBit(unsigned mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (int)i;
+#else
+    int i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+#endif
+
+/* return the first byte that is a, b or c, a control character (tab only if
+ * stopTab is set) or non-ASCII, or end if there is none
+ */
+static const unsigned char *XmlFast_scan(const unsigned char *p, const unsigned char *end,
+    unsigned char a, unsigned char b, unsigned char c, int stopTab)
+{
+#if defined(XMLTREE_SSE2)
+    const __m128i va = _mm_set1_epi8((char)a);
+    const __m128i vb = _mm_set1_epi8((char)b);
+    const __m128i vc = _mm_set1_epi8((char)c);
+    const __m128i vsp = _mm_set1_epi8(' ');
+    /* exempt tab from the control characters unless stopTab is set, space
+     * is no control character */
+    const __m128i vtab = _mm_set1_epi8(stopTab ? ' ' : '\t');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)), _mm_cmpeq_epi8(v, vc));
+        /* bytes < 0x20 and, as signed, >= 0x80 */
+        __m128i ctl = _mm_andnot_si128(_mm_cmpeq_epi8(v, vtab), _mm_cmplt_epi8(v, vsp));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(m, ctl));
+        if (mask != 0) {
+            return p + XmlFast_firstBit(mask);
+        }
+        p += 16;
+    }
+#endif
+    for (; p < end; p++) {
+        unsigned char ch = *p;
+        if (ch == a || ch == b || ch == c || ch >= 0x80 ||
+            (ch < 0x20 && (stopTab || ch != '\t'))) {
+            break;
+        }
+    }
+    return p;
+}
+
+/* return the length of the valid UTF-8 encoded XML character at p or 0 */
+static size_t XmlFast_utf8(const unsigned char *p, const unsigned char *end)
+{
+    size_t n, i;
+    unsigned char c = p[0];
+    if (c < 0xC2) {
+        return 0;
+    }
+    else if (c < 0xE0) {
+        n = 2;
+    }
+    else if (c < 0xF0) {
+        n = 3;
+    }
+    else if (c < 0xF5) {
+        n = 4;
+    }
+    else {
+        return 0;
+    }
+    if ((size_t)(end - p) < n) {
+        return 0;
+    }
+    for (i = 1; i < n; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    if (n == 3) {
+        /* overlong, surrogates, U+FFFE and U+FFFF */
+        if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] >= 0xA0) ||
+            (c == 0xEF && p[1] == 0xBF && p[2] >= 0xBE)) {
+            return 0;
+        }
+    }
+    else if (n == 4) {
+        if ((c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] >= 0x90)) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+/* advance over the line break at p */
+static void XmlFast_newline(XmlFast *f)
+{
+    if (*f->p++ == '\r' && f->p < f->end && *f->p == '\n') {
+        f->p++;
+    }
+    f->line++;
+}
+
+/* skip white space, return 1 if there was any */
+static int XmlFast_skipSpace(XmlFast *f)
+{
+    const unsigned char *start = f->p;
+    while (f->p < f->end && isSpace(*f->p)) {
+        if (*f->p == '\r' || *f->p == '\n') {
+            XmlFast_newline(f);
+        }
+        else {
+            f->p++;
+        }
+    }
+    return f->p != start;
+}
+
+static int XmlFast_append(XmlFast *f, const void *s, size_t len)
+{
+    if (f->bufLen + len > f->bufCap) {
+        size_t cap = f->bufCap > 0 ? f->bufCap : 256;
+        char *buf;
+        while (cap < f->bufLen + len) {
+            cap *= 2;
+        }
+        buf = (char *)realloc(f->buf, cap);
+        if (buf == NULL) {
+            return XML_NOK;
+        }
+        f->buf = buf;
+        f->bufCap = cap;
+    }
+    memcpy(f->buf + f->bufLen, s, len);
+    f->bufLen += len;
+    return XML_OK;
+}
+
+/* make room for offset off[i] */
+static int XmlFast_reserve(XmlFast *f, size_t i)
+{
+    if (i >= f->offCap) {
+        size_t cap = f->offCap > 0 ? 2*f->offCap : 16;
+        size_t *off = (size_t *)realloc(f->off, cap*sizeof(size_t));
+        const char **atts;
+        if (off == NULL) {
+            return XML_NOK;
+        }
+        f->off = off;
+        atts = (const char **)realloc((void *)f->atts, (cap + 1)*sizeof(char *));
+        if (atts == NULL) {
+            return XML_NOK;
+        }
+        f->atts = atts;
+        f->offCap = cap;
+    }
+    return XML_OK;
+}
+
+/* scan a name into the scratch buffer and record its offset at off[i] */
+static int XmlFast_name(XmlFast *f, size_t i)
+{
+    const unsigned char *start = f->p;
+    if (f->p >= f->end || !isNameStart(*f->p)) {
+        return XML_NOK;
     }
+    do {
+        f->p++;
+    } while (f->p < f->end && isNameChar(*f->p));
+    if ((f->p < f->end && *f->p >= 0x80) || !XmlFast_reserve(f, i)) {
+        /* non-ASCII name or out of memory */
+        return XML_NOK;
+    }
+    f->off[i] = f->bufLen;
+    return XmlFast_append(f, start, (size_t)(f->p - start)) &&
+        XmlFast_append(f, "", 1);
 }
 
+/* decode the reference at p (after '&') to UTF-8 in buf, return its length */
+static size_t XmlFast_reference(XmlFast *f, char *buf)
+{
+    const unsigned char *p = f->p;
+    const unsigned char *end = f->end;
+    if (p < end && *p == '#') {
+        unsigned long c = 0;
+        int hex = 0, digits = 0;
+        p++;
+        if (p < end && *p == 'x') {
+            hex = 1;
+            p++;
+        }
+        for (; p < end && *p != ';'; p++, digits++) {
+            unsigned d;
+            if (isDigit(*p)) {
+                d = *p - '0';
+            }
+            else if (hex && *p >= 'a' && *p <= 'f') {
+                d = *p - 'a' + 10;
+            }
+            else if (hex && *p >= 'A' && *p <= 'F') {
+                d = *p - 'A' + 10;
+            }
+            else {
+                return 0;
+            }
+            c = c*(hex ? 16 : 10) + d;
+            if (c >= 0x110000) {
+                return 0;
+            }
+        }
+        if (p >= end || digits == 0) {
+            return 0;
+        }
+        f->p = p + 1;
+        if (c < 0x20 && c != 0x9 && c != 0xA && c != 0xD) {
+            return 0;
+        }
+        else if (c < 0x80) {
+            buf[0] = (char)c;
+            return 1;
+        }
+        else if (c < 0x800) {
+            buf[0] = (char)(0xC0 | (c >> 6));
+            buf[1] = (char)(0x80 | (c & 0x3F));
+            return 2;
+        }
+        else if (c < 0x10000) {
+            if ((c >= 0xD800 && c <= 0xDFFF) || c >= 0xFFFE) {
+                return 0;
+            }
+            buf[0] = (char)(0xE0 | (c >> 12));
+            buf[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+            buf[2] = (char)(0x80 | (c & 0x3F));
+            return 3;
+        }
+        buf[0] = (char)(0xF0 | (c >> 18));
+        buf[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (c & 0x3F));
+        return 4;
+    }
+    else {
+        static const char *names[] = {"lt;", "gt;", "amp;", "quot;", "apos;"};
+        static const char chars[] = "<>&\"'";
+        size_t i;
+        for (i = 0; i < sizeof(chars) - 1; i++) {
+            size_t len = strlen(names[i]);
+            if ((size_t)(end - p) >= len && memcmp(p, names[i], len) == 0) {
+                f->p = p + len;
+                buf[0] = chars[i];
+                return 1;
+            }
+        }
+    }
+    /* undefined entity or malformed reference */
+    return 0;
+}
+
+/* skip a character at p that stopped a scan and is neither a line break nor
+ * one of the markup characters
+ */
+static int XmlFast_other(XmlFast *f)
+{
+    size_t n;
+    if (*f->p < 0x80) {
+        return *f->p == '\t' ? (f->p++, XML_OK) : XML_NOK;
+    }
+    n = XmlFast_utf8(f->p, f->end);
+    f->p += n;
+    return n > 0;
+}
+
+/* p after "<!--" */
+static int XmlFast_comment(XmlFast *f)
+{
+    for (;;) {
+        f->p = XmlFast_scan(f->p, f->end, '-', '-', '-', 0);
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        if (*f->p == '-') {
+            if (f->end - f->p >= 2 && f->p[1] == '-') {
+                /* "--" must end the comment */
+                if (f->end - f->p < 3 || f->p[2] != '>') {
+                    return XML_NOK;
+                }
+                f->p += 3;
+                return XML_OK;
+            }
+            f->p++;
+        }
+        else if (*f->p == '\r' || *f->p == '\n') {
+            XmlFast_newline(f);
+        }
+        else if (!XmlFast_other(f)) {
+            return XML_NOK;
+        }
+    }
+}
+
+/* p after "<?" */
+static int XmlFast_pi(XmlFast *f)
+{
+    const unsigned char *target = f->p;
+    if (f->p >= f->end || !isNameStart(*f->p)) {
+        return XML_NOK;
+    }
+    do {
+        f->p++;
+    } while (f->p < f->end && isNameChar(*f->p));
+    if (f->p - target == 3 && (target[0] | 0x20) == 'x' &&
+        (target[1] | 0x20) == 'm' && (target[2] | 0x20) == 'l') {
+        /* misplaced XML declaration or reserved target */
+        return XML_NOK;
+    }
+    if (!XmlFast_skipSpace(f)) {
+        if (f->end - f->p >= 2 && f->p[0] == '?' && f->p[1] == '>') {
+            f->p += 2;
+            return XML_OK;
+        }
+        return XML_NOK;
+    }
+    for (;;) {
+        f->p = XmlFast_scan(f->p, f->end, '?', '?', '?', 0);
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        if (*f->p == '?') {
+            f->p++;
+            if (f->p < f->end && *f->p == '>') {
+                f->p++;
+                return XML_OK;
+            }
+        }
+        else if (*f->p == '\r' || *f->p == '\n') {
+            XmlFast_newline(f);
+        }
+        else if (!XmlFast_other(f)) {
+            return XML_NOK;
+        }
+    }
+}
+
+/* p after "<![CDATA[" */
+static int XmlFast_cdata(XmlFast *f)
+{
+    const unsigned char *s = f->p;
+    for (;;) {
+        f->p = XmlFast_scan(f->p, f->end, ']', ']', ']', 0);
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        if (*f->p == ']') {
+            if (f->p > s) {
+                XmlParser_characters(f->parser, (const char *)s, (size_t)(f->p - s));
+            }
+            s = f->p;
+            if (f->end - f->p >= 3 && f->p[1] == ']' && f->p[2] == '>') {
+                f->p += 3;
+                return XML_OK;
+            }
+            f->p++;
+        }
+        else if (*f->p == '\r' || *f->p == '\n') {
+            if (f->p > s) {
+                XmlParser_characters(f->parser, (const char *)s, (size_t)(f->p - s));
+            }
+            XmlFast_newline(f);
+            s = f->p;
+        }
+        else if (!XmlFast_other(f)) {
+            return XML_NOK;
+        }
+    }
+}
+
+/* character data up to the next '<' */
+static int XmlFast_text(XmlFast *f)
+{
+    const unsigned char *s = f->p;
+    for (;;) {
+        f->p = XmlFast_scan(f->p, f->end, '<', '&', ']', 0);
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        switch (*f->p) {
+            case '<':
+                if (f->p > s) {
+                    XmlParser_characters(f->parser, (const char *)s, (size_t)(f->p - s));
+                }
+                return XML_OK;
+
+            case '&': {
+                char buf[4];
+                size_t n;
+                if (f->p > s) {
+                    XmlParser_characters(f->parser, (const char *)s, (size_t)(f->p - s));
+                }
+                f->p++;
+                n = XmlFast_reference(f, buf);
+                if (n == 0) {
+                    return XML_NOK;
+                }
+                XmlParser_characters(f->parser, buf, n);
+                s = f->p;
+                break;
+            }
+
+            case ']':
+                if (f->end - f->p >= 3 && f->p[1] == ']' && f->p[2] == '>') {
+                    return XML_NOK;
+                }
+                f->p++;
+                break;
+
+            case '\r':
+            case '\n':
+                /* the line break itself is white space and not stored */
+                if (f->p > s) {
+                    XmlParser_characters(f->parser, (const char *)s, (size_t)(f->p - s));
+                }
+                XmlFast_newline(f);
+                s = f->p;
+                break;
+
+            default:
+                if (!XmlFast_other(f)) {
+                    return XML_NOK;
+                }
+                break;
+        }
+    }
+}
+
+/* attribute value after the opening quote, normalized into the scratch buffer */
+static int XmlFast_value(XmlFast *f, unsigned char quote)
+{
+    const unsigned char *s = f->p;
+    for (;;) {
+        f->p = XmlFast_scan(f->p, f->end, quote, '<', '&', 1);
+        if (f->p >= f->end || *f->p == '<') {
+            return XML_NOK;
+        }
+        if (!XmlFast_append(f, s, (size_t)(f->p - s))) {
+            return XML_NOK;
+        }
+        if (*f->p == quote) {
+            f->p++;
+            return XmlFast_append(f, "", 1);
+        }
+        else if (*f->p == '&') {
+            char buf[4];
+            size_t n;
+            f->p++;
+            n = XmlFast_reference(f, buf);
+            if (n == 0 || !XmlFast_append(f, buf, n)) {
+                return XML_NOK;
+            }
+        }
+        else if (isSpace(*f->p)) {
+            if (*f->p == '\t') {
+                f->p++;
+            }
+            else {
+                XmlFast_newline(f);
+            }
+            if (!XmlFast_append(f, " ", 1)) {
+                return XML_NOK;
+            }
+        }
+        else {
+            s = f->p;
+            if (!XmlFast_other(f)) {
+                return XML_NOK;
+            }
+            continue;
+        }
+        s = f->p;
+    }
+}
+
+/* p after '<', return 1 for a start tag, 2 for an empty element tag */
+static int XmlFast_startTag(XmlFast *f)
+{
+    int line = f->line;
+    size_t i, j, n = 1;
+    f->bufLen = 0;
+    if (!XmlFast_name(f, 0)) {
+        return XML_NOK;
+    }
+    for (;;) {
+        int space = XmlFast_skipSpace(f);
+        int empty = 0;
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        if (*f->p == '/') {
+            if (f->end - f->p < 2 || f->p[1] != '>') {
+                return XML_NOK;
+            }
+            f->p++;
+            empty = 1;
+        }
+        if (*f->p == '>') {
+            f->p++;
+            for (i = 1; i < n; i++) {
+                f->atts[i - 1] = f->buf + f->off[i];
+            }
+            f->atts[n - 1] = NULL;
+            XmlParser_startNode(f->parser, f->buf + f->off[0], f->atts, line);
+            return 1 + empty;
+        }
+        if (!space || !XmlFast_name(f, n)) {
+            return XML_NOK;
+        }
+        for (j = 1; j < n; j += 2) {
+            if (strcmp(f->buf + f->off[j], f->buf + f->off[n]) == 0) {
+                /* duplicate attribute */
+                return XML_NOK;
+            }
+        }
+        XmlFast_skipSpace(f);
+        if (f->p >= f->end || *f->p != '=') {
+            return XML_NOK;
+        }
+        f->p++;
+        XmlFast_skipSpace(f);
+        if (f->p >= f->end || (*f->p != '"' && *f->p != '\'')) {
+            return XML_NOK;
+        }
+        f->p++;
+        if (!XmlFast_reserve(f, n + 1)) {
+            return XML_NOK;
+        }
+        f->off[n + 1] = f->bufLen;
+        if (!XmlFast_value(f, f->p[-1])) {
+            return XML_NOK;
+        }
+        n += 2;
+    }
+}
+
+/* p after "</" */
+static int XmlFast_endTag(XmlFast *f)
+{
+    const unsigned char *name = f->p;
+    XmlNodeRef node;
+    size_t len;
+    if (f->p >= f->end || !isNameStart(*f->p)) {
+        return XML_NOK;
+    }
+    do {
+        f->p++;
+    } while (f->p < f->end && isNameChar(*f->p));
+    len = (size_t)(f->p - name);
+    node = (XmlNodeRef)ARR_VAL(stack_back(f->parser->m_nodeStack));
+    if (strlen(node->m_tag) != len || memcmp(node->m_tag, name, len) != 0) {
+        return XML_NOK;
+    }
+    XmlFast_skipSpace(f);
+    if (f->p >= f->end || *f->p != '>') {
+        return XML_NOK;
+    }
+    f->p++;
+    stack_pop_back(f->parser->m_nodeStack);
+    return XML_OK;
+}
+
+/* root element at p, return after its end tag */
+static int XmlFast_element(XmlFast *f)
+{
+    for (;;) {
+        /* p at '<' */
+        const unsigned char *p = f->p + 1;
+        size_t left = (size_t)(f->end - p);
+        if (left > 0 && *p == '/') {
+            f->p = p + 1;
+            if (!XmlFast_endTag(f)) {
+                return XML_NOK;
+            }
+        }
+        else if (left >= 3 && memcmp(p, "!--", 3) == 0) {
+            f->p = p + 3;
+            if (!XmlFast_comment(f)) {
+                return XML_NOK;
+            }
+        }
+        else if (left >= 8 && memcmp(p, "![CDATA[", 8) == 0) {
+            f->p = p + 8;
+            if (!XmlFast_cdata(f)) {
+                return XML_NOK;
+            }
+        }
+        else if (left > 0 && *p == '?') {
+            f->p = p + 1;
+            if (!XmlFast_pi(f)) {
+                return XML_NOK;
+            }
+        }
+        else {
+            int tag;
+            f->p = p;
+            tag = XmlFast_startTag(f);
+            if (tag == 0) {
+                return XML_NOK;
+            }
+            if (tag == 2) {
+                stack_pop_back(f->parser->m_nodeStack);
+            }
+        }
+        if (f->parser->m_nodeStack->num == 0) {
+            return XML_OK;
+        }
+        if (!XmlFast_text(f)) {
+            return XML_NOK;
+        }
+    }
+}
+
+/* comments, PIs and white space before (prolog) or after (epilog) the root
+ * element, return with p at the root start tag or at the end
+ */
+static int XmlFast_misc(XmlFast *f, int prolog)
+{
+    for (;;) {
+        XmlFast_skipSpace(f);
+        if (f->p >= f->end) {
+            return !prolog;
+        }
+        if (*f->p != '<' || f->end - f->p < 2) {
+            return XML_NOK;
+        }
+        if (f->end - f->p >= 4 && memcmp(f->p + 1, "!--", 3) == 0) {
+            f->p += 4;
+            if (!XmlFast_comment(f)) {
+                return XML_NOK;
+            }
+        }
+        else if (f->p[1] == '?') {
+            f->p += 2;
+            if (!XmlFast_pi(f)) {
+                return XML_NOK;
+            }
+        }
+        else {
+            /* root element or DOCTYPE */
+            return prolog && isNameStart(f->p[1]);
+        }
+    }
+}
+
+/* p after "<?xml" */
+static int XmlFast_declaration(XmlFast *f)
+{
+    static const char *names[] = {"version", "encoding", "standalone"};
+    int next = 0;
+    for (;;) {
+        const unsigned char *name, *value;
+        size_t len;
+        int i, space = XmlFast_skipSpace(f);
+        if (f->end - f->p >= 2 && f->p[0] == '?' && f->p[1] == '>') {
+            f->p += 2;
+            /* version is required */
+            return next > 0;
+        }
+        name = f->p;
+        while (f->p < f->end && isAlpha(*f->p)) {
+            f->p++;
+        }
+        len = (size_t)(f->p - name);
+        for (i = next; i < 3; i++) {
+            if (strlen(names[i]) == len && memcmp(names[i], name, len) == 0) {
+                break;
+            }
+        }
+        if (!space || i == 3 || (next == 0 && i != 0)) {
+            return XML_NOK;
+        }
+        next = i + 1;
+        XmlFast_skipSpace(f);
+        if (f->p >= f->end || *f->p != '=') {
+            return XML_NOK;
+        }
+        f->p++;
+        XmlFast_skipSpace(f);
+        if (f->p >= f->end || (*f->p != '"' && *f->p != '\'')) {
+            return XML_NOK;
+        }
+        value = ++f->p;
+        while (f->p < f->end && *f->p != value[-1]) {
+            f->p++;
+        }
+        if (f->p >= f->end) {
+            return XML_NOK;
+        }
+        len = (size_t)(f->p++ - value);
+        if (i == 0) {
+            if (len != 3 || memcmp(value, "1.0", 3) != 0) {
+                return XML_NOK;
+            }
+        }
+        else if (i == 1) {
+            /* other encodings are converted by expat */
+            if (len != 5 || (value[0] | 0x20) != 'u' || (value[1] | 0x20) != 't' ||
+                (value[2] | 0x20) != 'f' || value[3] != '-' || value[4] != '8') {
+                return XML_NOK;
+            }
+        }
+        else if (!(len == 3 && memcmp(value, "yes", 3) == 0) &&
+            !(len == 2 && memcmp(value, "no", 2) == 0)) {
+            return XML_NOK;
+        }
+    }
+}
+
+/* return 1 and the tree in parser->m_root on success or 0 if the document
+ * has to be parsed by expat
+ */
+static int XmlFast_parse(XmlParser *parser, const char *xml, size_t len)
+{
+    XmlFast f;
+    int ok;
+    f.parser = parser;
+    f.p = (const unsigned char *)xml;
+    f.end = f.p + len;
+    f.line = 1;
+    f.buf = NULL;
+    f.bufLen = 0;
+    f.bufCap = 0;
+    f.off = NULL;
+    f.offCap = 0;
+    f.atts = NULL;
+    parser->m_root = NULL;
+    parser->m_errorString = NULL;
+    parser->m_nodeStack = cpo_array_create(XMLTREE_STACKSIZE, sizeof(void*));
+    if (parser->m_nodeStack == NULL) {
+        return XML_NOK;
+    }
+
+    if (len >= 3 && memcmp(f.p, "\xEF\xBB\xBF", 3) == 0) {
+        f.p += 3;
+    }
+    ok = 1;
+    if (f.end - f.p >= 6 && memcmp(f.p, "<?xml", 5) == 0 && isSpace(f.p[5])) {
+        f.p += 5;
+        ok = XmlFast_declaration(&f);
+    }
+    ok = ok && XmlFast_misc(&f, 1) && XmlFast_element(&f) && XmlFast_misc(&f, 0);
+
+    free(f.buf);
+    free(f.off);
+    free((void *)f.atts);
+    cpo_array_destroy(parser->m_nodeStack);
+    if (!ok) {
+        XmlNode_deleteTree(parser->m_root);
+        parser->m_root = NULL;
+    }
+    return ok;
+}
+
+#endif
+
 const String XmlParser_getErrorString(struct XmlParser *parser)
 {
     return parser->m_errorString;
@@ -527,10 +1367,9 @@ int XmlParser_getErrorLineSet(struct XmlParser *parser)
     return parser->m_errorLineSet;
 }
 
-/* return root elem */
-XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml )
+static void XmlParser_create(XmlParser *parser)
 {
-    XmlNodeRef root = NULL;
+    parser->m_root = NULL;
     parser->m_errorString = NULL;
     parser->m_nodeStack= cpo_array_create(XMLTREE_STACKSIZE, sizeof(void*));
     /*expat parser*/
@@ -538,8 +1377,12 @@ XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml )
     XML_SetUserData(parser->m_parser, parser );
     XML_SetElementHandler(parser->m_parser, startElement, endElement );
     XML_SetCharacterDataHandler(parser->m_parser, characterData );
+}
 
-    if (XML_Parse(parser->m_parser, xml, (int)strlen(xml), XML_TRUE)) {
+static XmlNodeRef XmlParser_finish(XmlParser *parser, int ok)
+{
+    XmlNodeRef root = NULL;
+    if (ok) {
         root = parser->m_root;
     } else {
         parser->m_errorString = (char*)XML_ErrorString(XML_GetErrorCode(parser->m_parser));
@@ -548,6 +1391,7 @@ XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml )
         //printf("XML Error: %s at line %ld\n",
         //    XmlParser_getErrorString(parser),
         //    XML_GetCurrentLineNumber(parser->m_parser));
+        XmlNode_deleteTree(parser->m_root);
     }
 
     XML_ParserFree(parser->m_parser);
@@ -555,6 +1399,54 @@ XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml )
     return root;
 }
 
+/* return root elem */
+XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml )
+{
+    return XmlParser_parse_buffer(parser, xml, strlen(xml));
+}
+
+XmlNodeRef XmlParser_parse_buffer(XmlParser *parser,  const char * xml, size_t len )
+{
+    int ok = 1;
+#if !defined(XMLTREE_NO_FASTPARSE)
+    if (XmlFast_parse(parser, xml, len)) {
+        return parser->m_root;
+    }
+#endif
+    XmlParser_create(parser);
+    /* expat takes int lengths */
+    while (ok && len > XMLTREE_MAXCHUNK) {
+        ok = XML_Parse(parser->m_parser, xml, XMLTREE_MAXCHUNK, XML_FALSE) != XML_STATUS_ERROR;
+        xml += XMLTREE_MAXCHUNK;
+        len -= XMLTREE_MAXCHUNK;
+    }
+    if (ok) {
+        ok = XML_Parse(parser->m_parser, xml, (int)len, XML_TRUE) != XML_STATUS_ERROR;
+    }
+    return XmlParser_finish(parser, ok);
+}
+
+XmlNodeRef XmlParser_parse_stream(XmlParser *parser,  XmlParser_read read, void *userData )
+{
+    int ok = 1;
+    XmlParser_create(parser);
+    while (ok) {
+        size_t len;
+        /* let the reader fill the expat buffer directly */
+        void *buf = XML_GetBuffer(parser->m_parser, XMLTREE_STREAMCHUNK);
+        if (buf == NULL) {
+            ok = 0;
+            break;
+        }
+        len = read(buf, XMLTREE_STREAMCHUNK, userData);
+        ok = XML_ParseBuffer(parser->m_parser, (int)len, len == 0) != XML_STATUS_ERROR;
+        if (len == 0) {
+            break;
+        }
+    }
+    return XmlParser_finish(parser, ok);
+}
+
 XmlNodeRef XmlParser_parse_file(struct XmlParser *parser,  const String fileName )
 {
     XmlNodeRef root = NULL;
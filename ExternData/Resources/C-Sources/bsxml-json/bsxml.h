@@ -66,8 +66,14 @@ struct XmlParser
     int         m_errorLineSet;
 };
 
+typedef size_t (*XmlParser_read)(void *buf, size_t len, void *userData);
+
 XmlNodeRef XmlParser_parse_file(XmlParser *parser,  const String fileName );
 XmlNodeRef XmlParser_parse(XmlParser *parser,  const char * xml );
+/* parse len bytes of xml (need not be null-terminated) */
+XmlNodeRef XmlParser_parse_buffer(XmlParser *parser,  const char * xml, size_t len );
+/* parse chunks delivered by read until it returns 0 */
+XmlNodeRef XmlParser_parse_stream(XmlParser *parser,  XmlParser_read read, void *userData );
 const String XmlParser_getErrorString(struct XmlParser *parser);
 XML_Size XmlParser_getErrorLine(struct XmlParser *parser);
 int XmlParser_getErrorLineSet(struct XmlParser *parser);
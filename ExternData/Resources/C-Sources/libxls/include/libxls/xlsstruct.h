@@ -59,6 +59,7 @@
 #define XLS_RECORD_EXTSST       0x00FF
 #define XLS_RECORD_TXO          0x01B6
 #define XLS_RECORD_HYPERREF     0x01B8
+#define XLS_RECORD_DIMENSIONS   0x0200
 #define XLS_RECORD_BLANK        0x0201
 #define XLS_RECORD_NUMBER       0x0203
 #define XLS_RECORD_LABEL        0x0204
@@ -439,6 +440,8 @@ typedef	struct st_row
     //	DWORD count;
     WORD lastcol;	// numCols - 1
     WORD lastrow;	// numRows - 1
+    DWORD allocrows;	// Rows allocated while parsing
+    WORD alloccols;	// Cells per row to allocate while parsing (from DIMENSIONS)
     struct st_row_data
     {
         WORD index;
@@ -57,8 +57,13 @@
 int xls_debug = 0;
 
 static double NumFromRk(DWORD_UA drk);
+static void xls_reserveRows(xlsWorkSheet* pWS,DWORD n);
+static struct st_row_data* xls_growRow(xlsWorkSheet* pWS,WORD r,WORD lcol);
 static xls_formula_handler formula_handler;
 
+// Marks a row without ROW record until the table is made
+#define XLS_LCELL_UNSET 0xFFFF
+
 extern void xls_addSST(xlsWorkBook* pWB,SST* sst,DWORD size);
 extern void xls_appendSST(xlsWorkBook* pWB,BYTE* buf,DWORD size);
 extern void xls_addFormat(xlsWorkBook* pWB,FORMAT* format);
@@ -71,8 +76,8 @@ extern void xls_addXF8(xlsWorkBook* pWB,XF8* xf);
 extern void xls_addXF5(xlsWorkBook* pWB,XF5* xf);
 extern void xls_addColinfo(xlsWorkSheet* pWS,COLINFO* colinfo);
 extern void xls_mergedCells(xlsWorkSheet* pWS,BOF* bof,BYTE* buf);
+extern void xls_dimensions(xlsWorkSheet* pWS,BOF* bof,BYTE* buf);
 extern void xls_parseWorkBook(xlsWorkBook* pWB);
-extern void xls_preparseWorkSheet(xlsWorkSheet* pWS);
 extern void xls_formatColumn(xlsWorkSheet* pWS);
 extern void xls_parseWorkSheet(xlsWorkSheet* pWS);
 extern void xls_dumpSummary(char *buf,int isSummary,xlsSummaryInfo	*pSI);
@@ -416,7 +421,7 @@ void xls_addRow(xlsWorkSheet* pWS,ROW* row)
 
     //verbose ("xls_addRow");
 
-    tmp=&pWS->rows.row[row->index];
+    tmp=xls_growRow(pWS,row->index,row->lcell);
     tmp->height=row->height;
     tmp->fcell=row->fcell;
     tmp->lcell=row->lcell;
@@ -426,40 +431,100 @@ void xls_addRow(xlsWorkSheet* pWS,ROW* row)
     if(xls_debug) xls_showROW(tmp);
 }
 
+// Make sure that row r with cells up to column lcol exists. The rows and
+// cells are grown on demand while parsing (preallocated from DIMENSIONS)
+// and the extent of the sheet is tracked in lastrow and lastcol.
+static void xls_reserveRows(xlsWorkSheet* pWS,DWORD n)
+{
+    DWORD i;
+
+    if (n<=pWS->rows.allocrows)
+        return;
+    pWS->rows.row=(struct st_row_data *)realloc(pWS->rows.row,n*sizeof(struct st_row_data));
+    memset(&pWS->rows.row[pWS->rows.allocrows],0,(n-pWS->rows.allocrows)*sizeof(struct st_row_data));
+    for (i=pWS->rows.allocrows;i<n;i++)
+    {
+        pWS->rows.row[i].index=i;
+        pWS->rows.row[i].lcell=XLS_LCELL_UNSET;
+    }
+    pWS->rows.allocrows=n;
+}
+
+static struct st_row_data* xls_growRow(xlsWorkSheet* pWS,WORD r,WORD lcol)
+{
+    struct st_row_data* tmp;
+    DWORD i;
+
+    if (r>=pWS->rows.allocrows)
+    {
+        DWORD n=pWS->rows.allocrows+pWS->rows.allocrows/2;
+        if (n<=r)
+            n=r+1;
+        xls_reserveRows(pWS,n);
+    }
+    if (pWS->rows.lastrow<r)
+        pWS->rows.lastrow=r;
+    if (pWS->rows.lastcol<lcol)
+        pWS->rows.lastcol=lcol;
+
+    tmp=&pWS->rows.row[r];
+    if (lcol>=tmp->cells.count)
+    {
+        DWORD n=(DWORD)pWS->rows.lastcol+1;
+        if (n<pWS->rows.alloccols)
+            n=pWS->rows.alloccols;
+        tmp->cells.cell=(struct st_cell_data *)realloc(tmp->cells.cell,n*sizeof(struct st_cell_data));
+        memset(&tmp->cells.cell[tmp->cells.count],0,(n-tmp->cells.count)*sizeof(struct st_cell_data));
+        for (i=tmp->cells.count;i<n;i++)
+        {
+            tmp->cells.cell[i].col=i;
+            tmp->cells.cell[i].row=r;
+            tmp->cells.cell[i].id=XLS_RECORD_BLANK;
+        }
+        tmp->cells.count=n;
+    }
+    return tmp;
+}
+
+// Bring the rows grown while parsing to the final extent of the sheet
 void xls_makeTable(xlsWorkSheet* pWS)
 {
     DWORD i,t;
     struct st_row_data* tmp;
     verbose ("xls_makeTable");
 
-    pWS->rows.row=(struct st_row_data *)calloc((pWS->rows.lastrow+1),sizeof(struct st_row_data));
+    // At least one cell, even for an empty sheet
+    xls_growRow(pWS,pWS->rows.lastrow,pWS->rows.lastcol);
+
+    for (t=pWS->rows.lastrow+1;t<pWS->rows.allocrows;t++)
+        free(pWS->rows.row[t].cells.cell);
+    pWS->rows.row=(struct st_row_data *)realloc(pWS->rows.row,(pWS->rows.lastrow+1)*sizeof(struct st_row_data));
+    pWS->rows.allocrows=pWS->rows.lastrow+1;
 
 	// printf("ALLOC: rows=%d cols=%d\n", pWS->rows.lastrow, pWS->rows.lastcol);
     for (t=0;t<=pWS->rows.lastrow;t++)
     {
         tmp=&pWS->rows.row[t];
-        tmp->index=t;
-        tmp->fcell=0;
-        tmp->lcell=pWS->rows.lastcol;
+        if (tmp->lcell==XLS_LCELL_UNSET)
+            tmp->lcell=pWS->rows.lastcol;
 
-		tmp->cells.count = pWS->rows.lastcol+1;
-        tmp->cells.cell=(struct st_cell_data *)calloc(tmp->cells.count,sizeof(struct st_cell_data));
+        if (tmp->cells.count!=(DWORD)pWS->rows.lastcol+1)
+        {
+            for (i=pWS->rows.lastcol+1;i<tmp->cells.count;i++)
+                free(tmp->cells.cell[i].str);
+            tmp->cells.cell=(struct st_cell_data *)realloc(tmp->cells.cell,(pWS->rows.lastcol+1)*sizeof(struct st_cell_data));
+            for (i=tmp->cells.count;i<=pWS->rows.lastcol;i++)
+            {
+                memset(&tmp->cells.cell[i],0,sizeof(struct st_cell_data));
+                tmp->cells.cell[i].col=i;
+                tmp->cells.cell[i].row=t;
+                tmp->cells.cell[i].id=XLS_RECORD_BLANK;
+            }
+            tmp->cells.count=pWS->rows.lastcol+1;
+        }
 
         for (i=0;i<=pWS->rows.lastcol;i++)
-        {
-            tmp->cells.cell[i].col=i;
-            tmp->cells.cell[i].row=t;
             tmp->cells.cell[i].width=pWS->defcolwidth;
-            tmp->cells.cell[i].xf=0;
-            tmp->cells.cell[i].str=NULL;
-            tmp->cells.cell[i].d=0;
-            tmp->cells.cell[i].l=0;
-            tmp->cells.cell[i].isHidden=0;
-            tmp->cells.cell[i].colspan=0;
-            tmp->cells.cell[i].rowspan=0;
-            tmp->cells.cell[i].id=XLS_RECORD_BLANK;
-            tmp->cells.cell[i].str=NULL;
-        }
     }
 }
 
@@ -468,11 +533,17 @@ struct st_cell_data *xls_addCell(xlsWorkSheet* pWS,BOF* bof,BYTE* buf)
     struct st_cell_data*	cell;
     struct st_row_data*		row;
     int						i;
+    int						lcol;
 
 	verbose ("xls_addCell");
 
 	// printf("ROW: %u COL: %u\n", xlsShortVal(((COL*)buf)->row), xlsShortVal(((COL*)buf)->col));
-    row=&pWS->rows.row[xlsShortVal(((COL*)buf)->row)];
+    lcol=xlsShortVal(((COL*)buf)->col);
+    if (bof->id==XLS_RECORD_MULRK && bof->size>=12)
+        lcol+=(bof->size - 6)/6 - 1;
+    else if (bof->id==XLS_RECORD_MULBLANK && bof->size>=8)
+        lcol+=(bof->size - 6)/2 - 1;
+    row=xls_growRow(pWS,xlsShortVal(((COL*)buf)->row),(WORD)lcol);
     //cell=&row->cells.cell[((COL*)buf)->col - row->fcell]; DFH - inconsistent
     cell=&row->cells.cell[xlsShortVal(((COL*)buf)->col)];
     cell->id=bof->id;
@@ -715,6 +786,9 @@ void xls_mergedCells(xlsWorkSheet* pWS,BOF* bof,BYTE* buf)
         span=(struct MERGEDCELLS*)(buf+(2+i*sizeof(struct MERGEDCELLS)));
         xlsConvertMergedcells(span);
         //		printf("Merged Cells: [%i,%i] [%i,%i] \n",span->colf,span->rowf,span->coll,span->rowl);
+        if (span->rowf>span->rowl || span->colf>span->coll ||
+            span->rowl>pWS->rows.lastrow || span->coll>pWS->rows.lastcol)
+            continue;
         for (r=span->rowf;r<=span->rowl;r++)
             for (c=span->colf;c<=span->coll;c++)
                 pWS->rows.row[r].cells.cell[c].isHidden=1;
@@ -724,6 +798,34 @@ void xls_mergedCells(xlsWorkSheet* pWS,BOF* bof,BYTE* buf)
     }
 }
 
+void xls_dimensions(xlsWorkSheet* pWS,BOF* bof,BYTE* buf)
+{
+    DWORD rows,cols;
+    verbose("xls_dimensions");
+
+    // The DIMENSIONS record is only a hint for preallocating the table, it
+    // is not always reliable
+    if (pWS->workbook->is5ver)
+    {
+        if (bof->size<8)
+            return;
+        rows=xlsShortVal(((WORD_UA *)buf)[1]);
+        cols=xlsShortVal(((WORD_UA *)buf)[3]);
+    }
+    else
+    {
+        if (bof->size<12)
+            return;
+        rows=xlsIntVal(((DWORD_UA *)buf)[1]);
+        cols=xlsShortVal(((WORD_UA *)buf)[5]);
+    }
+    if (rows==0 || rows>65536 || cols==0 || cols>256)
+        return;
+    if (pWS->rows.alloccols<cols)
+        pWS->rows.alloccols=cols;
+    xls_reserveRows(pWS,rows);
+}
+
 void xls_parseWorkBook(xlsWorkBook* pWB)
 {
     BOF bof1;
@@ -963,72 +1065,6 @@ void xls_parseWorkBook(xlsWorkBook* pWB)
 }
 
 
-void xls_preparseWorkSheet(xlsWorkSheet* pWS)
-{
-    BOF tmp;
-    BYTE* buf;
-
-    verbose ("xls_preparseWorkSheet");
-
-    ole2_seek(pWS->workbook->olestr,pWS->filepos);
-    do
-    {
-		size_t read;
-        read = ole2_read(&tmp, 1,4,pWS->workbook->olestr);
-		assert(read == 4);
-        xlsConvertBof(&tmp);
-        buf=(BYTE *)malloc(tmp.size);
-        read = ole2_read(buf, 1,tmp.size,pWS->workbook->olestr);
-		assert(read == tmp.size);
-        switch (tmp.id)
-        {
-        case XLS_RECORD_DEFCOLWIDTH:
-            pWS->defcolwidth=xlsShortVal(*(WORD_UA *)buf)*256;
-            break;
-        case XLS_RECORD_COLINFO:
-            xlsConvertColinfo((COLINFO*)buf);
-            xls_addColinfo(pWS,(COLINFO*)buf);
-            break;
-        case XLS_RECORD_ROW:
-            xlsConvertRow((ROW*)buf);
-            if (pWS->rows.lastcol<((ROW*)buf)->lcell)
-                pWS->rows.lastcol=((ROW*)buf)->lcell;
-            if (pWS->rows.lastrow<((ROW*)buf)->index)
-                pWS->rows.lastrow=((ROW*)buf)->index;
-            break;
-        /* If the ROW record is incorrect or missing, infer the information from
-         * cell data. */
-        case XLS_RECORD_MULRK:
-            if (pWS->rows.lastcol<xlsShortVal(((MULRK*)buf)->col) + (tmp.size - 6)/6 - 1)
-                pWS->rows.lastcol=xlsShortVal(((MULRK*)buf)->col) + (tmp.size - 6)/6 - 1;
-            if (pWS->rows.lastrow<xlsShortVal(((MULRK*)buf)->row))
-                pWS->rows.lastrow=xlsShortVal(((MULRK*)buf)->row);
-            break;
-        case XLS_RECORD_MULBLANK:
-            if (pWS->rows.lastcol<xlsShortVal(((MULBLANK*)buf)->col) + (tmp.size - 6)/2 - 1)
-                pWS->rows.lastcol=xlsShortVal(((MULBLANK*)buf)->col) + (tmp.size - 6)/2 - 1;
-            if (pWS->rows.lastrow<xlsShortVal(((MULBLANK*)buf)->row))
-                pWS->rows.lastrow=xlsShortVal(((MULBLANK*)buf)->row);
-            break;
-        case XLS_RECORD_NUMBER:
-        case XLS_RECORD_RK:
-        case XLS_RECORD_LABELSST:
-        case XLS_RECORD_BLANK:
-        case XLS_RECORD_LABEL:
-        case XLS_RECORD_FORMULA:
-        case XLS_RECORD_FORMULA_ALT:
-        case XLS_RECORD_BOOLERR:
-            if (pWS->rows.lastcol<xlsShortVal(((COL*)buf)->col))
-                pWS->rows.lastcol=xlsShortVal(((COL*)buf)->col);
-            if (pWS->rows.lastrow<xlsShortVal(((COL*)buf)->row))
-                pWS->rows.lastrow=xlsShortVal(((COL*)buf)->row);
-            break;
-        }
-        free(buf);
-    }
-    while ((!pWS->workbook->olestr->eof)&&(tmp.id!=XLS_RECORD_EOF));
-}
-
 void xls_formatColumn(xlsWorkSheet* pWS)
 {
     DWORD i,t,ii;
@@ -1066,15 +1102,17 @@ void xls_parseWorkSheet(xlsWorkSheet* pWS)
 
 	struct st_cell_data *cell;
 	xlsWorkBook *pWB = pWS->workbook;
+	// MERGEDCELLS records are applied once the table is complete
+	BYTE** merged = NULL;
+	DWORD mergedCount = 0;
+	DWORD i;
 
     verbose ("xls_parseWorkSheet");
 
-    xls_preparseWorkSheet(pWS);
+	// The sheet is parsed in a single pass, the rows and cells are grown on
+	// demand (see xls_growRow)
 	// printf("size=%d fatpos=%d)\n", pWS->workbook->olestr->size, pWS->workbook->olestr->fatpos);
 
-    xls_makeTable(pWS);
-    xls_formatColumn(pWS);
-
 	cell = (void *)0;
     ole2_seek(pWS->workbook->olestr,pWS->filepos);
     do
@@ -1098,7 +1136,16 @@ void xls_parseWorkSheet(xlsWorkSheet* pWS)
         case XLS_RECORD_EOF:
             break;
         case XLS_RECORD_MERGEDCELLS:
-            xls_mergedCells(pWS,&tmp,buf);
+            merged=(BYTE**)realloc(merged,(mergedCount+1)*sizeof(BYTE*));
+            merged[mergedCount++]=buf;
+            buf=NULL;
+            break;
+        case XLS_RECORD_DIMENSIONS:
+            xls_dimensions(pWS,&tmp,buf);
+            break;
+        case XLS_RECORD_COLINFO:
+            xlsConvertColinfo((COLINFO*)buf);
+            xls_addColinfo(pWS,(COLINFO*)buf);
             break;
         case XLS_RECORD_ROW:
 			if(xls_debug > 10) printf("ROW: %x at pos=%ld\n", tmp.id, lastPos);
@@ -1107,6 +1154,7 @@ void xls_parseWorkSheet(xlsWorkSheet* pWS)
             break;
 		case XLS_RECORD_DEFCOLWIDTH:
 			if(xls_debug > 10) printf("DEFAULT COL WIDTH: %d\n", *(WORD_UA *)buf);
+			pWS->defcolwidth=xlsShortVal(*(WORD_UA *)buf)*256;
 			break;
 		case XLS_RECORD_DEFAULTROWHEIGHT:
 			if(xls_debug > 10) printf("DEFAULT ROW Height: 0x%x %d\n", ((WORD_UA *)buf)[0], ((WORD_UA *)buf)[1]);
@@ -1361,6 +1409,15 @@ void xls_parseWorkSheet(xlsWorkSheet* pWS)
         free(buf);
     }
     while ((!pWS->workbook->olestr->eof)&&(tmp.id!=XLS_RECORD_EOF));
+
+    xls_makeTable(pWS);
+    xls_formatColumn(pWS);
+    for (i=0;i<mergedCount;i++)
+    {
+        xls_mergedCells(pWS,NULL,merged[i]);
+        free(merged[i]);
+    }
+    free(merged);
 }
 
 xlsWorkSheet * xls_getWorkSheet(xlsWorkBook* pWB,int num)
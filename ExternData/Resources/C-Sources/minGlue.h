@@ -8,22 +8,22 @@
  *  warranties or conditions of any kind, either express or implied.
  */
 
-/* map required file I/O types and functions to the standard C library */
+/* map required file I/O types and functions to the virtual file layer
+ * of ExternData, which also reads members of zip archives (read-only)
+ */
 #include <stdio.h>
+#include "ED_vfile.h"
+
+#define INI_READONLY
 
-#define INI_FILETYPE                    FILE*
-#define ini_openread(filename,file)     ((*(file) = fopen((filename),"rb")) != NULL)
-#define ini_openwrite(filename,file)    ((*(file) = fopen((filename),"wb")) != NULL)
-#define ini_openrewrite(filename,file)  ((*(file) = fopen((filename),"r+b")) != NULL)
-#define ini_close(file)                 (fclose(*(file)) == 0)
-#define ini_read(buffer,size,file)      (fgets((buffer),(size),*(file)) != NULL)
-#define ini_write(buffer,file)          (fputs((buffer),*(file)) >= 0)
-#define ini_rename(source,dest)         (rename((source), (dest)) == 0)
-#define ini_remove(filename)            (remove(filename) == 0)
+#define INI_FILETYPE                    ED_VFILE*
+#define ini_openread(filename,file)     ((*(file) = ED_vfopen(filename)) != NULL)
+#define ini_close(file)                 (ED_vfclose(*(file)), 1)
+#define ini_read(buffer,size,file)      (ED_vfgets((buffer),(size),*(file)) != NULL)
 
 #define INI_FILEPOS                     long int
-#define ini_tell(file,pos)              (*(pos) = ftell(*(file)))
-#define ini_seek(file,pos)              (fseek(*(file), *(pos), SEEK_SET) == 0)
+#define ini_tell(file,pos)              (*(pos) = ED_vftell(*(file)))
+#define ini_seek(file,pos)              (ED_vfseek(*(file), *(pos)) == 0)
 
 /* for floating-point support, define additional types and functions */
 #define INI_REAL                        float
@@ -296,6 +296,7 @@
 #endif
 #if defined(HAVE_HDF5)
 #   include <hdf5.h>
+#   include "../ED_h5chunk.h"
 #else
 #   define hobj_ref_t int
 #   define hid_t int
@@ -1718,20 +1719,59 @@ Mat_SizeOf(enum matio_types data_type)
     } while (0)
 
 #if defined(HAVE_ZLIB)
+/* Number of bytes inflated per call when converting compressed data */
+#define READ_COMPRESSED_BLOCK_SIZE 8192
+
+/* Inflates the elements block-wise and converts them in a tight loop */
 #define READ_COMPRESSED_DATA(SwapFunc) \
     do { \
-        if ( mat->byteswap ) { \
-            for ( i = 0; i < len; i++ ) { \
-                InflateData(mat,z,&v,data_size); \
-                data[i] = SwapFunc(&v); \
+        mat_uint8_t block[READ_COMPRESSED_BLOCK_SIZE]; \
+        int j, n; \
+        for ( i = 0; i < len; i += n ) { \
+            n = (int)(READ_COMPRESSED_BLOCK_SIZE/sizeof(v)); \
+            if ( n > len - i ) \
+                n = len - i; \
+            InflateData(mat,z,block,n*data_size); \
+            if ( mat->byteswap ) { \
+                for ( j = 0; j < n; j++ ) { \
+                    memcpy(&v,block+j*sizeof(v),sizeof(v)); \
+                    data[i+j] = SwapFunc(&v); \
+                } \
+            } else { \
+                for ( j = 0; j < n; j++ ) { \
+                    memcpy(&v,block+j*sizeof(v),sizeof(v)); \
+                    data[i+j] = v; \
+                } \
             } \
-        } else { \
-            for ( i = 0; i < len; i++ ) { \
-                InflateData(mat,z,&v,data_size); \
-                data[i] = v; \
+        } \
+    } while (0)
+
+/* Single byte elements need no swapping */
+#define READ_COMPRESSED_BYTES() \
+    do { \
+        mat_uint8_t block[READ_COMPRESSED_BLOCK_SIZE]; \
+        int j, n; \
+        for ( i = 0; i < len; i += n ) { \
+            n = len - i; \
+            if ( n > READ_COMPRESSED_BLOCK_SIZE ) \
+                n = READ_COMPRESSED_BLOCK_SIZE; \
+            InflateData(mat,z,block,n*data_size); \
+            for ( j = 0; j < n; j++ ) { \
+                memcpy(&v,block+j,1); \
+                data[i+j] = v; \
             } \
         } \
     } while (0)
+
+/* Same type in file and memory: inflate straight into the output */
+#define READ_COMPRESSED_DATA_DIRECT(SwapFunc) \
+    do { \
+        InflateData(mat,z,data,len*data_size); \
+        if ( mat->byteswap ) { \
+            for ( i = 0; i < len; i++ ) \
+                (void)SwapFunc(data+i); \
+        } \
+    } while (0)
 #endif
 
 /*
@@ -1868,367 +1908,74 @@ ReadCompressedDoubleData(mat_t *mat,z_streamp z,double *data,
     enum matio_types data_type,int len)
 {
     int nBytes = 0, data_size, i;
-    union _buf {
-        float           f[256];
-#ifdef HAVE_MATIO_INT64_T
-        mat_int64_t   i64[128];
-#endif
-#ifdef HAVE_MATIO_UINT64_T
-        mat_uint64_t ui64[128];
-#endif
-        mat_int32_t   i32[256];
-        mat_uint32_t ui32[256];
-        mat_int16_t   i16[512];
-        mat_uint16_t ui16[512];
-        mat_int8_t     i8[1024];
-        mat_uint8_t   ui8[1024];
-    } buf;
+
+    if ( (mat == NULL) || (data == NULL) || (z == NULL) )
+        return 0;
 
     data_size = Mat_SizeOf(data_type);
 
     switch ( data_type ) {
         case MAT_T_DOUBLE:
         {
-            if ( mat->byteswap ) {
-                InflateData(mat,z,data,len*data_size);
-                for ( i = 0; i < len; i++ )
-                    (void)Mat_doubleSwap(data+i);
-            } else {
-                InflateData(mat,z,data,len*data_size);
-            }
+            READ_COMPRESSED_DATA_DIRECT(Mat_doubleSwap);
             break;
         }
         case MAT_T_SINGLE:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 256 ){
-                    InflateData(mat,z,buf.f,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_floatSwap(buf.f+i);
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.f,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = Mat_floatSwap(buf.f+j);
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.f,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_floatSwap(buf.f+j);
-                }
-            } else {
-                if ( len <= 256 ){
-                    InflateData(mat,z,buf.f,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.f[i];
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.f,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = buf.f[j];
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.f,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.f[j];
-                }
-            }
+            float v;
+            READ_COMPRESSED_DATA(Mat_floatSwap);
             break;
         }
 #ifdef HAVE_MATIO_INT64_T
         case MAT_T_INT64:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 128 ){
-                    InflateData(mat,z,buf.i64,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_int64Swap(buf.i64+i);
-                } else {
-                    int j;
-                    len -= 128;
-                    for ( i = 0; i < len; i+=128 ) {
-                        InflateData(mat,z,buf.i64,128*data_size);
-                        for ( j = 0; j < 128; j++ )
-                            data[i+j] = Mat_int64Swap(buf.i64+j);
-                    }
-                    len = len-(i-128);
-                    InflateData(mat,z,buf.i64,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_int64Swap(buf.i64+j);
-                }
-            } else {
-                if ( len <= 128 ){
-                    InflateData(mat,z,buf.i64,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.i64[i];
-                } else {
-                    int j;
-                    len -= 128;
-                    for ( i = 0; i < len; i+=128 ) {
-                        InflateData(mat,z,buf.i64,128*data_size);
-                        for ( j = 0; j < 128; j++ )
-                            data[i+j] = buf.i64[j];
-                    }
-                    len = len-(i-128);
-                    InflateData(mat,z,buf.i64,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.i64[j];
-                }
-            }
+            mat_int64_t v;
+            READ_COMPRESSED_DATA(Mat_int64Swap);
             break;
         }
 #endif
 #ifdef HAVE_MATIO_UINT64_T
         case MAT_T_UINT64:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 128 ){
-                    InflateData(mat,z,buf.ui64,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_uint64Swap(buf.ui64+i);
-                } else {
-                    int j;
-                    len -= 128;
-                    for ( i = 0; i < len; i+=128 ) {
-                        InflateData(mat,z,buf.ui64,128*data_size);
-                        for ( j = 0; j < 128; j++ )
-                            data[i+j] = Mat_uint64Swap(buf.ui64+j);
-                    }
-                    len = len-(i-128);
-                    InflateData(mat,z,buf.ui64,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_uint64Swap(buf.ui64+j);
-                }
-            } else {
-                if ( len <= 128 ){
-                    InflateData(mat,z,buf.ui64,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.ui64[i];
-                } else {
-                    int j;
-                    len -= 128;
-                    for ( i = 0; i < len; i+=128 ) {
-                        InflateData(mat,z,buf.ui64,128*data_size);
-                        for ( j = 0; j < 128; j++ )
-                            data[i+j] = buf.ui64[j];
-                    }
-                    len = len-(i-128);
-                    InflateData(mat,z,buf.ui64,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.ui64[j];
-                }
-            }
+            mat_uint64_t v;
+            READ_COMPRESSED_DATA(Mat_uint64Swap);
             break;
         }
 #endif
         case MAT_T_INT32:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 256 ){
-                    InflateData(mat,z,buf.i32,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_int32Swap(buf.i32+i);
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.i32,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = Mat_int32Swap(buf.i32+j);
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.i32,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_int32Swap(buf.i32+j);
-                }
-            } else {
-                if ( len <= 256 ){
-                    InflateData(mat,z,buf.i32,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.i32[i];
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.i32,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = buf.i32[j];
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.i32,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.i32[j];
-                }
-            }
+            mat_int32_t v;
+            READ_COMPRESSED_DATA(Mat_int32Swap);
             break;
         }
         case MAT_T_UINT32:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 256 ){
-                    InflateData(mat,z,buf.ui32,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_uint32Swap(buf.ui32+i);
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.ui32,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = Mat_uint32Swap(buf.ui32+j);
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.ui32,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_uint32Swap(buf.ui32+j);
-                }
-            } else {
-                if ( len <= 256 ) {
-                    InflateData(mat,z,buf.ui32,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.ui32[i];
-                } else {
-                    int j;
-                    len -= 256;
-                    for ( i = 0; i < len; i+=256 ) {
-                        InflateData(mat,z,buf.ui32,256*data_size);
-                        for ( j = 0; j < 256; j++ )
-                            data[i+j] = buf.ui32[j];
-                    }
-                    len = len-(i-256);
-                    InflateData(mat,z,buf.ui32,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.ui32[j];
-                }
-            }
+            mat_uint32_t v;
+            READ_COMPRESSED_DATA(Mat_uint32Swap);
             break;
         }
         case MAT_T_INT16:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 512 ){
-                    InflateData(mat,z,buf.i16,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_int16Swap(buf.i16+i);
-                } else {
-                    int j;
-                    len -= 512;
-                    for ( i = 0; i < len; i+=512 ) {
-                        InflateData(mat,z,buf.i16,512*data_size);
-                        for ( j = 0; j < 512; j++ )
-                            data[i+j] = Mat_int16Swap(buf.i16+j);
-                    }
-                    len = len-(i-512);
-                    InflateData(mat,z,buf.i16,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_int16Swap(buf.i16+j);
-                }
-            } else {
-                if ( len <= 512 ) {
-                    InflateData(mat,z,buf.i16,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.i16[i];
-                } else {
-                    int j;
-                    len -= 512;
-                    for ( i = 0; i < len; i+=512 ) {
-                        InflateData(mat,z,buf.i16,512*data_size);
-                        for ( j = 0; j < 512; j++ )
-                            data[i+j] = buf.i16[j];
-                    }
-                    len = len-(i-512);
-                    InflateData(mat,z,buf.i16,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.i16[j];
-                }
-            }
+            mat_int16_t v;
+            READ_COMPRESSED_DATA(Mat_int16Swap);
             break;
         }
         case MAT_T_UINT16:
         {
-            if ( mat->byteswap ) {
-                if ( len <= 512 ){
-                    InflateData(mat,z,buf.ui16,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = Mat_uint16Swap(buf.ui16+i);
-                } else {
-                    int j;
-                    len -= 512;
-                    for ( i = 0; i < len; i+=512 ) {
-                        InflateData(mat,z,buf.ui16,512*data_size);
-                        for ( j = 0; j < 512; j++ )
-                            data[i+j] = Mat_uint16Swap(buf.ui16+j);
-                    }
-                    len = len-(i-512);
-                    InflateData(mat,z,buf.ui16,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = Mat_uint16Swap(buf.ui16+j);
-                }
-            } else {
-                if ( len <= 512 ) {
-                    InflateData(mat,z,buf.ui16,len*data_size);
-                    for ( i = 0; i < len; i++ )
-                        data[i] = buf.ui16[i];
-                } else {
-                    int j;
-                    len -= 512;
-                    for ( i = 0; i < len; i+=512 ) {
-                        InflateData(mat,z,buf.ui16,512*data_size);
-                        for ( j = 0; j < 512; j++ )
-                            data[i+j] = buf.ui16[j];
-                    }
-                    len = len-(i-512);
-                    InflateData(mat,z,buf.ui16,len*data_size);
-                    for ( j = 0; j < len; j++ )
-                        data[i+j] = buf.ui16[j];
-                }
-            }
+            mat_uint16_t v;
+            READ_COMPRESSED_DATA(Mat_uint16Swap);
             break;
         }
         case MAT_T_UINT8:
         {
-            if ( len <= 1024 ) {
-                InflateData(mat,z,buf.ui8,len*data_size);
-                for ( i = 0; i < len; i++ )
-                    data[i] = buf.ui8[i];
-            } else {
-                int j;
-                len -= 1024;
-                for ( i = 0; i < len; i+=1024 ) {
-                    InflateData(mat,z,buf.ui8,1024*data_size);
-                    for ( j = 0; j < 1024; j++ )
-                        data[i+j] = buf.ui8[j];
-                }
-                len = len-(i-1024);
-                InflateData(mat,z,buf.ui8,len*data_size);
-                for ( j = 0; j < len; j++ )
-                    data[i+j] = buf.ui8[j];
-            }
+            mat_uint8_t v;
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
-            if ( len <= 1024 ) {
-                InflateData(mat,z,buf.i8,len*data_size);
-                for ( i = 0; i < len; i++ )
-                    data[i] = buf.i8[i];
-            } else {
-                int j;
-                len -= 1024;
-                for ( i = 0; i < len; i+=1024 ) {
-                    InflateData(mat,z,buf.i8,1024*data_size);
-                    for ( j = 0; j < 1024; j++ )
-                        data[i+j] = buf.i8[j];
-                }
-                len = len-(i-1024);
-                InflateData(mat,z,buf.i8,len*data_size);
-                for ( j = 0; j < len; j++ )
-                    data[i+j] = buf.i8[j];
-            }
+            mat_int8_t v;
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -2374,8 +2121,7 @@ ReadCompressedSingleData(mat_t *mat,z_streamp z,float *data,
         }
         case MAT_T_SINGLE:
         {
-            float v;
-            READ_COMPRESSED_DATA(Mat_floatSwap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_floatSwap);
             break;
         }
 #ifdef HAVE_MATIO_INT64_T
@@ -2421,19 +2167,13 @@ ReadCompressedSingleData(mat_t *mat,z_streamp z,float *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -2586,8 +2326,7 @@ ReadCompressedInt64Data(mat_t *mat,z_streamp z,mat_int64_t *data,
         }
         case MAT_T_INT64:
         {
-            mat_int64_t v;
-            READ_COMPRESSED_DATA(Mat_int64Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_int64Swap);
             break;
         }
 #ifdef HAVE_MATIO_UINT64_T
@@ -2625,19 +2364,13 @@ ReadCompressedInt64Data(mat_t *mat,z_streamp z,mat_int64_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -2799,8 +2532,7 @@ ReadCompressedUInt64Data(mat_t *mat,z_streamp z,mat_uint64_t *data,
 #endif /* HAVE_MATIO_INT64_T */
         case MAT_T_UINT64:
         {
-            mat_uint64_t v;
-            READ_COMPRESSED_DATA(Mat_uint64Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_uint64Swap);
             break;
         }
         case MAT_T_INT32:
@@ -2830,19 +2562,13 @@ ReadCompressedUInt64Data(mat_t *mat,z_streamp z,mat_uint64_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -3013,8 +2739,7 @@ ReadCompressedInt32Data(mat_t *mat,z_streamp z,mat_int32_t *data,
 #endif
         case MAT_T_INT32:
         {
-            mat_int32_t v;
-            READ_COMPRESSED_DATA(Mat_int32Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_int32Swap);
             break;
         }
         case MAT_T_UINT32:
@@ -3038,19 +2763,13 @@ ReadCompressedInt32Data(mat_t *mat,z_streamp z,mat_int32_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -3226,8 +2945,7 @@ ReadCompressedUInt32Data(mat_t *mat,z_streamp z,mat_uint32_t *data,
         }
         case MAT_T_UINT32:
         {
-            mat_uint32_t v;
-            READ_COMPRESSED_DATA(Mat_uint32Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_uint32Swap);
             break;
         }
         case MAT_T_INT16:
@@ -3245,19 +2963,13 @@ ReadCompressedUInt32Data(mat_t *mat,z_streamp z,mat_uint32_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -3439,8 +3151,7 @@ ReadCompressedInt16Data(mat_t *mat,z_streamp z,mat_int16_t *data,
         }
         case MAT_T_INT16:
         {
-            mat_int16_t v;
-            READ_COMPRESSED_DATA(Mat_int16Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_int16Swap);
             break;
         }
         case MAT_T_UINT16:
@@ -3452,19 +3163,13 @@ ReadCompressedInt16Data(mat_t *mat,z_streamp z,mat_int16_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -3652,26 +3357,19 @@ ReadCompressedUInt16Data(mat_t *mat,z_streamp z,mat_uint16_t *data,
         }
         case MAT_T_UINT16:
         {
-            mat_uint16_t v;
-            READ_COMPRESSED_DATA(Mat_uint16Swap);
+            READ_COMPRESSED_DATA_DIRECT(Mat_uint16Swap);
             break;
         }
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -3866,19 +3564,12 @@ ReadCompressedInt8Data(mat_t *mat,z_streamp z,mat_int8_t *data,
         case MAT_T_UINT8:
         {
             mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         case MAT_T_INT8:
         {
-            mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            InflateData(mat,z,data,len*data_size);
             break;
         }
         default:
@@ -4072,20 +3763,13 @@ ReadCompressedUInt8Data(mat_t *mat,z_streamp z,mat_uint8_t *data,
         }
         case MAT_T_UINT8:
         {
-            mat_uint8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            InflateData(mat,z,data,len*data_size);
             break;
         }
         case MAT_T_INT8:
         {
             mat_int8_t v;
-            for ( i = 0; i < len; i++ ) {
-                InflateData(mat,z,&v,data_size);
-                data[i] = v;
-            }
+            READ_COMPRESSED_BYTES();
             break;
         }
         default:
@@ -4099,6 +3783,9 @@ ReadCompressedUInt8Data(mat_t *mat,z_streamp z,mat_uint8_t *data,
 #undef READ_DATA
 #if defined(HAVE_ZLIB)
 #undef READ_COMPRESSED_DATA
+#undef READ_COMPRESSED_BYTES
+#undef READ_COMPRESSED_DATA_DIRECT
+#undef READ_COMPRESSED_BLOCK_SIZE
 #endif
 #if defined(HAVE_ZLIB)
 /** @brief Reads data of type @c data_type into a char type
@@ -20486,7 +20173,10 @@ Mat_VarRead73(mat_t *mat,matvar_t *matvar)
 
             if ( !matvar->isComplex ) {
                 matvar->data = malloc(matvar->nbytes);
-                if ( NULL != matvar->data ) {
+                if ( NULL != matvar->data &&
+                     0 != ED_h5ReadChunked(dset_id,
+                            Mat_class_type_to_hid_t(matvar->class_type),
+                            matvar->data) ) {
                     H5Dread(dset_id,Mat_class_type_to_hid_t(matvar->class_type),
                             H5S_ALL,H5S_ALL,H5P_DEFAULT,matvar->data);
                 }
@@ -20689,7 +20379,7 @@ Mat_VarReadData73(mat_t *mat,matvar_t *matvar,void *data,
           int *start,int *stride,int *edge)
 {
     int err = -1;
-    int k;
+    int k, all = 1;
     hid_t fid,dset_id,ref_id,dset_space,mem_space;
     hsize_t dset_start[10],dset_stride[10],dset_edge[10];
 
@@ -20705,6 +20395,8 @@ Mat_VarReadData73(mat_t *mat,matvar_t *matvar,void *data,
         dset_start[k]  = start[matvar->rank-k-1];
         dset_stride[k] = stride[matvar->rank-k-1];
         dset_edge[k]   = edge[matvar->rank-k-1];
+        if ( 0 != start[k] || 1 != stride[k] || matvar->dims[k] != (size_t)edge[k] )
+            all = 0;
     }
     mem_space = H5Screate_simple(matvar->rank, dset_edge, NULL);
 
@@ -20737,8 +20429,12 @@ Mat_VarReadData73(mat_t *mat,matvar_t *matvar,void *data,
                                 dset_stride, dset_edge, NULL);
 
             if ( !matvar->isComplex ) {
-                H5Dread(dset_id,Mat_class_type_to_hid_t(matvar->class_type),
-                        mem_space,dset_space,H5P_DEFAULT,data);
+                /* Inflate the chunks in parallel if the whole variable is read */
+                if ( !all || 0 != ED_h5ReadChunked(dset_id,
+                        Mat_class_type_to_hid_t(matvar->class_type),data) ) {
+                    H5Dread(dset_id,Mat_class_type_to_hid_t(matvar->class_type),
+                            mem_space,dset_space,H5P_DEFAULT,data);
+                }
             } else {
                 mat_complex_split_t *complex_data = (mat_complex_split_t*)data;
                 hid_t h5_complex_base, h5_complex;
@@ -20795,6 +20491,7 @@ Mat_VarReadDataLinear73(mat_t *mat,matvar_t *matvar,void *data,
     hid_t fid,dset_id,dset_space,mem_space;
     hsize_t dset_start,dset_stride,dset_edge;
     hsize_t *points, k, dimp[10];
+    size_t numel;
 
     if ( NULL == mat || NULL == matvar || NULL == data )
         return err;
@@ -20826,6 +20523,19 @@ Mat_VarReadDataLinear73(mat_t *mat,matvar_t *matvar,void *data,
                 H5Iinc_ref(dset_id);
             }
 
+            numel = 1;
+            for ( k = 0; k < matvar->rank; k++ )
+                numel *= matvar->dims[k];
+            if ( !matvar->isComplex && 0 == start && 1 == stride &&
+                 numel == (size_t)edge &&
+                 0 == ED_h5ReadChunked(dset_id,
+                        Mat_class_type_to_hid_t(matvar->class_type),data) ) {
+                /* Whole variable read by parallel inflation of the chunks */
+                H5Dclose(dset_id);
+                err = 0;
+                break;
+            }
+
             points = (hsize_t*)malloc(matvar->rank*dset_edge*sizeof(*points));
             if ( NULL == points ) {
                 err = -2;
@@ -0,0 +1,50 @@
+/* ED_CBORFile.h - CBOR functions header
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_CBORFILE_H)
+#define ED_CBORFILE_H
+
+#include <stdlib.h>
+#include "msvc_compatibility.h"
+
+void* ED_createCBOR(const char* fileName, int verbose);
+void ED_destroyCBOR(void* _cbor);
+/* Elements are addressed by the dotted names of the keys of nested maps,
+ * as the elements of JSON files
+ */
+double ED_getDoubleFromCBOR(void* _cbor, const char* varName);
+const char* ED_getStringFromCBOR(void* _cbor, const char* varName);
+int ED_getIntFromCBOR(void* _cbor, const char* varName);
+/* Numeric arrays are flat arrays, arrays of rows, typed arrays (tags 64
+ * to 87 of RFC 8746) or multi-dimensional arrays (tags 40 and 1040). dim
+ * returns the number of rows and columns, for flat arrays the number of
+ * elements and 1. The values are read in row-major order.
+ */
+void ED_getArray2DSizeFromCBOR(void* _cbor, const char* varName, int* dim);
+void ED_getDoubleArray1DFromCBOR(void* _cbor, const char* varName, double* a, size_t n);
+void ED_getDoubleArray2DFromCBOR(void* _cbor, const char* varName, double* a, size_t m, size_t n);
+
+#endif
@@ -30,9 +30,37 @@
 #include "msvc_compatibility.h"
 
 void* ED_createINI(const char* fileName, int verbose);
+/* Overlay of the handle base: the values in the INI file fileName or the
+ * INI text overrides (either may be empty, the text takes precedence)
+ * replace the ones of base, all other values are read from base, which is
+ * not parsed again. base stays valid until it and all of its overlays are
+ * destroyed, in any order.
+ */
+void* ED_createINIOverlay(void* base, const char* fileName, const char* overrides, int verbose);
+/* Overlay of the INI file fileName by overlayFileName and overrides. The
+ * handle of fileName is shared by the overlays of all handles of the file,
+ * so it is parsed only once.
+ */
+void* ED_createINIWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose);
 void ED_destroyINI(void* _ini);
 double ED_getDoubleFromINI(void* _ini, const char* varName, const char* section);
 const char* ED_getStringFromINI(void* _ini, const char* varName, const char* section);
 int ED_getIntFromINI(void* _ini, const char* varName, const char* section);
+/* Numeric arrays of values like "0.1, 0.4, 0.9", with the columns
+ * separated by any character of delimiter and the rows by any character of
+ * rowDelimiter. A value without row delimiter is a vector of dim {n, 1},
+ * which can also be read as a single row. Each value is parsed once into
+ * a packed array kept until the handle is trimmed.
+ */
+void ED_getArray2DSizeFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, int* dim);
+void ED_getDoubleArray1DFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, double* a, size_t m);
+void ED_getDoubleArray2DFromINI(void* _ini, const char* varName, const char* section, const char* delimiter, const char* rowDelimiter, double* a, size_t m, size_t n);
+/* Read the double values of the keys varNames[0], ..., varNames[k - 1] of
+ * the sections sections[0], ..., sections[k - 1] of each of the n files
+ * fileNames into the rows of the n x k matrix a (row-major order). The
+ * files are read in parallel without building a table, no handle is
+ * created.
+ */
+void ED_getDoubleArray2DFromINIFiles(const char** fileNames, size_t n, const char** varNames, const char** sections, size_t k, double* a, int verbose);
 
 #endif
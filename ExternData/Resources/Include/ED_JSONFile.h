@@ -30,9 +30,27 @@
 #include "msvc_compatibility.h"
 
 void* ED_createJSON(const char* fileName, int verbose);
+/* Overlay of the handle base: the values in the JSON file fileName or the
+ * JSON text overrides (either may be empty, the text takes precedence)
+ * replace the ones of base, all other values are read from base, which is
+ * not parsed again. base stays valid until it and all of its overlays are
+ * destroyed, in any order.
+ */
+void* ED_createJSONOverlay(void* base, const char* fileName, const char* overrides, int verbose);
+/* Overlay of the JSON file fileName by overlayFileName and overrides. The
+ * handle of fileName is shared by the overlays of all handles of the file,
+ * so it is parsed only once.
+ */
+void* ED_createJSONWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose);
 void ED_destroyJSON(void* _json);
 double ED_getDoubleFromJSON(void* _json, const char* varName);
 const char* ED_getStringFromJSON(void* _json, const char* varName);
 int ED_getIntFromJSON(void* _json, const char* varName);
+/* Read the double values of the elements varNames[0], ..., varNames[k - 1]
+ * of each of the n files fileNames into the rows of the n x k matrix a
+ * (row-major order). The files are parsed in parallel and released right
+ * away, no handle is created.
+ */
+void ED_getDoubleArray2DFromJSONFiles(const char** fileNames, size_t n, const char** varNames, size_t k, double* a, int verbose);
 
 #endif
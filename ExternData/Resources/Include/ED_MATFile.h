@@ -34,5 +34,27 @@ void* ED_createMAT(const char* fileName, int verbose);
 void ED_destroyMAT(void* _mat);
 void ED_getDoubleArray2DFromMAT(void* _mat, const char* varName, double* a, size_t m, size_t n);
 void ED_getStringArray1DFromMAT(void* _mat, const char* varName, const char* string[], size_t m);
+/* Sparse matrices are copied from their stored row indices, column
+ * pointers and values without densification. dim returns the number of
+ * rows, columns and nonzeros. The compressed form is by columns (CSC, the
+ * storage order of the file) or, if rowMajor, by rows (CSR). Pointers and
+ * indices are 1-based: the nonzeros of column (row) j are the entries
+ * ptr[j - 1], ..., ptr[j] - 1 of idx and val, sorted by row (column).
+ */
+void ED_getSparseArray2DSizeFromMAT(void* _mat, const char* varName, int* dim);
+void ED_getSparseArray2DFromMAT(void* _mat, const char* varName, int rowMajor, int* ptr, size_t nPtr, int* idx, double* val, size_t nnz);
+/* Time series (matrices with the time stamps in the first column) aligned
+ * onto a common time grid, row by row the time and the signals of all time
+ * series. The grid is the union of all time stamps if nGrid is 0, of which
+ * dim returns the number of rows and columns. smoothness is
+ * LinearSegments (1) or ConstantSegments (3) of
+ * Modelica.Blocks.Types.Smoothness for each time series.
+ */
+void ED_getAlignedArray2DSizeFromMAT(void* _mat, const char** varNames, size_t nVars, int* dim);
+void ED_getAlignedArray2DFromMAT(void* _mat, const char** varNames, size_t nVars, const int* smoothness, const double* grid, size_t nGrid, double* a, size_t m, size_t n);
+void* ED_createNDTableFromMAT(void* _mat, const char* varName, const char** axisNames, size_t nAxes, int extrapolation);
+void ED_destroyNDTable(void* _nd);
+double ED_getDoubleFromNDTable(void* _nd, const double* u, size_t nDims);
+void ED_getDoubleArray1DFromNDTable(void* _nd, const double* u, size_t m, size_t nDims, double* y);
 
 #endif
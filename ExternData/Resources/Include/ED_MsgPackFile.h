@@ -0,0 +1,49 @@
+/* ED_MsgPackFile.h - MessagePack functions header
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_MSGPACKFILE_H)
+#define ED_MSGPACKFILE_H
+
+#include <stdlib.h>
+#include "msvc_compatibility.h"
+
+void* ED_createMsgPack(const char* fileName, int verbose);
+void ED_destroyMsgPack(void* _mp);
+/* Elements are addressed by the dotted names of the keys of nested maps,
+ * as the elements of JSON files
+ */
+double ED_getDoubleFromMsgPack(void* _mp, const char* varName);
+const char* ED_getStringFromMsgPack(void* _mp, const char* varName);
+int ED_getIntFromMsgPack(void* _mp, const char* varName);
+/* Numeric arrays are flat arrays or arrays of rows. dim returns the
+ * number of rows and columns, for flat arrays the number of elements and 1.
+ * The values are read in row-major order.
+ */
+void ED_getArray2DSizeFromMsgPack(void* _mp, const char* varName, int* dim);
+void ED_getDoubleArray1DFromMsgPack(void* _mp, const char* varName, double* a, size_t n);
+void ED_getDoubleArray2DFromMsgPack(void* _mp, const char* varName, double* a, size_t m, size_t n);
+
+#endif
@@ -35,5 +35,15 @@ double ED_getDoubleFromXLSX(void* _xlsx, const char* cellAddress, const char* sh
 const char* ED_getStringFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetName);
 int ED_getIntFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetName);
 void ED_getDoubleArray2DFromXLSX(void* _xlsx, const char* cellAddress, const char* sheetName, double* a, size_t m, size_t n);
+/* Streaming writer of a workbook with a single worksheet. The rows are
+ * appended in order and deflated into the file as they are written, only
+ * the shared strings of the string cells are kept in memory. The workbook
+ * is finished when the writer is destroyed.
+ */
+void* ED_createXLSXWriter(const char* fileName, const char* sheetName, int verbose);
+void ED_destroyXLSXWriter(void* _w);
+void ED_writeDoubleArray1DToXLSX(void* _w, const double* a, size_t n);
+void ED_writeDoubleArray2DToXLSX(void* _w, const double* a, size_t m, size_t n);
+void ED_writeStringArray1DToXLSX(void* _w, const char** s, size_t n);
 
 #endif
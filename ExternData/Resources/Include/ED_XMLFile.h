@@ -31,11 +31,29 @@
 #include "msvc_compatibility.h"
 
 void* ED_createXML(const char* fileName, int verbose);
+/* Overlay of the handle base: the values in the XML file fileName or the
+ * XML text overrides (either may be empty, the text takes precedence)
+ * replace the ones of base, all other values are read from base, which is
+ * not parsed again. base stays valid until it and all of its overlays are
+ * destroyed, in any order.
+ */
+void* ED_createXMLOverlay(void* base, const char* fileName, const char* overrides, int verbose);
+/* Overlay of the XML file fileName by overlayFileName and overrides. The
+ * handle of fileName is shared by the overlays of all handles of the file,
+ * so it is parsed only once.
+ */
+void* ED_createXMLWithOverlay(const char* fileName, const char* overlayFileName, const char* overrides, int verbose);
 void ED_destroyXML(void* _xml);
 double ED_getDoubleFromXML(void* _xml, const char* varName);
 const char* ED_getStringFromXML(void* _xml, const char* varName);
 int ED_getIntFromXML(void* _xml, const char* varName);
 void ED_getDoubleArray1DFromXML(void* _xml, const char* varName, double* a, size_t n);
 void ED_getDoubleArray2DFromXML(void* _xml, const char* varName, double* a, size_t m, size_t n);
+/* Read the double values of the elements varNames[0], ..., varNames[k - 1]
+ * of each of the n files fileNames into the rows of the n x k matrix a
+ * (row-major order). The files are parsed in parallel and released right
+ * away, no handle is created.
+ */
+void ED_getDoubleArray2DFromXMLFiles(const char** fileNames, size_t n, const char** varNames, size_t k, double* a, int verbose);
 
 #endif
@@ -0,0 +1,68 @@
+/* ED_trim.h - Release of parse structures of idle handles
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !defined(ED_TRIM_H)
+#define ED_TRIM_H
+
+/* External data is mostly read during initialization only, whereas the
+ * handles live until the end of the simulation. Handles therefore register
+ * a function that releases their parse structures (DOMs, lines, sheets),
+ * keeping only the extracted caches. The structures are released for all
+ * handles by ED_trim or, if the environment variable EXTERNDATA_TRIM_IDLE
+ * is set to a number of seconds, for each handle that was not accessed for
+ * that period. Accessing a handle afterwards reloads them.
+ *
+ * The registry is kept by each library: a program linking the static
+ * libraries has a single one, whereas each shared library (e.g. each DLL
+ * on Windows) keeps its own, so ED_trim of a shared library only releases
+ * the handles created by it.
+ */
+
+typedef struct ED_TrimEntry ED_TrimEntry;
+
+/* Release the parse structures of obj, must not call into Modelica */
+typedef void (*ED_trimFunc)(void* obj);
+
+/* Register obj and return its entry, NULL (i.e. never released) if out of
+ * memory
+ */
+ED_TrimEntry* ED_trimRegister(void* obj, ED_trimFunc func);
+void ED_trimUnregister(ED_TrimEntry* entry);
+
+/* Bracket each access of a registered handle: between ED_trimEnter and
+ * ED_trimLeave its structures are not released, so the handle can reload
+ * them after ED_trimEnter. A handle that is left by an error is never
+ * released again. entry may be NULL.
+ */
+void ED_trimEnter(ED_TrimEntry* entry);
+void ED_trimLeave(ED_TrimEntry* entry);
+
+/* Release the parse structures of all registered handles not in use,
+ * called by ExternData.Functions.trim
+ */
+void ED_trim(void);
+
+#endif
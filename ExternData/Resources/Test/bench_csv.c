@@ -0,0 +1,194 @@
+/* bench_csv.c - Table build throughput of ED_CSVFile per dialect
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Usage: bench_csv [rows] [-n repetitions]
+ *
+ * For each dialect, i.e. column delimiter and quotation, a file of the
+ * given number of rows (default 100000) of 10 decimal numbers and a header
+ * line is generated in the working directory. Each file is then read
+ * repeatedly by ED_createCSV, which reads its lines, and by
+ * ED_getDoubleArray2DFromCSV, which builds the table by the kernel of the
+ * dialect. The best throughput of both phases is reported in MB/s of the
+ * file, with a checksum of the values.
+ * The unquoted dialects use the kernel without quotation handling, the
+ * quoted ones the quotation aware kernel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "ED_CSVFile.h"
+
+#define BENCH_COLUMNS (10)
+
+/* The Modelica utility functions used by ED_CSVFile */
+void ModelicaMessage(const char* string)
+{
+	fputs(string, stdout);
+}
+
+void ModelicaFormatMessage(const char* string, ...)
+{
+	va_list args;
+	va_start(args, string);
+	vprintf(string, args);
+	va_end(args);
+}
+
+void ModelicaError(const char* string)
+{
+	fputs(string, stderr);
+	exit(1);
+}
+
+void ModelicaFormatError(const char* string, ...)
+{
+	va_list args;
+	va_start(args, string);
+	vfprintf(stderr, string, args);
+	va_end(args);
+	exit(1);
+}
+
+typedef struct {
+	const char* name;
+	const char* sep;
+	const char* quote;
+	int quoted;
+} Dialect;
+
+static const Dialect dialects[] = {
+	{"comma", ",", "\"", 0},
+	{"comma, \"", ",", "\"", 1},
+	{"comma, '", ",", "'", 1},
+	{"semicolon", ";", "\"", 0},
+	{"semicolon, \"", ";", "\"", 1},
+	{"tab", "\t", "\"", 0},
+	{"tab, \"", "\t", "\"", 1},
+	{"space", " ", "\"", 0},
+	{"space, \"", " ", "\"", 1}
+};
+
+/* Write the file of the dialect, returns its length or 0 on failure */
+static long writeFile(const char* fileName, const Dialect* d, int rows)
+{
+	FILE* fp = fopen(fileName, "wb");
+	unsigned long x = 12345;
+	long len;
+	int i, j;
+	if (fp == NULL) {
+		return 0;
+	}
+	for (j = 0; j < BENCH_COLUMNS; j++) {
+		fprintf(fp, "%s%sc%d%s", j > 0 ? d->sep : "", d->quoted ? d->quote : "", j,
+			d->quoted ? d->quote : "");
+	}
+	fputc('\n', fp);
+	for (i = 0; i < rows; i++) {
+		for (j = 0; j < BENCH_COLUMNS; j++) {
+			x = (x*1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+			fprintf(fp, "%s%s%s%lu.%03lu%s", j > 0 ? d->sep : "", d->quoted ? d->quote : "",
+				(x & 1) ? "-" : "", (x >> 8) % 1000, (x >> 1) % 1000, d->quoted ? d->quote : "");
+		}
+		fputc('\n', fp);
+	}
+	len = ftell(fp);
+	fclose(fp);
+	return len;
+}
+
+int main(int argc, char** argv)
+{
+	const char* fileName = "bench_csv.csv";
+	int rows = 100000;
+	int nRep = 5;
+	double* a;
+	size_t k;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			nRep = atoi(argv[++i]);
+			if (nRep < 1) {
+				nRep = 1;
+			}
+		}
+		else {
+			rows = atoi(argv[i]);
+			if (rows < 1) {
+				rows = 1;
+			}
+		}
+	}
+	a = (double*)malloc((size_t)rows*BENCH_COLUMNS*sizeof(double));
+	if (a == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		return 1;
+	}
+
+	for (k = 0; k < sizeof(dialects)/sizeof(dialects[0]); k++) {
+		const Dialect* d = &dialects[k];
+		long len = writeFile(fileName, d, rows);
+		double bestRead = 0;
+		double bestBuild = 0;
+		double sum = 0;
+		size_t j;
+		int field[2] = {2, 1};
+		if (len == 0) {
+			fprintf(stderr, "Cannot write file \"%s\"\n", fileName);
+			return 1;
+		}
+		for (i = 0; i < nRep; i++) {
+			clock_t t0 = clock();
+			clock_t t1;
+			double s;
+			void* csv = ED_createCSV(fileName, d->sep, d->quote, 0);
+			t1 = clock();
+			ED_getDoubleArray2DFromCSV(csv, field, a, (size_t)rows, BENCH_COLUMNS);
+			s = (double)(t1 - t0)/CLOCKS_PER_SEC;
+			if (i == 0 || s < bestRead) {
+				bestRead = s;
+			}
+			s = (double)(clock() - t1)/CLOCKS_PER_SEC;
+			if (i == 0 || s < bestBuild) {
+				bestBuild = s;
+			}
+			ED_destroyCSV(csv);
+		}
+		for (j = 0; j < (size_t)rows*BENCH_COLUMNS; j++) {
+			sum += a[j];
+		}
+		printf("%-14s read %8.1f MB/s  build %8.1f MB/s  checksum %.6f\n", d->name,
+			bestRead > 0 ? (double)len/bestRead/1e6 : 0,
+			bestBuild > 0 ? (double)len/bestBuild/1e6 : 0, sum);
+	}
+
+	remove(fileName);
+	free(a);
+	return 0;
+}
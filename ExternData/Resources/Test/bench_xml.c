@@ -0,0 +1,169 @@
+/* bench_xml.c - Parse throughput of the bsxml tree builder
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Usage: bench_xml [file.xml ...] [-n repetitions]
+ *
+ * Each file (by default a generated worksheet of 20000 rows of 10 cells)
+ * is parsed repeatedly into a bsxml tree by XmlParser_parse_buffer and the
+ * throughput is reported in MB/s. The target bench_xml uses the fast-path
+ * tokenizer, bench_xml_expat is the same program built with
+ * XMLTREE_NO_FASTPARSE, where every document is parsed by expat.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bsxml.h"
+
+#if defined(XMLTREE_NO_FASTPARSE)
+#define BENCH_PARSER "expat"
+#else
+#define BENCH_PARSER "fast path"
+#endif
+
+static char* readFile(const char* fileName, size_t* len)
+{
+	FILE* fp = fopen(fileName, "rb");
+	char* buf = NULL;
+	long size;
+	if (fp == NULL) {
+		return NULL;
+	}
+	if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) >= 0 &&
+		fseek(fp, 0, SEEK_SET) == 0) {
+		buf = (char*)malloc((size_t)size + 1);
+		if (buf != NULL && fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+			free(buf);
+			buf = NULL;
+		}
+		if (buf != NULL) {
+			buf[size] = '\0';
+			*len = (size_t)size;
+		}
+	}
+	fclose(fp);
+	return buf;
+}
+
+/* Worksheet part of an XLSX file with nRows rows of 10 numeric cells */
+static char* generateSheet(size_t nRows, size_t* len)
+{
+	static const char* header =
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+		"<sheetData>";
+	static const char* footer = "</sheetData></worksheet>";
+	size_t cap = strlen(header) + strlen(footer) + nRows*400 + 1;
+	char* buf = (char*)malloc(cap);
+	char* p = buf;
+	size_t i;
+	int j;
+	if (buf == NULL) {
+		return NULL;
+	}
+	p += sprintf(p, "%s", header);
+	for (i = 1; i <= nRows; i++) {
+		p += sprintf(p, "<row r=\"%lu\" spans=\"1:10\">", (unsigned long)i);
+		for (j = 0; j < 10; j++) {
+			p += sprintf(p, "<c r=\"%c%lu\" s=\"1\"><v>%.6g</v></c>", 'A' + j,
+				(unsigned long)i, (double)i*0.001 + j);
+		}
+		p += sprintf(p, "</row>");
+	}
+	p += sprintf(p, "%s", footer);
+	*len = (size_t)(p - buf);
+	return buf;
+}
+
+static int bench(const char* name, const char* xml, size_t len, int nRep)
+{
+	XmlParser xmlParser;
+	XmlNodeRef root;
+	clock_t t0;
+	double s;
+	int i;
+
+	t0 = clock();
+	for (i = 0; i < nRep; i++) {
+		root = XmlParser_parse_buffer(&xmlParser, xml, len);
+		if (root == NULL) {
+			fprintf(stderr, "%s: %s in line %lu\n", name,
+				XmlParser_getErrorString(&xmlParser), (unsigned long)XmlParser_getErrorLine(&xmlParser));
+			return 1;
+		}
+		XmlNode_deleteTree(root);
+	}
+	s = (double)(clock() - t0)/CLOCKS_PER_SEC;
+	printf("%s (%s): %lu bytes, %8.1f MB/s\n", name, BENCH_PARSER, (unsigned long)len,
+		s > 0 ? (double)len*nRep/s/1e6 : 0);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	int nRep = 20;
+	int nFiles = 0;
+	int ret = 0;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+			nRep = atoi(argv[++i]);
+			if (nRep < 1) {
+				nRep = 1;
+			}
+		}
+	}
+	for (i = 1; i < argc; i++) {
+		if (0 == strcmp(argv[i], "-n")) {
+			i++;
+		}
+		else {
+			size_t len = 0;
+			char* xml = readFile(argv[i], &len);
+			nFiles++;
+			if (xml == NULL) {
+				fprintf(stderr, "Cannot read \"%s\"\n", argv[i]);
+				ret = 1;
+				continue;
+			}
+			ret |= bench(argv[i], xml, len, nRep);
+			free(xml);
+		}
+	}
+	if (nFiles == 0) {
+		size_t len = 0;
+		char* xml = generateSheet(20000, &len);
+		if (xml == NULL) {
+			fprintf(stderr, "Memory allocation error\n");
+			return 1;
+		}
+		ret = bench("sheet", xml, len, nRep);
+		free(xml);
+	}
+	return ret;
+}
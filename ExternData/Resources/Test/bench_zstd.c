@@ -0,0 +1,194 @@
+/* bench_zstd.c - Decode throughput of ED_zstd against zlib
+ *
+ * Copyright (C) 2015-2017, tbeu
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Usage: bench_zstd file.zst [repetitions]
+ *
+ * The decompressed content of file.zst (e.g. from "zstd -19 data.csv") is
+ * gzip-compressed in memory by the vendored zlib at its default level. Both
+ * streams are then decoded repeatedly, by ED_zstdDecompressTo and by zlib
+ * inflate, and the throughput is reported in MB/s of decoded content.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "zlib.h"
+#include "ED_zstd.h"
+
+static unsigned char* readFile(const char* fileName, size_t* len)
+{
+	FILE* fp = fopen(fileName, "rb");
+	unsigned char* buf = NULL;
+	long size;
+	if (fp == NULL) {
+		return NULL;
+	}
+	if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) >= 0 &&
+		fseek(fp, 0, SEEK_SET) == 0) {
+		buf = (unsigned char*)malloc((size_t)size + 1);
+		if (buf != NULL && fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+			free(buf);
+			buf = NULL;
+		}
+		*len = (size_t)size;
+	}
+	fclose(fp);
+	return buf;
+}
+
+/* gzip-compress src, returns the compressed length or 0 on failure */
+static size_t gzipCompress(unsigned char* dst, size_t dstCap, const unsigned char* src, size_t len)
+{
+	z_stream zs;
+	size_t cLen = 0;
+	memset(&zs, 0, sizeof(zs));
+	if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return 0;
+	}
+	zs.next_in = (Bytef*)src;
+	zs.avail_in = (uInt)len;
+	zs.next_out = dst;
+	zs.avail_out = (uInt)dstCap;
+	if (deflate(&zs, Z_FINISH) == Z_STREAM_END) {
+		cLen = (size_t)zs.total_out;
+	}
+	deflateEnd(&zs);
+	return cLen;
+}
+
+/* gzip-decompress src, returns the decompressed length or 0 on failure */
+static size_t gzipDecompress(unsigned char* dst, size_t dstCap, const unsigned char* src, size_t len)
+{
+	z_stream zs;
+	size_t uLen = 0;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 15 + 16) != Z_OK) {
+		return 0;
+	}
+	zs.next_in = (Bytef*)src;
+	zs.avail_in = (uInt)len;
+	zs.next_out = dst;
+	zs.avail_out = (uInt)dstCap;
+	if (inflate(&zs, Z_FINISH) == Z_STREAM_END) {
+		uLen = (size_t)zs.total_out;
+	}
+	inflateEnd(&zs);
+	return uLen;
+}
+
+static double mbPerSecond(size_t len, int nRep, clock_t t)
+{
+	double s = (double)t/CLOCKS_PER_SEC;
+	return s > 0 ? (double)len*nRep/s/1e6 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned char* zst;
+	unsigned char* gz;
+	unsigned char* data;
+	unsigned char* out;
+	size_t zstLen = 0;
+	size_t gzLen;
+	size_t len;
+	size_t gzCap;
+	int nRep = 20;
+	int i;
+	clock_t t0;
+	clock_t tZstd;
+	clock_t tZlib;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s file.zst [repetitions]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) {
+		nRep = atoi(argv[2]);
+		if (nRep < 1) {
+			nRep = 1;
+		}
+	}
+	zst = readFile(argv[1], &zstLen);
+	if (zst == NULL || !ED_zstdIsFrame(zst, zstLen)) {
+		fprintf(stderr, "Cannot read Zstandard file \"%s\"\n", argv[1]);
+		return 1;
+	}
+	data = (unsigned char*)ED_zstdDecompress(zst, zstLen, &len);
+	if (data == NULL) {
+		fprintf(stderr, "Cannot decompress \"%s\"\n", argv[1]);
+		return 1;
+	}
+	gzCap = (size_t)compressBound((uLong)len) + 32;
+	gz = (unsigned char*)malloc(gzCap);
+	out = (unsigned char*)malloc(len + 1);
+	if (gz == NULL || out == NULL) {
+		fprintf(stderr, "Memory allocation error\n");
+		return 1;
+	}
+	gzLen = gzipCompress(gz, gzCap, data, len);
+	if (gzLen == 0) {
+		fprintf(stderr, "Cannot gzip-compress the content\n");
+		return 1;
+	}
+
+	t0 = clock();
+	for (i = 0; i < nRep; i++) {
+		if (ED_zstdDecompressTo(out, len + 1, zst, zstLen) != len) {
+			fprintf(stderr, "ED_zstd: decompression failed\n");
+			return 1;
+		}
+	}
+	tZstd = clock() - t0;
+	if (memcmp(out, data, len) != 0) {
+		fprintf(stderr, "ED_zstd: content mismatch\n");
+		return 1;
+	}
+
+	t0 = clock();
+	for (i = 0; i < nRep; i++) {
+		if (gzipDecompress(out, len + 1, gz, gzLen) != len) {
+			fprintf(stderr, "zlib: decompression failed\n");
+			return 1;
+		}
+	}
+	tZlib = clock() - t0;
+	if (memcmp(out, data, len) != 0) {
+		fprintf(stderr, "zlib: content mismatch\n");
+		return 1;
+	}
+
+	printf("content: %lu bytes, zstd: %lu bytes, gzip: %lu bytes\n",
+		(unsigned long)len, (unsigned long)zstLen, (unsigned long)gzLen);
+	printf("ED_zstd: %8.1f MB/s\n", mbPerSecond(len, nRep, tZstd));
+	printf("zlib:    %8.1f MB/s\n", mbPerSecond(len, nRep, tZlib));
+
+	free(zst);
+	free(data);
+	free(gz);
+	free(out);
+	return 0;
+}